@@ -9,10 +9,13 @@
 // The AVOIDANCE-FIELD emitter itself places engine PointEffectorComponents
 // sampled by FieldSolver (rule 6 -- one field), so it has no struct here.
 // ===========================================================================
+#include "ParallelFor.hpp"
+
 #include <glm/glm.hpp>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 
 namespace krs::field {
 
@@ -88,23 +91,48 @@ struct GridSdf {
         return origin + extent * (glm::vec3(float(i), float(j), float(k)) / glm::vec3(dims - glm::ivec3(1)));
     }
 
-    void build(const std::vector<glm::vec3>& parts, float r, int band = 1 << 20) {
+    // The splat runs over z-slabs of kSlab layers on `pool` (nullptr = serial).
+    // Particles are bucketed by their centre layer, so a slab only visits the
+    // ones whose band reaches it, and it writes only its own cells: the field
+    // is identical for any thread count.
+    static constexpr int kSlab = 4;
+    void build(const std::vector<glm::vec3>& parts, float r, int band = 1 << 20,
+               krs::par::ThreadPool* pool = &krs::par::ThreadPool::global()) {
         radius = r;
         field.assign(size_t(dims.x) * dims.y * dims.z, 1.0e9f);
         const glm::vec3 span = glm::vec3(dims - glm::ivec3(1));
-        for (const auto& p : parts) {
-            const glm::vec3 t = (p - origin) / extent * span;        // particle node-index
-            const glm::ivec3 c = glm::ivec3(glm::round(t));
-            const glm::ivec3 lo = glm::max(c - glm::ivec3(band), glm::ivec3(0));
-            const glm::ivec3 hi = glm::min(c + glm::ivec3(band), dims - glm::ivec3(1));
-            for (int k = lo.z; k <= hi.z; ++k)
-                for (int j = lo.y; j <= hi.y; ++j)
-                    for (int i = lo.x; i <= hi.x; ++i) {
-                        const float d = glm::length(nodePos(i, j, k) - p) - r;
-                        float& cell = field[idx(i, j, k)];
-                        if (d < cell) cell = d;
-                    }
+        std::vector<glm::ivec3> centre(parts.size());                  // particle node-index
+        std::vector<uint32_t> start(size_t(dims.z) + 1, 0), order(parts.size());
+        auto layer = [&](int k) { return size_t(std::clamp(k, 0, dims.z - 1)); };
+        for (size_t p = 0; p < parts.size(); ++p) {
+            centre[p] = glm::ivec3(glm::round((parts[p] - origin) / extent * span));
+            ++start[layer(centre[p].z) + 1];
+        }
+        for (size_t k = 0; k < size_t(dims.z); ++k) start[k + 1] += start[k];
+        {
+            std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+            for (size_t p = 0; p < parts.size(); ++p) order[fill[layer(centre[p].z)]++] = uint32_t(p);
         }
+        auto slab = [&](size_t s) {
+            const int k0 = int(s) * kSlab, k1 = std::min(dims.z, k0 + kSlab);
+            const size_t b0 = layer(std::max(k0 - band, 0)), b1 = layer(int(std::min<int64_t>(int64_t(k1) - 1 + band, dims.z - 1)));
+            for (uint32_t n = start[b0]; n < start[b1 + 1]; ++n) {
+                const glm::vec3& p = parts[order[n]];
+                const glm::ivec3 c = centre[order[n]];
+                const glm::ivec3 lo = glm::max(c - glm::ivec3(band), glm::ivec3(0, 0, k0));
+                const glm::ivec3 hi = glm::min(c + glm::ivec3(band), glm::ivec3(dims.x - 1, dims.y - 1, k1 - 1));
+                for (int k = lo.z; k <= hi.z; ++k)
+                    for (int j = lo.y; j <= hi.y; ++j)
+                        for (int i = lo.x; i <= hi.x; ++i) {
+                            const float d = glm::length(nodePos(i, j, k) - p) - r;
+                            float& cell = field[idx(i, j, k)];
+                            if (d < cell) cell = d;
+                        }
+            }
+        };
+        const size_t slabs = size_t((dims.z + kSlab - 1) / kSlab);
+        if (pool) pool->run(slabs, slab);
+        else for (size_t s = 0; s < slabs; ++s) slab(s);
     }
     float nodeValue(int i, int j, int k) const { return field[idx(i, j, k)]; }
 
@@ -145,7 +173,7 @@ inline double substanceFieldMagnitude(const GridSdf& sdf, const glm::vec3& point
 }
 
 // GATE SDF (env KRS_SDF_SELFTEST; in the bench): SDF-DISTANCE / SDF-GRADIENT /
-// SDF-DYNAMICS / SDF-PERF. Returns true iff all pass.
+// SDF-DYNAMICS / SDF-PERF / SDF-TILED. Returns true iff all pass.
 bool runSdfGate();
 
 // --- Phase 4.5: SDF uncertainty + reaction tempering + temporal coherence ---
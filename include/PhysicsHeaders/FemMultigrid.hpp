@@ -0,0 +1,81 @@
+#pragma once
+// ===========================================================================
+// Phase 5b — matrix-free geometric multigrid for the voxel FEM oracle.
+//
+// Every element of a VoxelFemModel is the SAME cubic hex, so the global operator
+// never has to be assembled: y = K x is evaluated node-by-node by gathering the
+// <= 8 incident elements and multiplying by the shared element matrix (same flop
+// count as element-by-element, but each node writes only its own rows -> no
+// scatter races, no colouring, bit-identical for any thread count). Memory is
+// linear in the node count (a handful of DOF vectors + the voxel index grids).
+//
+// Preconditioner: one V-cycle over a hierarchy of re-discretised voxel grids
+// (cell size 2h, 4h, ...). A coarse cell exists if any of its 8 children does
+// and carries the element matrix at its size scaled by its solid fill fraction;
+// transfer is trilinear prolongation / its transpose. Damped-Jacobi smoothing
+// (symmetric pre/post) runs on the shared krs::par pool; the coarsest level is
+// assembled and factored with SimplicialLDLT. Driven by PCG on the free DOFs.
+//
+// B = DOFs per node (3 = elasticity, 1 = heat). Dirichlet nodes are eliminated
+// (held at the values already in x); `nodalShift` adds a per-node diagonal term
+// (lumped convection). CPU/Eigen only — no GL, no Qt.
+// ===========================================================================
+#include <Eigen/Dense>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "FemSolver.hpp"
+
+namespace krs::fem {
+
+struct MgOptions {
+    double relTol = 1e-9;        // ||r_free|| / ||b_free|| stopping criterion
+    int maxIters = 500;          // PCG iteration cap
+    int smoothSweeps = 2;        // damped-Jacobi sweeps before AND after the coarse correction
+    double omega = 0.6;          // Jacobi damping
+    int coarseDofs = 6000;       // stop coarsening once a level has <= this many DOFs
+};
+
+struct MgStats {
+    int levels = 0;
+    int iterations = 0;
+    double relResidual = 0.0;
+    bool converged = false;
+    double setupSec = 0.0, solveSec = 0.0;
+};
+
+template <int B>
+class VoxelMultigrid {
+public:
+    using ElemMat = Eigen::Matrix<double, 8 * B, 8 * B>;
+    // Element matrix of a FULL cubic cell of side h (called once per level).
+    using ElemFn = std::function<ElemMat(double h)>;
+
+    VoxelMultigrid(const VoxelFemModel& m, const ElemFn& elem, const std::vector<char>& fixedNode,
+                   const std::vector<double>* nodalShift = nullptr, const MgOptions& opt = {});
+    ~VoxelMultigrid();
+    VoxelMultigrid(const VoxelMultigrid&) = delete;
+    VoxelMultigrid& operator=(const VoxelMultigrid&) = delete;
+
+    int dofs() const;
+    int levels() const;
+    const MgOptions& options() const { return m_opt; }
+
+    // y = K x on the finest level (full operator; Dirichlet rows NOT eliminated).
+    void apply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const;
+    // Solve K x = b for the free DOFs; x carries the initial guess and the
+    // prescribed Dirichlet values on entry.
+    MgStats solve(const Eigen::VectorXd& b, Eigen::VectorXd& x) const;
+
+private:
+    struct Level;
+    void vcycle(int l, const Eigen::VectorXd& b, Eigen::VectorXd& x) const;
+    std::vector<std::unique_ptr<Level>> m_levels;
+    MgOptions m_opt;
+    double m_setupSec = 0.0;
+};
+
+extern template class VoxelMultigrid<1>;
+extern template class VoxelMultigrid<3>;
+
+} // namespace krs::fem
@@ -4,8 +4,9 @@
 // volume, discretised as an immersed voxel/hexahedral FE mesh on a regular
 // background grid (occupancy from a predicate / SDF / surface mesh). Trilinear
 // 8-node hexes; one precomputed element matrix reused for every (cubic) cell of
-// a material; sparse SPD assembly solved with Eigen (SimplicialLDLT). This is
-// the IMPLICIT oracle, so it handles REAL metal modulus (no explicit-MPM
+// a material; sparse SPD assembly solved with Eigen (SimplicialLDLT), or — for
+// large elastic models — matrix-free multigrid-preconditioned CG (Phase 5b,
+// FemMultigrid.hpp). This is the IMPLICIT oracle, so it handles REAL metal modulus (no explicit-MPM
 // stiffness ceiling). CPU/Eigen only — no GL, no Qt; runnable on a worker thread.
 //
 // Discretisation decision + trade-offs: ROADMAP §L.
@@ -15,6 +16,8 @@
 #include <array>
 #include <functional>
 #include <future>
+#include <memory>
+#include <cstdint>
 
 namespace krs::fem {
 
@@ -56,9 +59,18 @@ struct ElasticResult {
     // Net constraint reaction = sum over fixed DOFs of the penalty force P*u (Newton). At static
     // equilibrium this balances the applied load: netReaction == -(nodalForces + mass*gravity).
     glm::dvec3 netReaction{ 0.0 };
+    int iterations = 0;                    // MG-PCG iterations (0 = direct LDLT)
+    double assemblySec = 0.0, solveSec = 0.0;   // stage wall times (assembly incl. MG setup)
     bool ok = false;
 };
 
+// Linear solver for solveElastic. Auto = direct LDLT up to kDirectMaxDofs DOFs,
+// matrix-free multigrid-PCG above. LDLT fill-in on a compact 3D blob grows like
+// n^2 (a 43k-DOF voxel sphere factors in minutes; MG-PCG solves it in < 1 s), so
+// the cut-over sits just above the thin test bodies (plate-with-hole: 15k DOFs).
+enum class FemLinearSolver { Auto, DirectLDLT, MultigridPCG };
+constexpr int kDirectMaxDofs = 20000;
+
 struct ThermalBC {
     std::vector<std::pair<int, double>> dirichlet;    // (node, T °C) fixed
     std::vector<std::pair<int, double>> nodalSource;  // (node, W) lumped heat input
@@ -69,6 +81,7 @@ struct ThermalBC {
 struct ThermalResult {
     std::vector<double> temperature;  // per node (°C)
     double minT = 0.0, maxT = 0.0;
+    double assemblySec = 0.0, solveSec = 0.0;   // stage wall times (stateless solves)
     bool ok = false;
 };
 
@@ -80,13 +93,16 @@ public:
                                   const std::function<bool(const glm::dvec3&)>& inside);
     // Axis-aligned solid box at resolution h (all cells solid).
     static VoxelFemModel voxelizeBox(const glm::dvec3& center, const glm::dvec3& half, double h);
-    // Surface triangle mesh -> occupancy via robust inside test (libigl winding number).
+    // Surface triangle mesh -> occupancy by +x ray parity, one scanline per cell row
+    // over a YZ triangle BVH, z-slabs in parallel (krs::par).
     static VoxelFemModel voxelizeMesh(const std::vector<glm::vec3>& verts,
                                       const std::vector<unsigned int>& indices, double h);
 
-    // --- solves (synchronous; Eigen SimplicialLDLT) ---
-    static ElasticResult solveElastic(const VoxelFemModel& m, const FemMaterial& mat, const ElasticBC& bc);
+    // --- solves (synchronous; Eigen SimplicialLDLT / matrix-free MG-PCG) ---
+    static ElasticResult solveElastic(const VoxelFemModel& m, const FemMaterial& mat, const ElasticBC& bc,
+                                      FemLinearSolver solver = FemLinearSolver::Auto);
     static ThermalResult solveThermalSteady(const VoxelFemModel& m, const FemMaterial& mat, const ThermalBC& bc);
+    // Stateless reference step (assembles + factors every call); time loops use ThermalStepper.
     static ThermalResult stepThermalTransient(const VoxelFemModel& m, const FemMaterial& mat,
                                               const ThermalBC& bc, const std::vector<double>& Tprev, double dt);
 
@@ -95,7 +111,9 @@ public:
     static std::future<ThermalResult> solveThermalSteadyAsync(VoxelFemModel m, FemMaterial mat, ThermalBC bc);
 
     // KRS_FEM_SELFTEST: axial bar (exact), cantilever vs Euler-Bernoulli,
-    // 1D-bar steady conduction vs linear gradient, plate-with-hole concentration.
+    // 1D-bar steady conduction vs linear gradient, plate-with-hole concentration,
+    // MG-PCG vs LDLT agreement + MG scaling (KRS_FEM_MG_N cells per axis),
+    // ThermalStepper reuse vs the stateless step (heat soak).
     static bool runSelfTests();
 
     // Phase 1 GATE 1.5 -- FEM static equilibrium: the net constraint reaction (ElasticResult::
@@ -105,4 +123,34 @@ public:
     static bool runEquilibriumGate1_5();
 };
 
+// Persistent backward-Euler thermal stepper for long heat-soak runs. The system
+// matrix (Kt + Ct/dt + convection + Dirichlet penalty) depends only on the model,
+// material, dt, convection coefficient and the SETS of surface / Dirichlet nodes;
+// its factorization (or, above kDirectMaxDofs, its multigrid hierarchy) is cached
+// under a fingerprint of exactly those inputs. A step with an unchanged key only
+// assembles the RHS (Ct/dt Tprev + sources + ambient + Dirichlet values) and does
+// the two triangular solves. Anything else changing -> rebuilt on the next step.
+// Not thread-safe: one stepper per body / worker.
+class ThermalStepper {
+public:
+    explicit ThermalStepper(FemLinearSolver solver = FemLinearSolver::Auto);
+    ~ThermalStepper();
+    ThermalStepper(ThermalStepper&&) noexcept;
+    ThermalStepper& operator=(ThermalStepper&&) noexcept;
+
+    ThermalResult step(const VoxelFemModel& m, const FemMaterial& mat, const ThermalBC& bc,
+                       const std::vector<double>& Tprev, double dt);
+    void invalidate();                                   // force a rebuild on the next step
+
+    int factorizations() const { return m_factorizations; }   // rebuilds so far
+    bool lastReused() const { return m_lastReused; }           // did the last step hit the cache?
+
+private:
+    struct Cache;
+    std::unique_ptr<Cache> m_cache;
+    FemLinearSolver m_solver;
+    int m_factorizations = 0;
+    bool m_lastReused = false;
+};
+
 } // namespace krs::fem
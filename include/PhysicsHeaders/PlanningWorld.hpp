@@ -213,6 +213,7 @@ public:
 // --- joint limits (position + velocity) ------------------------------------
 struct JointLimits {
     Eigen::VectorXd qLower, qUpper, vMax;     // size nq
+    Eigen::VectorXd aMax, tauMax;             // size nq, OPTIONAL (empty => unconstrained); read by toppra()
 };
 
 // Min position-limit margin over all waypoints/dofs (negative => some dof out of range).
@@ -0,0 +1,121 @@
+#pragma once
+// ===========================================================================
+// OMPL sprint, Phase 6 — planned-path post-processing (krs::plan).
+//
+// The planner returns a dense, collision-checked but wandering RRT path, and the
+// constant-speed timeParameterize() rides every segment at vMax and stops dead
+// at each waypoint. This pipeline shortens and re-times it:
+//   1. shortcutPath : randomized shortcutting — pick two path points, replace the
+//                     span between them by the straight joint-space segment iff
+//                     it is collision-free at the checking resolution. Seeded,
+//                     so the result is deterministic per seed.
+//   2. smoothPath   : end-interpolating cubic B-spline over the shortcut polygon,
+//                     re-validated densely against the CollisionWorld. A span
+//                     that collides is pulled back onto the (valid) polygon by
+//                     inserting edge midpoints as extra control points; if that
+//                     does not converge the polygon itself (every vertex tripled
+//                     -> C1 with a rest at each corner) is returned.
+//   3. toppra       : TOPP-RA time-optimal path parameterization (Pham & Pham,
+//                     IEEE T-RO 2018) along the spline under |qd| <= vMax,
+//                     |qdd| <= aMax and |tau| <= tauMax, where
+//                     tau(s, sd, sdd) = a(s) sdd + b(s) sd^2 + c(s) is built from
+//                     three RNEA calls per gridpoint (exact for a rigid chain).
+// Pure CPU/Eigen, no OMPL. Interior spans stay inside the convex hull of their
+// control points, so the position limits of the polygon carry over.
+// ===========================================================================
+#include <Eigen/Dense>
+#include <cstdint>
+#include <vector>
+#include "RobotDynamics.hpp"
+#include "PlanningWorld.hpp"
+
+namespace krs::plan {
+
+struct ShortcutOptions {
+    std::uint32_t seed = 1u;          // RNG seed (determinism)
+    unsigned iterations = 200;        // shortcut attempts
+    double resolution = 0.01;         // rad, max joint-space step when checking a segment
+};
+
+struct SmoothOptions {
+    double resolution = 0.01;         // rad, max joint-space step when validating the spline
+    unsigned maxRefinements = 6;      // midpoint-insertion rounds before falling back to the polygon
+};
+
+struct ToppraOptions {
+    unsigned gridPoints = 200;        // path discretization (raised to >= 4 per spline span)
+    Eigen::Vector3d gravity = Eigen::Vector3d(0, 0, -9.81);
+};
+
+// Uniform cubic B-spline over joint-space control points, end-interpolating via
+// reflected phantom points (the curve starts/ends exactly on the first/last
+// control point); the parameter s runs over [0, spans()].
+class BSplinePath {
+public:
+    BSplinePath() = default;
+    explicit BSplinePath(const std::vector<Eigen::VectorXd>& controlPoints);
+
+    int spans() const { return P_.size() < 4 ? 0 : int(P_.size()) - 3; }
+    int dim() const { return P_.empty() ? 0 : int(P_.front().size()); }
+    const std::vector<Eigen::VectorXd>& controlPoints() const { return ctrl_; }
+
+    Eigen::VectorXd eval(double s) const;
+    // Position + first/second derivatives w.r.t. the path parameter s.
+    void eval(double s, Eigen::VectorXd& q, Eigen::VectorXd& dq, Eigen::VectorXd& ddq) const;
+
+private:
+    std::vector<Eigen::VectorXd> ctrl_;   // as given
+    std::vector<Eigen::VectorXd> P_;      // with the phantom end points
+};
+
+// A TOPP-RA result: per-gridpoint path speed sd = ds/dt and the piecewise-
+// constant path acceleration sdd held over [s_i, s_{i+1}].
+struct TimedPath {
+    BSplinePath path;
+    std::vector<double> s, sd, sdd, t;
+    double total = 0.0;               // trajectory duration [s]
+    bool ok = false;                  // false => the limits are infeasible along this path
+
+    // Commanded joint state at time tq (clamped to [0, total]).
+    void sample(double tq, Eigen::VectorXd& q, Eigen::VectorXd& qd, Eigen::VectorXd& qdd) const;
+};
+
+// Is the straight joint-space segment [a,b] collision-free at `resolution`?
+bool segmentValid(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                  const Eigen::VectorXd& a, const Eigen::VectorXd& b, double resolution);
+
+std::vector<Eigen::VectorXd> shortcutPath(const krs::dyn::SerialChain& chain,
+                                          const CollisionWorld& world,
+                                          const std::vector<Eigen::VectorXd>& path,
+                                          const ShortcutOptions& opt = {});
+
+// `fellBack` (optional) reports whether the exact polygon had to be returned.
+BSplinePath smoothPath(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                       const std::vector<Eigen::VectorXd>& polygon,
+                       const SmoothOptions& opt = {}, unsigned* refinements = nullptr,
+                       bool* fellBack = nullptr);
+
+TimedPath toppra(const krs::dyn::SerialChain& chain, const BSplinePath& path,
+                 const JointLimits& lim, const ToppraOptions& opt = {});
+
+// shortcut -> smooth -> TOPP-RA, with the numbers the EXECUTE gate reports.
+struct PostProcessOptions {
+    ShortcutOptions shortcut;
+    SmoothOptions smooth;
+    ToppraOptions toppra;
+};
+
+struct PostProcessResult {
+    std::vector<Eigen::VectorXd> shortcut;    // shortcut polygon (start..goal)
+    TimedPath traj;
+    double inputLength = 0.0, shortcutLength = 0.0;
+    unsigned refinements = 0;
+    bool smoothFellBack = false;
+    bool ok = false;
+};
+
+PostProcessResult postProcessPath(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                                  const JointLimits& lim, const std::vector<Eigen::VectorXd>& path,
+                                  const PostProcessOptions& opt = {});
+
+} // namespace krs::plan
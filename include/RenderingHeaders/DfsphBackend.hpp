@@ -15,9 +15,16 @@
  * the ground plane and every Box collider in the scene; fluid volumes and
  * emitters come from the same components the PBF backend uses.
  *
- * Runs synchronously inside the engine frame with a substep budget: when
- * the CPU can't keep up, simulation time dilates instead of stalling the
- * UI (the bake-and-scrub workflow is the answer for big particle counts).
+ * Steps on its own worker thread. Each frame update() asks for dt more sim
+ * time and takes the newest COMPLETED step through a swap-only hand-off
+ * (worker fill buffer -> ready slot -> frame staging), so the frame never
+ * waits on the solver and rendering / samplePositions() always see a whole
+ * step. The request backlog is capped: when the CPU can't keep up,
+ * simulation time dilates instead of stalling the UI (the bake-and-scrub
+ * workflow is the answer for big particle counts). Box colliders are
+ * exchanged at step boundaries: a moved or resized collider is resampled
+ * by the worker between steps with the live fluid state carried over
+ * (static Akinci boundaries — no fluid->rigid force feedback).
  * Particle positions are uploaded into the FluidSystem's shared SSBO, so
  * rendering is identical across backends.
  */
@@ -2,16 +2,25 @@
 
 #include <QString>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 /**
- * @brief Houdini-style fluid sim cache: one compact binary file per frame
- * (cache/<name>/frame_00000.krfc), recorded live while the simulation
+ * @brief Houdini-style fluid sim cache, recorded live while the simulation
  * plays and scrubbed back through the same particle SSBO the renderer
  * already consumes — baked playback looks identical to the live sim.
  *
- * Frame layout: header {magic 'KRFC', version, frameIndex, simTime,
- * particleCount} followed by particleCount * {vec4 posLife, vec4 vel}.
+ * Container (cache/<name>/): frames.krfd holds the frame blobs back to back
+ * (krs::fcache codec: per-block quantized or lossless, delta + LZ packed);
+ * frames.krfi is the frame index {offset, bytes, particleCount, simTime}.
+ * Reading maps frames.krfd once, so any frame is an index lookup plus a
+ * decode of just its own bytes — scrubbing never reads whole files.
+ * Sequential reads arm a background prefetcher that decodes the next few
+ * frames ahead. Old one-file-per-frame bakes (frame_00000.krfc) still read.
+ *
+ * Frames are quantized by default (16-bit positions within each block's
+ * bounds, 16-bit velocities); setLossless(true) / KRS_FLUID_CACHE_LOSSLESS=1
+ * keeps every float bit-exact.
  */
 class FluidCache
 {
@@ -22,6 +31,19 @@ public:
         int particleCount() const { return int(data.size() / 8); }
     };
 
+    /// Compression-ratio report over the frames on disk.
+    struct Stats {
+        int frames = 0;
+        int64_t rawBytes = 0;       // 32 B/particle, what the legacy format stored
+        int64_t storedBytes = 0;    // frame blobs in frames.krfd
+        int64_t prefetchHits = 0;   // readFrame served by the prefetcher
+        int64_t reads = 0;
+        double ratio() const { return storedBytes > 0 ? double(rawBytes) / double(storedBytes) : 0.0; }
+    };
+
+    FluidCache();
+    ~FluidCache();
+
     void setDirectory(const QString& dir);
     const QString& directory() const { return m_dir; }
 
@@ -29,12 +51,27 @@ public:
     int frameCount() const { return m_frameCount; }
     void refresh();
 
+    /// Frames written from now on are bit-exact instead of quantized.
+    void setLossless(bool on) { m_lossless = on; }
+    bool lossless() const { return m_lossless; }
+
     bool writeFrame(int index, double simTime, const std::vector<float>& interleaved);
     bool readFrame(int index, Frame& out) const;
     void clear(); // delete all frames in the directory
+    Stats stats() const;
+
+    /// Container suite (temp dir): lossless bake bit-exact under random access,
+    /// quantized ratio report, reopen-from-index, sequential prefetch hit rate,
+    /// corrupted-blob rejection (neg-ctrl). Runs the codec suite first. Logs PASS/FAIL.
+    static bool runSelfTests();
 
 private:
     QString framePath(int index) const;
+    bool readLegacyFrame(int index, Frame& out) const;
+
+    struct Store;                  // mapped data file, index, writers, prefetch worker
+    std::unique_ptr<Store> m_store;
     QString m_dir;
     int m_frameCount = 0;
+    bool m_lossless = false;
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Frame codec behind FluidCache's packed container. No Qt, no I/O:
+ * turns one cached frame (8 floats per particle: posLife, vel) into a
+ * self-describing blob and back.
+ *
+ * A frame is split into blocks of kBlockParticles. Each block stores its
+ * channels planar, delta-encoded along particle index (neighbouring indices
+ * are seeded / emitted together, so deltas are small), byte-shuffled so equal
+ * significance bytes sit together, then LZ-compressed (LZ4-style token stream,
+ * 64 KiB window).
+ *
+ *  - Lossless: every float's bit pattern is delta-coded as a uint32, so a
+ *    round trip is bit-exact (NaN payloads and -0 included).
+ *  - Quantized: positions become 16-bit fractions of the block's AABB and
+ *    velocities 16-bit fractions of the block's max |v| component; life stays
+ *    a lossless float. Error <= half a quantization step per block.
+ */
+namespace krs::fcache {
+
+constexpr int kFloatsPerParticle = 8;   // FluidCache::Frame layout
+constexpr int kBlockParticles = 4096;
+
+enum class Mode : uint32_t { Lossless = 0, Quantized = 1 };
+
+/// Encode `count` particles into a frame blob, appended to `out`.
+void encodeFrame(const float* interleaved, int count, double simTime, Mode mode,
+                 std::vector<uint8_t>& out);
+/// Decode a frame blob into `out` (8 floats per particle). False on a
+/// truncated or corrupt blob; never reads outside [blob, blob + bytes).
+bool decodeFrame(const uint8_t* blob, size_t bytes, double& simTime, std::vector<float>& out);
+/// Particle count / mode from a blob header without decoding (false if not a frame blob).
+bool peekFrame(const uint8_t* blob, size_t bytes, int& count, Mode& mode);
+
+/// LZ77 byte compressor (LZ4-style sequences, 64 KiB window). Appends to `out`.
+void lzCompress(const uint8_t* src, size_t n, std::vector<uint8_t>& out);
+/// Exact-size decompression; false unless the stream fills `dst` exactly.
+bool lzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t dstSize);
+
+/// Headless suite: lossless bit-exact round trips (odd sizes, NaN/-0/denormal
+/// patterns, empty frame), quantization error bound per block, compression-ratio
+/// report on a synthetic settling pool, truncated-blob rejection, quantized !=
+/// lossless neg-ctrl, decode throughput. Logs PASS/FAIL.
+bool runSelfTests();
+
+} // namespace krs::fcache
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "components.hpp"
+#include "FluidSequenceMesher.hpp"
 
+#include <QString>
 #include <glm/glm.hpp>
 #include <vector>
 
+class FluidCache;
+
 namespace krs {
 
 /**
@@ -17,4 +21,14 @@ namespace krs {
 bool meshFluidParticles(const std::vector<glm::vec3>& positions, float particleRadius,
                         RenderableMeshComponent& out);
 
+/**
+ * @brief Mesh every frame of a bake into dir/frame_%05d.obj with the
+ * incremental FluidSequenceMesher, frames batched across the krs::par pool.
+ * Dead particles (life <= 0) are dropped; survivors keep their buffer slot as
+ * id so incremental reuse survives the compaction. Returns false if nothing
+ * was written.
+ */
+bool exportFluidMeshSequence(const FluidCache& cache, const QString& dir, float particleRadius,
+                             FluidSequenceMesher::Stats* stats = nullptr);
+
 } // namespace krs
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace krs::par { class ThreadPool; }
+
+/**
+ * @brief Multithreaded CPU MLS-MPM backend for MpmSystem — the same substep the
+ * mpm_p2g / mpm_grid / mpm_g2p compute shaders run (quadratic B-splines,
+ * D^-1 = 4/dx^2 APIC, Tait fluid, fixed-corotated elastic/snow, stress-space
+ * Drucker-Prager sand, floor Coulomb friction), ported line for line in float so
+ * the two paths agree to within the GPU's fixed-point scatter noise. The four
+ * mpm_heat_* stages (energy scatter, normalize, harmonic-mean Fourier sweep,
+ * Shepard gather + ambient/source exchange + melt) are ported the same way, so
+ * the CPU backend needs no GL at all; only the flame-grid coupling, which reads
+ * the smoke system's 3D texture, stays on the GPU backend.
+ *
+ * Particles use the shaders' std430 layout (12 vec4), so MpmSystem uploads them
+ * into the shared particle SSBO with one memcpy when something renders them.
+ * No Qt, no GL: usable headless and from worker threads.
+ *
+ * Grid: sparse 4^3-node blocks. Occupied blocks are found by radix-sorting the
+ * particles' block keys and kept as a sorted key list with per-block neighbour
+ * slots, so there is no N^3 (or (N/4)^3) table anywhere: memory and grid work
+ * follow the material, and the domain can be as fine as kMaxGrid cells per axis.
+ * P2G scatters race-free through the 8-colour block schedule (same-colour
+ * blocks never share a node), processing each block's particles in index
+ * order; the grid update and G2P are per-node / per-particle. Every stage
+ * therefore gives bit-identical results for any krs::par thread count.
+ *
+ * The 27-node P2G scatter and G2P gather run on SSE2 where available (x86-64
+ * baseline on both compilers): one node is one vec4 (momentum + mass), so each
+ * stencil node is a single 4-lane multiply-add, with the scalar operation order
+ * kept so both paths round alike. setSimd(false) selects the scalar loops.
+ *
+ * Every reorderInterval substeps the particle array is radix-sorted by the
+ * Morton code of each particle's cell (krs::morton), so P2G/G2P walk memory in
+ * grid order instead of spawn order once the material has mixed. The sort is
+ * deterministic; particle indices are not stable across it.
+ */
+class MpmCpuSolver
+{
+public:
+    /// One particle, bit-compatible with the shader struct (see MpmSystem.cpp).
+    struct Particle {
+        glm::vec4 posMass;     // xyz world pos, w mass
+        glm::vec4 velVol;      // xyz vel, w V0
+        glm::vec4 c0, c1, c2;  // APIC C (columns)
+        glm::vec4 f0, f1, f2;  // deformation gradient F (columns)
+        glm::vec4 plastic;     // x Jp (fluid: J), y temperature, z heatCap, w meltTemp
+        glm::vec4 matl;        // solids (mu, lambda, alpha) / fluid (K, gamma, visc); w = matType
+        glm::vec4 color;       // rgb, w alive (> 0)
+        glm::vec4 therm2;      // x thermal conductivity k
+    };
+    static_assert(sizeof(Particle) == 48 * sizeof(float), "must match MpmSystem::kFloatsPerParticle");
+
+    /// Finest grid the sparse block keys address (cells per axis).
+    static constexpr int kMaxGrid = 4096;
+
+    /// The per-substep uniforms of the three shaders.
+    struct Params {
+        int N = 64;
+        glm::vec3 origin{ -1.5f };
+        float dx = 3.0f / 64.0f;
+        float dt = 1.0e-4f;
+        glm::vec3 gravity{ 0.0f, -9.81f, 0.0f };
+        int bound = 2;                // wall BC band (cells)
+        float floorFriction = 0.4f;
+        float floorStick = 0.0f;
+        float thetaC = 0.025f, thetaS = 0.0075f; // snow clamp
+        float floorY = 0.0f;          // world-y floor plane (origin.y + bound*dx)
+        float radius = 0.02f;         // particle radius (floor offset)
+        float picBlend = 0.0f;        // SAND affine APIC->PIC blend
+        float velDampRate = 0.0f;     // SAND dt-scaled velocity bleed [1/s]
+    };
+
+    /// The per-frame uniforms of the four heat shaders (no flame-grid coupling).
+    struct ThermalParams {
+        static constexpr int kMaxSources = 8;
+        float dtFrame = 1.0f / 60.0f;
+        float ambientT = 20.0f;       // ambient reservoir (C)
+        float heatExchange = 0.0f;    // Newton exchange rate with ambient (1/s)
+        float coef = 0.0f;            // Fourier face conductance scale S * dt * dx
+        float betaMax = 0.5f;         // per-cell stability cap of the explicit sweep
+        float fluidK = 5.0e4f;        // bulk modulus given to melted particles
+        int heatCount = 0;
+        glm::vec4 heatSrc[kMaxSources]{};   // xyz world pos, w nominal temperature
+        float heatRadius[kMaxSources]{};
+        float heatPower[kMaxSources]{};     // W volumetric heat generation
+    };
+
+    struct Stats {
+        int activeBlocks = 0;         // allocated 4^3-node blocks this substep
+        size_t gridBytes = 0;         // grid storage held (high-water)
+        double p2gMs = 0.0, gridMs = 0.0, g2pMs = 0.0;
+        double sortMs = 0.0;          // last Morton reorder
+        int reorders = 0;
+    };
+
+    MpmCpuSolver();
+    ~MpmCpuSolver();
+
+    /// Replace the particle set with `count` std430 particles (48 floats each).
+    void setParticles(const float* data, int count);
+    std::vector<Particle>& particles() { return m_particles; }
+    const std::vector<Particle>& particles() const { return m_particles; }
+    const float* data() const { return m_particles.empty() ? nullptr : &m_particles[0].posMass.x; }
+    int count() const { return int(m_particles.size()); }
+
+    /// One MLS-MPM substep (P2G -> grid update -> G2P).
+    void substep(const Params& p);
+    /// One thermal step on the grid of `p` (scatter -> normalize -> diffuse ->
+    /// gather + phase change), once per frame. Uses its own block grid, so the
+    /// mechanics grid (gridMass()) is left as the last substep wrote it.
+    void thermalStep(const Params& p, const ThermalParams& t);
+    const Stats& stats() const { return m_stats; }
+    /// Total grid mass after the last substep (== sum of live particle mass).
+    double gridMass() const;
+
+    /// Pool for P2G/grid/G2P (nullptr = krs::par::ThreadPool::global()).
+    void setThreadPool(krs::par::ThreadPool* pool) { m_pool = pool; }
+
+    /// SSE2 stencil loops (default on where the build has SSE2; false = scalar).
+    void setSimd(bool on);
+    bool simd() const { return m_simd; }
+
+    /// Morton-reorder the particles every `substeps` substeps (0 = keep spawn order).
+    void setReorderInterval(int substeps) { m_reorderInterval = std::max(0, substeps); }
+    int reorderInterval() const { return m_reorderInterval; }
+
+    /// Headless suite: free fall vs g*t, grid mass == particle mass (sparse blocks
+    /// cover every stencil), floor contact, sand slump, 1 vs N threads bit-identical
+    /// (+ 1-ulp neg-ctrl), a particle-throughput thread-scaling bench
+    /// (KRS_MPM_CPU_BENCH = particle count, default 262144), shuffled-vs-Morton
+    /// substep throughput, SSE2 == scalar (+ bench), heat conduction conserving
+    /// energy (+ ambient-leak neg-ctrl) and melting, and a free fall on a
+    /// 2048^3-cell domain whose grid stays material-sized. Logs PASS/FAIL.
+    static bool runSelfTests();
+
+private:
+    struct Grid;
+    void reorder(const Params& p);
+    /// Block schedule + sparse allocation of g for the current particles.
+    void schedule(Grid& g, const Params& p, krs::par::ThreadPool& pool);
+
+    std::vector<Particle> m_particles;
+    std::vector<Particle> m_sortScratch;
+    std::vector<uint64_t> m_sortKeys;
+    std::vector<uint32_t> m_sortOrder;
+    int m_reorderInterval = 32;
+    int m_sinceReorder = 0;
+    std::unique_ptr<Grid> m_grid;
+    std::unique_ptr<Grid> m_heatGrid;
+    krs::par::ThreadPool* m_pool = nullptr;
+    bool m_simd = true;
+    Stats m_stats;
+};
@@ -4,10 +4,12 @@
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 class QOpenGLFunctions_4_3_Core;
 class RenderingSystem;
+class MpmCpuSolver;
 
 /**
  * @brief GPU MLS-MPM (Moving Least Squares Material Point Method, Hu et al.
@@ -24,6 +26,11 @@ class RenderingSystem;
  *
  * The grid scatter uses int32 fixed-point atomicAdd (GL 4.3 has no float
  * atomics) — the proven pattern from the PBF impulse/compaction buffers.
+ *
+ * Backend::Cpu steps the same substep and thermal step on MpmCpuSolver
+ * (multithreaded, sparse block grid) and needs no GL: particle and thermal
+ * state live on the CPU, no grid SSBOs exist, and the particles are uploaded
+ * into the render SSBO only when a pass asks for particleBuffer(gl).
  */
 class MpmSystem
 {
@@ -32,6 +39,14 @@ public:
     // std430 particle stride: 12 vec4 (pos/mass, vel/vol, C cols x3, F cols x3,
     // plastic/thermo, material, color, therm2{k}). Keep in sync with the shaders.
     static constexpr int kFloatsPerParticle = 12 * 4;
+    // CPU backend cap: no fixed GPU grid/particle budget, memory follows the material.
+    static constexpr int kMaxParticlesCpu = 4000000;
+    // KRS_MPM_GRID caps: dense m_N^3 SSBOs on the GPU, sparse blocks on the CPU.
+    static constexpr int kMaxGridGpu = 160;
+    static constexpr int kMaxGridCpu = 4096;
+
+    MpmSystem();
+    ~MpmSystem();
 
     void initialize(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl);
     void shutdown(QOpenGLFunctions_4_3_Core* gl);
@@ -43,12 +58,24 @@ public:
 
     bool active() const { return m_initialized && m_particleCount > 0; }
     int particleCount() const { return m_particleCount; }
-    GLuint particleBuffer() const { return m_particleSSBO; }
+    // Render SSBO; on the CPU backend this uploads the stepped particles first
+    // (the only GL that backend does).
+    GLuint particleBuffer(QOpenGLFunctions_4_3_Core* gl);
     int gridN() const { return m_N; }
     glm::vec3 origin() const { return m_origin; }
     glm::vec3 extent() const { return m_size; }
     float particleRadius() const { return m_renderRadius; }
 
+    // Solver backend, switchable at runtime (live state is carried across).
+    // KRS_MPM_BACKEND=cpu (or no GL context) selects the CPU path at boot; it is
+    // also the fallback when the MPM compute shaders are unavailable. Heat and
+    // phase change run on the active backend; flame-grid heating is GPU only.
+    // Switching to the GPU clamps the grid to kMaxGridGpu.
+    enum class Backend : int { Gpu = 0, Cpu = 1 };
+    void setBackend(QOpenGLFunctions_4_3_Core* gl, Backend b);
+    Backend backend() const { return m_backend; }
+    int maxParticles() const { return m_backend == Backend::Cpu ? kMaxParticlesCpu : kMaxParticles; }
+
     // --- Visualization (Phase 3): recolor particle splats by a physics scalar.
     // The scalar is computed per-particle in the render shader (Default uses the
     // body albedo); ranges are configurable or one-shot auto-calibrated.
@@ -114,8 +141,18 @@ public:
     // magic number. Gated by KRS_FIDELITY_REPOSE_SELFTEST. Runs on the engine GL context.
     bool runReposeFidelity(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl);
 
+    // BACKEND PARITY gate -- compute shaders vs MpmCpuSolver on the same scenes: fluid/elastic/sand
+    // drop COM, closed two-block conduction (energy mean + spread) and melt fraction must agree.
+    // NEG-CTRL A: a half-speed CPU throw leaves the COM band. NEG-CTRL B: skipping the CPU thermal
+    // step leaves the spread band. Fails without GL / shaders. Gated by KRS_MPM_PARITY_SELFTEST,
+    // the overnight bench and runSelfTests Test 10.
+    bool runBackendParity(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl);
+
 private:
-    void allocate(QOpenGLFunctions_4_3_Core* gl);
+    void allocate(QOpenGLFunctions_4_3_Core* gl);   // GPU backend: particle + grid SSBOs
+    void ensureParticleBuffer(QOpenGLFunctions_4_3_Core* gl, int count);
+    void ensureGpuGrid(QOpenGLFunctions_4_3_Core* gl);
+    void releaseGpuGrid(QOpenGLFunctions_4_3_Core* gl);
     void seedBodies(QOpenGLFunctions_4_3_Core* gl, entt::registry& registry);
     void computeDomain(entt::registry& registry);
     void autoCalibrate(QOpenGLFunctions_4_3_Core* gl, bool smooth = false); // CPU min/max for the active viz mode (smooth=EMA)
@@ -125,15 +162,22 @@ private:
     void runSubstep(QOpenGLFunctions_4_3_Core* gl, class Shader* p2g, class Shader* grid,
                     class Shader* g2p, float sdt, const glm::vec3& gravity,
                     float dx, float invDx);
+    void endSubsteps(QOpenGLFunctions_4_3_Core* gl);    // unbind the substep SSBOs (GPU)
     // One thermal step (heat scatter -> normalize -> diffuse -> gather + phase
-    // change), run once per frame. No-op if thermal shaders are missing.
+    // change), run once per frame. GPU: no-op if thermal shaders are missing.
     void runThermalStep(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl, float dtFrame);
+    // Backend plumbing: seed upload (SSBO or CPU solver), state readback, and the
+    // CPU -> SSBO push behind particleBuffer(gl).
+    void uploadParticles(QOpenGLFunctions_4_3_Core* gl);
+    void readParticles(QOpenGLFunctions_4_3_Core* gl, std::vector<float>& buf);
+    void pushCpuParticles(QOpenGLFunctions_4_3_Core* gl);
 
     int m_N = 64;                       // grid cells per axis
     glm::vec3 m_origin{ -1.5f, 0.0f, -1.5f };
     glm::vec3 m_size{ 3.0f, 3.0f, 3.0f };
 
-    GLuint m_particleSSBO = 0;          // kFloatsPerParticle * kMaxParticles
+    GLuint m_particleSSBO = 0;          // kFloatsPerParticle * m_particleCapacity (created on demand)
+    int m_particleCapacity = 0;         // GPU: kMaxParticles; CPU: the drawn count
     GLuint m_gridIntSSBO = 0;           // int[cellCount*4] fixed-point momentum+mass
     GLuint m_gridVelSSBO = 0;           // vec4[cellCount] velocity + mass (float)
     GLuint m_gridThermSSBO = 0;         // int[cellCount*2] fixed-point (m*T, m)
@@ -142,6 +186,7 @@ private:
     GLuint m_gridC = 0;                 // float[cellCount] node thermal mass C (J/K)
     GLuint m_gridK = 0;                 // float[cellCount] node conductivity k (W/m.K)
     GLuint m_heatAccumSSBO = 0;         // int[kMaxHeatSources] fixed-point sum(m*c_p) per source
+    int m_gpuGridN = 0;                 // N the grid SSBOs were sized for (0 = none)
     int m_particleCount = 0;
 
     // Thermodynamics (M4 / Phase 4.5): ambient field + Newton exchange + grid
@@ -177,6 +222,10 @@ private:
     float m_renderRadius = 0.02f;       // point-sprite radius (= dx; floor-contact offset)
     std::vector<float> m_seedScratch;   // CPU staging for seeding
 
+    Backend m_backend = Backend::Gpu;
+    std::unique_ptr<MpmCpuSolver> m_cpu; // CPU backend state (particles + sparse grid)
+    bool m_gpuStale = false;            // CPU state changed since the last SSBO push
+
     Appearance m_appearance;            // Phase 3 visualization mode + ranges
     bool m_calibratePending = false;    // run a range calibration next update
     unsigned m_vizFrame = 0;            // for periodic dynamic-range recalibration
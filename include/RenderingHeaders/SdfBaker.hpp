@@ -1,9 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 
 struct Vertex; // components.hpp
+class CookedMeshCache;
 
 /// Output of an OpenVDB mesh -> signed distance field bake.
 struct SdfBakeResult {
@@ -13,11 +15,72 @@ struct SdfBakeResult {
     glm::vec3 aabbMax{ 0 };
 };
 
+/// How the dense block is filled. The level set is narrow-band either way
+/// (halfWidthVoxels on each side of the surface); outside it OpenVDB only
+/// knows +-halfWidth * voxel. The block is sampled in tile x tile x tile node
+/// tiles on the shared pool; with narrowBand, tiles no band leaf touches are
+/// filled with that constant instead of being sampled node by node.
+struct SdfBakeOptions {
+    float halfWidthVoxels = 4.0f;
+    bool narrowBand = true;
+    int tile = 8;
+    bool useCache = true;     // look up / store in sdfBakeCache()
+};
+
+/// Process-wide bake counters (sdfBakeStats()).
+struct SdfBakeStats {
+    int64_t requests = 0, hits = 0, bakes = 0, failures = 0;
+    int64_t shared = 0;                          // same key earlier in the batch
+    int64_t tilesSampled = 0, tilesFilled = 0;   // narrow band: tiles skipped as constant
+    double bakeMs = 0.0;                         // OpenVDB level set + tile sampling
+    double loadMs = 0.0;                         // hashing + mapped cache loads
+};
+
 /// Bakes a world-transformed triangle mesh into a dense SDF block.
 /// Returns false (with a warning) when OpenVDB is unavailable or the bake
 /// fails. Isolated in its own TU: OpenVDB 12 headers require /permissive-.
+///
+/// Bakes of static fixtures are cached on disk (CookedMeshCache, kind Sdf)
+/// under a key of the mesh, transform, voxel size and options, so the next
+/// session maps the finished field instead of re-baking it.
 bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
                    const std::vector<unsigned int>& indices,
                    const glm::mat4& worldTransform,
                    float voxelSize,
-                   SdfBakeResult& out);
+                   SdfBakeResult& out,
+                   const SdfBakeOptions& options = {});
+
+struct SdfBakeRequest {
+    const std::vector<Vertex>* vertices = nullptr;
+    const std::vector<unsigned int>* indices = nullptr;
+    glm::mat4 worldTransform{ 1.0f };
+    float voxelSize = 0.02f;
+};
+
+/// Bakes a batch (a scene's SDF colliders). Keys are hashed and cache entries
+/// mapped in parallel; requests with the same key are baked once; misses are
+/// then baked one after another, each tile-parallel. out[i] is left empty
+/// (field.empty()) for a failed request. Returns the number of filled results.
+int bakeMeshesToSdf(const std::vector<SdfBakeRequest>& requests,
+                    std::vector<SdfBakeResult>& out,
+                    const SdfBakeOptions& options = {});
+
+/// Cache key of one bake (mesh positions + indices, transform, voxel size, options).
+uint64_t sdfBakeKey(const std::vector<Vertex>& vertices,
+                    const std::vector<unsigned int>& indices,
+                    const glm::mat4& worldTransform,
+                    float voxelSize,
+                    const SdfBakeOptions& options);
+
+/// Shared SDF cache, in CookedMeshCache::defaultDirectory() (KRS_COOK_CACHE_DIR).
+CookedMeshCache& sdfBakeCache();
+SdfBakeStats sdfBakeStats();
+void resetSdfBakeStats();
+
+/// Temp-dir suite: tiled / parallel / narrow-band fills of an analytic field
+/// match a serial dense fill bit for bit (neg-ctrl: narrow band without the
+/// sampler-footprint margin differs), the cache payload round-trips through
+/// the mapping and refuses a wrong-sized block, the key follows every input,
+/// and a batch of repeated fixtures bakes each once, then maps them all. With
+/// OpenVDB, a cold vs warm bake is timed. Logs PASS/FAIL.
+bool runSdfBakeSelfTests();
@@ -33,6 +33,10 @@ struct SmokeParams {
  *   emit -> advect velocity -> curl -> confinement+buoyancy ->
  *   combust/cool/dissipate scalars -> divergence -> Jacobi pressure ->
  *   project (subtract gradient, free-slip walls) -> advect scalars.
+ *
+ * SmokeCpuSolver is the headless CPU reference of this pipeline (MacCormack,
+ * multigrid pressure to a residual tolerance); KRS_SMOKE_CPU_SELFTEST reports
+ * what pressureIterations Jacobi sweeps leave behind.
  */
 class SmokeSystem
 {
@@ -68,4 +68,5 @@ private:
     QLabel* m_cacheInfo = nullptr;
     QPushButton* m_clearCache = nullptr;
     QPushButton* m_meshFrame = nullptr;
+    QPushButton* m_meshSequence = nullptr;
 };
@@ -8,6 +8,8 @@
 
 #include <glm/glm.hpp>
 
+#include "CookedMeshCache.hpp"
+
 struct Vertex; // components.hpp
 
 namespace physx {
@@ -30,9 +32,13 @@ class PxConvexMesh;
  *  - Geometry is cooked UNSCALED — the entity's scale is applied at shape
  *    creation time via PxMeshScale, so one cooked mesh serves every instance
  *    at every scale.
- *  - Cooking runs on worker threads (PhysX cooking is thread-safe); only the
- *    final PxPhysics object creation is serialized. Spawn paths request
- *    cooks speculatively so the data is warm before the user presses Play.
+ *  - Cooking runs on a bounded worker pool (KRS_COOK_THREADS, default one
+ *    per core; PhysX cooking is thread-safe); only the final PxPhysics
+ *    object creation is serialized. Spawn paths request cooks speculatively
+ *    so the data is warm before the user presses Play.
+ *  - Cooked streams persist across launches in a CookedMeshCache keyed by
+ *    geometry hash + cooking parameters + PX_PHYSICS_VERSION; a hit maps the
+ *    stream and skips cooking entirely. shutdown() logs hit/miss counts.
  *
  * Lifetime: initialize() after PxPhysics exists, shutdown() before it is
  * released (waits for in-flight cooks and drops the cache references).
@@ -66,6 +72,9 @@ public:
                                const std::vector<unsigned int>& indices,
                                const std::string& debugName);
 
+    /// Disk-cache counters since startup (hits, misses, rejected entries, bytes).
+    CookedMeshCache::Stats diskCacheStats() const;
+
     static uint64_t hashGeometry(const std::vector<Vertex>& vertices,
                                  const std::vector<unsigned int>& indices);
 
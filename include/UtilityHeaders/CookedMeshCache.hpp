@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QString>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class QFile;
+
+/**
+ * @brief Content-addressed disk cache for cooked collision streams, shared by
+ * every launch. No PhysX dependency: it stores and maps opaque byte streams;
+ * CollisionCookingService decides what goes in them.
+ *
+ * One file per entry, <dir>/<kind>-<key>.kcm: a 40-byte header (magic,
+ * version, kind, key, payload size, FNV-1a of the payload) followed by the
+ * payload. The key already folds in everything that changes the cooked bytes
+ * (geometry hash, cooking parameters, PhysX version), so entries are never
+ * updated in place -- a different input is a different file. Writes go
+ * through QSaveFile (temp + rename), so a crash or a concurrent writer of the
+ * same key never leaves a torn entry; loads map the file and verify the header
+ * and checksum before handing out the bytes. A rejected entry counts as a miss
+ * and is overwritten by the next store.
+ *
+ * Thread-safe: load/store may run concurrently from any worker.
+ */
+class CookedMeshCache
+{
+public:
+    /// HullSet holds decomposition hull points (krs::HullSet layout) -- the
+    /// expensive V-HACD output, PhysX-independent, so keyed without a version.
+    /// Sdf holds a baked signed distance field (SdfBaker's payload layout).
+    enum class Kind : uint32_t { TriangleMesh = 1, ConvexHull = 2, Decomposition = 3, HullSet = 4, Sdf = 5 };
+
+    struct Stats {
+        int64_t hits = 0, misses = 0, rejected = 0, stores = 0, storeFailures = 0;
+        int64_t bytesRead = 0, bytesWritten = 0;
+    };
+
+    /// A mapped entry; the mapping lives as long as the last reference.
+    class Blob {
+    public:
+        ~Blob();
+        const unsigned char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+    private:
+        friend class CookedMeshCache;
+        std::unique_ptr<QFile> m_file;
+        unsigned char* m_map = nullptr;
+        const unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    CookedMeshCache();
+    ~CookedMeshCache();
+
+    /// Empty = disabled (every load misses, stores are dropped).
+    void setDirectory(const QString& dir);
+    QString directory() const;
+    bool enabled() const;
+    /// KRS_COOK_CACHE_DIR, else ./cookcache; empty when KRS_COOK_CACHE=0.
+    static QString defaultDirectory();
+
+    /// Cache key of one cooked result.
+    static uint64_t key(uint64_t geometryHash, Kind kind, uint64_t paramsHash, uint32_t physxVersion);
+    /// FNV-1a 64 (parameter blocks, payload checksums).
+    static uint64_t hash(const void* data, size_t bytes, uint64_t seed = 14695981039346656037ull);
+
+    /// Mapped payload of (kind, key), or nullptr on a miss / rejected entry.
+    std::shared_ptr<const Blob> load(Kind kind, uint64_t key);
+    bool store(Kind kind, uint64_t key, const void* data, size_t bytes);
+    QString entryPath(Kind kind, uint64_t key) const;
+
+    /// Map a whole file with no entry header (offline assets in a mappable
+    /// layout, e.g. CoACD parts). nullptr if it cannot be opened or is empty.
+    static std::shared_ptr<const Blob> mapFile(const QString& path);
+
+    Stats stats() const;
+    void resetStats();
+
+    /// Temp-dir suite: round trip through the mapping, key sensitivity to every
+    /// input, truncated / bit-flipped / wrong-key entries rejected (neg-ctrl: a
+    /// header-only check would accept the bit flip), concurrent same-key
+    /// stores, and a parallel cold-vs-warm pass over synthetic "cooks" with
+    /// hit/miss counts. Logs PASS/FAIL.
+    static bool runSelfTests();
+
+private:
+    struct Dir;
+    std::unique_ptr<Dir> m_dir;
+    std::atomic<int64_t> m_hits{ 0 }, m_misses{ 0 }, m_rejected{ 0 }, m_stores{ 0 }, m_storeFailures{ 0 };
+    std::atomic<int64_t> m_bytesRead{ 0 }, m_bytesWritten{ 0 };
+};
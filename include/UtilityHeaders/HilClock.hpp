@@ -56,6 +56,57 @@ private:
     std::atomic<uint64_t> m_seq{ 0 };
 };
 
+/// Lock-free SPSC FIFO for commands into a fixed-rate thread. push() fails
+/// (nothing is dropped silently) when the consumer is Capacity behind.
+template <typename T, size_t Capacity = 1024>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    bool push(const T& v) {                                 // producer
+        const uint64_t h = m_head.load(std::memory_order_relaxed);
+        if (h - m_tail.load(std::memory_order_acquire) == Capacity) return false;
+        m_slots[h & (Capacity - 1)] = v;
+        m_head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& out) {                                      // consumer
+        const uint64_t t = m_tail.load(std::memory_order_relaxed);
+        if (t == m_head.load(std::memory_order_acquire)) return false;
+        out = m_slots[t & (Capacity - 1)];
+        m_tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+private:
+    std::array<T, Capacity> m_slots{};
+    alignas(64) std::atomic<uint64_t> m_head{ 0 };
+    alignas(64) std::atomic<uint64_t> m_tail{ 0 };
+};
+
+/// Lock-free latest-value hand-off for state too big or too variable for
+/// StateRing (vectors of bodies): a double buffer with a third slot in the
+/// middle, so neither side ever waits. The writer fills back() and publish()es
+/// it; the reader's update() takes the newest published slot as front() when
+/// there is one. Slots are reused, so steady-state publishing does not allocate.
+template <typename T>
+class TripleBuffer {
+public:
+    T& back() { return m_slots[m_back]; }                   // writer
+    void publish() {
+        m_back = m_middle.exchange(uint8_t(m_back | kFresh), std::memory_order_acq_rel) & kIndex;
+    }
+    bool update() {                                         // reader: true when front() changed
+        if (!(m_middle.load(std::memory_order_acquire) & kFresh)) return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+    const T& front() const { return m_slots[m_front]; }
+private:
+    static constexpr uint8_t kIndex = 3, kFresh = 4;
+    std::array<T, 3> m_slots{};
+    uint8_t m_back = 0, m_front = 1;
+    std::atomic<uint8_t> m_middle{ 2 };
+};
+
 /// Scheduling-jitter statistics for the deterministic physics loop.
 struct JitterStats {
     int    ticks = 0;
@@ -73,6 +124,44 @@ struct JitterStats {
 JitterStats runJitterBench(int ticks, double hz,
                            const std::function<void(uint64_t, double)>& step = {});
 
+/// Percentile summary of per-tick |interval - nominal| deviations (sorts `deviationsMs`).
+JitterStats summarizeJitter(std::vector<double>& deviationsMs, double nominalMs);
+
+/**
+ * @brief Calls `tick(k, dt)` on a dedicated thread at a fixed rate, with the
+ * sleep-then-spin deadline wait runJitterBench measures. Deadlines are absolute
+ * (t0 + k * period), so a late tick does not shift the ones after it; after
+ * more than `maxCatchUp` missed periods the schedule re-anchors to now instead
+ * of bursting. Interval deviations go into a ring of the last minute of ticks
+ * (at most 2^20), allocated once in start(), plus a running count/sum/max over
+ * the whole run; stop() summarizes them (percentiles over the ring window).
+ */
+class FixedRateThread {
+public:
+    using TickFn = std::function<void(uint64_t tick, double dt)>;
+
+    ~FixedRateThread() { stop(); }
+    void start(double hz, TickFn tick, int maxCatchUp = 32);
+    JitterStats stop();                                     // joins; stats over the run
+    // Both are read from the tick thread too, so they go through m_id, never m_thread
+    // (start() move-assigns m_thread while the new thread may already be ticking).
+    bool running() const { return m_id.load(std::memory_order_acquire) != std::thread::id(); }
+    bool onThread() const { return std::this_thread::get_id() == m_id.load(std::memory_order_acquire); }
+    uint64_t ticks() const { return m_ticks.load(std::memory_order_acquire); }
+    uint64_t reanchors() const { return m_reanchors.load(std::memory_order_acquire); }
+
+private:
+    std::thread m_thread;
+    std::atomic<std::thread::id> m_id{};                   // id of the tick thread, {} when stopped
+    std::atomic<bool> m_run{ false };
+    std::atomic<uint64_t> m_ticks{ 0 }, m_reanchors{ 0 };
+    std::vector<double> m_ringMs;                          // last m_ringMs.size() deviations
+    size_t m_ringHead = 0;
+    uint64_t m_devCount = 0;                               // deviations recorded (whole run)
+    double m_devSumMs = 0.0, m_devMaxMs = 0.0;
+    double m_nominalMs = 0.0;
+};
+
 /// HIL_JITTER verification module: 10,000 ticks @ 1000 Hz. Pass gate is p99.9 < 1.0 ms
 /// (+ a max < 100 ms catastrophic-hang guard) — outlier-robust on a non-RT host, where
 /// a lone scheduler hiccup must not false-fail; the true 0.15 ms target requires a
@@ -97,7 +186,8 @@ public:
 
 private:
     StateRing<PlantState> m_ring;
-    std::thread m_physThread, m_sensorThread;
+    FixedRateThread m_physThread;
+    std::thread m_sensorThread;
     std::atomic<bool> m_run{ false };
     JitterStats m_jitter;
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace krs {
+
+/// A set of convex-part point clouds (one V-HACD or CoACD decomposition),
+/// viewed in place over a byte buffer -- a mapped file or a disk-cache entry.
+///
+/// Layout ("COAC", the format scripts/gen_coacd.py writes, little-endian):
+///   "COAC" | u32 numParts | per part { u32 numVerts ; float32[3] * numVerts }
+/// Every field is 4 bytes wide, so at any 4-aligned base each part's points
+/// are a ready glm::vec3 array: opening a set maps the file and records one
+/// (pointer, count) per part -- nothing is copied or parsed per vertex.
+class HullSet
+{
+public:
+    struct Part {
+        const glm::vec3* points = nullptr;
+        uint32_t count = 0;
+    };
+
+    /// Serialize hulls in the layout above (parts with no points are skipped).
+    static std::vector<unsigned char> encode(const std::vector<std::vector<glm::vec3>>& hulls);
+
+    /// View `bytes` in place; `owner` keeps them alive for the set's lifetime.
+    /// False (and empty) on a short, corrupt or misaligned buffer.
+    bool view(std::shared_ptr<const void> owner, const unsigned char* bytes, size_t size);
+    /// Map a file and view it.
+    bool open(const QString& path);
+
+    bool empty() const { return m_parts.empty(); }
+    size_t size() const { return m_parts.size(); }
+    const Part& operator[](size_t i) const { return m_parts[i]; }
+    const std::vector<Part>& parts() const { return m_parts; }
+    size_t totalPoints() const;
+    std::vector<std::vector<glm::vec3>> toVectors() const;
+
+    /// Temp-dir suite: encode -> map round trip bit-exact, parts equal to the
+    /// legacy ifstream reader on a gen_coacd-layout file (neg-ctrl: the
+    /// compare catches a one-ulp change in one point), truncated / inflated
+    /// counts / bad magic rejected, and open() vs the copying reader timed on
+    /// a large set. Logs PASS/FAIL.
+    static bool runSelfTests();
+
+private:
+    std::shared_ptr<const void> m_owner;
+    std::vector<Part> m_parts;
+};
+
+} // namespace krs
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace krs::par { class ThreadPool; }
+
+/**
+ * @brief Z-order (Morton) particle sorting for the CPU particle paths. No Qt,
+ * no GL.
+ *
+ * radixSort() is a stable LSD radix sort of 64-bit keys (8-bit digits, only as
+ * many passes as the widest key needs; keys of at most 16 bits take a single
+ * counting pass). Per-chunk histograms are combined in chunk order, so the
+ * result is identical for any krs::par thread count.
+ *
+ * CellTable bins points into cubic cells, sorts them by the cells' Morton codes
+ * and keeps a compact cell-start table: occupied cells in Morton order, the
+ * first sorted slot of each cell, and an open-addressed hash from cell to
+ * table row. A radius query visits the 27 cells around the point. Callers that
+ * gather their own arrays into order() get spatially coherent memory for both
+ * the query loop and the neighbour reads; adoptOrder() then makes the table
+ * refer to the gathered arrays without re-sorting.
+ */
+namespace krs::morton {
+
+/// Interleave the low 21 bits of each axis (x in bit 0).
+uint64_t encode(uint32_t x, uint32_t y, uint32_t z);
+glm::uvec3 decode(uint64_t code);
+
+/// Stable ascending sort; on return order[k] is the input index of keys[k].
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order, krs::par::ThreadPool* pool = nullptr);
+
+/// Morton codes of the cells (edge `cellSize`, corner `origin`) holding `count`
+/// points read as xyz triples every `strideFloats` floats. Coordinates below
+/// the origin clamp to cell 0.
+void cellKeys(const float* xyz, size_t strideFloats, size_t count, const glm::vec3& origin, float cellSize,
+              std::vector<uint64_t>& keys, krs::par::ThreadPool* pool = nullptr);
+
+/// data[k] = old data[order[k]]; scratch is reused between calls.
+template <class T>
+void gather(std::vector<T>& data, const std::vector<uint32_t>& order, std::vector<T>& scratch)
+{
+    scratch.resize(order.size());
+    for (size_t k = 0; k < order.size(); ++k) scratch[k] = data[order[k]];
+    data.swap(scratch);
+}
+
+class CellTable
+{
+public:
+    /// Bin and sort `count` points (xyz every `strideFloats` floats).
+    void build(const float* xyz, size_t strideFloats, size_t count, float cellSize,
+               krs::par::ThreadPool* pool = nullptr);
+    /// The caller gathered its arrays into order(): slots now index them directly.
+    void adoptOrder();
+
+    /// Sorted slot -> index into the arrays passed to build().
+    const std::vector<uint32_t>& order() const { return m_order; }
+    size_t cells() const { return m_cellKey.size(); }
+    size_t points() const { return m_order.size(); }
+    float cellSize() const { return m_cellSize; }
+    /// World corner of cell (0, 0, 0).
+    const glm::vec3& origin() const { return m_origin; }
+
+    glm::ivec3 cellOf(const glm::vec3& p) const;
+    /// Sorted slots [first, second) of cell c (empty when unoccupied).
+    std::pair<uint32_t, uint32_t> cellRange(const glm::ivec3& c) const;
+
+    /// fn(index, dist2) for every point within `radius` of p. Requires
+    /// radius <= cellSize(); positions are the arrays build() saw (or their
+    /// gathered copies after adoptOrder()).
+    template <class Fn>
+    void forEachNeighbor(const float* xyz, size_t strideFloats, const glm::vec3& p, float radius, Fn&& fn) const
+    {
+        const glm::ivec3 c = cellOf(p);
+        const float r2 = radius * radius;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const auto range = cellRange(c + glm::ivec3(dx, dy, dz));
+                    for (uint32_t k = range.first; k < range.second; ++k) {
+                        const uint32_t j = m_identity ? k : m_order[k];
+                        const float* q = xyz + size_t(j) * strideFloats;
+                        const glm::vec3 d(q[0] - p.x, q[1] - p.y, q[2] - p.z);
+                        const float d2 = glm::dot(d, d);
+                        if (d2 <= r2) fn(j, d2);
+                    }
+                }
+    }
+
+    /// Headless suite: radix sort == std::stable_sort, 1 vs N threads identical,
+    /// neighbour sets == brute force (+ under-sized cell neg-ctrl), and a
+    /// neighbour-search throughput report in spawn order vs Morton order
+    /// (KRS_MORTON_BENCH = particle count, default 262144). Logs PASS/FAIL.
+    static bool runSelfTests();
+
+private:
+    glm::vec3 m_origin{ 0.0f };
+    float m_cellSize = 1.0f, m_invCell = 1.0f;
+    bool m_identity = false;
+    std::vector<uint64_t> m_keys;        // per sorted slot
+    std::vector<uint32_t> m_order;
+    std::vector<uint64_t> m_cellKey;     // occupied cells, ascending Morton
+    std::vector<uint32_t> m_cellStart;   // cells() + 1 entries
+    std::vector<uint32_t> m_hash;        // cell row + 1 (0 = empty), power-of-two size
+    int m_hashBits = 0;
+};
+
+} // namespace krs::morton
@@ -47,8 +47,28 @@ struct Config {
     double dt = 1.0e-3;          // substep (s)
     int steps = 24;              // substeps per rollout
     int bound = 2;               // wall BC band (cells)
+    // Reverse-pass memory budget: particle-state snapshots held at once (incl. the
+    // initial state). 0 or >= steps = full tape (one snapshot per substep); fewer ->
+    // binomial (Revolve) checkpointing, recomputing forward substeps on reverse.
+    int checkpoints = 0;
 };
 
+/// Cost of one reverse sweep (tape vs checkpointed). Recomputation replays the
+/// exact forward arithmetic, so a checkpointed gradient is bit-identical.
+struct CheckpointStats {
+    int steps = 0;                  // rollout substeps
+    int snapshots = 0;              // peak particle-state snapshots held
+    long long forwardSteps = 0;     // stepForward calls incl. the primal sweep
+    long long backwardSteps = 0;
+    size_t peakStateBytes = 0;      // snapshots * particles * sizeof(Particle)
+    double seconds = 0.0;
+    size_t processPeakRssBytes = 0; // process-wide peak RSS after the sweep (monotone)
+    double recomputeOverhead() const { return steps ? double(forwardSteps) / steps - 1.0 : 0.0; }
+};
+
+/// Snapshot count that fits `bytes` of reverse-pass state for `particles` particles (>= 1).
+int checkpointsForBudget(size_t bytes, size_t particles);
+
 /// SVD F = U diag(sigma) V^T with U,V proper rotations and the reflection sign
 /// pushed onto the smallest singular value (so U*diag(sigma)*V^T == F exactly).
 void svd3(const mat3& F, mat3& U, vec3& sigma, mat3& V);
@@ -80,10 +100,56 @@ struct StressEval {
 StressEval evaluatePeakStress(double accel, double youngsE, double nu,
                               double density, double yieldStress);
 
+/// Batched material-parameter sweep: one initial particle layout, many
+/// (E, nu, friction) samples. Each sample rolls out cfg.steps substeps and returns
+/// L = 0.5 sum_p |x_p - target_p|^2 with its gradient. Samples are spread over the
+/// krs::par pool; each worker keeps one simulator (grids, tape, adjoint buffers)
+/// and reuses it for its contiguous slice, so results do not depend on the thread
+/// count and match an isolated rollout bit for bit.
+struct SweepSetup {
+    Config cfg;
+    std::vector<Particle> particles; // initial state; mu/lambda/alpha overwritten per sample
+    std::vector<vec3> target;        // per-particle target positions (size == particles)
+};
+struct MaterialSample {
+    double youngsE = 1.0e4;     // Pa
+    double nu = 0.2;            // Poisson ratio
+    double frictionDeg = 35.0;  // Drucker-Prager friction angle (sand particles only)
+};
+struct SweepResult {
+    double loss = 0.0;
+    double dLdE = 0.0, dLdNu = 0.0, dLdFriction = 0.0; // friction per degree
+    vec3 dLdv0{ 0.0 };          // sum of initial-velocity adjoints (uniform-v0 control)
+};
+struct SweepStats {
+    int samples = 0;
+    unsigned threads = 1;
+    double seconds = 0.0;
+    double samplesPerSec = 0.0;
+};
+std::vector<SweepResult> runParameterSweep(const SweepSetup& setup, const std::vector<MaterialSample>& samples,
+                                           SweepStats* stats = nullptr);
+
 /// Headless verification suite hooks (Task 3 modules).
 bool runSelfTests();              // runs all adjoint checks, logs PASS/FAIL
 GradCheck checkSvdAdjoint();      // standalone SVD-adjoint FD check
 GradCheck checkElasticGradient(); // dL/dv0 of a deforming elastic block, <1e-5
 GradCheck checkSandGradient();    // Drucker-Prager return-map adjoint check
+GradCheck checkMaterialGradient(); // dL/dE, dL/dnu, dL/dfriction of the sweep loss vs FD
+/// Checkpointed vs full-tape dL/dv0 of an elastic block (side^3 particles) over a
+/// `steps`-substep rollout with `checkpoints` snapshots. pass = agreement to 1e-9.
+GradCheck checkCheckpointedGradient(int steps, int checkpoints, int side = 4,
+                                    CheckpointStats* tape = nullptr, CheckpointStats* ckpt = nullptr);
+
+/// Thread scaling of one forward + reverse gradient sweep over an elastic block of
+/// side^3 particles. P2G and the adjoint G2P scatter through a fixed colour/block
+/// schedule, so every thread count must reproduce the 1-thread result bit for bit.
+struct ScalingPoint {
+    unsigned threads = 1;
+    double seconds = 0.0;
+    double speedup = 1.0;      // vs the first entry
+    bool bitIdentical = false; // final state + initial-state adjoints == first entry
+};
+std::vector<ScalingPoint> benchmarkThreadScaling(int side, int steps, const std::vector<unsigned>& threads);
 
 } // namespace krs::mpmad
@@ -9,7 +9,12 @@
 //   2. the orb<->node binding lifecycle on an entt::registry (decorate / find /
 //      remove / count) -- so spawning, colour assignment, and bidirectional
 //      deletion are gateable without the QtNodes graph or a window.
+//   3. ProbeIndex -- the same query against a uniform-grid spatial hash built
+//      once per step, so N probes cost N x (particles near the probe) instead
+//      of N x (all particles).
 // ===========================================================================
+#include "MortonSort.hpp"
+
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
 #include <vector>
@@ -29,6 +34,46 @@ OrbVelocity averageVelocityInSphere(const std::vector<glm::vec3>& positions,
                                     const std::vector<glm::vec3>& velocities,
                                     const glm::vec3& center, float radius);
 
+// Uniform-grid spatial hash over ONE step's particles: built once, then each probe fetches only the
+// cells its sphere overlaps. The answer is bit-for-bit the brute-force averageVelocityInSphere on the
+// same arrays (contained particles are summed in ascending index order, exactly like the linear scan);
+// a probe whose sphere spans more cells than are occupied simply runs that scan.
+class ProbeIndex {
+public:
+    // Takes the step's arrays (same pairing / alive-filter contract as averageVelocityInSphere).
+    // cellSize ~ the smallest probe radius keeps every query to a handful of cells. The sort runs on
+    // `pool` when given; the result does not depend on its size.
+    void build(std::vector<glm::vec3> positions, std::vector<glm::vec3> velocities, float cellSize,
+               krs::par::ThreadPool* pool = nullptr);
+    OrbVelocity averageVelocityInSphere(const glm::vec3& center, float radius) const;
+
+    size_t size() const { return m_pos.size(); }
+    size_t cells() const { return m_table.cells(); }
+    const krs::morton::CellTable& table() const { return m_table; }
+    const std::vector<glm::vec3>& positions() const { return m_pos; }
+    const std::vector<glm::vec3>& velocities() const { return m_vel; }
+    // Cells fetched / particles distance-tested by the last query (bench + gate).
+    size_t lastCellsFetched() const { return m_lastCells; }
+    size_t lastParticlesTested() const { return m_lastTested; }
+
+private:
+    std::vector<glm::vec3> m_pos, m_vel;            // caller order (the scan's summation order)
+    std::vector<glm::vec3> m_sortedPos;              // cell order: one probe reads contiguous runs
+    krs::morton::CellTable m_table;
+    glm::ivec3 m_cellMax{ -1 };
+    mutable std::vector<uint32_t> m_hits;            // caller indices of the contained particles
+    mutable size_t m_lastCells = 0, m_lastTested = 0;
+};
+
+// Headless gate for ProbeIndex (no GL): synthetic clouds (uniform + clustered) with probes inside,
+// straddling, off-cloud, empty and larger than the cloud must equal the brute-force scan bit for bit;
+// NEG-CTRL: summing hits in cell order instead of index order is caught by the bitwise compare.
+// A lattice on the cell faces (points binned a few ulps outside their rebuilt cell box) must match
+// too; NEG-CTRL: the un-inflated closest-point cull drops such a point's cell for some probe.
+// Reports the scan vs the index (build included) and the probe count where the build pays off; speed
+// is reported, not gated (it depends on the cloud/probe ratio and the core count). Prints PASS/FAIL.
+bool runProbeIndexSelfTest(int particles = 200000, int probes = 64);
+
 // Attach the probe-orb components to an existing entity (the runtime first spawns a glass IcoSphere
 // mesh via SceneBuilder, then calls this; the gate calls it on a bare entity). Emplaces/updates a
 // TransformComponent (center, scale = radius), a GlassComponent tinted by color, and the
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Shared CPU worker pool for the headless solvers (FEM, MPM, fluid
+ * post-processing). No Qt, no GL: usable from worker threads and self-tests.
+ *
+ * Work is split into FIXED chunks whose boundaries depend only on the range and
+ * the grain, never on the thread count, so any per-chunk partial result that is
+ * combined in chunk order (see reduce()) is bit-identical for 1..N threads.
+ * The calling thread participates; a run() issued from inside a pool job runs
+ * inline (no nested fan-out, no deadlock).
+ */
+namespace krs::par {
+
+class ThreadPool {
+public:
+    /// `threads` = total participants including the caller (0 = hardware concurrency).
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 1; t < threads; ++t)
+            m_workers.emplace_back([this]() { workerLoop(); });
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        for (std::thread& w : m_workers) w.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(m_workers.size()) + 1; }
+
+    /// While alive, run() from this thread executes inline, as from inside a job. For threads
+    /// that are already one of several parallel workers (RL rollout workers) and would
+    /// otherwise queue behind each other for the pool.
+    class InlineScope {
+    public:
+        InlineScope() : m_outer(tl_inPool()) { tl_inPool() = true; }
+        ~InlineScope() { tl_inPool() = m_outer; }
+        InlineScope(const InlineScope&) = delete;
+        InlineScope& operator=(const InlineScope&) = delete;
+    private:
+        bool m_outer;
+    };
+
+    /// Run fn(chunk) for chunk in [0, chunks); returns when every chunk is done.
+    void run(size_t chunks, const std::function<void(size_t)>& fn) {
+        if (chunks == 0) return;
+        if (tl_inPool() || m_workers.empty() || chunks == 1) {
+            for (size_t c = 0; c < chunks; ++c) fn(c);
+            return;
+        }
+        std::lock_guard<std::mutex> runLock(m_runMutex);   // one job at a time
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_job = &fn;
+            m_chunks.store(chunks, std::memory_order_relaxed);
+            m_done.store(0, std::memory_order_relaxed);
+            m_next.store(0, std::memory_order_release);      // publishes job/chunks to late workers
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_finished.wait(lk, [&]() { return m_done.load(std::memory_order_acquire) == chunks; });
+        m_next.store(kIdle, std::memory_order_relaxed);      // a worker waking late sees no work
+        m_job = nullptr;
+    }
+
+    /// Process-wide pool. Size = KRS_THREADS if set, else hardware concurrency.
+    static ThreadPool& global() {
+        static ThreadPool pool([]() -> unsigned {
+            if (const char* s = std::getenv("KRS_THREADS")) return unsigned(std::max(1, std::atoi(s)));
+            return 0u;
+        }());
+        return pool;
+    }
+
+private:
+    static constexpr size_t kIdle = ~size_t(0) / 2;
+
+    static bool& tl_inPool() { thread_local bool in = false; return in; }
+
+    void drain() {
+        const bool outer = tl_inPool();
+        tl_inPool() = true;
+        for (;;) {
+            const size_t c = m_next.fetch_add(1, std::memory_order_acq_rel);
+            const size_t chunks = m_chunks.load(std::memory_order_relaxed);
+            if (c >= chunks) break;
+            (*m_job)(c);
+            if (m_done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                m_finished.notify_all();
+            }
+        }
+        tl_inPool() = outer;
+    }
+
+    void workerLoop() {
+        unsigned long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_wake.wait(lk, [&]() { return m_generation != seen; });
+                seen = m_generation;
+                if (m_stop) return;
+                if (!m_job) continue;
+            }
+            drain();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex, m_runMutex;
+    std::condition_variable m_wake, m_finished;
+    const std::function<void(size_t)>* m_job = nullptr;
+    std::atomic<size_t> m_chunks{ 0 }, m_next{ kIdle }, m_done{ 0 };
+    unsigned long long m_generation = 0;
+    bool m_stop = false;
+};
+
+/// Number of fixed chunks [0, n) splits into at `grain` items per chunk.
+inline size_t chunkCount(size_t n, size_t grain) {
+    grain = std::max<size_t>(1, grain);
+    return (n + grain - 1) / grain;
+}
+
+/// fn(lo, hi) over fixed chunks of [0, n).
+template <class Fn>
+void parallelFor(ThreadPool& pool, size_t n, size_t grain, Fn&& fn) {
+    grain = std::max<size_t>(1, grain);
+    pool.run(chunkCount(n, grain), [&](size_t c) {
+        const size_t lo = c * grain;
+        fn(lo, std::min(n, lo + grain));
+    });
+}
+template <class Fn>
+void parallelFor(size_t n, size_t grain, Fn&& fn) {
+    parallelFor(ThreadPool::global(), n, grain, std::forward<Fn>(fn));
+}
+
+/// Deterministic sum: per-chunk partials fn(lo, hi) -> T, added in chunk order.
+template <class T, class Fn>
+T reduce(ThreadPool& pool, size_t n, size_t grain, T init, Fn&& fn) {
+    std::vector<T> part(chunkCount(n, grain), T{});
+    grain = std::max<size_t>(1, grain);
+    pool.run(part.size(), [&](size_t c) {
+        const size_t lo = c * grain;
+        part[c] = fn(lo, std::min(n, lo + grain));
+    });
+    for (const T& p : part) init += p;
+    return init;
+}
+template <class T, class Fn>
+T reduce(size_t n, size_t grain, T init, Fn&& fn) {
+    return reduce<T>(ThreadPool::global(), n, grain, init, std::forward<Fn>(fn));
+}
+
+} // namespace krs::par
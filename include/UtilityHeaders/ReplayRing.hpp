@@ -0,0 +1,133 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Fixed-layout ring buffer of RL transitions for off-policy learning
+ * (the storage behind the ReplayBuffer component).
+ *
+ * Every field is one contiguous array of fixed row width, so an insert is a
+ * few memcpys and a minibatch gather reads whole rows:
+ *
+ *   header   "KRRB" | u32 version | u32 obsDim | u32 actDim | u64 capacity
+ *            | u64 written (transitions ever added) | pad to 64 B
+ *   obs      capacity x obsDim  f32
+ *   action   capacity x actDim  f32
+ *   reward   capacity           f32
+ *   nextObs  capacity x obsDim  f32
+ *   done     capacity           u8
+ *   priority capacity           f32  (already raised to alpha)
+ *
+ * Each array starts on a 64-byte boundary. The block lives in memory or in a
+ * file mapped read-write. A file-backed ring survives restarts: open() resumes
+ * at the stored write position. Another process can open() the same file
+ * read-only and sample while this one writes. `written` is published with
+ * release order after the slot's fields, so a reader never sees a slot before
+ * its data. There are no per-slot locks: a reader can still catch a slot while
+ * the writer laps it and overwrites it.
+ *
+ * Sampling fills a Batch of contiguous row-major arrays. Prioritized sampling
+ * is proportional (p^alpha / sum) through a sum-tree over the slots,
+ * stratified over the batch, with importance weights (N * P)^-beta normalized
+ * by the batch maximum. New transitions get the highest priority seen so far.
+ * One writer; sampling may run on several threads when no add() or
+ * updatePriorities() runs at the same time.
+ */
+namespace krs::rl {
+
+class ReplayRing
+{
+public:
+    /// One minibatch, row-major, reused between calls (no allocation once sized).
+    struct Batch {
+        std::vector<uint64_t> indices;
+        std::vector<float> obs, actions, rewards, nextObs, weights;
+        std::vector<uint8_t> dones;
+    };
+
+    ReplayRing();
+    ~ReplayRing();
+    ReplayRing(const ReplayRing&) = delete;
+    ReplayRing& operator=(const ReplayRing&) = delete;
+
+    bool create(uint32_t obsDim, uint32_t actDim, uint64_t capacity);                       // in memory
+    bool create(const QString& path, uint32_t obsDim, uint32_t actDim, uint64_t capacity);  // file, truncated
+    /// Resume a file-backed ring, or attach to one another process writes (readOnly).
+    bool open(const QString& path, bool readOnly = false);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    bool readOnly() const { return m_readOnly; }
+
+    uint32_t obsDim() const { return m_obsDim; }
+    uint32_t actDim() const { return m_actDim; }
+    uint64_t capacity() const { return m_capacity; }
+    uint64_t written() const;                     // transitions ever added
+    uint64_t size() const;                        // min(written, capacity)
+    size_t bytes() const { return m_bytes; }
+
+    /// Append one transition, overwriting the oldest when full. Returns its slot.
+    uint64_t add(const float* obs, const float* action, float reward, const float* nextObs, bool done);
+    /// Append `count` transitions given as row-major arrays.
+    void addBatch(size_t count, const float* obs, const float* actions, const float* rewards,
+                  const float* nextObs, const uint8_t* dones);
+
+    void sampleUniform(size_t batchSize, uint64_t seed, Batch& out) const;
+    void samplePrioritized(size_t batchSize, float beta, uint64_t seed, Batch& out) const;
+    /// p = (|tdError| + epsilon)^alpha for each sampled slot.
+    void updatePriorities(const uint64_t* indices, const float* tdErrors, size_t count);
+    void setAlpha(float alpha) { m_alpha = alpha; }
+    void setEpsilon(float epsilon) { m_epsilon = epsilon; }
+    /// Rebuild the sum-tree from the stored priorities (a reader after the writer updated them).
+    void refresh();
+
+    const float* obs(uint64_t slot) const { return m_obs + slot * m_obsDim; }
+    const float* action(uint64_t slot) const { return m_act + slot * m_actDim; }
+    float reward(uint64_t slot) const { return m_reward[slot]; }
+    const float* nextObs(uint64_t slot) const { return m_next + slot * m_obsDim; }
+    bool done(uint64_t slot) const { return m_done[slot] != 0; }
+    float priority(uint64_t slot) const { return m_priority[slot]; }
+
+    /// PhysX-free suite: field round trip and wrap-around, file persistence and a
+    /// concurrent read-only attach, sum-tree sampling frequencies vs priorities
+    /// (neg-ctrl: uniform does not match them), IS weights, and insert/sample
+    /// throughput vs the old deque-of-vectors buffer. Logs PASS/FAIL.
+    static bool runSelfTests();
+
+private:
+    struct Header;
+    bool layout(unsigned char* base, uint32_t obsDim, uint32_t actDim, uint64_t capacity);
+    static size_t blockBytes(uint32_t obsDim, uint32_t actDim, uint64_t capacity);
+    std::atomic<uint64_t>& writtenCounter() const;
+    void setPriority(uint64_t slot, float p);
+    void gather(Batch& out) const;
+    void resize(Batch& out, size_t batchSize) const;
+
+    std::unique_ptr<uint64_t[]> m_memory;         // in-memory block
+    std::unique_ptr<QFile> m_file;                // file-backed block
+    unsigned char* m_base = nullptr;
+    size_t m_bytes = 0;
+    bool m_readOnly = false;
+
+    uint32_t m_obsDim = 0, m_actDim = 0;
+    uint64_t m_capacity = 0;
+    float* m_obs = nullptr;
+    float* m_act = nullptr;
+    float* m_reward = nullptr;
+    float* m_next = nullptr;
+    uint8_t* m_done = nullptr;
+    float* m_priority = nullptr;
+
+    std::vector<double> m_tree;                   // sum-tree, leaves at [m_leaves, 2 m_leaves)
+    uint64_t m_leaves = 0;
+    float m_maxPriority = 1.0f;
+    float m_alpha = 0.6f, m_epsilon = 1e-6f;
+};
+
+} // namespace krs::rl
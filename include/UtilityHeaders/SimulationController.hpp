@@ -5,10 +5,15 @@
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <array>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "HilBridges.hpp"
+#include "HilClock.hpp"
+#include "SimReplay.hpp"
 #include "ArticulationSpec.hpp"   // Phase G: live FANUC articulation spec (POD)
 
 class Scene;
@@ -28,6 +33,8 @@ enum class SimulationState { Stopped, Playing, Paused };
  *
  * Stepping uses a fixed timestep with an accumulator: rendering rate and
  * physics rate stay decoupled. tick() is called from the master timer.
+ * In threaded mode (setThreaded) the fixed steps run on a dedicated sim
+ * thread instead, and tick() only exchanges commands and state with it.
  */
 class SimulationController : public QObject
 {
@@ -106,6 +113,55 @@ public:
     /// Per-frame Δv is clamped for stability.
     void applyFluidImpulse(entt::entity entity, const glm::vec3& impulse);
 
+    // Deterministic replay (SimReplay.hpp). startRecording arms a log while stopped; from the next
+    // play()/singleStep() every input the world consumes (user teleports, kinematic targets,
+    // articulation commands, CAN frames, live edits, spawns, fluid impulses) and the state hash
+    // after every fixed step are written to it, until stop(). KRS_REPLAY_RECORD=<path> arms it on
+    // every play. replay() rebuilds the world from the CURRENT scene (the one the log was recorded
+    // from), feeds it the logged inputs step by step and stops at the first step whose hash
+    // differs, naming the bodies. Spawned bodies are recreated under their logged entity id and
+    // destroyed again when the replay ends. `beforeStep` runs before each replayed step (fault
+    // injection).
+    bool startRecording(const QString& path);
+    void stopRecording();
+    bool isRecording() const { return m_recorder != nullptr || !m_recordPath.isEmpty(); }
+    krs::replay::ReplayReport replay(const QString& path,
+                                     const std::function<void(uint64_t step)>& beforeStep = {});
+    static bool runReplaySelfTest();   // box pile: replay == recording, nudge located, hash overhead
+
+    // Sim thread. Threaded mode steps PhysX on a krs::hil::FixedRateThread at 1/kFixedDt while
+    // playing, so a UI stall (menu, dialog, heavy repaint) no longer drops or bunches steps. The
+    // thread owns the PhysX world between steps. tick() posts user edits, kinematic targets,
+    // impulses and joint commands to its lock-free command queue. tick() also writes the newest
+    // frame the thread published (poses, velocities, joint state) back to the ECS. Structural edits
+    // (notifyEntityChanged, gravity, viz mapping) wait for the current step to finish. pause/stop/
+    // singleStep join the thread first, so paused stepping and the gates run on the calling thread
+    // as before. The registry is only ever touched on the main thread.
+    void setThreaded(bool on);                 // takes effect at the next play()
+    bool threaded() const { return m_threaded; }
+    krs::hil::JitterStats simThreadJitter() const { return m_simJitter; }   // last threaded run
+    static bool runSimThreadSelfTest();        // step-period jitter under UI stalls vs main thread
+
+    // Episode reset (RL). captureResetPoint() records the live world once: every dynamic actor's
+    // pose, velocity, mass and inertia, its shapes' friction, the ECS transforms, the articulation
+    // joint state and the scene light (SceneProperties). resetEpisode() writes that state back in
+    // place: no actor, shape or material is rebuilt and nothing is allocated, unlike stop()+play().
+    // With a DomainRandomization it also draws, in the same pass, a mass scale and pose jitter per
+    // body, a friction scale per material and a light intensity/tint from `seed` (same seed, same
+    // episode). Live edits (notifyEntityChanged) and stop() drop the reset point.
+    struct DomainRandomization {
+        glm::vec2 massScale{ 1.0f, 1.0f };         // uniform [min, max] factor on mass + inertia
+        glm::vec2 frictionScale{ 1.0f, 1.0f };     // on static + dynamic friction, per material
+        glm::vec3 positionJitter{ 0.0f };          // +- m per axis, dynamic bodies
+        float yawJitterDeg = 0.0f;                 // +- about world up, dynamic bodies
+        glm::vec2 lightIntensity{ 1.0f, 1.0f };    // factor on SceneProperties::lightColor
+        float lightTint = 0.0f;                    // +- per-channel factor on top of the intensity
+    };
+    bool captureResetPoint();
+    bool hasResetPoint() const;
+    bool resetEpisode(uint64_t seed = 0, const DomainRandomization* randomization = nullptr);
+    static bool runResetSelfTest();            // bit-exact restore, seeded randomization, resets/s
+
 signals:
     void stateChanged(SimulationState newState);
 
@@ -128,6 +184,57 @@ private:
     void closeHilCan();
     void applyCanCommands();   // drain effort command frames -> body forces (pre-step)
     void publishCanState();    // body pose/velocity/effort -> state frames (post-step)
+    void applyCanFrame(const krs::hil::CanFrame& frame, bool& articTouched);
+
+    // Deterministic replay: open the armed log on a freshly built world, hash the state, apply one
+    // logged input.
+    void openRecorder();
+    void closeRecorder();
+    void collectStateHashes(std::vector<krs::replay::BodyHash>& out);
+    bool applyReplayEvent(const krs::replay::Event& event, bool& articTouched);
+
+    // Sim thread: one input for the world (queued while the thread runs, applied at once otherwise).
+    struct SimCommand {
+        enum class Type : uint8_t { UserMove, KinematicTarget, Impulse, ArticPositions, ArticVelocities, ArticTorques,
+                                    ArticDrive };
+        static constexpr int kMaxValues = 16;
+        Type type = Type::UserMove;
+        entt::entity entity = entt::null;
+        uint32_t count = 0;
+        uint32_t driven = 0;   // ArticDrive: bit d set = DOF d takes v[d], the rest keep their live position
+        float v[kMaxValues] = {};
+    };
+    // Everything the ECS reads back after a step, captured from PhysX on the stepping thread.
+    struct SimFrame {
+        struct Body {
+            entt::entity entity = entt::null;
+            glm::vec3 p{ 0.0f };
+            glm::quat q{ 1.0f, 0.0f, 0.0f, 0.0f };
+            glm::vec3 v{ 0.0f }, w{ 0.0f };
+            bool kinematic = false;
+        };
+        uint64_t step = 0;
+        std::vector<Body> bodies;                       // dynamic + kinematic actors
+        std::vector<float> articQ, articQd;
+        std::vector<std::array<float, 7>> articLinks;   // per non-root link, as articLinkPoses()
+        std::vector<std::pair<entt::entity, glm::vec3>> hilEfforts;
+    };
+    void startSimThread();
+    void stopSimThread();
+    void simThreadTick();        // on the sim thread
+    void tickThreaded();         // tick() while the sim thread runs
+    void postKinematicTargets();
+    void dispatch(const SimCommand& cmd);
+    void applyCommand(const SimCommand& cmd);
+    void drainCommands();        // apply queued inputs in order: on the sim thread, or under lockWorld()
+    bool writeArticCache(SimCommand::Type type, const std::vector<float>& values);
+    void applyArticNow(SimCommand::Type type, const float* values, size_t count);
+    void applyArticDriveNow(const float* target, const char* driven, size_t count);
+    void applyImpulseNow(entt::entity entity, const glm::vec3& impulse);
+    std::unique_lock<std::mutex> lockWorld() const;   // blocks the sim thread; empty when not running
+    bool simThreadRunning() const { return m_simThread.running(); }
+    void captureFrame(SimFrame& out) const;
+    void applyFrame(const SimFrame& frame, float dtTick);
 
     struct TransformSnapshot {
         entt::entity entity;
@@ -151,4 +258,22 @@ private:
     std::unique_ptr<PxImpl> m_px;
 
     std::unique_ptr<krs::hil::IVirtualCAN> m_can; // HIL telemetry bus (null = off)
+
+    QString m_recordPath;                              // armed replay log (empty = off)
+    std::unique_ptr<krs::replay::Recorder> m_recorder; // open while the armed world runs
+    std::vector<krs::replay::BodyHash> m_stateHashes;  // per-step scratch
+    uint64_t m_simStep = 0;                            // fixed steps since the world was built
+    double m_hashNs = 0.0, m_stepNs = 0.0;             // recording overhead vs simulate+fetch
+    bool m_replaying = false;
+    std::vector<entt::entity> m_replaySpawned;         // recreated from Spawn events, destroyed after replay
+
+    bool m_threaded = false;
+    krs::hil::FixedRateThread m_simThread;
+    std::unique_ptr<krs::hil::SpscQueue<SimCommand>> m_commands;
+    std::unique_ptr<krs::hil::TripleBuffer<SimFrame>> m_frames;
+    SimFrame m_localFrame;                             // write-back scratch when not threaded
+    mutable std::mutex m_worldMutex;                   // the sim thread holds it for each step
+    uint64_t m_frameStep = 0;                          // step of the last frame written back
+    krs::hil::JitterStats m_simJitter;
+    uint64_t m_resetStep = 0;                          // threaded: frames up to this step predate the last reset
 };
@@ -4,4 +4,5 @@
 // never see the min/max/near/far macros. Used by GATE D (no-resource-growth).
 namespace krs {
 size_t processWorkingSetBytes();   // current working set (RSS), 0 on failure
+size_t processPeakWorkingSetBytes(); // peak working set (peak RSS) so far, 0 on failure
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <future>
+#include <memory>
+#include <string>
 #include <vector>
 
 /**
@@ -10,6 +13,13 @@
  * only those flagged segments are forked to the heavy double-precision
  * MpmAdjoint backend (`evaluatePeakStress`) on background threads. The planner
  * gets pending futures immediately and is never blocked by the exact math.
+ *
+ * Exact passes run on a FIXED set of worker threads fed by a priority queue (most
+ * suspicious surrogate/yield ratio first), so a large sweep never oversubscribes
+ * the machine. Re-submitting a plan id supersedes that plan's outstanding jobs.
+ * Results are cached under a content hash of the segment's knot samples, the
+ * material and the exact-pass sample model; with a cache file the cache persists
+ * across runs, so re-verifying an unchanged plan resolves without any solve.
  */
 namespace krs::hil {
 
@@ -29,12 +39,14 @@ struct MaterialSpec {
     double charLength = 0.25;   // m (characteristic load length for the surrogate)
 };
 
-enum class Verdict { Safe, Rejected };
+enum class Verdict { Safe, Rejected, Cancelled };
 
 /// Resolved result of the exact pass (also returned immediately for unflagged).
+/// Cancelled = superseded before the verifier produced a result for this plan.
 struct ExactResult {
     Verdict verdict = Verdict::Safe;
     double maxVonMises = 0.0;   // Pa, from the exact MpmAdjoint rollout
+    bool cached = false;        // served from the result cache (no solve)
 };
 
 /// Per-segment token. For flagged segments `result` is a pending future that
@@ -49,11 +61,43 @@ struct SegmentToken {
     std::future<ExactResult> result;
 };
 
+struct VerifierOptions {
+    unsigned workers = 0;       // exact-pass threads (0 = half the hardware threads, >= 1)
+    std::string cacheFile;      // persistent result cache; empty = in-memory only
+};
+
+struct VerifierStats {
+    long long exactRuns = 0;    // evaluatePeakStress calls
+    long long cacheHits = 0;    // flagged segments resolved from the cache
+    long long cancelled = 0;    // futures resolved Cancelled
+    int peakRunning = 0;        // max concurrent exact passes (<= workers)
+    unsigned workers = 0;
+};
+
 class TrajectoryVerifier {
 public:
-    // Fast sweep is synchronous and cheap; flagged segments fork to std::async.
-    // Returns immediately with pending futures for the flagged segments.
-    std::vector<SegmentToken> submit(const std::vector<TrajPoint>& traj, const MaterialSpec& mat);
+    explicit TrajectoryVerifier(const VerifierOptions& opt = {});
+    ~TrajectoryVerifier();      // cancels queued jobs, joins the workers
+    TrajectoryVerifier(const TrajectoryVerifier&) = delete;
+    TrajectoryVerifier& operator=(const TrajectoryVerifier&) = delete;
+
+    // Fast sweep is synchronous and cheap; flagged segments are queued for the
+    // worker pool (or resolved from the cache). Returns immediately with pending
+    // futures for the flagged segments. Submitting again under the same `plan`
+    // cancels whatever that plan still has outstanding.
+    std::vector<SegmentToken> submit(const std::vector<TrajPoint>& traj, const MaterialSpec& mat,
+                                     std::uint64_t plan = 0);
+    // Resolve every outstanding future of `plan` as Cancelled. Queued solves nobody
+    // else waits on are dropped; a solve already running finishes into the cache.
+    void cancel(std::uint64_t plan);
+    VerifierStats stats() const;
+
+    // Cache key: FNV-1a over the segment's two knots (q, qdd; not t), the material
+    // and kExactModelTag.
+    static std::uint64_t segmentKey(const TrajPoint& a, const TrajPoint& b, const MaterialSpec& mat);
+    // Version of the exact pass's sample model (block layout, grid, rollout length
+    // in evaluatePeakStress). Bump when that changes so stale cache entries miss.
+    static constexpr std::uint64_t kExactModelTag = 1;
 
     // Conservative neural-surrogate stand-in: a coarse high-recall pre-filter.
     // The inertial estimate (rho*L*a) under-predicts the true dynamic-impact
@@ -61,6 +105,10 @@ public:
     // misses a real failure; the expensive exact pass then clears the false
     // positives (the whole point of the multi-fidelity split).
     static constexpr double kSurrogateSafety = 10.0;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
 };
 
 /// TRAJECTORY_HIL_LOOP verification module (Task 3).
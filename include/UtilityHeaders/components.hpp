@@ -22,6 +22,8 @@
 // --- CORE COMPONENTS ---
 struct Texture2D;
 struct Cubemap;
+namespace krs::rl { class ReplayRing; }
+namespace krs::demo { class Writer; }
 struct SelectedComponent {};
 struct CameraGizmoTag {};
 struct RecordLedTag {};
@@ -579,6 +581,7 @@ struct SceneProperties
     float fogEndDistance = 75.0f;
     float deltaTime = 0.016f;
     bool showCollisionShapes = false; // wireframe overlay of cooked collision geometry
+    glm::vec3 lightColor = { 200.0f, 150.0f, 150.0f }; // key light radiance (LightingPass; domain randomization)
 };
 
 enum class SplineType { Linear, CatmullRom, Bezier, Parametric };
@@ -1156,11 +1159,12 @@ struct Experience {
 
 /**
  * @brief A buffer to store past experiences for off-policy learning.
- * This component would live on the TrainingManager entity.
+ * This component would live on the TrainingManager entity. The transitions
+ * live in a krs::rl::ReplayRing (ReplayRing.hpp): fixed-dimension contiguous
+ * arrays, optionally mapped from a file, with uniform and prioritized sampling.
  */
 struct ReplayBuffer {
-    // A deque is efficient for adding to the front and removing from the back.
-    std::deque<Experience> memory;
+    std::shared_ptr<krs::rl::ReplayRing> ring;   // created with the agent's obs/action dims
     size_t capacity = 100000;
 };
 /**
@@ -1170,6 +1174,8 @@ struct ReplayBuffer {
 struct DemonstrationRecorder {
     std::string output_path;
     uint32_t samples_recorded = 0;
+    // Columnar episode log (DemoLog.hpp); set/commit once per step, encoded off the step.
+    std::shared_ptr<krs::demo::Writer> writer;
 };
 
 /**
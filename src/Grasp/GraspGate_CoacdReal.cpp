@@ -62,14 +62,16 @@ bool insideAnyHull(const glm::vec3& p, const std::vector<PxConvexMesh*>& hulls)
 
 // cook the CoACD parts file into convex hulls (mirrors GraspSim's CoACD path).
 std::vector<PxConvexMesh*> cookCoacd(CollisionCookingService& cook, const std::string& path) {
-    std::vector<std::vector<glm::vec3>> parts; std::vector<PxConvexMesh*> hulls;
+    krs::HullSet parts; std::vector<PxConvexMesh*> hulls;
     if (!loadCoacdParts(path, parts)) return hulls;
-    for (auto& part : parts) {
-        std::vector<Vertex> vv(part.size());
-        for (size_t k = 0; k < part.size(); ++k) vv[k].position = part[k];
-        PxConvexMesh* h = cook.requestConvexHull(vv, "creal_coacd").get();
-        if (h) hulls.push_back(h);
+    std::vector<std::shared_future<PxConvexMesh*>> pending;
+    for (const krs::HullSet::Part& part : parts.parts()) {
+        std::vector<Vertex> vv(part.count);
+        for (uint32_t k = 0; k < part.count; ++k) vv[k].position = part.points[k];
+        pending.push_back(cook.requestConvexHull(vv, "creal_coacd"));
     }
+    for (auto& f : pending)
+        if (PxConvexMesh* h = f.get()) hulls.push_back(h);
     return hulls;
 }
 } // namespace
@@ -97,12 +99,23 @@ bool runGraspCoacdRealGate() {
     bool anyGraspRelevantDiscriminates = false, anyCoverageBad = false;
     int nConcaveTested = 0;
 
-    std::printf("  %-18s cavity-pts  V-HACD-presv  CoACD-presv   (solid coverage)   discriminates?\n", "object");
+    // Load the 4 grasp-relevant concave objects (pitcher/bowl/mug/cup) and queue all their V-HACD decompositions
+    // first: the jobs run concurrently on the cooking pool (or map from the disk cache), and the loop below
+    // collects them in catalog order from the service's future cache.
+    std::vector<const YcbObject*> concave;
+    std::vector<RenderableMeshComponent> meshes;
     for (const auto& o : ycbCatalog()) {
-        if (!o.concavity) continue;  // the 4 grasp-relevant concave objects (pitcher/bowl/mug/cup)
-        RenderableMeshComponent mesh;
-        try { mesh = MeshUtils::loadMeshFromFile(o.meshPath()); }
+        if (!o.concavity) continue;
+        try { meshes.push_back(MeshUtils::loadMeshFromFile(o.meshPath())); }
         catch (const std::exception& e) { std::printf("  %-18s load failed: %s\n", o.id.c_str(), e.what()); return false; }
+        concave.push_back(&o);
+        cook.requestConvexDecomposition(meshes.back().vertices, meshes.back().indices, "creal_vhacd");
+    }
+
+    std::printf("  %-18s cavity-pts  V-HACD-presv  CoACD-presv   (solid coverage)   discriminates?\n", "object");
+    for (size_t oi = 0; oi < concave.size(); ++oi) {
+        const YcbObject& o = *concave[oi];
+        const RenderableMeshComponent& mesh = meshes[oi];
         const MeshMetrics mm = computeMetrics(mesh);
 
         std::vector<PxConvexMesh*> vhacd = cook.requestConvexDecomposition(mesh.vertices, mesh.indices, "creal_vhacd").get();
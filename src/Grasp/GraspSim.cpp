@@ -126,16 +126,20 @@ bool graspSucceeded(const GraspResult& r) {
 static std::vector<PxConvexMesh*> cookObjectCollider(CollisionCookingService& cook,
                                                      const RenderableMeshComponent& objectMesh,
                                                      const std::string& coacdPath) {
-    std::vector<std::vector<glm::vec3>> parts;
+    krs::HullSet parts;
     if (!coacdPath.empty() && loadCoacdParts(coacdPath, parts)) {
-        std::vector<PxConvexMesh*> hulls;
-        hulls.reserve(parts.size());
-        for (size_t i = 0; i < parts.size(); ++i) {
-            std::vector<Vertex> vv(parts[i].size());
-            for (size_t k = 0; k < parts[i].size(); ++k) vv[k].position = parts[i][k];   // hull cook uses position only
-            PxConvexMesh* h = cook.requestConvexHull(vv, "coacd_part").get();
-            if (h) hulls.push_back(h);
+        // Queue every part on the cooking pool first, then collect: the parts cook concurrently.
+        std::vector<std::shared_future<PxConvexMesh*>> pending;
+        pending.reserve(parts.size());
+        for (const krs::HullSet::Part& part : parts.parts()) {
+            std::vector<Vertex> vv(part.count);
+            for (uint32_t k = 0; k < part.count; ++k) vv[k].position = part.points[k];   // hull cook uses position only
+            pending.push_back(cook.requestConvexHull(vv, "coacd_part"));
         }
+        std::vector<PxConvexMesh*> hulls;
+        hulls.reserve(pending.size());
+        for (auto& f : pending)
+            if (PxConvexMesh* h = f.get()) hulls.push_back(h);
         if (!hulls.empty()) return hulls;            // CoACD collider
     }
     return cook.requestConvexDecomposition(objectMesh.vertices, objectMesh.indices, "grasp_obj").get();  // V-HACD fallback
@@ -19,8 +19,14 @@
 //                            straight-line reference -> the achieved path collides.
 //   EXECUTE-LIMITS         : achieved q within [qLower,qUpper], achieved |qd| <=
 //                            vMax. NEG: a 3x-fast re-timing -> achieved |qd| > vMax.
+//   EXECUTE-OPTIMIZED      : shortcut + B-spline + TOPP-RA (Phase 6) re-timing of
+//                            the same plan finishes SOONER than the cubic-ease
+//                            baseline and still tracks / stays collision-free /
+//                            within vMax; its commanded limit ratio sits at ~1
+//                            (time-optimal). NEG: 1.5x-compressed -> ratio > 1.
 // ===========================================================================
 #include "MotionPlanner.hpp"
+#include "TrajectoryOptimizer.hpp"
 #include "ComputedTorque.hpp"
 #include "RobotModel.hpp"     // Phase 5 E2E: define the robot via the chain data model
 
@@ -71,6 +77,9 @@ JointLimits armLimits() {
     lim.qLower << -kPi, -1.5, -2.5;
     lim.qUpper <<  kPi,  1.5,  2.5;
     lim.vMax   << 2.0, 2.0, 3.0;
+    lim.aMax.resize(3); lim.tauMax.resize(3);      // read only by the TOPP-RA re-timing
+    lim.aMax   << 8.0, 8.0, 12.0;
+    lim.tauMax << 40.0, 60.0, 25.0;
     return lim;
 }
 
@@ -125,9 +134,11 @@ struct ExecResult {
     std::vector<Eigen::VectorXd> achieved;      // achieved q(t)
 };
 
-// Execute a timed trajectory with either computed torque or the soft PD, under
-// gravity, via forward dynamics + semi-implicit Euler.
-ExecResult execute(const krs::dyn::SerialChain& chain, const TimedTraj& traj,
+// Execute a timed trajectory (TimedTraj or a TOPP-RA TimedPath) with either
+// computed torque or the soft PD, under gravity, via forward dynamics +
+// semi-implicit Euler.
+template <class Traj>
+ExecResult execute(const krs::dyn::SerialChain& chain, const Traj& traj,
                    const JointLimits& lim, bool useComputedTorque, const Eigen::Vector3d& gravity) {
     ExecResult r;
     const int nq = chain.nq();
@@ -135,9 +146,10 @@ ExecResult execute(const krs::dyn::SerialChain& chain, const TimedTraj& traj,
     const double Kp = 900.0, Kd = 60.0;                      // computed torque
     const double KpOld[3] = { 50.0, 50.0, 35.0 };            // soft PD: stable but no model/gravity
     const double KdOld[3] = { 12.0, 12.0, 9.0 };             // feedforward -> sags+lags (finite, large)
-    Eigen::VectorXd q = traj.wp.front(), qd = Eigen::VectorXd::Zero(nq);
-    const int steps = int(std::ceil(traj.total / dt)) + 1;
     Eigen::VectorXd q_des(nq), qd_des(nq), qdd_des(nq);
+    traj.sample(0.0, q_des, qd_des, qdd_des);
+    Eigen::VectorXd q = q_des, qd = Eigen::VectorXd::Zero(nq);
+    const int steps = int(std::ceil(traj.total / dt)) + 1;
     for (int k = 0; k <= steps; ++k) {
         const double t = k * dt;
         traj.sample(t, q_des, qd_des, qdd_des);
@@ -165,6 +177,27 @@ double trajMaxPen(const krs::dyn::SerialChain& chain, const CollisionWorld& w,
     return m;
 }
 
+// Max over the COMMANDED trajectory (time-compressed by `speedScale`) of
+// |qd|/vMax, |qdd|/aMax and |tau|/tauMax (tau by RNEA). ~1 => some limit is
+// saturated (time-optimal); > 1 => the command itself violates a limit.
+double commandedLimitRatio(const krs::dyn::SerialChain& chain, const TimedPath& traj,
+                           const JointLimits& lim, const Eigen::Vector3d& gravity, double speedScale) {
+    double ratio = 0.0;
+    Eigen::VectorXd q, qd, qdd;
+    const int n = 4000;
+    for (int k = 0; k <= n; ++k) {
+        traj.sample(traj.total * k / n, q, qd, qdd);
+        qd *= speedScale; qdd *= speedScale * speedScale;
+        const Eigen::VectorXd tau = chain.rnea(q, qd, qdd, gravity);
+        for (int i = 0; i < q.size(); ++i) {
+            ratio = std::max(ratio, std::abs(qd[i]) / lim.vMax[i]);
+            ratio = std::max(ratio, std::abs(qdd[i]) / lim.aMax[i]);
+            ratio = std::max(ratio, std::abs(tau[i]) / lim.tauMax[i]);
+        }
+    }
+    return ratio;
+}
+
 } // namespace
 
 bool runExecuteGate() {
@@ -244,6 +277,36 @@ bool runExecuteGate() {
         allOk = allOk && ok;
     }
 
+    // ---- EXECUTE-OPTIMIZED ---------------------------------------------------
+    {
+        TimedTraj base; base.build(plan.waypoints, lim, 1.0);
+        PostProcessOptions po; po.shortcut.seed = 7; po.toppra.gravity = gravity;
+        std::fprintf(stderr, "TRACE execute: OPTIMIZED post-process\n");
+        const PostProcessResult opt = postProcessPath(chain, planWorld, lim, plan.waypoints, po);
+        bool ok = opt.ok;
+        if (opt.ok) {
+            const ExecResult ct = execute(chain, opt.traj, lim, true, gravity);
+            const double achievedPen = trajMaxPen(chain, trueWorld, ct.achieved);
+            const double cmdRatio  = commandedLimitRatio(chain, opt.traj, lim, gravity, 1.0);
+            const double fastRatio = commandedLimitRatio(chain, opt.traj, lim, gravity, 1.5);
+            std::printf("  [execute-optimized] waypoints %zu->%zu len %.3f->%.3f rad (refine=%u fallback=%d) | "
+                        "cycle %.3fs -> %.3fs (%.0f%% shorter)\n",
+                        plan.waypoints.size(), opt.shortcut.size(), opt.inputLength, opt.shortcutLength,
+                        opt.refinements, int(opt.smoothFellBack), base.total, opt.traj.total,
+                        100.0 * (1.0 - opt.traj.total / base.total));
+            std::printf("  [execute-optimized] CT peak=%.4f rad achieved pen=%.4f velRatio=%.4f | "
+                        "cmd limitRatio=%.4f (~1 = time-optimal) | NEG 1.5x-fast limitRatio=%.4f (>1)\n",
+                        ct.peakErr, achievedPen, ct.maxVelRatio, cmdRatio, fastRatio);
+            ok = opt.traj.total < base.total
+              && ct.peakErr < 0.10 && achievedPen < 1e-3 && ct.maxVelRatio < 1.10
+              && cmdRatio > 0.98 && cmdRatio < 1.02 && fastRatio > 1.10;
+        } else {
+            std::printf("  [execute-optimized] TOPP-RA infeasible under the arm limits\n");
+        }
+        std::printf("    -> EXECUTE-OPTIMIZED %s\n", ok ? "PASS" : "FAIL");
+        allOk = allOk && ok;
+    }
+
     std::printf("  [execute gate] %s\n", allOk ? "ALL PASS" : "FAIL");
     return allOk;
 }
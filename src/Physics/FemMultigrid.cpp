@@ -0,0 +1,385 @@
+// ===========================================================================
+// Phase 5b — matrix-free voxel multigrid implementation (see FemMultigrid.hpp).
+//
+// Level data is a set of index grids over the regular voxel lattice: node grid
+// -> active node, cell grid -> element, plus per-element fill weights. Local
+// corner numbering matches FemSolver (a = di | dj<<1 | dk<<2). Every parallel
+// loop writes only the rows it owns and every reduction is summed in fixed
+// chunk order (krs::par), so a solve is bit-reproducible for any thread count.
+// ===========================================================================
+#include "FemMultigrid.hpp"
+#include "ParallelFor.hpp"
+
+#include <Eigen/Sparse>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+namespace krs::fem {
+
+namespace {
+using Vec = Eigen::VectorXd;
+constexpr size_t kGrain = 4096;    // nodes / DOFs per parallel chunk
+
+double dot(const Vec& a, const Vec& b) {
+    return krs::par::reduce<double>(size_t(a.size()), kGrain, 0.0, [&](size_t lo, size_t hi) {
+        double s = 0.0;
+        for (size_t i = lo; i < hi; ++i) s += a[i] * b[i];
+        return s;
+    });
+}
+// y += alpha * x
+void axpy(double alpha, const Vec& x, Vec& y) {
+    krs::par::parallelFor(size_t(x.size()), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) y[i] += alpha * x[i];
+    });
+}
+} // namespace
+
+template <int B>
+struct VoxelMultigrid<B>::Level {
+    int nx = 0, ny = 0, nz = 0;
+    double h = 0.0;
+    std::vector<int> nodeId;                  // (nx+1)(ny+1)(nz+1) grid -> active node, -1
+    std::vector<int> nodeGrid;                // active node -> grid index
+    std::vector<float> cellW;                 // nx*ny*nz cell -> solid fill fraction (0 = void)
+    std::vector<char> fixed;                  // per node: Dirichlet
+    std::vector<double> shift;                // per node diagonal term (empty = none)
+    ElemMat Ke;
+    // Assembled 27-point nodal stencil of a node whose 8 incident cells are all
+    // full (w = 1): the common interior case skips the per-element gather.
+    std::array<Eigen::Matrix<double, B, B>, 27> S;
+    std::vector<char> interior;               // per node
+    Vec invDiag;                              // per DOF, 0 on Dirichlet DOFs
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> direct;   // coarsest level only
+    bool hasDirect = false;
+
+    int n() const { return int(nodeGrid.size()); }
+    int gridIdx(int i, int j, int k) const { return (k * (ny + 1) + j) * (nx + 1) + i; }
+    int cellIdx(int i, int j, int k) const { return (k * ny + j) * nx + i; }
+    void gridCoord(int g, int& i, int& j, int& k) const {
+        i = g % (nx + 1); g /= (nx + 1); j = g % (ny + 1); k = g / (ny + 1);
+    }
+    double cellWeight(int i, int j, int k) const {
+        if (i < 0 || j < 0 || k < 0 || i >= nx || j >= ny || k >= nz) return 0.0;
+        return cellW[cellIdx(i, j, k)];
+    }
+
+    // y[rows of node] = sum over incident elements of w_e * Ke(rows of local corner, :) * x_e
+    void apply(const Vec& x, Vec& y) const {
+        const int sy = nx + 1, sz = (nx + 1) * (ny + 1);
+        krs::par::parallelFor(size_t(n()), kGrain, [&](size_t lo, size_t hi) {
+            Eigen::Matrix<double, 8 * B, 1> xe;
+            for (size_t nd = lo; nd < hi; ++nd) {
+                Eigen::Matrix<double, B, 1> acc = Eigen::Matrix<double, B, 1>::Zero();
+                if (interior[nd]) {
+                    const int g = nodeGrid[nd];
+                    int s = 0;
+                    for (int dz = -1; dz <= 1; ++dz) for (int dy = -1; dy <= 1; ++dy) for (int dx = -1; dx <= 1; ++dx, ++s)
+                        acc.noalias() += S[s] * x.template segment<B>(B * nodeId[g + dx + dy * sy + dz * sz]);
+                    if (!shift.empty()) acc += shift[nd] * x.template segment<B>(B * nd);
+                    y.template segment<B>(B * nd) = acc;
+                    continue;
+                }
+                int i, j, k; gridCoord(nodeGrid[nd], i, j, k);
+                for (int o = 0; o < 8; ++o) {
+                    const int ci = i - 1 + (o & 1), cj = j - 1 + ((o >> 1) & 1), ck = k - 1 + ((o >> 2) & 1);
+                    const double w = cellWeight(ci, cj, ck);
+                    if (w == 0.0) continue;
+                    const int a = 7 - o;                       // this node's corner within the cell
+                    for (int b = 0; b < 8; ++b)
+                        xe.template segment<B>(B * b) = x.template segment<B>(
+                            B * nodeId[gridIdx(ci + (b & 1), cj + ((b >> 1) & 1), ck + ((b >> 2) & 1))]);
+                    acc.noalias() += w * (Ke.template middleRows<B>(B * a) * xe);
+                }
+                if (!shift.empty()) acc += shift[nd] * x.template segment<B>(B * nd);
+                y.template segment<B>(B * nd) = acc;
+            }
+        });
+    }
+
+    void zeroFixed(Vec& v) const {
+        krs::par::parallelFor(size_t(n()), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t nd = lo; nd < hi; ++nd)
+                if (fixed[nd]) v.template segment<B>(B * nd).setZero();
+        });
+    }
+
+    // r = b - A x (Dirichlet rows zeroed)
+    void residual(const Vec& b, const Vec& x, Vec& r) const {
+        apply(x, r);
+        krs::par::parallelFor(size_t(r.size()), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t d = lo; d < hi; ++d) r[d] = b[d] - r[d];
+        });
+        zeroFixed(r);
+    }
+
+    void jacobi(const Vec& b, Vec& x, Vec& r, double omega) const {
+        residual(b, x, r);
+        krs::par::parallelFor(size_t(x.size()), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t d = lo; d < hi; ++d) x[d] += omega * invDiag[d] * r[d];
+        });
+    }
+
+    void buildStencil() {
+        for (auto& m : S) m.setZero();
+        for (int o = 0; o < 8; ++o) {                      // incident cell offset
+            const int a = 7 - o;
+            for (int b = 0; b < 8; ++b) {
+                const int dx = -1 + (o & 1) + (b & 1), dy = -1 + ((o >> 1) & 1) + ((b >> 1) & 1),
+                          dz = -1 + ((o >> 2) & 1) + ((b >> 2) & 1);
+                S[(dz + 1) * 9 + (dy + 1) * 3 + (dx + 1)] += Ke.template block<B, B>(B * a, B * b);
+            }
+        }
+        interior.assign(n(), 0);
+        for (int nd = 0; nd < n(); ++nd) {
+            int i, j, k; gridCoord(nodeGrid[nd], i, j, k);
+            bool full = i > 0 && j > 0 && k > 0 && i < nx && j < ny && k < nz;
+            for (int o = 0; o < 8 && full; ++o)
+                full = cellWeight(i - 1 + (o & 1), j - 1 + ((o >> 1) & 1), k - 1 + ((o >> 2) & 1)) == 1.0;
+            interior[nd] = full;
+        }
+    }
+
+    void buildDiagonal() {
+        invDiag.setZero(B * n());
+        krs::par::parallelFor(size_t(n()), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t nd = lo; nd < hi; ++nd) {
+                if (fixed[nd]) continue;
+                int i, j, k; gridCoord(nodeGrid[nd], i, j, k);
+                Eigen::Matrix<double, B, 1> dg = Eigen::Matrix<double, B, 1>::Zero();
+                for (int o = 0; o < 8; ++o) {
+                    const double w = cellWeight(i - 1 + (o & 1), j - 1 + ((o >> 1) & 1), k - 1 + ((o >> 2) & 1));
+                    const int a = 7 - o;
+                    for (int c = 0; c < B; ++c) dg[c] += w * Ke(B * a + c, B * a + c);
+                }
+                if (!shift.empty()) dg.array() += shift[nd];
+                for (int c = 0; c < B; ++c) invDiag[B * nd + c] = dg[c] > 0.0 ? 1.0 / dg[c] : 0.0;
+            }
+        });
+    }
+
+    void buildDirect() {
+        using Trip = Eigen::Triplet<double>;
+        std::vector<Trip> trips;
+        for (int k = 0; k < nz; ++k) for (int j = 0; j < ny; ++j) for (int i = 0; i < nx; ++i) {
+            const double w = cellW[cellIdx(i, j, k)];
+            if (w == 0.0) continue;
+            std::array<int, 8> e;
+            for (int a = 0; a < 8; ++a) e[a] = nodeId[gridIdx(i + (a & 1), j + ((a >> 1) & 1), k + ((a >> 2) & 1))];
+            for (int a = 0; a < 8; ++a) for (int b = 0; b < 8; ++b)
+                for (int ci = 0; ci < B; ++ci) for (int cj = 0; cj < B; ++cj)
+                    trips.emplace_back(B * e[a] + ci, B * e[b] + cj, w * Ke(B * a + ci, B * b + cj));
+        }
+        double dmax = 1.0;
+        for (int d = 0; d < invDiag.size(); ++d) if (invDiag[d] > 0.0) dmax = std::max(dmax, 1.0 / invDiag[d]);
+        for (int nd = 0; nd < n(); ++nd)
+            for (int c = 0; c < B; ++c) {
+                double v = shift.empty() ? 0.0 : shift[nd];
+                if (fixed[nd]) v += 1.0e9 * dmax;            // eliminated DOF (RHS is zero there)
+                if (v != 0.0) trips.emplace_back(B * nd + c, B * nd + c, v);
+            }
+        Eigen::SparseMatrix<double> K(B * n(), B * n());
+        K.setFromTriplets(trips.begin(), trips.end());
+        direct.compute(K);
+        hasDirect = direct.info() == Eigen::Success;
+    }
+};
+
+template <int B>
+VoxelMultigrid<B>::VoxelMultigrid(const VoxelFemModel& m, const ElemFn& elem, const std::vector<char>& fixedNode,
+                                  const std::vector<double>* nodalShift, const MgOptions& opt)
+    : m_opt(opt) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // --- finest level: the model itself --------------------------------------
+    auto fine = std::make_unique<Level>();
+    fine->nx = m.nx; fine->ny = m.ny; fine->nz = m.nz; fine->h = m.h;
+    fine->nodeId = m.nodeId;
+    fine->nodeGrid.assign(m.numNodes, -1);
+    for (int g = 0; g < int(m.nodeId.size()); ++g) if (m.nodeId[g] >= 0) fine->nodeGrid[m.nodeId[g]] = g;
+    fine->cellW.assign(size_t(m.nx) * m.ny * m.nz, 0.0f);
+    for (const auto& e : m.elements) {
+        int i, j, k; fine->gridCoord(fine->nodeGrid[e[0]], i, j, k);
+        fine->cellW[fine->cellIdx(i, j, k)] = 1.0f;
+    }
+    fine->fixed = fixedNode;
+    fine->fixed.resize(m.numNodes, 0);
+    if (nodalShift) fine->shift = *nodalShift;
+    fine->Ke = elem(fine->h);
+    fine->buildStencil();
+    fine->buildDiagonal();
+    m_levels.push_back(std::move(fine));
+
+    // --- coarse levels: re-discretised 2h grids, fill-fraction weighted ------
+    while (true) {
+        const Level& F = *m_levels.back();
+        if (B * F.n() <= opt.coarseDofs || std::min({ F.nx, F.ny, F.nz }) < 2) break;
+        auto C = std::make_unique<Level>();
+        C->nx = (F.nx + 1) / 2; C->ny = (F.ny + 1) / 2; C->nz = (F.nz + 1) / 2; C->h = 2.0 * F.h;
+        // Fill fraction = mean of the 8 children (dyadic fractions: exact in float).
+        C->cellW.assign(size_t(C->nx) * C->ny * C->nz, 0.0f);
+        for (int ck = 0; ck < F.nz; ++ck) for (int cj = 0; cj < F.ny; ++cj) for (int ci = 0; ci < F.nx; ++ci)
+            C->cellW[C->cellIdx(ci / 2, cj / 2, ck / 2)] += 0.125f * F.cellW[F.cellIdx(ci, cj, ck)];
+        C->nodeId.assign(size_t(C->nx + 1) * (C->ny + 1) * (C->nz + 1), -1);
+        for (int k = 0; k < C->nz; ++k) for (int j = 0; j < C->ny; ++j) for (int i = 0; i < C->nx; ++i) {
+            if (C->cellW[C->cellIdx(i, j, k)] == 0.0f) continue;
+            for (int a = 0; a < 8; ++a) {
+                const int g = C->gridIdx(i + (a & 1), j + ((a >> 1) & 1), k + ((a >> 2) & 1));
+                if (C->nodeId[g] < 0) { C->nodeId[g] = C->n(); C->nodeGrid.push_back(g); }
+            }
+        }
+        // A fine Dirichlet node pins the coarse node it rounds up to (an even
+        // index coincides exactly); that node is a corner of a solid coarse cell.
+        C->fixed.assign(C->n(), 0);
+        for (int nd = 0; nd < F.n(); ++nd) {
+            if (!F.fixed[nd]) continue;
+            int i, j, k; F.gridCoord(F.nodeGrid[nd], i, j, k);
+            const int id = C->nodeId[C->gridIdx((i + 1) / 2, (j + 1) / 2, (k + 1) / 2)];
+            if (id >= 0) C->fixed[id] = 1;
+        }
+        // Nodal diagonal terms are lumped through the restriction weights.
+        if (!F.shift.empty()) {
+            C->shift.assign(C->n(), 0.0);
+            for (int nd = 0; nd < F.n(); ++nd) {
+                int i, j, k; F.gridCoord(F.nodeGrid[nd], i, j, k);
+                for (int o = 0; o < 8; ++o) {
+                    const int di = (o & 1), dj = (o >> 1) & 1, dk = (o >> 2) & 1;
+                    if ((di && !(i & 1)) || (dj && !(j & 1)) || (dk && !(k & 1))) continue;
+                    const int id = C->nodeId[C->gridIdx((i + di) / 2, (j + dj) / 2, (k + dk) / 2)];
+                    const double w = ((i & 1) ? 0.5 : 1.0) * ((j & 1) ? 0.5 : 1.0) * ((k & 1) ? 0.5 : 1.0);
+                    if (id >= 0) C->shift[id] += w * F.shift[nd];
+                }
+            }
+        }
+        C->Ke = elem(C->h);
+        C->buildStencil();
+        C->buildDiagonal();
+        if (C->n() >= F.n()) break;                          // no reduction: stop coarsening
+        m_levels.push_back(std::move(C));
+    }
+    m_levels.back()->buildDirect();
+    m_setupSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+template <int B>
+VoxelMultigrid<B>::~VoxelMultigrid() = default;
+
+template <int B>
+int VoxelMultigrid<B>::dofs() const { return B * m_levels.front()->n(); }
+
+template <int B>
+int VoxelMultigrid<B>::levels() const { return int(m_levels.size()); }
+
+template <int B>
+void VoxelMultigrid<B>::apply(const Vec& x, Vec& y) const {
+    y.resize(x.size());
+    m_levels.front()->apply(x, y);
+}
+
+template <int B>
+void VoxelMultigrid<B>::vcycle(int l, const Vec& b, Vec& x) const {
+    const Level& F = *m_levels[l];
+    Vec r(b.size());
+    if (l + 1 == int(m_levels.size())) {
+        if (F.hasDirect) { x = F.direct.solve(b); F.zeroFixed(x); }
+        else for (int s = 0; s < 20 * m_opt.smoothSweeps; ++s) F.jacobi(b, x, r, m_opt.omega);
+        return;
+    }
+    const Level& C = *m_levels[l + 1];
+    for (int s = 0; s < m_opt.smoothSweeps; ++s) F.jacobi(b, x, r, m_opt.omega);
+    F.residual(b, x, r);
+
+    // Restriction = transpose of trilinear prolongation, gathered per coarse node.
+    Vec bc = Vec::Zero(B * C.n());
+    krs::par::parallelFor(size_t(C.n()), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t cn = lo; cn < hi; ++cn) {
+            if (C.fixed[cn]) continue;
+            int I, J, K; C.gridCoord(C.nodeGrid[cn], I, J, K);
+            Eigen::Matrix<double, B, 1> acc = Eigen::Matrix<double, B, 1>::Zero();
+            for (int dk = -1; dk <= 1; ++dk) for (int dj = -1; dj <= 1; ++dj) for (int di = -1; di <= 1; ++di) {
+                const int i = 2 * I + di, j = 2 * J + dj, k = 2 * K + dk;
+                if (i < 0 || j < 0 || k < 0 || i > F.nx || j > F.ny || k > F.nz) continue;
+                const int fn = F.nodeId[F.gridIdx(i, j, k)];
+                if (fn < 0) continue;
+                const double w = (di ? 0.5 : 1.0) * (dj ? 0.5 : 1.0) * (dk ? 0.5 : 1.0);
+                acc += w * r.template segment<B>(B * fn);
+            }
+            bc.template segment<B>(B * cn) = acc;
+        }
+    });
+    Vec xc = Vec::Zero(bc.size());
+    vcycle(l + 1, bc, xc);
+
+    // Prolongation (trilinear), gathered per fine node.
+    krs::par::parallelFor(size_t(F.n()), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t fn = lo; fn < hi; ++fn) {
+            if (F.fixed[fn]) continue;
+            int i, j, k; F.gridCoord(F.nodeGrid[fn], i, j, k);
+            Eigen::Matrix<double, B, 1> acc = Eigen::Matrix<double, B, 1>::Zero();
+            for (int o = 0; o < 8; ++o) {
+                const int di = (o & 1), dj = (o >> 1) & 1, dk = (o >> 2) & 1;
+                if ((di && !(i & 1)) || (dj && !(j & 1)) || (dk && !(k & 1))) continue;
+                const int cn = C.nodeId[C.gridIdx((i + di) / 2, (j + dj) / 2, (k + dk) / 2)];
+                if (cn < 0) continue;
+                const double w = ((i & 1) ? 0.5 : 1.0) * ((j & 1) ? 0.5 : 1.0) * ((k & 1) ? 0.5 : 1.0);
+                acc += w * xc.template segment<B>(B * cn);
+            }
+            x.template segment<B>(B * fn) += acc;
+        }
+    });
+    for (int s = 0; s < m_opt.smoothSweeps; ++s) F.jacobi(b, x, r, m_opt.omega);
+}
+
+template <int B>
+MgStats VoxelMultigrid<B>::solve(const Vec& b, Vec& x) const {
+    const auto t0 = std::chrono::steady_clock::now();
+    MgStats st;
+    st.levels = levels();
+    st.setupSec = m_setupSec;
+    const Level& F = *m_levels.front();
+    const int n = dofs();
+    if (x.size() != n) x = Vec::Zero(n);
+
+    Vec r(n), z = Vec::Zero(n), p(n), Ap(n);
+    F.residual(b, x, r);
+    Vec bFree = b; F.zeroFixed(bFree);
+    double ref = std::sqrt(dot(bFree, bFree));
+    if (ref <= 0.0) ref = std::sqrt(dot(r, r));               // pure Dirichlet lift
+    if (ref <= 0.0) { st.converged = true; return st; }       // x already solves it
+
+    vcycle(0, r, z);
+    p = z;
+    double rz = dot(r, z);
+    st.relResidual = std::sqrt(dot(r, r)) / ref;
+    for (int it = 0; it < m_opt.maxIters && st.relResidual > m_opt.relTol; ++it) {
+        F.apply(p, Ap);
+        F.zeroFixed(Ap);
+        const double pAp = dot(p, Ap);
+        if (!(pAp > 0.0)) break;                              // lost SPD (singular free block)
+        const double alpha = rz / pAp;
+        axpy(alpha, p, x);
+        axpy(-alpha, Ap, r);
+        st.iterations = it + 1;
+        st.relResidual = std::sqrt(dot(r, r)) / ref;
+        if (st.relResidual <= m_opt.relTol) break;
+        z.setZero();
+        vcycle(0, r, z);
+        const double rzNew = dot(r, z);
+        const double beta = rzNew / rz;
+        rz = rzNew;
+        krs::par::parallelFor(size_t(n), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t d = lo; d < hi; ++d) p[d] = z[d] + beta * p[d];
+        });
+    }
+    st.converged = st.relResidual <= m_opt.relTol;
+    st.solveSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return st;
+}
+
+template class VoxelMultigrid<1>;
+template class VoxelMultigrid<3>;
+
+} // namespace krs::fem
@@ -1,18 +1,26 @@
 // ===========================================================================
 // Phase 5 — FEM oracle implementation (voxel/hex linear elasticity + heat).
 // Trilinear 8-node hexes on a regular grid; one element matrix per (cubic) cell
-// reused for all full cells; sparse SPD assembly via Eigen SimplicialLDLT.
-// CPU/Eigen only. See ROADMAP §L for the discretisation decision + trade-offs.
+// reused for all full cells; sparse SPD assembly via Eigen SimplicialLDLT, or
+// matrix-free MG-PCG for large elastic models (FemMultigrid.cpp). CPU/Eigen only.
+// See ROADMAP §L for the discretisation decision + trade-offs.
 // ===========================================================================
 #include "FemSolver.hpp"
+#include "FemMultigrid.hpp"
+#include "SysMem.hpp"
+#include "ParallelFor.hpp"
 
 #include <Eigen/Sparse>
 #include <Eigen/Dense>
 
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <algorithm>
+#include <memory>
 
 namespace krs::fem {
 namespace {
@@ -45,6 +53,7 @@ inline void shape(double xi, double eta, double ze, double h,
     }
 }
 
+constexpr double kPi = 3.14159265358979323846;
 const double kG = 0.5773502691896258; // 1/sqrt(3)
 const double kGauss[2] = { -kG, kG };
 
@@ -108,19 +117,29 @@ double maxDiag(const SpMat& A) {
     return m > 0.0 ? m : 1.0;
 }
 
-} // namespace
-
-int VoxelFemModel::nearestNode(const glm::dvec3& p) const {
-    int best = -1; double bd = 1e300;
-    for (int n = 0; n < numNodes; ++n) {
-        const double d = glm::dot(nodePos[n] - p, nodePos[n] - p);
-        if (d < bd) { bd = d; best = n; }
-    }
-    return best;
+// Parallel element assembly: every element emits exactly (8B)^2 triplets into its
+// own pre-sized slot, so chunks never contend and the triplet sequence (hence the
+// summed matrix) is the serial one, bit-for-bit.
+template <int B>
+SpMat assembleHex(const VoxelFemModel& m, const Eigen::Matrix<double, 8 * B, 8 * B>& Ke) {
+    constexpr size_t kPer = 64 * B * B;
+    std::vector<Trip> trips(m.elements.size() * kPer);
+    krs::par::parallelFor(m.elements.size(), 512, [&](size_t lo, size_t hi) {
+        for (size_t el = lo; el < hi; ++el) {
+            const auto& e = m.elements[el];
+            Trip* t = trips.data() + el * kPer;
+            for (int a = 0; a < 8; ++a) for (int b = 0; b < 8; ++b)
+                for (int ci = 0; ci < B; ++ci) for (int cj = 0; cj < B; ++cj)
+                    *t++ = Trip(B * e[a] + ci, B * e[b] + cj, Ke(B * a + ci, B * b + cj));
+        }
+    });
+    SpMat K(B * m.numNodes, B * m.numNodes);
+    K.setFromTriplets(trips.begin(), trips.end());
+    return K;
 }
 
-VoxelFemModel FemSolver::voxelize(const glm::dvec3& origin, double h, int nx, int ny, int nz,
-                                  const std::function<bool(const glm::dvec3&)>& inside) {
+// Merge solid cells into a model (shared nodes, ids in k,j,i cell order).
+VoxelFemModel buildModel(const glm::dvec3& origin, double h, int nx, int ny, int nz, const std::vector<char>& solid) {
     VoxelFemModel m;
     m.origin = origin; m.h = h; m.nx = nx; m.ny = ny; m.nz = nz;
     m.nodeId.assign(size_t(nx + 1) * (ny + 1) * (nz + 1), -1);
@@ -129,9 +148,9 @@ VoxelFemModel FemSolver::voxelize(const glm::dvec3& origin, double h, int nx, in
         if (id < 0) { id = m.numNodes++; m.nodePos.push_back(origin + glm::dvec3(i, j, k) * h); }
         return id;
     };
-    for (int k = 0; k < nz; ++k) for (int j = 0; j < ny; ++j) for (int i = 0; i < nx; ++i) {
-        const glm::dvec3 c = origin + (glm::dvec3(i, j, k) + 0.5) * h;
-        if (!inside(c)) continue;
+    size_t c = 0;
+    for (int k = 0; k < nz; ++k) for (int j = 0; j < ny; ++j) for (int i = 0; i < nx; ++i, ++c) {
+        if (!solid[c]) continue;
         std::array<int, 8> e{};
         for (int a = 0; a < 8; ++a) { int di, dj, dk; cornerOffset(a, di, dj, dk); e[a] = activate(i + di, j + dj, k + dk); }
         m.elements.push_back(e);
@@ -139,6 +158,76 @@ VoxelFemModel FemSolver::voxelize(const glm::dvec3& origin, double h, int nx, in
     return m;
 }
 
+// 2D BVH over triangle bounds projected on the YZ plane. A +x scanline through a
+// cell row (y, z) only visits triangles whose YZ box contains (y, z).
+struct YzBvh {
+    struct Node { double lo[2], hi[2]; int left = -1, right = -1, first = 0, count = 0; };
+    std::vector<Node> nodes;
+    std::vector<int> tri;
+
+    void build(const std::vector<std::array<double, 4>>& box) {   // {ylo, zlo, yhi, zhi}
+        tri.resize(box.size());
+        for (size_t t = 0; t < box.size(); ++t) tri[t] = int(t);
+        nodes.clear();
+        nodes.reserve(2 * box.size() + 1);
+        if (!box.empty()) split(box, 0, int(box.size()));
+    }
+    int split(const std::vector<std::array<double, 4>>& box, int first, int count) {
+        const int id = int(nodes.size());
+        nodes.emplace_back();
+        Node nd; nd.lo[0] = nd.lo[1] = 1e300; nd.hi[0] = nd.hi[1] = -1e300;
+        for (int t = first; t < first + count; ++t)
+            for (int ax = 0; ax < 2; ++ax) {
+                nd.lo[ax] = std::min(nd.lo[ax], box[tri[t]][ax]);
+                nd.hi[ax] = std::max(nd.hi[ax], box[tri[t]][ax + 2]);
+            }
+        nd.first = first; nd.count = count;
+        if (count > 4) {
+            const int ax = (nd.hi[1] - nd.lo[1]) > (nd.hi[0] - nd.lo[0]) ? 1 : 0;
+            const int half = count / 2;
+            std::nth_element(tri.begin() + first, tri.begin() + first + half, tri.begin() + first + count,
+                             [&](int a, int b) { return box[a][ax] + box[a][ax + 2] < box[b][ax] + box[b][ax + 2]; });
+            nd.left = split(box, first, half);
+            nd.right = split(box, first + half, count - half);
+            nd.count = 0;
+        }
+        nodes[id] = nd;
+        return id;
+    }
+    template <class Fn>
+    void query(double y, double z, Fn&& fn) const {
+        if (nodes.empty()) return;
+        int stack[64]; int sp = 0; stack[sp++] = 0;
+        while (sp > 0) {
+            const Node& nd = nodes[stack[--sp]];
+            if (y < nd.lo[0] || y > nd.hi[0] || z < nd.lo[1] || z > nd.hi[1]) continue;
+            if (nd.left < 0) { for (int t = nd.first; t < nd.first + nd.count; ++t) fn(tri[t]); continue; }
+            stack[sp++] = nd.left; stack[sp++] = nd.right;
+        }
+    }
+};
+
+} // namespace
+
+int VoxelFemModel::nearestNode(const glm::dvec3& p) const {
+    int best = -1; double bd = 1e300;
+    for (int n = 0; n < numNodes; ++n) {
+        const double d = glm::dot(nodePos[n] - p, nodePos[n] - p);
+        if (d < bd) { bd = d; best = n; }
+    }
+    return best;
+}
+
+VoxelFemModel FemSolver::voxelize(const glm::dvec3& origin, double h, int nx, int ny, int nz,
+                                  const std::function<bool(const glm::dvec3&)>& inside) {
+    // Serial: `inside` is an arbitrary caller predicate (no thread-safety assumed).
+    std::vector<char> solid(size_t(nx) * ny * nz, 0);
+    size_t c = 0;
+    for (int k = 0; k < nz; ++k) for (int j = 0; j < ny; ++j) for (int i = 0; i < nx; ++i, ++c)
+        solid[c] = inside(origin + (glm::dvec3(i, j, k) + 0.5) * h) ? 1 : 0;
+    return buildModel(origin, h, nx, ny, nz, solid);
+}
+
 VoxelFemModel FemSolver::voxelizeBox(const glm::dvec3& center, const glm::dvec3& half, double h) {
     const glm::dvec3 origin = center - half;
     const int nx = std::max(1, int(std::lround(2.0 * half.x / h)));
@@ -158,32 +247,55 @@ VoxelFemModel FemSolver::voxelizeMesh(const std::vector<glm::vec3>& verts,
     const int ny = std::max(1, int(std::ceil((hi.y - lo.y) / h)));
     const int nz = std::max(1, int(std::ceil((hi.z - lo.z) / h)));
     // Inside test: +x ray vs triangles (parity). Watertight-solid assumption.
-    auto inside = [&](const glm::dvec3& p) -> bool {
-        int crossings = 0;
+    // Scanline form: one ray per (j,k) cell row collects every crossing x (only
+    // triangles whose YZ box holds the row, via the BVH), then a cell centre is
+    // inside iff an odd number of crossings lie beyond it. Rows are independent ->
+    // z-slabs run in parallel; the model is merged serially in the usual order.
+    const size_t nTri = indices.size() / 3;
+    std::vector<std::array<glm::dvec3, 3>> tris(nTri);
+    std::vector<std::array<double, 4>> box(nTri);
+    for (size_t t = 0; t < nTri; ++t) {
+        for (int v = 0; v < 3; ++v) tris[t][v] = glm::dvec3(verts[indices[3 * t + v]]);
+        box[t] = { std::min({ tris[t][0].y, tris[t][1].y, tris[t][2].y }), std::min({ tris[t][0].z, tris[t][1].z, tris[t][2].z }),
+                   std::max({ tris[t][0].y, tris[t][1].y, tris[t][2].y }), std::max({ tris[t][0].z, tris[t][1].z, tris[t][2].z }) };
+    }
+    YzBvh bvh; bvh.build(box);
+    std::vector<char> solid(size_t(nx) * ny * nz, 0);
+    krs::par::parallelFor(size_t(nz), 1, [&](size_t k0, size_t k1) {
+        std::vector<double> xs;
         const glm::dvec3 dir(1.0, 0.0, 0.0);
-        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
-            const glm::dvec3 a = glm::dvec3(verts[indices[t]]);
-            const glm::dvec3 b = glm::dvec3(verts[indices[t + 1]]);
-            const glm::dvec3 c = glm::dvec3(verts[indices[t + 2]]);
-            // Moller-Trumbore.
-            const glm::dvec3 e1 = b - a, e2 = c - a;
-            const glm::dvec3 pv = glm::cross(dir, e2);
-            const double det = glm::dot(e1, pv);
-            if (std::abs(det) < 1e-12) continue;
-            const double inv = 1.0 / det;
-            const glm::dvec3 tv = p - a;
-            const double u = glm::dot(tv, pv) * inv; if (u < 0.0 || u > 1.0) continue;
-            const glm::dvec3 qv = glm::cross(tv, e1);
-            const double v = glm::dot(dir, qv) * inv; if (v < 0.0 || u + v > 1.0) continue;
-            const double tt = glm::dot(e2, qv) * inv;
-            if (tt > 1e-9) ++crossings;
+        for (int k = int(k0); k < int(k1); ++k) for (int j = 0; j < ny; ++j) {
+            const glm::dvec3 p = lo + (glm::dvec3(0, j, k) + 0.5) * h;    // row start (cell i = 0)
+            xs.clear();
+            bvh.query(p.y, p.z, [&](int t) {
+                // Moller-Trumbore; u, v do not depend on the ray origin's x.
+                const glm::dvec3& a = tris[t][0];
+                const glm::dvec3 e1 = tris[t][1] - a, e2 = tris[t][2] - a;
+                const glm::dvec3 pv = glm::cross(dir, e2);
+                const double det = glm::dot(e1, pv);
+                if (std::abs(det) < 1e-12) return;
+                const double inv = 1.0 / det;
+                const glm::dvec3 tv = p - a;
+                const double u = glm::dot(tv, pv) * inv; if (u < 0.0 || u > 1.0) return;
+                const glm::dvec3 qv = glm::cross(tv, e1);
+                const double v = glm::dot(dir, qv) * inv; if (v < 0.0 || u + v > 1.0) return;
+                xs.push_back(p.x + glm::dot(e2, qv) * inv);
+            });
+            std::sort(xs.begin(), xs.end());
+            size_t behind = 0;                                      // crossings at x <= centre
+            char* row = solid.data() + (size_t(k) * ny + j) * nx;
+            for (int i = 0; i < nx; ++i) {
+                const double xc = p.x + i * h;
+                while (behind < xs.size() && xs[behind] <= xc + 1e-9) ++behind;
+                row[i] = ((xs.size() - behind) & 1) ? 1 : 0;
+            }
         }
-        return (crossings & 1) != 0;
-    };
-    return voxelize(lo, h, nx, ny, nz, inside);
+    });
+    return buildModel(lo, h, nx, ny, nz, solid);
 }
 
-ElasticResult FemSolver::solveElastic(const VoxelFemModel& m, const FemMaterial& mat, const ElasticBC& bc) {
+ElasticResult FemSolver::solveElastic(const VoxelFemModel& m, const FemMaterial& mat, const ElasticBC& bc,
+                                      FemLinearSolver solver) {
     ElasticResult r;
     if (!m.valid()) return r;
     // Well-posedness: a body with NO fixed nodes but under load (gravity / applied
@@ -194,33 +306,54 @@ ElasticResult FemSolver::solveElastic(const VoxelFemModel& m, const FemMaterial&
         std::printf("[FEM] solveElastic: no fixed nodes under load -> unrestrained; skipped.\n");
         return r;
     }
+    const auto tAsm = std::chrono::steady_clock::now();
     const int nDof = 3 * m.numNodes;
-    const auto Ke = hexElastic(mat.E, mat.nu, m.h);
-    std::vector<Trip> trips; trips.reserve(m.elements.size() * 24 * 24);
     Vec f = Vec::Zero(nDof);
     const double cellW = mat.rho * (m.h * m.h * m.h) / 8.0; // body-force lump per node
-    for (const auto& e : m.elements) {
-        for (int a = 0; a < 8; ++a) {
-            for (int c = 0; c < 3; ++c) f[3 * e[a] + c] += cellW * bc.gravity[c];
-            for (int b = 0; b < 8; ++b)
-                for (int ci = 0; ci < 3; ++ci) for (int cj = 0; cj < 3; ++cj)
-                    trips.emplace_back(3 * e[a] + ci, 3 * e[b] + cj, Ke(3 * a + ci, 3 * b + cj));
-        }
-    }
-    SpMat K(nDof, nDof); K.setFromTriplets(trips.begin(), trips.end());
+    for (const auto& e : m.elements)
+        for (int a = 0; a < 8; ++a) for (int c = 0; c < 3; ++c) f[3 * e[a] + c] += cellW * bc.gravity[c];
     for (const auto& nf : bc.nodalForces) for (int c = 0; c < 3; ++c) f[3 * nf.first + c] += nf.second[c];
-    const double P = 1.0e9 * maxDiag(K);
-    for (int n : bc.fixedNodes) for (int c = 0; c < 3; ++c) K.coeffRef(3 * n + c, 3 * n + c) += P; // u=0 penalty
-    Eigen::SimplicialLDLT<SpMat> solver; solver.compute(K);
-    if (solver.info() != Eigen::Success) return r;
-    const Vec u = solver.solve(f);
-    if (solver.info() != Eigen::Success) return r;
 
-    // Net constraint reaction = sum over fixed DOFs of the penalty spring force P*u. At static
-    // equilibrium this balances the applied load (nodalForces + mass*gravity), per Newton.
+    if (solver == FemLinearSolver::Auto)
+        solver = nDof > kDirectMaxDofs ? FemLinearSolver::MultigridPCG : FemLinearSolver::DirectLDLT;
+    Vec u;
     glm::dvec3 react(0.0);
-    for (int n : bc.fixedNodes) for (int c = 0; c < 3; ++c) react[c] += P * u[3 * n + c];
+    auto tSolve = std::chrono::steady_clock::now();
+    if (solver == FemLinearSolver::MultigridPCG) {
+        // Matrix-free: u = 0 on the fixed nodes is eliminated exactly, and the reaction
+        // is the out-of-balance force there, f_fixed - (K u)_fixed (same quantity the
+        // penalty spring P*u measures below).
+        std::vector<char> fixed(m.numNodes, 0);
+        for (int n : bc.fixedNodes) fixed[n] = 1;
+        const VoxelMultigrid<3> mg(m, [&](double h) { return hexElastic(mat.E, mat.nu, h); }, fixed);
+        tSolve = std::chrono::steady_clock::now();          // hierarchy setup counts as assembly
+        r.assemblySec = std::chrono::duration<double>(tSolve - tAsm).count();
+        u = Vec::Zero(nDof);
+        const MgStats st = mg.solve(f, u);
+        if (!st.converged) {
+            std::printf("[FEM] solveElastic: MG-PCG not converged (it=%d rel=%.3g); skipped.\n",
+                        st.iterations, st.relResidual);
+            return r;
+        }
+        r.iterations = st.iterations;
+        Vec Ku; mg.apply(u, Ku);
+        for (int n : bc.fixedNodes) for (int c = 0; c < 3; ++c) react[c] += f[3 * n + c] - Ku[3 * n + c];
+    } else {
+        SpMat K = assembleHex<3>(m, hexElastic(mat.E, mat.nu, m.h));
+        const double P = 1.0e9 * maxDiag(K);
+        for (int n : bc.fixedNodes) for (int c = 0; c < 3; ++c) K.coeffRef(3 * n + c, 3 * n + c) += P; // u=0 penalty
+        tSolve = std::chrono::steady_clock::now();
+        r.assemblySec = std::chrono::duration<double>(tSolve - tAsm).count();
+        Eigen::SimplicialLDLT<SpMat> ldlt; ldlt.compute(K);
+        if (ldlt.info() != Eigen::Success) return r;
+        u = ldlt.solve(f);
+        if (ldlt.info() != Eigen::Success) return r;
+        // Net constraint reaction = sum over fixed DOFs of the penalty spring force P*u. At static
+        // equilibrium this balances the applied load (nodalForces + mass*gravity), per Newton.
+        for (int n : bc.fixedNodes) for (int c = 0; c < 3; ++c) react[c] += P * u[3 * n + c];
+    }
     r.netReaction = react;
+    r.solveSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tSolve).count();
 
     r.displacement.resize(m.numNodes);
     for (int n = 0; n < m.numNodes; ++n) r.displacement[n] = glm::dvec3(u[3 * n], u[3 * n + 1], u[3 * n + 2]);
@@ -230,19 +363,24 @@ ElasticResult FemSolver::solveElastic(const VoxelFemModel& m, const FemMaterial&
     // points and extrapolate to nodes; ~5-10% better, ROADMAP §L.)
     const auto D = elasticityD(mat.E, mat.nu);
     const auto B0 = strainB(0.0, 0.0, 0.0, m.h);
+    std::vector<double> vmEl(m.elements.size()), enEl(m.elements.size());
+    krs::par::parallelFor(m.elements.size(), 1024, [&](size_t lo, size_t hi) {
+        for (size_t el = lo; el < hi; ++el) {
+            const auto& e = m.elements[el];
+            Eigen::Matrix<double, 24, 1> ue;
+            for (int a = 0; a < 8; ++a) for (int c = 0; c < 3; ++c) ue[3 * a + c] = u[3 * e[a] + c];
+            const Eigen::Matrix<double, 6, 1> eps = B0 * ue;
+            const Eigen::Matrix<double, 6, 1> s = D * eps;
+            vmEl[el] = std::sqrt(std::max(0.0,
+                0.5 * ((s[0] - s[1]) * (s[0] - s[1]) + (s[1] - s[2]) * (s[1] - s[2]) + (s[2] - s[0]) * (s[2] - s[0]))
+                + 3.0 * (s[3] * s[3] + s[4] * s[4] + s[5] * s[5])));
+            enEl[el] = std::sqrt(eps[0] * eps[0] + eps[1] * eps[1] + eps[2] * eps[2]
+                + 0.5 * (eps[3] * eps[3] + eps[4] * eps[4] + eps[5] * eps[5]));
+        }
+    });
     std::vector<double> vmAcc(m.numNodes, 0.0), enAcc(m.numNodes, 0.0); std::vector<int> cnt(m.numNodes, 0);
-    for (const auto& e : m.elements) {
-        Eigen::Matrix<double, 24, 1> ue;
-        for (int a = 0; a < 8; ++a) for (int c = 0; c < 3; ++c) ue[3 * a + c] = u[3 * e[a] + c];
-        const Eigen::Matrix<double, 6, 1> eps = B0 * ue;
-        const Eigen::Matrix<double, 6, 1> s = D * eps;
-        const double vm = std::sqrt(std::max(0.0,
-            0.5 * ((s[0] - s[1]) * (s[0] - s[1]) + (s[1] - s[2]) * (s[1] - s[2]) + (s[2] - s[0]) * (s[2] - s[0]))
-            + 3.0 * (s[3] * s[3] + s[4] * s[4] + s[5] * s[5])));
-        const double en = std::sqrt(eps[0] * eps[0] + eps[1] * eps[1] + eps[2] * eps[2]
-            + 0.5 * (eps[3] * eps[3] + eps[4] * eps[4] + eps[5] * eps[5]));
-        for (int a = 0; a < 8; ++a) { vmAcc[e[a]] += vm; enAcc[e[a]] += en; ++cnt[e[a]]; }
-    }
+    for (size_t el = 0; el < m.elements.size(); ++el)
+        for (int nd : m.elements[el]) { vmAcc[nd] += vmEl[el]; enAcc[nd] += enEl[el]; ++cnt[nd]; }
     r.vonMises.resize(m.numNodes); r.strainNorm.resize(m.numNodes);
     for (int n = 0; n < m.numNodes; ++n) {
         const int c = std::max(1, cnt[n]);
@@ -255,11 +393,45 @@ ElasticResult FemSolver::solveElastic(const VoxelFemModel& m, const FemMaterial&
     return r;
 }
 
+// Thermal system matrix Kt (+ Ct/dt when dt > 0) + lumped convection, with the
+// Dirichlet penalty P (returned) on the pinned diagonals. Depends only on what
+// ThermalStepper keys its cache on — never on T values, sources or ambient.
+static SpMat assembleThermal(const VoxelFemModel& m, const Eigen::Matrix<double, 8, 8>& Kt,
+                             const Eigen::Matrix<double, 8, 8>& Ct, double dt, const ThermalBC& bc, double& P) {
+    Eigen::Matrix<double, 8, 8> Ke = Kt;
+    if (dt > 0.0) Ke += Ct / dt;
+    SpMat K = assembleHex<1>(m, Ke);
+    for (int sn : bc.surfaceNodes) K.coeffRef(sn, sn) += bc.convection;
+    P = 1.0e9 * maxDiag(K);
+    for (const auto& d : bc.dirichlet) K.coeffRef(d.first, d.first) += P;
+    return K;
+}
+
+// Matching RHS: (Ct/dt) T_prev + sources + h A T_amb (+ P T_d when P > 0).
+static Vec thermalRhs(const VoxelFemModel& m, const Eigen::Matrix<double, 8, 8>& Ct, double dt,
+                      const std::vector<double>* Tprev, const ThermalBC& bc, double P) {
+    Vec f = Vec::Zero(m.numNodes);
+    if (Tprev && dt > 0.0)
+        for (const auto& e : m.elements)
+            for (int a = 0; a < 8; ++a) { double acc = 0.0; for (int b = 0; b < 8; ++b) acc += Ct(a, b) / dt * (*Tprev)[e[b]]; f[e[a]] += acc; }
+    for (const auto& src : bc.nodalSource) f[src.first] += src.second;   // W lumped
+    for (int sn : bc.surfaceNodes) f[sn] += bc.convection * bc.ambientT;
+    if (P > 0.0) for (const auto& d : bc.dirichlet) f[d.first] += P * d.second;
+    return f;
+}
+
+static ThermalResult packThermal(const Vec& T) {
+    ThermalResult r;
+    r.temperature.resize(T.size()); r.minT = 1e300; r.maxT = -1e300;
+    for (int i = 0; i < T.size(); ++i) { r.temperature[i] = T[i]; r.minT = std::min(r.minT, T[i]); r.maxT = std::max(r.maxT, T[i]); }
+    r.ok = true;
+    return r;
+}
+
 static ThermalResult solveThermalImpl(const VoxelFemModel& m, const FemMaterial& mat, const ThermalBC& bc,
                                        const std::vector<double>* Tprev, double dt) {
     ThermalResult r;
     if (!m.valid()) return r;
-    const int n = m.numNodes;
     Eigen::Matrix<double, 8, 8> Kt, Ct; hexThermal(mat.k, mat.rho, mat.cp, m.h, Kt, Ct);
     const bool transient = (Tprev != nullptr) && dt > 0.0;
     // Well-posedness: a STEADY conduction solve with neither a Dirichlet pin nor a
@@ -270,30 +442,18 @@ static ThermalResult solveThermalImpl(const VoxelFemModel& m, const FemMaterial&
         std::printf("[FEM] solveThermalSteady: no Dirichlet pin or convective sink -> singular; skipped.\n");
         return r;
     }
-    std::vector<Trip> trips; trips.reserve(m.elements.size() * 64);
-    Vec f = Vec::Zero(n);
-    for (const auto& e : m.elements) {
-        for (int a = 0; a < 8; ++a) for (int b = 0; b < 8; ++b) {
-            double v = Kt(a, b);
-            if (transient) v += Ct(a, b) / dt;
-            trips.emplace_back(e[a], e[b], v);
-        }
-        if (transient) { // RHS: (Ct/dt) T_prev
-            for (int a = 0; a < 8; ++a) { double acc = 0.0; for (int b = 0; b < 8; ++b) acc += Ct(a, b) / dt * (*Tprev)[e[b]]; f[e[a]] += acc; }
-        }
-    }
-    SpMat K(n, n); K.setFromTriplets(trips.begin(), trips.end());
-    for (const auto& src : bc.nodalSource) f[src.first] += src.second;   // W lumped
-    for (int sn : bc.surfaceNodes) { K.coeffRef(sn, sn) += bc.convection; f[sn] += bc.convection * bc.ambientT; }
-    const double P = 1.0e9 * maxDiag(K);
-    for (const auto& d : bc.dirichlet) { K.coeffRef(d.first, d.first) += P; f[d.first] += P * d.second; }
+    const auto t0 = std::chrono::steady_clock::now();
+    double P = 0.0;
+    const SpMat K = assembleThermal(m, Kt, Ct, transient ? dt : 0.0, bc, P);
+    const Vec f = thermalRhs(m, Ct, dt, transient ? Tprev : nullptr, bc, P);
+    const auto t1 = std::chrono::steady_clock::now();
     Eigen::SimplicialLDLT<SpMat> solver; solver.compute(K);
     if (solver.info() != Eigen::Success) return r;
     const Vec T = solver.solve(f);
     if (solver.info() != Eigen::Success) return r;
-    r.temperature.resize(n); r.minT = 1e300; r.maxT = -1e300;
-    for (int i = 0; i < n; ++i) { r.temperature[i] = T[i]; r.minT = std::min(r.minT, T[i]); r.maxT = std::max(r.maxT, T[i]); }
-    r.ok = true;
+    r = packThermal(T);
+    r.assemblySec = std::chrono::duration<double>(t1 - t0).count();
+    r.solveSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
     return r;
 }
 
@@ -305,6 +465,94 @@ ThermalResult FemSolver::stepThermalTransient(const VoxelFemModel& m, const FemM
     return solveThermalImpl(m, mat, bc, &Tprev, dt);
 }
 
+// ---------------------------------------------------------------------------
+// ThermalStepper — cached factorization / MG hierarchy across transient steps.
+// ---------------------------------------------------------------------------
+namespace {
+// FNV-1a 64-bit over an arbitrary byte range.
+inline std::uint64_t fnv1a(const void* data, size_t bytes, std::uint64_t h) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+// Fingerprint of every input the system MATRIX depends on (see assembleThermal).
+// Dirichlet / surface node sets are hashed in the caller's order: a reordered but
+// equal set costs one spurious rebuild, never a stale factorization.
+std::uint64_t thermalKey(const VoxelFemModel& m, const FemMaterial& mat, const ThermalBC& bc, double dt) {
+    std::uint64_t h = 14695981039346656037ull;
+    const int dims[4] = { m.nx, m.ny, m.nz, m.numNodes };
+    const double reals[9] = { m.origin.x, m.origin.y, m.origin.z, m.h, mat.k, mat.rho, mat.cp, dt, bc.convection };
+    h = fnv1a(dims, sizeof(dims), h);
+    h = fnv1a(reals, sizeof(reals), h);
+    h = fnv1a(m.elements.data(), m.elements.size() * sizeof(m.elements[0]), h);
+    h = fnv1a(bc.surfaceNodes.data(), bc.surfaceNodes.size() * sizeof(int), h);
+    for (const auto& d : bc.dirichlet) h = fnv1a(&d.first, sizeof(d.first), h);
+    const std::uint64_t counts[2] = { bc.surfaceNodes.size(), bc.dirichlet.size() };
+    return fnv1a(counts, sizeof(counts), h);
+}
+} // namespace
+
+struct ThermalStepper::Cache {
+    std::uint64_t key = 0;
+    Eigen::Matrix<double, 8, 8> Kt, Ct;
+    double P = 0.0;                                       // direct path: Dirichlet penalty
+    Eigen::SimplicialLDLT<SpMat> ldlt;
+    std::unique_ptr<VoxelMultigrid<1>> mg;                // large models
+};
+
+ThermalStepper::ThermalStepper(FemLinearSolver solver) : m_solver(solver) {}
+ThermalStepper::~ThermalStepper() = default;
+ThermalStepper::ThermalStepper(ThermalStepper&&) noexcept = default;
+ThermalStepper& ThermalStepper::operator=(ThermalStepper&&) noexcept = default;
+
+void ThermalStepper::invalidate() { m_cache.reset(); }
+
+ThermalResult ThermalStepper::step(const VoxelFemModel& m, const FemMaterial& mat, const ThermalBC& bc,
+                                   const std::vector<double>& Tprev, double dt) {
+    ThermalResult r;
+    m_lastReused = false;
+    if (!m.valid() || dt <= 0.0 || int(Tprev.size()) != m.numNodes) return r;
+    const std::uint64_t key = thermalKey(m, mat, bc, dt);
+    if (m_cache && m_cache->key == key) {
+        m_lastReused = true;
+    } else {
+        m_cache.reset();
+        auto c = std::make_unique<Cache>();
+        c->key = key;
+        hexThermal(mat.k, mat.rho, mat.cp, m.h, c->Kt, c->Ct);
+        const bool useMg = m_solver == FemLinearSolver::MultigridPCG
+                        || (m_solver == FemLinearSolver::Auto && m.numNodes > kDirectMaxDofs);
+        if (useMg) {
+            std::vector<char> fixed(m.numNodes, 0);
+            for (const auto& d : bc.dirichlet) fixed[d.first] = 1;
+            std::vector<double> shift(m.numNodes, 0.0);
+            for (int sn : bc.surfaceNodes) shift[sn] += bc.convection;
+            const FemMaterial mt = mat;
+            c->mg = std::make_unique<VoxelMultigrid<1>>(m, [mt, dt](double h) {
+                Eigen::Matrix<double, 8, 8> Kh, Ch; hexThermal(mt.k, mt.rho, mt.cp, h, Kh, Ch);
+                return VoxelMultigrid<1>::ElemMat(Kh + Ch / dt);
+            }, fixed, &shift);
+        } else {
+            c->ldlt.compute(assembleThermal(m, c->Kt, c->Ct, dt, bc, c->P));
+            if (c->ldlt.info() != Eigen::Success) return r;
+        }
+        m_cache = std::move(c);
+        ++m_factorizations;
+    }
+    const Cache& c = *m_cache;
+    if (c.mg) {
+        // Dirichlet values are eliminated (held in x), so no penalty term in the RHS.
+        const Vec f = thermalRhs(m, c.Ct, dt, &Tprev, bc, 0.0);
+        Vec T = Eigen::Map<const Vec>(Tprev.data(), m.numNodes);
+        for (const auto& d : bc.dirichlet) T[d.first] = d.second;
+        if (!c.mg->solve(f, T).converged) return r;
+        return packThermal(T);
+    }
+    const Vec T = c.ldlt.solve(thermalRhs(m, c.Ct, dt, &Tprev, bc, c.P));
+    if (c.ldlt.info() != Eigen::Success) return r;
+    return packThermal(T);
+}
+
 std::future<ElasticResult> FemSolver::solveElasticAsync(VoxelFemModel m, FemMaterial mat, ElasticBC bc) {
     return std::async(std::launch::async, [m = std::move(m), mat, bc = std::move(bc)]() { return solveElastic(m, mat, bc); });
 }
@@ -401,6 +649,225 @@ bool FemSolver::runSelfTests() {
         check("plate-with-hole stress concentration (Kt>2)", r.ok && Kt > 2.0,
               fmt("maxVM", r.maxVonMises) + " " + fmt("sigNom", sigNom) + " " + fmt("Kt", Kt));
     }
+    // --- Test 5: matrix-free MG-PCG vs direct LDLT on the same systems (cantilever under
+    // gravity + tip load, plate with a hole). Displacement and reaction must agree. ---
+    {
+        auto agree = [&](const char* name, const VoxelFemModel& mdl, const ElasticBC& bc) {
+            const ElasticResult d = solveElastic(mdl, steel, bc, FemLinearSolver::DirectLDLT);
+            const ElasticResult g = solveElastic(mdl, steel, bc, FemLinearSolver::MultigridPCG);
+            double du = 0.0, uMax = 0.0;
+            if (d.ok && g.ok)
+                for (int n = 0; n < mdl.numNodes; ++n) {
+                    du = std::max(du, glm::length(d.displacement[n] - g.displacement[n]));
+                    uMax = std::max(uMax, glm::length(d.displacement[n]));
+                }
+            const double relU = uMax > 0.0 ? du / uMax : 1.0;
+            const double relR = glm::length(d.netReaction - g.netReaction) / std::max(1e-12, glm::length(d.netReaction));
+            const double relVM = std::abs(d.maxVonMises - g.maxVonMises) / std::max(1e-12, d.maxVonMises);
+            check(name, d.ok && g.ok && relU < 1e-6 && relR < 1e-6 && relVM < 1e-6,
+                  fmt("dofs", 3.0 * mdl.numNodes) + " " + fmt("it", g.iterations) + " " + fmt("relU", relU)
+                  + " " + fmt("relReact", relR) + " " + fmt("relVM", relVM));
+        };
+        {
+            const double L = 1.0, b = 0.1, hC = 0.1, h = 0.1 / 6.0;
+            VoxelFemModel mdl = voxelizeBox(glm::dvec3(L / 2, 0, 0), glm::dvec3(L / 2, hC / 2, b / 2), h);
+            ElasticBC bc; bc.fixedNodes = faceNodes(mdl, 0, false);
+            auto tip = faceNodes(mdl, 0, true);
+            for (int n : tip) bc.nodalForces.push_back({ n, glm::dvec3(0, -1000.0 / tip.size(), 0) });
+            bc.gravity = glm::dvec3(0, 0, -9.81);
+            agree("MG-PCG == LDLT (cantilever)", mdl, bc);
+        }
+        {
+            const double Lx = 0.4, Ly = 0.2, h = 0.01, holeR = 0.04;
+            const glm::dvec2 hole(Lx / 2, Ly / 2);
+            VoxelFemModel mdl = voxelize(glm::dvec3(0.0), h, 40, 20, 5, [&](const glm::dvec3& c) {
+                return glm::length(glm::dvec2(c.x, c.y) - hole) > holeR; });
+            ElasticBC bc; bc.fixedNodes = faceNodes(mdl, 0, false);
+            auto tip = faceNodes(mdl, 0, true);
+            for (int n : tip) bc.nodalForces.push_back({ n, glm::dvec3(1.0e6 / tip.size(), 0, 0) });
+            agree("MG-PCG == LDLT (plate with hole)", mdl, bc);
+        }
+    }
+    // --- Test 6: MG-PCG scaling. Clamped N^3 block under gravity at N/2 and N cells per
+    // axis (KRS_FEM_MG_N, default 48; 200 = the production target). Iterations must stay
+    // flat (mesh-independent preconditioner) and memory per node bounded (linear). The
+    // reaction balances the weight, so the large solve is checked, not just timed. ---
+    {
+        const char* env = std::getenv("KRS_FEM_MG_N");
+        const int N = std::max(32, env ? std::atoi(env) : 48);  // N/2 must already be multi-level
+        int itHalf = 0;
+        for (int n : { N / 2, N }) {
+            const double h = 1.0 / n;
+            const size_t mem0 = krs::processWorkingSetBytes();
+            VoxelFemModel mdl = voxelizeBox(glm::dvec3(0.5), glm::dvec3(0.5), h);
+            ElasticBC bc; bc.fixedNodes = faceNodes(mdl, 2, false);
+            bc.gravity = glm::dvec3(0, 0, -9.81);
+            const auto t0 = std::chrono::steady_clock::now();
+            const ElasticResult r = solveElastic(mdl, steel, bc, FemLinearSolver::MultigridPCG);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            const size_t mem1 = krs::processWorkingSetBytes();
+            const double weight = steel.rho * 9.81;              // unit cube
+            const double relR = std::abs(std::abs(r.netReaction.z) - weight) / weight;
+            const double bytesPerNode = mem1 > mem0 ? double(mem1 - mem0) / mdl.numNodes : 0.0;
+            const bool flat = n != N || r.iterations <= 2 * std::max(1, itHalf) + 2;
+            if (n != N) itHalf = r.iterations;
+            char nm[64]; std::snprintf(nm, sizeof(nm), "MG-PCG %d^3 cells (%u threads)", n,
+                                      krs::par::ThreadPool::global().size());
+            check(nm, r.ok && relR < 1e-6 && flat,
+                  fmt("dofs", 3.0 * mdl.numNodes) + " " + fmt("it", r.iterations) + " " + fmt("sec", sec)
+                  + " " + fmt("B/node", bytesPerNode) + " " + fmt("relReact", relR));
+        }
+    }
+    // --- Test 7: heat soak with ThermalStepper. A bar heated at one end, pinned at the
+    // other, convecting on its top face, stepped 40x. The cached factorization must give
+    // the stateless step's temperatures bit-for-bit with ONE factorization, and the per-
+    // step cost must drop. Changing a Dirichlet VALUE reuses the factor; changing dt (a
+    // keyed input) must rebuild (NEG-CTRL: the cache is not blindly reused). The MG
+    // hierarchy path must match the LDLT path. ---
+    {
+        const double h = 0.0125;
+        VoxelFemModel mdl = voxelizeBox(glm::dvec3(0.5, 0.05, 0.05), glm::dvec3(0.5, 0.05, 0.05), h);
+        ThermalBC bc;
+        for (int n : faceNodes(mdl, 0, false)) bc.dirichlet.push_back({ n, 20.0 });
+        const auto hot = faceNodes(mdl, 0, true);
+        for (int n : hot) bc.nodalSource.push_back({ n, 500.0 / hot.size() });
+        bc.surfaceNodes = faceNodes(mdl, 1, true);
+        bc.convection = 25.0 * h * h;
+        const double dt = 2.0;
+        const int steps = 40;
+        std::vector<double> T0(mdl.numNodes, 20.0), Ta = T0, Tb = T0, Tc = T0;
+        ThermalStepper direct(FemLinearSolver::DirectLDLT), mg(FemLinearSolver::MultigridPCG);
+        double secA = 0.0, secB = 0.0, dAB = 0.0, dMG = 0.0;
+        bool ok = true;
+        for (int s = 0; s < steps; ++s) {
+            auto t0 = std::chrono::steady_clock::now();
+            const ThermalResult ra = stepThermalTransient(mdl, steel, bc, Ta, dt);
+            auto t1 = std::chrono::steady_clock::now();
+            const ThermalResult rb = direct.step(mdl, steel, bc, Tb, dt);
+            auto t2 = std::chrono::steady_clock::now();
+            const ThermalResult rc = mg.step(mdl, steel, bc, Tc, dt);
+            ok = ok && ra.ok && rb.ok && rc.ok;
+            if (!ok) break;
+            secA += std::chrono::duration<double>(t1 - t0).count();
+            secB += std::chrono::duration<double>(t2 - t1).count();
+            Ta = ra.temperature; Tb = rb.temperature; Tc = rc.temperature;
+        }
+        double rise = 0.0;
+        for (int n = 0; ok && n < mdl.numNodes; ++n) {
+            dAB = std::max(dAB, std::abs(Ta[n] - Tb[n]));
+            dMG = std::max(dMG, std::abs(Tb[n] - Tc[n]));
+            rise = std::max(rise, Tb[n] - 20.0);
+        }
+        const double speedup = secB > 0.0 ? secA / secB : 0.0;
+        check("ThermalStepper == stateless step (1 factorization)",
+              ok && dAB == 0.0 && direct.factorizations() == 1 && direct.lastReused() && rise > 1.0,
+              fmt("steps", steps) + " " + fmt("nodes", mdl.numNodes) + " " + fmt("maxDiff", dAB)
+              + " " + fmt("rise", rise) + " " + fmt("factorizations", direct.factorizations()));
+        check("ThermalStepper per-step speedup", ok && speedup > 2.0,
+              fmt("stateless_ms", 1e3 * secA / steps) + " " + fmt("cached_ms", 1e3 * secB / steps)
+              + " " + fmt("speedup", speedup));
+        check("ThermalStepper MG hierarchy == LDLT", ok && dMG < 1e-6 * rise && mg.factorizations() == 1,
+              fmt("maxDiff", dMG) + " " + fmt("builds", mg.factorizations()));
+        // Dirichlet value change -> RHS only (reused); dt change -> keyed -> rebuilt.
+        ThermalBC bc2 = bc;
+        for (auto& d : bc2.dirichlet) d.second = 40.0;
+        const ThermalResult rv = direct.step(mdl, steel, bc2, Tb, dt);
+        const bool valueReused = rv.ok && direct.lastReused() && direct.factorizations() == 1;
+        const ThermalResult rd = direct.step(mdl, steel, bc2, Tb, 0.5 * dt);
+        const ThermalResult rref = stepThermalTransient(mdl, steel, bc2, Tb, 0.5 * dt);
+        double dDt = 0.0;
+        for (int n = 0; rd.ok && rref.ok && n < mdl.numNodes; ++n) dDt = std::max(dDt, std::abs(rd.temperature[n] - rref.temperature[n]));
+        check("NEG-CTRL ThermalStepper rebuilds on dt change",
+              valueReused && rd.ok && !direct.lastReused() && direct.factorizations() == 2 && dDt == 0.0,
+              fmt("factorizations", direct.factorizations()) + " " + fmt("maxDiff", dDt));
+    }
+    // --- Test 8: pipeline stages on an imported-style triangle mesh (UV sphere, r = 0.5).
+    // The BVH scanline voxelizer must reproduce the per-cell brute-force ray cast cell-for-
+    // cell (NEG-CTRL: a sphere with its hull shrunk 10% must NOT match), the voxel volume
+    // must track 4/3 pi r^3, and voxelize / assemble / solve wall times are reported. ---
+    {
+        const double R = 0.5;
+        const int nLat = 48, nLon = 96;
+        auto sphere = [&](double rad, std::vector<glm::vec3>& vs, std::vector<unsigned int>& ix) {
+            vs.clear(); ix.clear();
+            vs.push_back(glm::vec3(0, 0, float(rad)));
+            for (int a = 1; a < nLat; ++a)
+                for (int b = 0; b < nLon; ++b) {
+                    const double th = kPi * a / nLat, ph = 2.0 * kPi * b / nLon;
+                    vs.push_back(glm::vec3(float(rad * std::sin(th) * std::cos(ph)), float(rad * std::sin(th) * std::sin(ph)),
+                                           float(rad * std::cos(th))));
+                }
+            vs.push_back(glm::vec3(0, 0, float(-rad)));
+            const unsigned south = unsigned(vs.size() - 1);
+            auto ring = [&](int a, int b) { return unsigned(1 + (a - 1) * nLon + (b % nLon)); };
+            for (int b = 0; b < nLon; ++b) {
+                ix.insert(ix.end(), { 0u, ring(1, b), ring(1, b + 1) });
+                ix.insert(ix.end(), { south, ring(nLat - 1, b + 1), ring(nLat - 1, b) });
+            }
+            for (int a = 1; a + 1 < nLat; ++a)
+                for (int b = 0; b < nLon; ++b)
+                    ix.insert(ix.end(), { ring(a, b), ring(a + 1, b), ring(a + 1, b + 1),
+                                          ring(a, b), ring(a + 1, b + 1), ring(a, b + 1) });
+        };
+        // Reference: the original per-cell +x ray cast over every triangle.
+        auto bruteModel = [](const std::vector<glm::vec3>& vs, const std::vector<unsigned int>& ix, const VoxelFemModel& like) {
+            return voxelize(like.origin, like.h, like.nx, like.ny, like.nz, [&](const glm::dvec3& p) {
+                int crossings = 0;
+                const glm::dvec3 dir(1.0, 0.0, 0.0);
+                for (size_t t = 0; t + 2 < ix.size(); t += 3) {
+                    const glm::dvec3 a(vs[ix[t]]), b(vs[ix[t + 1]]), c(vs[ix[t + 2]]);
+                    const glm::dvec3 e1 = b - a, e2 = c - a, pv = glm::cross(dir, e2);
+                    const double det = glm::dot(e1, pv);
+                    if (std::abs(det) < 1e-12) continue;
+                    const double inv = 1.0 / det;
+                    const glm::dvec3 tv = p - a;
+                    const double u = glm::dot(tv, pv) * inv; if (u < 0.0 || u > 1.0) continue;
+                    const glm::dvec3 qv = glm::cross(tv, e1);
+                    const double v = glm::dot(dir, qv) * inv; if (v < 0.0 || u + v > 1.0) continue;
+                    if (glm::dot(e2, qv) * inv > 1e-9) ++crossings;
+                }
+                return (crossings & 1) != 0;
+            });
+        };
+        auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+            return 1e3 * std::chrono::duration<double>(b - a).count(); };
+        std::vector<glm::vec3> vs, vsSmall; std::vector<unsigned int> ix, ixSmall;
+        sphere(R, vs, ix);
+        sphere(0.9 * R, vsSmall, ixSmall);
+        const double hRef = 0.04;
+        auto t0 = std::chrono::steady_clock::now();
+        const VoxelFemModel fast = voxelizeMesh(vs, ix, hRef);
+        auto t1 = std::chrono::steady_clock::now();
+        const VoxelFemModel ref = bruteModel(vs, ix, fast);
+        auto t2 = std::chrono::steady_clock::now();
+        const VoxelFemModel shrunk = bruteModel(vsSmall, ixSmall, fast);
+        const bool same = fast.elements == ref.elements && fast.nodeId == ref.nodeId;
+        check("BVH scanline voxelizer == brute-force ray cast", same && fast.valid(),
+              fmt("tris", ix.size() / 3.0) + " " + fmt("cells", double(fast.elements.size()))
+              + " " + fmt("bvh_ms", ms(t0, t1)) + " " + fmt("brute_ms", ms(t1, t2)));
+        check("NEG-CTRL voxelizer comparison detects a different solid", shrunk.elements != fast.elements,
+              fmt("cells", double(fast.elements.size())) + " " + fmt("shrunk", double(shrunk.elements.size())));
+
+        // Stage timings (43k elastic DOFs -> Auto picks MG-PCG; thermal steady is LDLT).
+        const double h = 0.035;
+        t0 = std::chrono::steady_clock::now();
+        const VoxelFemModel mdl = voxelizeMesh(vs, ix, h);
+        t1 = std::chrono::steady_clock::now();
+        const double vol = mdl.elements.size() * h * h * h, volExact = 4.0 / 3.0 * kPi * R * R * R;
+        ElasticBC bc;
+        for (int n = 0; n < mdl.numNodes; ++n) if (mdl.nodePos[n].z < -0.4) bc.fixedNodes.push_back(n);
+        bc.gravity = glm::dvec3(0, 0, -9.81);
+        const ElasticResult r = solveElastic(mdl, steel, bc);
+        ThermalBC tb;
+        for (int n : bc.fixedNodes) tb.dirichlet.push_back({ n, 20.0 });
+        tb.nodalSource.push_back({ mdl.nearestNode(glm::dvec3(0, 0, 0.45)), 100.0 });
+        const ThermalResult tr = solveThermalSteady(mdl, steel, tb);
+        check("FEM pipeline stages (sphere mesh)", r.ok && tr.ok && std::abs(vol / volExact - 1.0) < 0.05,
+              fmt("threads", krs::par::ThreadPool::global().size()) + " " + fmt("nodes", mdl.numNodes)
+              + " " + fmt("vol/exact", vol / volExact) + " " + fmt("voxelize_ms", ms(t0, t1)) + " " + fmt("mg_it", r.iterations)
+              + " " + fmt("elastic_asm_ms", 1e3 * r.assemblySec) + " " + fmt("elastic_solve_ms", 1e3 * r.solveSec)
+              + " " + fmt("thermal_asm_ms", 1e3 * tr.assemblySec) + " " + fmt("thermal_solve_ms", 1e3 * tr.solveSec));
+    }
 
     printf("[FEM selftest] overall: %s\n", all ? "ALL PASS" : "FAILURES PRESENT");
     std::fflush(stdout);
@@ -0,0 +1,333 @@
+// ===========================================================================
+// OMPL sprint, Phase 6 — krs::plan path post-processing implementation.
+//
+// TOPP-RA works on the path parameter s with u = sdd and x = sd^2, for which
+// x_{i+1} = x_i + 2*ds*u_i and every joint constraint is LINEAR in (u, x):
+//   velocity : q'(s)^2 x <= vMax^2
+//   accel    : |q'(s) u + q''(s) x| <= aMax
+//   torque   : |a(s) u + b(s) x + c(s)| <= tauMax,
+//              a = RNEA(q, 0, q', 0) = M q',  b = RNEA(q, q', q'', 0) = M q'' + C(q,q')q',
+//              c = RNEA(q, 0, 0, g)
+// The backward pass computes the controllable sets K_i (the x from which the
+// rest-at-goal end state is still reachable); the forward pass then takes the
+// greedy max-u step that stays inside K_{i+1}. u is eliminated from each
+// two-variable stage problem exactly (Fourier–Motzkin), so the result is
+// deterministic and needs no LP solver.
+// ===========================================================================
+#include "TrajectoryOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace krs::plan {
+
+namespace {
+
+constexpr double kXCap = 1e6;    // sd^2 cap where q'(s) vanishes (tripled fallback corners)
+constexpr double kUCap = 1e8;    // sdd cap where no constraint involves u
+constexpr double kTiny = 1e-12;
+
+// Reflected phantom end points (2*P0 - P1): the curve then starts/ends exactly
+// on the end control points with a non-zero tangent and zero curvature, so the
+// path derivative never vanishes at the rest states.
+std::vector<Eigen::VectorXd> padEnds(const std::vector<Eigen::VectorXd>& c) {
+    std::vector<Eigen::VectorXd> p;
+    if (c.empty()) return p;
+    const size_t n = c.size();
+    p.reserve(n + 2);
+    p.push_back(n > 1 ? Eigen::VectorXd(2.0 * c[0] - c[1]) : c[0]);
+    p.insert(p.end(), c.begin(), c.end());
+    p.push_back(n > 1 ? Eigen::VectorXd(2.0 * c[n - 1] - c[n - 2]) : c[n - 1]);
+    if (n == 1) { p.push_back(c[0]); p.push_back(c[0]); }
+    return p;
+}
+
+// One stage constraint lo <= a*u + b*x <= hi.
+struct Row { double a, b, lo, hi; };
+
+// Feasible x-interval of { x >= 0 : exists u with every row satisfied }.
+bool feasibleX(const std::vector<Row>& rows, double& xlo, double& xhi) {
+    xlo = 0.0; xhi = kXCap;
+    bool ok = true;
+    auto bound = [&](double alpha, double beta) {            // alpha*x <= beta
+        if (std::abs(alpha) < kTiny) { ok = ok && beta >= -1e-9; return; }
+        if (alpha > 0.0) xhi = std::min(xhi, beta / alpha);
+        else             xlo = std::max(xlo, beta / alpha);
+    };
+    struct Lin { double c0, c1; };                           // c0 + c1*x
+    std::vector<Lin> lower, upper;
+    for (const Row& r : rows) {
+        if (std::abs(r.a) < kTiny) { bound(r.b, r.hi); bound(-r.b, -r.lo); continue; }
+        const Lin l{ r.lo / r.a, -r.b / r.a }, h{ r.hi / r.a, -r.b / r.a };
+        if (r.a > 0.0) { lower.push_back(l); upper.push_back(h); }
+        else           { lower.push_back(h); upper.push_back(l); }
+    }
+    for (const Lin& l : lower)
+        for (const Lin& h : upper) bound(l.c1 - h.c1, h.c0 - l.c0);   // l(x) <= h(x)
+    if (!ok) return false;
+    if (xlo > xhi) {
+        if (xlo - xhi > 1e-9 * (1.0 + std::abs(xhi))) return false;
+        xhi = xlo;                                           // round-off on an equality stage
+    }
+    return true;
+}
+
+// Feasible u-interval at a fixed x (x-only rows are the caller's business).
+void feasibleU(const std::vector<Row>& rows, double x, double& ulo, double& uhi) {
+    ulo = -kUCap; uhi = kUCap;
+    for (const Row& r : rows) {
+        if (std::abs(r.a) < kTiny) continue;
+        double l = (r.lo - r.b * x) / r.a, h = (r.hi - r.b * x) / r.a;
+        if (r.a < 0.0) std::swap(l, h);
+        ulo = std::max(ulo, l); uhi = std::min(uhi, h);
+    }
+}
+
+// Spans of the spline over C that leave the collision-free set.
+std::vector<int> invalidSpans(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                              const std::vector<Eigen::VectorXd>& C, double resolution) {
+    std::vector<int> bad;
+    const BSplinePath sp(C);
+    const std::vector<Eigen::VectorXd> Q = padEnds(C);
+    for (int k = 0; k < sp.spans(); ++k) {
+        // A span's arc length is bounded by its control-polygon length.
+        const double L = (Q[k + 1] - Q[k]).norm() + (Q[k + 2] - Q[k + 1]).norm()
+                       + (Q[k + 3] - Q[k + 2]).norm();
+        const int n = std::max(1, int(std::ceil(L / std::max(1e-6, resolution))));
+        for (int j = 0; j <= n; ++j) {
+            if (!world.valid(chain, sp.eval(k + double(j) / n))) { bad.push_back(k); break; }
+        }
+    }
+    return bad;
+}
+
+} // namespace
+
+// --- BSplinePath -------------------------------------------------------------
+
+BSplinePath::BSplinePath(const std::vector<Eigen::VectorXd>& controlPoints)
+    : ctrl_(controlPoints), P_(padEnds(controlPoints)) {}
+
+Eigen::VectorXd BSplinePath::eval(double s) const {
+    Eigen::VectorXd q, dq, ddq;
+    eval(s, q, dq, ddq);
+    return q;
+}
+
+void BSplinePath::eval(double s, Eigen::VectorXd& q, Eigen::VectorXd& dq, Eigen::VectorXd& ddq) const {
+    const int n = dim();
+    if (spans() == 0) {
+        q = ctrl_.empty() ? Eigen::VectorXd() : ctrl_.front();
+        dq.setZero(n); ddq.setZero(n);
+        return;
+    }
+    const int k = std::clamp(int(std::floor(s)), 0, spans() - 1);
+    const double u = std::clamp(s - k, 0.0, 1.0), v = 1.0 - u;
+    const double b[4]   = { v * v * v / 6.0, (3 * u * u * u - 6 * u * u + 4) / 6.0,
+                            (-3 * u * u * u + 3 * u * u + 3 * u + 1) / 6.0, u * u * u / 6.0 };
+    const double db[4]  = { -v * v / 2.0, (3 * u * u - 4 * u) / 2.0,
+                            (-3 * u * u + 2 * u + 1) / 2.0, u * u / 2.0 };
+    const double ddb[4] = { v, 3 * u - 2, -3 * u + 1, u };
+    q.setZero(n); dq.setZero(n); ddq.setZero(n);
+    for (int j = 0; j < 4; ++j) {
+        q   += b[j]   * P_[k + j];
+        dq  += db[j]  * P_[k + j];
+        ddq += ddb[j] * P_[k + j];
+    }
+}
+
+// --- TimedPath ---------------------------------------------------------------
+
+void TimedPath::sample(double tq, Eigen::VectorXd& q, Eigen::VectorXd& qd, Eigen::VectorXd& qdd) const {
+    Eigen::VectorXd dq, ddq;
+    if (t.size() < 2 || tq >= total) {
+        path.eval(s.empty() ? 0.0 : s.back(), q, dq, ddq);
+        qd.setZero(q.size()); qdd.setZero(q.size());
+        return;
+    }
+    tq = std::max(0.0, tq);
+    const size_t i = std::min(size_t(std::upper_bound(t.begin(), t.end(), tq) - t.begin()) - 1,
+                              sdd.size() - 1);
+    const double tau = tq - t[i], u = sdd[i];
+    const double sv  = std::clamp(s[i] + sd[i] * tau + 0.5 * u * tau * tau, s[i], s[i + 1]);
+    const double sdv = std::max(0.0, sd[i] + u * tau);
+    path.eval(sv, q, dq, ddq);
+    qd  = dq * sdv;
+    qdd = dq * u + ddq * (sdv * sdv);
+}
+
+// --- shortcutting / smoothing ----------------------------------------------
+
+bool segmentValid(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                  const Eigen::VectorXd& a, const Eigen::VectorXd& b, double resolution) {
+    const int n = std::max(1, int(std::ceil((b - a).norm() / std::max(1e-6, resolution))));
+    for (int k = 0; k <= n; ++k)
+        if (!world.valid(chain, a + (double(k) / n) * (b - a))) return false;
+    return true;
+}
+
+std::vector<Eigen::VectorXd> shortcutPath(const krs::dyn::SerialChain& chain,
+                                          const CollisionWorld& world,
+                                          const std::vector<Eigen::VectorXd>& path,
+                                          const ShortcutOptions& opt) {
+    std::vector<Eigen::VectorXd> out = path;
+    std::mt19937 rng(opt.seed);
+    for (unsigned it = 0; it < opt.iterations && out.size() > 2; ++it) {
+        std::uniform_int_distribution<size_t> pick(0, out.size() - 1);
+        size_t i = pick(rng), j = pick(rng);
+        if (i > j) std::swap(i, j);
+        if (j - i < 2) continue;
+        if (!segmentValid(chain, world, out[i], out[j], opt.resolution)) continue;
+        out.erase(out.begin() + std::ptrdiff_t(i + 1), out.begin() + std::ptrdiff_t(j));
+    }
+    return out;
+}
+
+BSplinePath smoothPath(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                       const std::vector<Eigen::VectorXd>& polygon, const SmoothOptions& opt,
+                       unsigned* refinements, bool* fellBack) {
+    // Midpoints lie ON the polygon, so each round keeps the control polygon
+    // itself unchanged (and valid) while shrinking the rounding near corners.
+    std::vector<Eigen::VectorXd> C = polygon;
+    for (unsigned r = 0;; ++r) {
+        const std::vector<int> bad = invalidSpans(chain, world, C, opt.resolution);
+        if (bad.empty()) {
+            if (refinements) *refinements = r;
+            if (fellBack) *fellBack = false;
+            return BSplinePath(C);
+        }
+        if (r == opt.maxRefinements) break;
+        // Span k blends padded points k..k+3 = C[k-1..k+2]; split those edges.
+        std::vector<char> split(C.size(), 0);
+        for (int k : bad)
+            for (int e = k - 1; e <= k + 1; ++e)
+                if (e >= 0 && e + 1 < int(C.size())) split[e] = 1;
+        std::vector<Eigen::VectorXd> next;
+        next.reserve(2 * C.size());
+        for (size_t e = 0; e < C.size(); ++e) {
+            next.push_back(C[e]);
+            if (split[e]) next.push_back(0.5 * (C[e] + C[e + 1]));
+        }
+        C.swap(next);
+    }
+
+    // Fallback: triple every interior vertex -> each span is a straight piece of
+    // the polygon (the spline rests at the corners; the end phantoms are
+    // collinear with the first/last edge, so the end spans stay on it too).
+    std::vector<Eigen::VectorXd> T;
+    for (size_t k = 0; k < polygon.size(); ++k) {
+        const int copies = (k == 0 || k + 1 == polygon.size()) ? 1 : 3;
+        for (int c = 0; c < copies; ++c) T.push_back(polygon[k]);
+    }
+    if (refinements) *refinements = opt.maxRefinements;
+    if (fellBack) *fellBack = true;
+    return BSplinePath(T);
+}
+
+// --- TOPP-RA -----------------------------------------------------------------
+
+TimedPath toppra(const krs::dyn::SerialChain& chain, const BSplinePath& path,
+                 const JointLimits& lim, const ToppraOptions& opt) {
+    TimedPath out;
+    out.path = path;
+    const int nq = path.dim();
+    if (path.spans() == 0 || nq != chain.nq()) return out;
+
+    const int N = int(std::max<unsigned>(opt.gridPoints, 4u * unsigned(path.spans())));
+    const double S = double(path.spans()), ds = S / N;
+    const bool useVel = lim.vMax.size() == nq;
+    const bool useAcc = lim.aMax.size() == nq;
+    const bool useTau = lim.tauMax.size() == nq;
+    const Eigen::VectorXd zero = Eigen::VectorXd::Zero(nq);
+    const Eigen::Vector3d noGravity = Eigen::Vector3d::Zero();
+
+    // Per-gridpoint stage constraints (without the reachability row).
+    std::vector<std::vector<Row>> rows(N + 1);
+    out.s.resize(N + 1);
+    for (int i = 0; i <= N; ++i) {
+        out.s[i] = i * ds;
+        Eigen::VectorXd q, dq, ddq;
+        path.eval(out.s[i], q, dq, ddq);
+        std::vector<Row>& R = rows[i];
+        R.push_back({ 0.0, 1.0, 0.0, kXCap });
+        R.push_back({ 1.0, 0.0, -kUCap, kUCap });
+        for (int j = 0; j < nq; ++j) {
+            if (useVel && std::abs(dq[j]) > kTiny) {
+                const double v = lim.vMax[j] / dq[j];
+                R.push_back({ 0.0, 1.0, 0.0, v * v });
+            }
+            if (useAcc) R.push_back({ dq[j], ddq[j], -lim.aMax[j], lim.aMax[j] });
+        }
+        if (useTau) {
+            const Eigen::VectorXd a = chain.rnea(q, zero, dq, noGravity);
+            const Eigen::VectorXd b = chain.rnea(q, dq, ddq, noGravity);
+            const Eigen::VectorXd c = chain.rnea(q, zero, zero, opt.gravity);
+            for (int j = 0; j < nq; ++j)
+                R.push_back({ a[j], b[j], -lim.tauMax[j] - c[j], lim.tauMax[j] - c[j] });
+        }
+    }
+
+    // Interpolation discretization (TOPP-RA §VI): stage i also enforces the
+    // constraints of gridpoint i+1 at x + 2*ds*u, which keeps the limits from
+    // being overshot between gridpoints where the binding constraint switches.
+    std::vector<std::vector<Row>> stage(N);
+    for (int i = 0; i < N; ++i) {
+        stage[i] = rows[i];
+        for (const Row& r : rows[i + 1])
+            stage[i].push_back({ r.a + 2.0 * ds * r.b, r.b, r.lo, r.hi });
+    }
+
+    // Backward pass: controllable sets, ending at rest.
+    std::vector<double> Klo(N + 1), Khi(N + 1);
+    if (!feasibleX(rows[N], Klo[N], Khi[N]) || Klo[N] > 1e-9) return out;
+    Klo[N] = Khi[N] = 0.0;
+    for (int i = N - 1; i >= 0; --i) {
+        std::vector<Row> R = stage[i];
+        R.push_back({ 2.0 * ds, 1.0, Klo[i + 1], Khi[i + 1] });
+        if (!feasibleX(R, Klo[i], Khi[i])) return out;
+    }
+    if (Klo[0] > 1e-9) return out;                          // cannot start from rest
+
+    // Forward pass: greedy max-acceleration inside the controllable sets.
+    std::vector<double> x(N + 1, 0.0);
+    out.sdd.assign(N, 0.0);
+    for (int i = 0; i < N; ++i) {
+        std::vector<Row> R = stage[i];
+        R.push_back({ 2.0 * ds, 1.0, Klo[i + 1], Khi[i + 1] });
+        double ulo, uhi;
+        feasibleU(R, x[i], ulo, uhi);
+        x[i + 1] = (i + 1 == N) ? 0.0
+                 : std::clamp(x[i] + 2.0 * ds * uhi, Klo[i + 1], Khi[i + 1]);
+        out.sdd[i] = (x[i + 1] - x[i]) / (2.0 * ds);
+    }
+
+    out.sd.resize(N + 1);
+    out.t.assign(N + 1, 0.0);
+    for (int i = 0; i <= N; ++i) out.sd[i] = std::sqrt(std::max(0.0, x[i]));
+    for (int i = 0; i < N; ++i) {
+        const double v = out.sd[i] + out.sd[i + 1];
+        if (v < kTiny) return out;                          // stalled: no motion possible
+        out.t[i + 1] = out.t[i] + 2.0 * ds / v;
+    }
+    out.total = out.t[N];
+    out.ok = true;
+    return out;
+}
+
+PostProcessResult postProcessPath(const krs::dyn::SerialChain& chain, const CollisionWorld& world,
+                                  const JointLimits& lim, const std::vector<Eigen::VectorXd>& path,
+                                  const PostProcessOptions& opt) {
+    PostProcessResult out;
+    if (path.size() < 2) return out;
+    out.inputLength = pathLength(path);
+    out.shortcut = shortcutPath(chain, world, path, opt.shortcut);
+    out.shortcutLength = pathLength(out.shortcut);
+    const BSplinePath spline = smoothPath(chain, world, out.shortcut, opt.smooth,
+                                          &out.refinements, &out.smoothFellBack);
+    out.traj = toppra(chain, spline, lim, opt.toppra);
+    out.ok = out.traj.ok;
+    return out;
+}
+
+} // namespace krs::plan
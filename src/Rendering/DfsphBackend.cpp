@@ -8,6 +8,12 @@
 #include <QElapsedTimer>
 
 #include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 
 #if defined(KR_WITH_SPLISHSPLASH)
@@ -112,18 +118,249 @@ void sampleBoxFaces(const glm::vec3& center, const glm::vec3& halfExtents,
 }
 #endif
 
+#if defined(KR_WITH_SPLISHSPLASH)
+/// World pose of one BoxCollider as the boundary sampler sees it.
+struct BoxPose {
+    glm::vec3 center{ 0.0f };
+    glm::vec3 halfExtents{ 0.0f };
+    glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+};
+
+bool samePoses(const std::vector<BoxPose>& a, const std::vector<BoxPose>& b)
+{
+    if (a.size() != b.size()) return false;
+    constexpr float kEps = 1e-5f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (glm::any(glm::greaterThan(glm::abs(a[i].center - b[i].center), glm::vec3(kEps))) ||
+            glm::any(glm::greaterThan(glm::abs(a[i].halfExtents - b[i].halfExtents), glm::vec3(kEps))) ||
+            std::abs(std::abs(glm::dot(a[i].rotation, b[i].rotation)) - 1.0f) > kEps)
+            return false;
+    }
+    return true;
+}
+
+std::vector<BoxPose> captureBoxes(entt::registry& registry)
+{
+    std::vector<BoxPose> boxes;
+    for (auto e : registry.view<BoxCollider, TransformComponent>()) {
+        const auto& box = registry.get<BoxCollider>(e);
+        const auto& xf = registry.get<TransformComponent>(e);
+        boxes.push_back({ xf.translation + xf.rotation * (box.offset * xf.scale),
+                          box.halfExtents * xf.scale, xf.rotation });
+    }
+    return boxes;
+}
+
+/// Everything buildSim needs, copied out of the registry on the frame thread so
+/// the solver worker never touches ECS state.
+struct SceneDesc {
+    struct Volume { glm::vec3 min{ 0.0f }, max{ 0.0f }; };
+    struct Emitter { glm::vec3 position{ 0.0f }, direction{ 0.0f, -1.0f, 0.0f }; float radius = 0.05f, speed = 2.0f; };
+    FluidParams params;
+    std::vector<Volume> volumes;
+    std::vector<Emitter> emitters;
+    std::vector<BoxPose> boxes;
+    bool emit = true;
+};
+
+SceneDesc captureScene(entt::registry& registry, const FluidParams& params)
+{
+    SceneDesc s;
+    s.params = params;
+    for (auto e : registry.view<FluidVolumeComponent, TransformComponent>()) {
+        const auto& vol = registry.get<FluidVolumeComponent>(e);
+        const auto& xf = registry.get<TransformComponent>(e);
+        s.volumes.push_back({ xf.translation - vol.halfExtents, xf.translation + vol.halfExtents });
+    }
+    for (auto e : registry.view<FluidEmitterComponent, TransformComponent>()) {
+        const auto& em = registry.get<FluidEmitterComponent>(e);
+        if (!em.enabled) continue;
+        const auto& xf = registry.get<TransformComponent>(e);
+        s.emitters.push_back({ xf.translation, glm::normalize(xf.rotation * em.direction),
+                               em.emitterRadius, em.initialSpeed });
+    }
+    s.boxes = captureBoxes(registry);
+    s.emit = !qEnvironmentVariableIsSet("KRS_DFSPH_NO_EMIT");
+    return s;
+}
+#endif
+
 } // namespace
 
 struct DfsphBackend::Impl
 {
 #if defined(KR_WITH_SPLISHSPLASH)
-    bool built = false;
+    std::atomic<bool> built{ false };           // also cleared/set by worker-side boundary rebuilds
     bool playing = false;
     bool needsRebuild = true;
-    double targetTime = 0.0;
-    int lastCount = 0;
+    int lastCount = 0;                          // frame thread only
     int slowFrames = 0;
-    std::vector<GpuParticleMirror> staging;
+    SceneDesc scene;                            // last built scene (boundary rebuilds reuse it)
+    std::vector<BoxPose> postedBoxes;           // collider poses last handed to the worker
+    std::vector<GpuParticleMirror> staging;     // frame thread: newest completed step
+
+    // ---- Solver worker. While it runs it owns the Simulation/TimeManager
+    // singletons; the frame thread only touches them after stopWorker(). ----
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopRequested = false;                 // all below guarded by mtx
+    double targetTime = 0.0;                    // sim time the frame thread has asked for
+    double publishedTime = 0.0;                 // sim time of `ready`
+    bool fresh = false;                         // `ready` holds a step staging hasn't seen
+    std::vector<GpuParticleMirror> ready;       // hand-off slot between worker and frame
+    std::optional<std::vector<BoxPose>> pendingBoxes; // applied at the next step boundary
+    long long steps = 0;
+    std::vector<GpuParticleMirror> back;        // worker-owned fill buffer
+
+    /// Copy the active particles of fluid model 0 into `out` (SSBO layout).
+    static void readParticles(std::vector<GpuParticleMirror>& out)
+    {
+        FluidModel* fm = Simulation::getCurrent()->getFluidModel(0);
+        const unsigned n = std::min<unsigned>(fm->numActiveParticles(),
+                                              unsigned(FluidSystem::kMaxParticles));
+        out.resize(n);
+        for (unsigned i = 0; i < n; ++i) {
+            const Vector3r& p = fm->getPosition(i);
+            const Vector3r& v = fm->getVelocity(i);
+            out[i].posLife = glm::vec4(p[0], p[1], p[2], 1.0f);
+            out[i].vel = glm::vec4(v[0], v[1], v[2], 0.0f);
+            out[i].pred = glm::vec4(p[0], p[1], p[2], 0.0f);
+        }
+    }
+
+    void startWorker()
+    {
+        if (!built || worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopRequested = false;
+            fresh = false;
+            pendingBoxes.reset();
+            targetTime = publishedTime = TimeManager::getCurrent()->getTime();
+        }
+        worker = std::thread([this] { workerLoop(); });
+    }
+
+    void stopWorker()
+    {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopRequested = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    /// Step toward targetTime in ~frame-sized slices, publishing each completed
+    /// slice. Collider changes are applied between steps, never mid-step.
+    void workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        bool firstStep = steps == 0;
+        for (;;) {
+            cv.wait(lock, [&] {
+                return stopRequested || pendingBoxes.has_value() || publishedTime < targetTime;
+            });
+            if (stopRequested) return;
+            if (pendingBoxes) {
+                std::vector<BoxPose> boxes = std::move(*pendingBoxes);
+                pendingBoxes.reset();
+                lock.unlock();
+                rebuildBoundaries(boxes);
+                lock.lock();
+                if (!built) return;              // rebuild dropped the sim: nothing left to step
+                continue;
+            }
+            const double goal = targetTime;
+            lock.unlock();
+
+            // A boundary rebuild replaces both singletons (deleting the
+            // Simulation deletes its TimeManager), so never cache them across slices.
+            Simulation* sim = Simulation::getCurrent();
+            TimeManager* tm = TimeManager::getCurrent();
+
+            QElapsedTimer wall;
+            wall.start();
+            int n = 0;
+            while (tm->getTime() < goal && wall.elapsed() < 16) {
+                sim->getTimeStep()->step();
+                if (firstStep) {
+                    qInfo() << "[DFSPH] first substep OK in" << wall.elapsed() << "ms, dt ="
+                            << tm->getTimeStepSize();
+                    firstStep = false;
+                }
+                ++n;
+            }
+            readParticles(back);
+
+            lock.lock();
+            std::swap(back, ready);
+            fresh = true;
+            publishedTime = tm->getTime();
+            steps += n;
+        }
+    }
+
+    /// Worker side of the rigid exchange: resample the box boundaries at their
+    /// new poses and rebuild around the live fluid state (positions, velocities
+    /// and sim time carry over; only the boundary particles move).
+    void rebuildBoundaries(const std::vector<BoxPose>& boxes)
+    {
+        FluidModel* fm = Simulation::getCurrent()->getFluidModel(0);
+        const unsigned n = fm->numActiveParticles();
+        if (n == 0 && !(scene.emit && !scene.emitters.empty())) return; // buildSim would drop the sim
+        std::vector<Vector3r> pos(n), vel(n);
+        for (unsigned i = 0; i < n; ++i) {
+            pos[i] = fm->getPosition(i);
+            vel[i] = fm->getVelocity(i);
+        }
+        const Real t = TimeManager::getCurrent()->getTime();
+        SceneDesc s = scene;
+        s.boxes = boxes;
+        buildSim(s, &pos, &vel);
+        TimeManager::getCurrent()->setTime(t);
+    }
+
+    /// Frame thread: ask for `dt` more sim time and take the newest completed
+    /// step if there is one. Never waits on the solver.
+    bool pump(double dt)
+    {
+        bool got = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            targetTime += dt;
+            // Keep the backlog under ~6 frames: when the CPU can't keep up, sim
+            // time dilates instead of queuing work the viewport would wait on.
+            constexpr double kMaxLag = 0.1;
+            if (targetTime - publishedTime > kMaxLag) {
+                targetTime = publishedTime + kMaxLag;
+                if (++slowFrames == 90)
+                    qInfo() << "[DFSPH] CPU-bound: simulation running slower than real time"
+                            << "(reference tier — bake for full speed)";
+            }
+            if (fresh) {
+                std::swap(ready, staging);
+                fresh = false;
+                got = true;
+            }
+        }
+        cv.notify_one();
+        return got;
+    }
+
+    /// Frame thread: hand changed collider poses to the worker.
+    void postBoxes(std::vector<BoxPose>&& boxes)
+    {
+        if (samePoses(boxes, postedBoxes)) return;
+        postedBoxes = boxes;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            pendingBoxes = std::move(boxes);
+        }
+        cv.notify_one();
+    }
 
     void destroySim()
     {
@@ -131,13 +368,29 @@ struct DfsphBackend::Impl
         delete Simulation::getCurrent();
         Simulation::setCurrent(nullptr);
         built = false;
+    }
+
+    /// Stop the worker, then drop the simulation and every published frame.
+    void teardown()
+    {
+        stopWorker();
+        destroySim();
         lastCount = 0;
-        targetTime = 0.0;
+        staging.clear();
+        ready.clear();
+        fresh = false;
+        steps = 0;
+        targetTime = publishedTime = 0.0;
     }
 
-    void buildSim(entt::registry& registry, const FluidParams& params)
+    /// Build the solver for `s`. With `livePos`/`liveVel` the fluid is seeded
+    /// from that state instead of the scene's volumes (boundary rebuilds).
+    void buildSim(const SceneDesc& s, const std::vector<Vector3r>* livePos = nullptr,
+                  const std::vector<Vector3r>* liveVel = nullptr)
     {
         destroySim();
+        scene = s;
+        const FluidParams& params = s.params;
 
         const Real radius = std::max(0.01f, params.particleRadius * 0.7f);
         const Real spacing = 2.0f * radius;
@@ -157,27 +410,25 @@ struct DfsphBackend::Impl
         // occupy neighborhood-search point sets [0, nFluids).
         sim->setBoundaryHandlingMethod(BoundaryHandlingMethods::Akinci2012);
 
-        // ---- Fluid block(s) from FluidVolumeComponents ----
+        // ---- Fluid block(s) from FluidVolumeComponents (or the live state) ----
         std::vector<Vector3r> positions;
         std::vector<Vector3r> velocities;
-        for (auto e : registry.view<FluidVolumeComponent, TransformComponent>()) {
-            const auto& vol = registry.get<FluidVolumeComponent>(e);
-            const auto& xf = registry.get<TransformComponent>(e);
-            const glm::vec3 mn = xf.translation - vol.halfExtents;
-            const glm::vec3 mx = xf.translation + vol.halfExtents;
-            for (float x = mn.x + radius; x < mx.x; x += spacing)
-                for (float y = mn.y + radius; y < mx.y; y += spacing)
-                    for (float z = mn.z + radius; z < mx.z; z += spacing) {
-                        positions.emplace_back(x, y, z);
-                        velocities.emplace_back(0, 0, 0);
-                    }
+        if (livePos && liveVel) {
+            positions = *livePos;
+            velocities = *liveVel;
+        }
+        else {
+            for (const auto& vol : s.volumes)
+                for (float x = vol.min.x + radius; x < vol.max.x; x += spacing)
+                    for (float y = vol.min.y + radius; y < vol.max.y; y += spacing)
+                        for (float z = vol.min.z + radius; z < vol.max.z; z += spacing) {
+                            positions.emplace_back(x, y, z);
+                            velocities.emplace_back(0, 0, 0);
+                        }
         }
 
         // Reserve emitter capacity (their emitters activate from this pool).
-        unsigned maxEmitParticles = 0;
-        if (!qEnvironmentVariableIsSet("KRS_DFSPH_NO_EMIT"))
-            for (auto e : registry.view<FluidEmitterComponent>())
-                if (registry.get<FluidEmitterComponent>(e).enabled) maxEmitParticles = 30000;
+        const unsigned maxEmitParticles = (s.emit && !s.emitters.empty()) ? 30000u : 0u;
 
         if (positions.empty() && maxEmitParticles == 0) {
             qWarning() << "[DFSPH] no fluid volumes or emitters in scene — nothing to simulate";
@@ -234,24 +485,18 @@ struct DfsphBackend::Impl
             addBoundary(std::move(ground));
         }
         int boxCount = 0;
-        for (auto e : registry.view<BoxCollider, TransformComponent>()) {
-            const auto& box = registry.get<BoxCollider>(e);
-            const auto& xf = registry.get<TransformComponent>(e);
+        for (const auto& box : s.boxes) {
             std::vector<Vector3r> pts;
-            sampleBoxFaces(xf.translation + xf.rotation * (box.offset * xf.scale),
-                           box.halfExtents * xf.scale, xf.rotation, spacing, pts);
+            sampleBoxFaces(box.center, box.halfExtents, box.rotation, spacing, pts);
             addBoundary(std::move(pts));
             ++boxCount;
         }
 
         // ---- Emitters (circle nozzles emitting along the component dir) ----
-        for (auto e : registry.view<FluidEmitterComponent, TransformComponent>()) {
-            const auto& em = registry.get<FluidEmitterComponent>(e);
-            if (!em.enabled) continue;
-            const auto& xf = registry.get<TransformComponent>(e);
-            const glm::vec3 dir = glm::normalize(xf.rotation * em.direction);
+        for (const auto& em : s.emitters) {
+            if (!s.emit) break;
             // SPlisHSPlasH emitters emit along local +x.
-            const glm::vec3 x = dir;
+            const glm::vec3 x = em.direction;
             const glm::vec3 helper = std::abs(x.y) < 0.9f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
             const glm::vec3 z = glm::normalize(glm::cross(x, helper));
             const glm::vec3 y = glm::cross(z, x);
@@ -259,11 +504,11 @@ struct DfsphBackend::Impl
             rot << x.x, y.x, z.x,
                    x.y, y.y, z.y,
                    x.z, y.z, z.z;
-            const unsigned size = std::max(1u, unsigned(em.emitterRadius / radius));
+            const unsigned size = std::max(1u, unsigned(em.radius / radius));
             fm->getEmitterSystem()->addEmitter(
                 size, size,
-                Vector3r(xf.translation.x, xf.translation.y, xf.translation.z),
-                rot, em.initialSpeed, 1 /*circle*/);
+                Vector3r(em.position.x, em.position.y, em.position.z),
+                rot, em.speed, 1 /*circle*/);
         }
 
         sim->setSimulationMethod(int(SimulationMethods::DFSPH));
@@ -272,8 +517,8 @@ struct DfsphBackend::Impl
 
         TimeManager::getCurrent()->setTime(0.0);
         TimeManager::getCurrent()->setTimeStepSize(static_cast<Real>(1.0 / 240.0));
-        targetTime = 0.0;
         built = true;
+        if (livePos) return; // boundary rebuild: keep the log quiet while dragging colliders
         qInfo().nospace() << "[DFSPH] sim built: " << positions.size() << " particles, "
                           << (boxCount + 1) << " boundaries, r=" << radius
                           << " m, rho0=" << params.restDensity
@@ -407,7 +652,7 @@ DfsphBackend::DfsphBackend() : m_impl(std::make_unique<Impl>())
 DfsphBackend::~DfsphBackend()
 {
 #if defined(KR_WITH_SPLISHSPLASH)
-    m_impl->destroySim();
+    m_impl->teardown();
 #endif
 }
 
@@ -436,7 +681,7 @@ void DfsphBackend::samplePositions(std::vector<glm::vec4>& out) const
 void DfsphBackend::shutdown(QOpenGLFunctions_4_3_Core*)
 {
 #if defined(KR_WITH_SPLISHSPLASH)
-    m_impl->destroySim();
+    m_impl->teardown();
 #endif
 }
 
@@ -453,7 +698,7 @@ void DfsphBackend::setPlaying(bool playing)
 void DfsphBackend::reset()
 {
 #if defined(KR_WITH_SPLISHSPLASH)
-    m_impl->destroySim();
+    m_impl->teardown();
     m_impl->needsRebuild = true;
 #endif
 }
@@ -465,53 +710,31 @@ int DfsphBackend::update(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* g
     FluidSystem* fluidSystem = renderer.getFluidSystem();
     if (!fluidSystem) return 0;
 
+    bool seeded = false;
     if (m_impl->needsRebuild) {
-        m_impl->buildSim(registry, fluidSystem->params());
+        m_impl->teardown();
+        m_impl->buildSim(captureScene(registry, fluidSystem->params()));
         m_impl->needsRebuild = false;
+        if (!m_impl->built) return 0;
+        m_impl->postedBoxes = m_impl->scene.boxes;
+        Impl::readParticles(m_impl->staging);   // show the seeded state before the first step lands
+        qInfo() << "[DFSPH] first step starting...";
+        m_impl->startWorker();
+        seeded = true;
     }
-    if (!m_impl->built) return 0;
+    if (!m_impl->worker.joinable()) return 0;
 
-    Simulation* sim = Simulation::getCurrent();
-    TimeManager* tm = TimeManager::getCurrent();
-
-    // Advance with adaptive CFL substeps inside a hard CPU budget: when the
-    // CPU can't keep up, sim time dilates instead of freezing the editor.
-    static bool firstStep = true;
-    if (firstStep) qInfo() << "[DFSPH] first step starting...";
-    m_impl->targetTime += dt;
-    QElapsedTimer wall;
-    wall.start();
-    int substeps = 0;
-    while (tm->getTime() < m_impl->targetTime && substeps < 32 && wall.elapsed() < 50) {
-        sim->getTimeStep()->step();
-        if (firstStep) {
-            qInfo() << "[DFSPH] first substep OK in" << wall.elapsed() << "ms, dt ="
-                    << tm->getTimeStepSize();
-            firstStep = false;
-        }
-        ++substeps;
-    }
-    if (tm->getTime() < m_impl->targetTime) {
-        m_impl->targetTime = tm->getTime(); // dilation: drop unmet sim time
-        if (++m_impl->slowFrames == 90)
-            qInfo() << "[DFSPH] CPU-bound: simulation running slower than real time"
-                    << "(reference tier — bake for full speed)";
-    }
+    // Rigid coupling: moved/resized box colliders go to the worker, which
+    // resamples their boundaries at its next step boundary.
+    m_impl->postBoxes(captureBoxes(registry));
 
-    // ---- Publish positions/velocities into the shared particle SSBO ----
-    FluidModel* fm = sim->getFluidModel(0);
-    const unsigned n = std::min<unsigned>(fm->numActiveParticles(),
-                                          unsigned(FluidSystem::kMaxParticles));
+    // Request dt more sim time and take whatever step the worker finished last.
+    // The frame never waits on the solver: rendering and samplePositions() see
+    // the newest COMPLETED step, so sim throughput is decoupled from frame rate.
+    const bool got = m_impl->pump(dt) || seeded;
     auto& staging = m_impl->staging;
-    staging.resize(n);
-    for (unsigned i = 0; i < n; ++i) {
-        const Vector3r& p = fm->getPosition(i);
-        const Vector3r& v = fm->getVelocity(i);
-        staging[i].posLife = glm::vec4(p[0], p[1], p[2], 1.0f);
-        staging[i].vel = glm::vec4(v[0], v[1], v[2], 0.0f);
-        staging[i].pred = glm::vec4(p[0], p[1], p[2], 0.0f);
-    }
-    if (n > 0) {
+    const unsigned n = unsigned(staging.size());
+    if (got && n > 0) {
         gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, fluidSystem->particleBuffer());
         gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
                             GLsizeiptr(n * sizeof(GpuParticleMirror)), staging.data());
@@ -599,7 +822,8 @@ bool DfsphBackend::runFluidFidelity()
                                               // the answer -- it only buys a quicker rest state.
         params.surfaceTensionNpm = 0.0f;      // surface tension would distort the free-surface pressure datum.
 
-        m_impl->buildSim(reg, params);
+        m_impl->teardown();   // the probe steps the singleton itself -- no worker
+        m_impl->buildSim(captureScene(reg, params));
         if (!m_impl->built) { if (verbose) printf("  [build failed]\n"); return M; }
 
         Simulation*  sim = Simulation::getCurrent();
@@ -1,10 +1,25 @@
 #include "FluidCache.hpp"
+#include "FluidCacheCodec.hpp"
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
 
 namespace {
+// Legacy one-file-per-frame layout (read only).
 struct FrameHeader {
     char magic[4] = { 'K', 'R', 'F', 'C' };
     uint32_t version = 1;
@@ -13,11 +28,192 @@ struct FrameHeader {
     uint32_t particleCount = 0;
     uint32_t reserved = 0;
 };
+
+// frames.krfd / frames.krfi both start with this; index entries follow it.
+struct ContainerHeader {
+    char magic[4] = { 0, 0, 0, 0 };
+    uint32_t version = 2;
+    uint32_t reserved[2] = { 0, 0 };
+};
+static_assert(sizeof(ContainerHeader) == 16, "container header layout drift");
+
+struct IndexEntry {
+    uint64_t offset = 0;         // blob start in frames.krfd
+    uint32_t bytes = 0;          // blob size (0 = frame missing)
+    uint32_t particleCount = 0;
+    double simTime = 0.0;
+};
+static_assert(sizeof(IndexEntry) == 24, "index entry layout drift");
+
+constexpr int kPrefetchAhead = 4;   // frames decoded ahead of a sequential reader
+
+QString dataPath(const QString& dir) { return dir + QStringLiteral("/frames.krfd"); }
+QString indexPath(const QString& dir) { return dir + QStringLiteral("/frames.krfi"); }
 } // namespace
 
+struct FluidCache::Store
+{
+    QString dir;
+    bool legacy = false;                 // directory holds a pre-container bake
+
+    // ---- read side: frames.krfd mapped read-only (remapped as it grows) ----
+    QFile dataFile;
+    uchar* map = nullptr;
+    qint64 mapBytes = 0;
+
+    // ---- write side: append handles, open while recording ----
+    std::unique_ptr<QFile> dataOut, indexOut;
+    std::vector<uint8_t> scratch;
+
+    // ---- shared with the prefetch worker, guarded by mtx ----
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<IndexEntry> index;
+    std::deque<std::pair<int, Frame>> ready;   // decoded ahead, (window, window + kPrefetchAhead]
+    int window = -1;                           // last sequential read (-1 = prefetch idle)
+    int lastRead = -2;
+    int decoding = -1;                         // frame the worker is decoding
+    int failed = -1;                           // don't retry a frame that failed to decode
+    bool stop = false;
+    int64_t hits = 0, reads = 0;
+    std::thread worker;
+
+    ~Store()
+    {
+        stopWorker();
+        unmap();
+    }
+
+    void stopWorker()
+    {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        worker.join();
+        stop = false;
+    }
+
+    void unmap()
+    {
+        if (map) dataFile.unmap(map);
+        map = nullptr;
+        mapBytes = 0;
+        dataFile.close();
+    }
+
+    /// Make [0, need) of frames.krfd readable through `map`. Only the owning
+    /// (engine) thread remaps, and only once the worker has let go of it.
+    bool ensureMapped(qint64 need, std::unique_lock<std::mutex>& lock)
+    {
+        if (map && need <= mapBytes) return true;
+        cv.wait(lock, [&] { return decoding < 0; });
+        unmap();
+        dataFile.setFileName(dataPath(dir));
+        if (!dataFile.open(QIODevice::ReadOnly)) return false;
+        const qint64 size = dataFile.size();
+        if (size < need || size <= qint64(sizeof(ContainerHeader))) { dataFile.close(); return false; }
+        map = dataFile.map(0, size);
+        if (!map) { dataFile.close(); return false; }
+        mapBytes = size;
+        return true;
+    }
+
+    bool inWindow(int f) const { return window >= 0 && f > window && f <= window + kPrefetchAhead; }
+
+    int pickNext() const
+    {
+        if (window < 0) return -1;
+        for (int f = window + 1; f <= window + kPrefetchAhead && f < int(index.size()); ++f) {
+            const IndexEntry& e = index[size_t(f)];
+            if (!e.bytes || f == failed || qint64(e.offset + e.bytes) > mapBytes) continue;
+            const bool have = std::any_of(ready.begin(), ready.end(),
+                                          [f](const auto& r) { return r.first == f; });
+            if (!have) return f;
+        }
+        return -1;
+    }
+
+    void prefetchLoop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            int next = -1;
+            cv.wait(lock, [&] { return stop || (next = pickNext()) >= 0; });
+            if (stop) return;
+            const IndexEntry e = index[size_t(next)];
+            const uchar* base = map;
+            decoding = next;
+            lock.unlock();
+            Frame f;
+            const bool ok = krs::fcache::decodeFrame(base + e.offset, e.bytes, f.simTime, f.data);
+            lock.lock();
+            decoding = -1;
+            if (!ok) failed = next;
+            else if (inWindow(next)) ready.emplace_back(next, std::move(f));
+            cv.notify_all();
+        }
+    }
+
+    /// Called with the lock held after a read: slide (or disarm) the window.
+    void slideWindow(int readIndex)
+    {
+        const bool sequential = readIndex == lastRead + 1;
+        lastRead = readIndex;
+        window = sequential ? readIndex : -1;
+        ready.erase(std::remove_if(ready.begin(), ready.end(),
+                                   [&](const auto& r) { return !inWindow(r.first); }),
+                    ready.end());
+        if (sequential && !worker.joinable()) worker = std::thread([this] { prefetchLoop(); });
+    }
+
+    /// Open (creating if needed) one of the container files for writing.
+    static std::unique_ptr<QFile> openForAppend(const QString& path, const char magic[4])
+    {
+        auto f = std::make_unique<QFile>(path);
+        if (!f->open(QIODevice::ReadWrite)) return nullptr;
+        if (f->size() < qint64(sizeof(ContainerHeader))) {
+            ContainerHeader h;
+            std::memcpy(h.magic, magic, 4);
+            f->resize(0);
+            f->write(reinterpret_cast<const char*>(&h), sizeof(h));
+        }
+        return f;
+    }
+
+    void closeWriters()
+    {
+        dataOut.reset();
+        indexOut.reset();
+    }
+};
+
+FluidCache::FluidCache()
+    : m_store(std::make_unique<Store>())
+    , m_lossless(qEnvironmentVariableIntValue("KRS_FLUID_CACHE_LOSSLESS") != 0)
+{
+}
+
+FluidCache::~FluidCache() = default;
+
 void FluidCache::setDirectory(const QString& dir)
 {
+    if (dir != m_dir) {
+        Store& s = *m_store;
+        s.stopWorker();
+        s.closeWriters();
+        s.unmap();
+        std::lock_guard<std::mutex> lock(s.mtx);
+        s.index.clear();
+        s.ready.clear();
+        s.window = -1;
+        s.lastRead = -2;
+        s.failed = -1;
+    }
     m_dir = dir;
+    m_store->dir = dir;
     QDir().mkpath(dir);
     refresh();
 }
@@ -29,29 +225,131 @@ QString FluidCache::framePath(int index) const
 
 void FluidCache::refresh()
 {
+    Store& s = *m_store;
     if (m_dir.isEmpty()) { m_frameCount = 0; return; }
+    if (s.indexOut) {                       // we are the writer: the in-memory index is current
+        std::lock_guard<std::mutex> lock(s.mtx);
+        m_frameCount = int(s.index.size());
+        return;
+    }
+
+    QFile idx(indexPath(m_dir));
+    if (idx.open(QIODevice::ReadOnly)) {
+        ContainerHeader h;
+        std::vector<IndexEntry> entries;
+        if (idx.read(reinterpret_cast<char*>(&h), sizeof(h)) == qint64(sizeof(h))
+            && std::memcmp(h.magic, "KRFI", 4) == 0 && h.version == 2) {
+            entries.resize(size_t((idx.size() - qint64(sizeof(h))) / qint64(sizeof(IndexEntry))));
+            const qint64 bytes = qint64(entries.size() * sizeof(IndexEntry));
+            if (idx.read(reinterpret_cast<char*>(entries.data()), bytes) != bytes) entries.clear();
+        }
+        else {
+            qWarning() << "[FluidCache] bad frame index:" << indexPath(m_dir);
+        }
+        // A bake interrupted mid-write can index past the end of the data file.
+        const qint64 dataBytes = QFileInfo(dataPath(m_dir)).size();
+        while (!entries.empty() && qint64(entries.back().offset + entries.back().bytes) > dataBytes)
+            entries.pop_back();
+
+        std::lock_guard<std::mutex> lock(s.mtx);
+        for (auto it = s.ready.begin(); it != s.ready.end();) {
+            const size_t f = size_t(it->first);
+            const bool same = f < entries.size() && f < s.index.size()
+                           && entries[f].offset == s.index[f].offset;
+            it = same ? std::next(it) : s.ready.erase(it);
+        }
+        s.index = std::move(entries);
+        s.legacy = false;
+        m_frameCount = int(s.index.size());
+        return;
+    }
+
     const QStringList frames =
         QDir(m_dir).entryList({ QStringLiteral("frame_*.krfc") }, QDir::Files, QDir::Name);
+    s.legacy = !frames.isEmpty();
     m_frameCount = frames.size();
 }
 
 bool FluidCache::writeFrame(int index, double simTime, const std::vector<float>& interleaved)
 {
-    if (m_dir.isEmpty()) return false;
-    QFile f(framePath(index));
-    if (!f.open(QIODevice::WriteOnly)) return false;
-    FrameHeader h;
-    h.frameIndex = uint32_t(index);
-    h.simTime = simTime;
-    h.particleCount = uint32_t(interleaved.size() / 8);
-    f.write(reinterpret_cast<const char*>(&h), sizeof(h));
-    f.write(reinterpret_cast<const char*>(interleaved.data()),
-            qint64(interleaved.size() * sizeof(float)));
-    m_frameCount = std::max(m_frameCount, index + 1);
+    if (m_dir.isEmpty() || index < 0) return false;
+    Store& s = *m_store;
+    if (s.legacy) clear();   // never mix layouts in one directory
+    if (!s.dataOut) s.dataOut = Store::openForAppend(dataPath(m_dir), "KRFD");
+    if (!s.indexOut) s.indexOut = Store::openForAppend(indexPath(m_dir), "KRFI");
+    if (!s.dataOut || !s.indexOut) { s.closeWriters(); return false; }
+
+    const int count = int(interleaved.size() / krs::fcache::kFloatsPerParticle);
+    s.scratch.clear();
+    krs::fcache::encodeFrame(interleaved.data(), count, simTime,
+                             m_lossless ? krs::fcache::Mode::Lossless : krs::fcache::Mode::Quantized,
+                             s.scratch);
+
+    IndexEntry e;
+    e.offset = uint64_t(s.dataOut->size());
+    e.bytes = uint32_t(s.scratch.size());
+    e.particleCount = uint32_t(count);
+    e.simTime = simTime;
+    if (!s.dataOut->seek(qint64(e.offset))
+        || s.dataOut->write(reinterpret_cast<const char*>(s.scratch.data()), qint64(e.bytes)) != qint64(e.bytes))
+        return false;
+    s.dataOut->flush();
+
+    // Index slot `index`; a rewrite of an earlier frame re-points it (the old blob is left behind).
+    const qint64 at = qint64(sizeof(ContainerHeader)) + qint64(index) * qint64(sizeof(IndexEntry));
+    if (s.indexOut->size() < at) s.indexOut->resize(at);   // zero entries = missing frames
+    if (!s.indexOut->seek(at)
+        || s.indexOut->write(reinterpret_cast<const char*>(&e), sizeof(e)) != qint64(sizeof(e)))
+        return false;
+    s.indexOut->flush();
+
+    std::lock_guard<std::mutex> lock(s.mtx);
+    if (size_t(index) >= s.index.size()) s.index.resize(size_t(index) + 1);
+    s.index[size_t(index)] = e;
+    s.ready.erase(std::remove_if(s.ready.begin(), s.ready.end(),
+                                 [index](const auto& r) { return r.first == index; }),
+                  s.ready.end());
+    if (s.failed == index) s.failed = -1;
+    m_frameCount = int(s.index.size());
     return true;
 }
 
 bool FluidCache::readFrame(int index, Frame& out) const
+{
+    Store& s = *m_store;
+    if (s.legacy) return readLegacyFrame(index, out);
+
+    std::unique_lock<std::mutex> lock(s.mtx);
+    ++s.reads;
+    if (index < 0 || size_t(index) >= s.index.size() || !s.index[size_t(index)].bytes) return false;
+
+    // Let an in-flight prefetch of this very frame finish rather than decoding it twice.
+    s.cv.wait(lock, [&] { return s.decoding != index; });
+    auto it = std::find_if(s.ready.begin(), s.ready.end(),
+                           [index](const auto& r) { return r.first == index; });
+    bool ok = false;
+    if (it != s.ready.end()) {
+        out = std::move(it->second);
+        s.ready.erase(it);
+        ++s.hits;
+        ok = true;
+    }
+    else {
+        const IndexEntry e = s.index[size_t(index)];
+        if (!s.ensureMapped(qint64(e.offset + e.bytes), lock)) return false;
+        const uchar* base = s.map;
+        lock.unlock();   // the mapping only changes on this thread
+        ok = krs::fcache::decodeFrame(base + e.offset, e.bytes, out.simTime, out.data);
+        lock.lock();
+        if (!ok) qWarning() << "[FluidCache] corrupt frame" << index << "in" << dataPath(m_dir);
+    }
+    s.slideWindow(index);
+    lock.unlock();
+    s.cv.notify_all();
+    return ok;
+}
+
+bool FluidCache::readLegacyFrame(int index, Frame& out) const
 {
     QFile f(framePath(index));
     if (!f.open(QIODevice::ReadOnly)) return false;
@@ -70,8 +368,161 @@ bool FluidCache::readFrame(int index, Frame& out) const
 void FluidCache::clear()
 {
     if (m_dir.isEmpty()) return;
+    Store& s = *m_store;
+    s.stopWorker();
+    s.closeWriters();
+    s.unmap();
+    {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        s.index.clear();
+        s.ready.clear();
+        s.window = -1;
+        s.lastRead = -2;
+        s.failed = -1;
+        s.hits = s.reads = 0;
+    }
     QDir d(m_dir);
+    d.remove(QStringLiteral("frames.krfd"));
+    d.remove(QStringLiteral("frames.krfi"));
     for (const QString& name : d.entryList({ QStringLiteral("frame_*.krfc") }, QDir::Files))
         d.remove(name);
+    s.legacy = false;
     m_frameCount = 0;
 }
+
+FluidCache::Stats FluidCache::stats() const
+{
+    Store& s = *m_store;
+    std::lock_guard<std::mutex> lock(s.mtx);
+    Stats st;
+    for (const IndexEntry& e : s.index) {
+        if (!e.bytes) continue;
+        ++st.frames;
+        st.rawBytes += int64_t(e.particleCount) * krs::fcache::kFloatsPerParticle * int64_t(sizeof(float));
+        st.storedBytes += int64_t(e.bytes);
+    }
+    st.prefetchHits = s.hits;
+    st.reads = s.reads;
+    return st;
+}
+
+// =====================================================================================
+// Container self-test (temp directory; no GL).
+// =====================================================================================
+namespace {
+/// A drifting particle set: seeded on a lattice, advected by a smooth flow.
+std::vector<float> movingFrame(int count, int frame)
+{
+    std::vector<float> d(size_t(count) * 8, 0.0f);
+    std::mt19937 rng(1234u + uint32_t(frame));
+    std::uniform_real_distribution<float> jit(-0.001f, 0.001f);
+    const float t = frame / 60.0f;
+    for (int i = 0; i < count; ++i) {
+        float* p = d.data() + size_t(i) * 8;
+        const float x = -0.4f + 0.02f * float(i % 40), z = -0.4f + 0.02f * float((i / 40) % 40);
+        const float y = 0.02f * float(i / 1600);
+        p[0] = x + 0.05f * std::sin(t + 2.0f * z) + jit(rng);
+        p[1] = y - 0.1f * t * t + jit(rng);
+        p[2] = z + 0.05f * std::cos(t + 2.0f * x) + jit(rng);
+        p[3] = 1.0f;
+        p[4] = 0.05f * std::cos(t + 2.0f * z);
+        p[5] = -0.2f * t;
+        p[6] = -0.05f * std::sin(t + 2.0f * x);
+    }
+    return d;
+}
+} // namespace
+
+bool FluidCache::runSelfTests()
+{
+    bool pass = krs::fcache::runSelfTests();
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[FLUID-CACHE] %s %-36s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+    const int kFrames = 24, kCount = 20000;
+    std::vector<std::vector<float>> src;
+    for (int f = 0; f < kFrames; ++f) src.push_back(movingFrame(kCount, f));
+
+    // ---- lossless bake: random-order reads bit-exact ----
+    FluidCache c;
+    c.setDirectory(tmp.path());
+    c.clear();
+    c.setLossless(true);
+    bool wrote = true;
+    for (int f = 0; f < kFrames; ++f) wrote = wrote && c.writeFrame(f, f / 60.0, src[size_t(f)]);
+    std::vector<int> order(kFrames);
+    for (int f = 0; f < kFrames; ++f) order[size_t(f)] = f;
+    std::shuffle(order.begin(), order.end(), std::mt19937(5));
+    int exact = 0;
+    for (int f : order) {
+        Frame fr;
+        exact += c.readFrame(f, fr) && fr.simTime == f / 60.0 && fr.data.size() == src[size_t(f)].size()
+              && std::memcmp(fr.data.data(), src[size_t(f)].data(), fr.data.size() * sizeof(float)) == 0;
+    }
+    const Stats lossless = c.stats();
+    report(wrote && exact == kFrames, "lossless bake random access",
+           QStringLiteral("(%1/%2 frames bit-exact, %3x)").arg(exact).arg(kFrames).arg(lossless.ratio(), 0, 'f', 2));
+
+    // ---- reopen from the on-disk index, then play back sequentially ----
+    {
+        FluidCache d;
+        d.setDirectory(tmp.path());
+        Frame fr;
+        const bool reopened = d.frameCount() == kFrames && d.readFrame(17, fr)
+                           && std::memcmp(fr.data.data(), src[17].data(), fr.data.size() * sizeof(float)) == 0;
+        report(reopened, "reopen from frame index", QStringLiteral("(%1 frames indexed)").arg(d.frameCount()));
+
+        QElapsedTimer wall;
+        wall.start();
+        bool seqOk = d.readFrame(0, fr);
+        for (int f = 1; f < kFrames; ++f) {
+            QThread::msleep(16);                 // ~60 Hz playback
+            seqOk = d.readFrame(f, fr) && seqOk;
+        }
+        const Stats st = d.stats();
+        const double hitRate = double(st.prefetchHits) / double(kFrames - 1);
+        report(seqOk && hitRate >= 0.8, "sequential playback prefetched",
+               QStringLiteral("(%1/%2 frames from the prefetcher)").arg(st.prefetchHits).arg(kFrames - 1));
+    }
+
+    // ---- quantized bake: compression-ratio report ----
+    c.clear();
+    c.setLossless(false);
+    for (int f = 0; f < kFrames; ++f) c.writeFrame(f, f / 60.0, src[size_t(f)]);
+    const Stats quant = c.stats();
+    std::fprintf(stderr, "[FLUID-CACHE]      bake report: %d frames x %d particles, legacy %.2f MB -> "
+                         "lossless %.2f MB (%.2fx), quantized %.2f MB (%.2fx)\n",
+                 kFrames, kCount, quant.rawBytes / 1e6, lossless.storedBytes / 1e6, lossless.ratio(),
+                 quant.storedBytes / 1e6, quant.ratio());
+    report(quant.ratio() >= 2.5, "quantized bake ratio >= 2.5x", QStringLiteral("(%1x)").arg(quant.ratio(), 0, 'f', 2));
+
+    // ---- NEG-CTRL: a damaged blob is rejected, its neighbours still read ----
+    {
+        QFile idx(indexPath(tmp.path()));
+        IndexEntry e;
+        bool patched = idx.open(QIODevice::ReadOnly)
+                    && idx.seek(qint64(sizeof(ContainerHeader)) + 5 * qint64(sizeof(IndexEntry)))
+                    && idx.read(reinterpret_cast<char*>(&e), sizeof(e)) == qint64(sizeof(e));
+        idx.close();
+        c.setDirectory(QString());               // drop the writer + mapping before patching
+        QFile data(dataPath(tmp.path()));
+        patched = patched && data.open(QIODevice::ReadWrite) && data.seek(qint64(e.offset))
+               && data.write("XXXX", 4) == 4;
+        data.close();
+        FluidCache d;
+        d.setDirectory(tmp.path());
+        Frame fr;
+        const bool rejected = !d.readFrame(5, fr);
+        const bool neighbour = d.readFrame(6, fr) && fr.particleCount() == kCount;
+        report(patched && rejected && neighbour, "NEG-CTRL corrupt blob rejected",
+               QStringLiteral("(frame 5 %1, frame 6 %2)").arg(rejected ? "rejected" : "DECODED")
+                   .arg(neighbour ? "intact" : "LOST"));
+    }
+
+    std::fprintf(stderr, "[FLUID-CACHE] container %s\n", pass ? "ALL PASS" : "FAIL");
+    return pass;
+}
@@ -0,0 +1,540 @@
+#include "FluidCacheCodec.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace krs::fcache {
+
+namespace {
+
+constexpr char kMagic[4] = { 'K', 'R', 'F', 'B' };
+constexpr uint32_t kVersion = 2;
+constexpr size_t kFrameHeaderBytes = 4 + 4 + 4 + 4 + 8 + 4;   // magic, version, mode, count, simTime, blocks
+constexpr uint32_t kBlockStored = 1u;                          // payload kept raw (LZ did not help)
+
+template <typename T>
+void put(std::vector<uint8_t>& out, const T& v)
+{
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &v, sizeof(T));
+}
+
+/// Bounds-checked little reader over a blob.
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    template <typename T>
+    bool get(T& v)
+    {
+        if (size_t(end - p) < sizeof(T)) return false;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+};
+
+uint32_t floatBits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+float bitsFloat(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+// ---- channel packing: delta along particle index, then byte planes ----
+
+void packChannel32(const float* src, int n, uint8_t* dst)
+{
+    uint32_t prev = 0;
+    for (int i = 0; i < n; ++i) {
+        const uint32_t u = floatBits(src[size_t(i) * kFloatsPerParticle]);
+        const uint32_t d = u - prev;
+        prev = u;
+        for (int b = 0; b < 4; ++b) dst[size_t(b) * n + i] = uint8_t(d >> (8 * b));
+    }
+}
+
+void unpackChannel32(const uint8_t* src, int n, float* dst)
+{
+    uint32_t prev = 0;
+    for (int i = 0; i < n; ++i) {
+        uint32_t d = 0;
+        for (int b = 0; b < 4; ++b) d |= uint32_t(src[size_t(b) * n + i]) << (8 * b);
+        prev += d;
+        dst[size_t(i) * kFloatsPerParticle] = bitsFloat(prev);
+    }
+}
+
+void packChannel16(const uint16_t* q, int n, uint8_t* dst)
+{
+    uint16_t prev = 0;
+    for (int i = 0; i < n; ++i) {
+        const uint16_t d = uint16_t(q[i] - prev);
+        prev = q[i];
+        dst[i] = uint8_t(d);
+        dst[size_t(n) + i] = uint8_t(d >> 8);
+    }
+}
+
+void unpackChannel16(const uint8_t* src, int n, uint16_t* q)
+{
+    uint16_t prev = 0;
+    for (int i = 0; i < n; ++i) {
+        prev = uint16_t(prev + uint16_t(src[i] | (uint16_t(src[size_t(n) + i]) << 8)));
+        q[i] = prev;
+    }
+}
+
+struct BlockBounds {
+    float mn[3] = { 0.0f, 0.0f, 0.0f };
+    float mx[3] = { 0.0f, 0.0f, 0.0f };
+    float velScale = 0.0f;
+};
+
+BlockBounds measureBlock(const float* p, int n)
+{
+    BlockBounds b;
+    bool any = false;
+    for (int i = 0; i < n; ++i) {
+        const float* s = p + size_t(i) * kFloatsPerParticle;
+        if (!std::isfinite(s[0]) || !std::isfinite(s[1]) || !std::isfinite(s[2])) continue;
+        for (int a = 0; a < 3; ++a) {
+            b.mn[a] = any ? std::min(b.mn[a], s[a]) : s[a];
+            b.mx[a] = any ? std::max(b.mx[a], s[a]) : s[a];
+        }
+        any = true;
+        for (int a = 4; a < 7; ++a)
+            if (std::isfinite(s[a])) b.velScale = std::max(b.velScale, std::fabs(s[a]));
+    }
+    return b;
+}
+
+uint16_t quantizeUnit(float t)   // t in [0,1]
+{
+    if (!(t > 0.0f)) return 0;   // also catches NaN
+    if (t >= 1.0f) return 65535;
+    return uint16_t(std::lround(double(t) * 65535.0));
+}
+
+} // namespace
+
+// =====================================================================================
+// LZ77 byte codec. Sequence = token (hi nibble literal length, lo nibble match length
+// - 4; 15 = "more in 255-run bytes"), literals, u16 offset, match-length run. The last
+// sequence carries literals only. Greedy single-probe hash matching: fast, modest ratio;
+// the delta + byte-plane transform above does most of the work.
+// =====================================================================================
+namespace {
+constexpr int kMinMatch = 4;
+constexpr int kHashBits = 14;
+constexpr size_t kWindow = 65535;
+
+inline uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint32_t hash4(uint32_t v) { return (v * 2654435761u) >> (32 - kHashBits); }
+
+void putLength(std::vector<uint8_t>& out, size_t len)
+{
+    while (len >= 255) { out.push_back(255); len -= 255; }
+    out.push_back(uint8_t(len));
+}
+
+void emitSequence(std::vector<uint8_t>& out, const uint8_t* lit, size_t litLen,
+                  size_t offset, size_t matchLen)
+{
+    const size_t m = matchLen ? matchLen - kMinMatch : 0;
+    out.push_back(uint8_t((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(m, 15)));
+    if (litLen >= 15) putLength(out, litLen - 15);
+    out.insert(out.end(), lit, lit + litLen);
+    if (!matchLen) return;
+    out.push_back(uint8_t(offset));
+    out.push_back(uint8_t(offset >> 8));
+    if (m >= 15) putLength(out, m - 15);
+}
+} // namespace
+
+void lzCompress(const uint8_t* src, size_t n, std::vector<uint8_t>& out)
+{
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0xFFFFFFFFu);
+    size_t anchor = 0, i = 0;
+    while (n >= kMinMatch && i + kMinMatch <= n) {
+        const uint32_t v = read32(src + i);
+        const uint32_t h = hash4(v);
+        const uint32_t cand = table[h];
+        table[h] = uint32_t(i);
+        if (cand != 0xFFFFFFFFu && i - cand <= kWindow && read32(src + cand) == v) {
+            size_t len = kMinMatch;
+            while (i + len < n && src[cand + len] == src[i + len]) ++len;
+            emitSequence(out, src + anchor, i - anchor, i - cand, len);
+            i += len;
+            anchor = i;
+            continue;
+        }
+        ++i;
+    }
+    emitSequence(out, src + anchor, n - anchor, 0, 0);
+}
+
+bool lzDecompress(const uint8_t* src, size_t n, uint8_t* dst, size_t dstSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + n;
+    size_t op = 0;
+    auto readLength = [&](size_t& len) {
+        for (;;) {
+            if (ip >= iend) return false;
+            const uint8_t b = *ip++;
+            len += b;
+            if (b != 255) return true;
+        }
+    };
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !readLength(lit)) return false;
+        if (size_t(iend - ip) < lit || dstSize - op < lit) return false;
+        std::memcpy(dst + op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) break;                       // final literal-only sequence
+        if (iend - ip < 2) return false;
+        const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && !readLength(len)) return false;
+        len += kMinMatch;
+        if (offset == 0 || offset > op || dstSize - op < len) return false;
+        for (size_t k = 0; k < len; ++k, ++op) dst[op] = dst[op - offset];   // may overlap
+    }
+    return op == dstSize;
+}
+
+// =====================================================================================
+// Frame blobs
+// =====================================================================================
+void encodeFrame(const float* interleaved, int count, double simTime, Mode mode,
+                 std::vector<uint8_t>& out)
+{
+    count = std::max(0, count);
+    const uint32_t blocks = uint32_t((count + kBlockParticles - 1) / kBlockParticles);
+    out.insert(out.end(), kMagic, kMagic + 4);
+    put(out, kVersion);
+    put(out, uint32_t(mode));
+    put(out, uint32_t(count));
+    put(out, simTime);
+    put(out, blocks);
+
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> packed;
+    std::vector<uint16_t> q;
+    for (uint32_t blk = 0; blk < blocks; ++blk) {
+        const int first = int(blk) * kBlockParticles;
+        const int n = std::min(kBlockParticles, count - first);
+        const float* p = interleaved + size_t(first) * kFloatsPerParticle;
+
+        BlockBounds b;
+        if (mode == Mode::Lossless) {
+            raw.resize(size_t(n) * kFloatsPerParticle * 4);
+            for (int c = 0; c < kFloatsPerParticle; ++c)
+                packChannel32(p + c, n, raw.data() + size_t(c) * n * 4);
+        }
+        else {
+            b = measureBlock(p, n);
+            raw.resize(size_t(n) * (6 * 2 + 4));
+            uint8_t* w = raw.data();
+            q.resize(size_t(n));
+            for (int a = 0; a < 3; ++a) {
+                const float ext = b.mx[a] - b.mn[a];
+                for (int i = 0; i < n; ++i)
+                    q[size_t(i)] = ext > 0.0f
+                        ? quantizeUnit((p[size_t(i) * kFloatsPerParticle + a] - b.mn[a]) / ext) : 0;
+                packChannel16(q.data(), n, w);
+                w += size_t(n) * 2;
+            }
+            packChannel32(p + 3, n, w);   // life: lossless
+            w += size_t(n) * 4;
+            for (int a = 4; a < 7; ++a) {
+                for (int i = 0; i < n; ++i) {
+                    const float v = p[size_t(i) * kFloatsPerParticle + a];
+                    const float t = b.velScale > 0.0f ? 0.5f + 0.5f * (v / b.velScale) : 0.5f;
+                    q[size_t(i)] = quantizeUnit(t);
+                }
+                packChannel16(q.data(), n, w);
+                w += size_t(n) * 2;
+            }
+        }
+
+        packed.clear();
+        lzCompress(raw.data(), raw.size(), packed);
+        const bool stored = packed.size() >= raw.size();
+        const std::vector<uint8_t>& payload = stored ? raw : packed;
+
+        put(out, uint32_t(n));
+        put(out, uint32_t(raw.size()));
+        put(out, uint32_t(payload.size()));
+        put(out, stored ? kBlockStored : 0u);
+        for (float f : b.mn) put(out, f);
+        for (float f : b.mx) put(out, f);
+        put(out, b.velScale);
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+}
+
+bool peekFrame(const uint8_t* blob, size_t bytes, int& count, Mode& mode)
+{
+    if (bytes < kFrameHeaderBytes || std::memcmp(blob, kMagic, 4) != 0) return false;
+    Reader r{ blob + 4, blob + bytes };
+    uint32_t version = 0, m = 0, c = 0;
+    if (!r.get(version) || version != kVersion || !r.get(m) || m > 1 || !r.get(c)) return false;
+    count = int(c);
+    mode = Mode(m);
+    return true;
+}
+
+bool decodeFrame(const uint8_t* blob, size_t bytes, double& simTime, std::vector<float>& out)
+{
+    int count = 0;
+    Mode mode = Mode::Lossless;
+    if (!peekFrame(blob, bytes, count, mode)) return false;
+    Reader r{ blob + 16, blob + bytes };
+    uint32_t blocks = 0;
+    if (!r.get(simTime) || !r.get(blocks)) return false;
+    if (count < 0 || blocks != uint32_t((count + kBlockParticles - 1) / kBlockParticles)) return false;
+
+    out.assign(size_t(count) * kFloatsPerParticle, 0.0f);
+    std::vector<uint8_t> raw;
+    std::vector<uint16_t> q;
+    for (uint32_t blk = 0; blk < blocks; ++blk) {
+        const int first = int(blk) * kBlockParticles;
+        uint32_t n = 0, rawBytes = 0, packedBytes = 0, flags = 0;
+        BlockBounds b;
+        if (!r.get(n) || !r.get(rawBytes) || !r.get(packedBytes) || !r.get(flags)) return false;
+        for (float& f : b.mn) if (!r.get(f)) return false;
+        for (float& f : b.mx) if (!r.get(f)) return false;
+        if (!r.get(b.velScale)) return false;
+        const size_t expectRaw = mode == Mode::Lossless ? size_t(n) * kFloatsPerParticle * 4
+                                                        : size_t(n) * (6 * 2 + 4);
+        if (int(n) != std::min(kBlockParticles, count - first) || rawBytes != expectRaw) return false;
+        if (size_t(r.end - r.p) < packedBytes) return false;
+
+        raw.resize(rawBytes);
+        if (flags & kBlockStored) {
+            if (packedBytes != rawBytes) return false;
+            std::memcpy(raw.data(), r.p, rawBytes);
+        }
+        else if (!lzDecompress(r.p, packedBytes, raw.data(), rawBytes)) {
+            return false;
+        }
+        r.p += packedBytes;
+
+        float* p = out.data() + size_t(first) * kFloatsPerParticle;
+        const int ni = int(n);
+        if (mode == Mode::Lossless) {
+            for (int c = 0; c < kFloatsPerParticle; ++c)
+                unpackChannel32(raw.data() + size_t(c) * ni * 4, ni, p + c);
+            continue;
+        }
+        const uint8_t* rd = raw.data();
+        q.resize(size_t(ni));
+        for (int a = 0; a < 3; ++a) {
+            unpackChannel16(rd, ni, q.data());
+            rd += size_t(ni) * 2;
+            const float ext = b.mx[a] - b.mn[a];
+            for (int i = 0; i < ni; ++i)
+                p[size_t(i) * kFloatsPerParticle + a] = b.mn[a] + ext * (float(q[size_t(i)]) / 65535.0f);
+        }
+        unpackChannel32(rd, ni, p + 3);
+        rd += size_t(ni) * 4;
+        for (int a = 4; a < 7; ++a) {
+            unpackChannel16(rd, ni, q.data());
+            rd += size_t(ni) * 2;
+            for (int i = 0; i < ni; ++i)
+                p[size_t(i) * kFloatsPerParticle + a] =
+                    b.velScale * (2.0f * (float(q[size_t(i)]) / 65535.0f) - 1.0f);
+        }
+    }
+    return r.p == r.end;
+}
+
+// =====================================================================================
+// Self-tests
+// =====================================================================================
+namespace {
+
+/// A settled pool with a falling sheet: lattice-seeded particles (index order ==
+/// seeding order, like a FluidVolumeComponent fill), sub-spacing jitter, a slow
+/// circulation, and a dead tail (recycled emitter slots).
+std::vector<float> syntheticPool(int count, float t, uint32_t seed)
+{
+    std::vector<float> d(size_t(count) * kFloatsPerParticle, 0.0f);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> jit(-0.002f, 0.002f);
+    const float h = 0.02f;
+    const int nx = 48, nz = 48;
+    for (int i = 0; i < count; ++i) {
+        float* s = d.data() + size_t(i) * kFloatsPerParticle;
+        const int x = i % nx, z = (i / nx) % nz, y = i / (nx * nz);
+        const bool dead = i >= count - count / 10;
+        s[0] = -0.5f + x * h + jit(rng);
+        s[1] = 0.01f + y * h + jit(rng) - (dead ? 0.0f : 0.05f * t * float(y) / 50.0f);
+        s[2] = -0.5f + z * h + jit(rng);
+        s[3] = dead ? 0.0f : 1.0f;
+        s[4] = 0.3f * std::sin(3.0f * s[2]) + jit(rng);
+        s[5] = -0.2f * float(y) / 50.0f + jit(rng);
+        s[6] = 0.3f * std::cos(3.0f * s[0]) + jit(rng);
+        s[7] = 0.0f;
+    }
+    return d;
+}
+
+bool bitEqual(const std::vector<float>& a, const std::vector<float>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * 4) == 0);
+}
+
+} // namespace
+
+bool runSelfTests()
+{
+    int fails = 0;
+    char detail[160];
+    auto report = [&](bool ok, const char* name) {
+        std::fprintf(stderr, "[FLUID-CACHE] %s %-36s %s\n", ok ? "PASS" : "FAIL", name, detail);
+        if (!ok) ++fails;
+    };
+
+    // ---- 1. Lossless round trip: odd sizes, awkward float patterns, empty frame ----
+    {
+        bool allExact = true;
+        int frames = 0;
+        for (int count : { 0, 1, 7, kBlockParticles - 1, kBlockParticles, kBlockParticles + 3, 50000 }) {
+            std::vector<float> src = syntheticPool(count, 0.5f, 11u + uint32_t(count));
+            if (count >= 7) {   // bit patterns a float-arithmetic codec would mangle
+                src[0] = std::numeric_limits<float>::quiet_NaN();
+                src[1] = -0.0f;
+                src[2] = std::numeric_limits<float>::denorm_min();
+                src[3] = std::numeric_limits<float>::infinity();
+                src[9] = bitsFloat(0x7FC00123u);   // NaN with a payload
+                src[10] = -std::numeric_limits<float>::max();
+            }
+            std::vector<uint8_t> blob;
+            encodeFrame(src.data(), count, 1.25 * count, Mode::Lossless, blob);
+            std::vector<float> back;
+            double t = 0.0;
+            const bool ok = decodeFrame(blob.data(), blob.size(), t, back) && t == 1.25 * count
+                         && bitEqual(src, back);
+            allExact = allExact && ok;
+            ++frames;
+        }
+        std::snprintf(detail, sizeof(detail), "(%d frames, sizes 0..50000, NaN/-0/denorm/inf)", frames);
+        report(allExact, "lossless round trip bit-exact");
+    }
+
+    // ---- 2. LZ codec round trip on incompressible + highly repetitive bytes ----
+    {
+        std::mt19937 rng(7);
+        std::vector<uint8_t> noise(100000), rep(100000);
+        for (auto& b : noise) b = uint8_t(rng());
+        for (size_t i = 0; i < rep.size(); ++i) rep[i] = uint8_t("abcabcabd"[i % 9]);
+        bool ok = true;
+        size_t repPacked = 0;
+        for (const auto* v : { &noise, &rep }) {
+            std::vector<uint8_t> packed, back(v->size());
+            lzCompress(v->data(), v->size(), packed);
+            ok = ok && lzDecompress(packed.data(), packed.size(), back.data(), back.size()) && back == *v;
+            if (v == &rep) repPacked = packed.size();
+        }
+        ok = ok && repPacked * 50 < rep.size();
+        std::snprintf(detail, sizeof(detail), "(repetitive 100000 B -> %zu B)", repPacked);
+        report(ok, "LZ round trip (noise + repeats)");
+    }
+
+    // ---- 3. Quantized mode: error within half a step of each block's range ----
+    const int poolN = 200000;
+    const std::vector<float> pool = syntheticPool(poolN, 0.8f, 99u);
+    std::vector<uint8_t> qBlob, lBlob;
+    encodeFrame(pool.data(), poolN, 0.0, Mode::Quantized, qBlob);
+    encodeFrame(pool.data(), poolN, 0.0, Mode::Lossless, lBlob);
+    std::vector<float> qBack, lBack;
+    double t = 0.0;
+    const bool qDecoded = decodeFrame(qBlob.data(), qBlob.size(), t, qBack);
+    {
+        double worstPos = 0.0, worstVel = 0.0;   // error / bound, max over blocks
+        bool lifeExact = qDecoded;
+        for (int first = 0; qDecoded && first < poolN; first += kBlockParticles) {
+            const int n = std::min(kBlockParticles, poolN - first);
+            const BlockBounds b = measureBlock(pool.data() + size_t(first) * kFloatsPerParticle, n);
+            for (int i = first; i < first + n; ++i) {
+                const float* s = pool.data() + size_t(i) * kFloatsPerParticle;
+                const float* r = qBack.data() + size_t(i) * kFloatsPerParticle;
+                for (int a = 0; a < 3; ++a) {
+                    const double bound = 0.5 * (b.mx[a] - b.mn[a]) / 65535.0 + 1e-6;
+                    worstPos = std::max(worstPos, std::fabs(double(s[a]) - r[a]) / bound);
+                    const double vb = b.velScale / 65535.0 + 1e-6;   // half-step of 2*scale/65535
+                    worstVel = std::max(worstVel, std::fabs(double(s[a + 4]) - r[a + 4]) / vb);
+                }
+                lifeExact = lifeExact && floatBits(s[3]) == floatBits(r[3]);
+            }
+        }
+        std::snprintf(detail, sizeof(detail), "(worst err / bound = %.3f, life %s)",
+                      worstPos, lifeExact ? "exact" : "CHANGED");
+        report(qDecoded && worstPos <= 1.0 && lifeExact, "quantized positions <= half step");
+        std::snprintf(detail, sizeof(detail), "(worst err / bound = %.3f)", worstVel);
+        report(qDecoded && worstVel <= 1.0, "quantized velocities <= half step");
+    }
+
+    // ---- 4. Compression-ratio report (vs the legacy 32 B/particle frame) ----
+    {
+        const double rawBytes = double(poolN) * kFloatsPerParticle * 4;
+        const double qRatio = rawBytes / double(qBlob.size());
+        const double lRatio = rawBytes / double(lBlob.size());
+        std::fprintf(stderr, "[FLUID-CACHE]      ratio report: %d particles, raw %.2f MB -> lossless %.2f MB (%.2fx), "
+                             "quantized %.2f MB (%.2fx, %.1f B/particle)\n",
+                     poolN, rawBytes / 1e6, lBlob.size() / 1e6, lRatio, qBlob.size() / 1e6, qRatio,
+                     double(qBlob.size()) / poolN);
+        std::snprintf(detail, sizeof(detail), "(%.2fx; lossless %.2fx)", qRatio, lRatio);
+        report(qRatio >= 2.5, "quantized ratio >= 2.5x");
+        std::snprintf(detail, sizeof(detail), "(%.2fx)", lRatio);
+        report(lRatio >= 1.0, "lossless never inflates");
+    }
+
+    // ---- 5. Corruption / truncation must be rejected, not decoded into garbage ----
+    {
+        int rejected = 0, trials = 0;
+        for (size_t cut : { size_t(0), size_t(5), size_t(27), lBlob.size() / 2, lBlob.size() - 1 }) {
+            std::vector<float> junk;
+            double jt = 0.0;
+            rejected += decodeFrame(lBlob.data(), cut, jt, junk) ? 0 : 1;
+            ++trials;
+        }
+        std::snprintf(detail, sizeof(detail), "(%d / %d)", rejected, trials);
+        report(rejected == trials, "truncated blobs rejected");
+    }
+
+    // ---- NEG-CTRL: the bit-exact check must see quantization as lossy ----
+    {
+        const bool differs = qDecoded && !bitEqual(pool, qBack);
+        std::snprintf(detail, sizeof(detail), "(the bit-exact check can fail)");
+        report(differs, "NEG-CTRL quantized is NOT bit-exact");
+    }
+
+    // ---- 6. Decode throughput (scrub cost per frame) ----
+    {
+        using clock = std::chrono::steady_clock;
+        const int reps = 5;
+        const auto t0 = clock::now();
+        for (int i = 0; i < reps; ++i) decodeFrame(qBlob.data(), qBlob.size(), t, qBack);
+        const double s = std::chrono::duration<double>(clock::now() - t0).count() / reps;
+        const auto t1 = clock::now();
+        std::vector<uint8_t> enc;
+        for (int i = 0; i < reps; ++i) { enc.clear(); encodeFrame(pool.data(), poolN, 0.0, Mode::Quantized, enc); }
+        const double e = std::chrono::duration<double>(clock::now() - t1).count() / reps;
+        std::fprintf(stderr, "[FLUID-CACHE]      bench: %d particles decode %.2f ms (%.0f Mparticles/s), encode %.2f ms\n",
+                     poolN, s * 1e3, poolN / s / 1e6, e * 1e3);
+    }
+
+    std::fprintf(stderr, "[FLUID-CACHE] %s (%d failure%s)\n", fails ? "FAIL" : "ALL PASS", fails, fails == 1 ? "" : "s");
+    return fails == 0;
+}
+
+} // namespace krs::fcache
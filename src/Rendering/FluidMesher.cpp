@@ -1,12 +1,18 @@
 // OpenVDB particle -> level set -> triangle mesh ("hero stills"). Compiled
 // with /permissive- like SdfBaker.cpp: OpenVDB 12 headers require it.
 #include "FluidMesher.hpp"
+#include "FluidCache.hpp"
 
 #include <QDebug>
+#include <QDir>
+#include <QFile>
 #include <QElapsedTimer>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <limits>
+#include <mutex>
 
 #if defined(KR_WITH_OPENVDB)
 // Qt's keyword macros collide with OpenVDB (TypeList::foreach) and TBB
@@ -153,4 +159,61 @@ bool meshFluidParticles(const std::vector<glm::vec3>& positions, float particleR
 #endif
 }
 
+namespace {
+bool writeObj(const QString& path, const RenderableMeshComponent& mesh)
+{
+    FILE* f = std::fopen(QFile::encodeName(path).constData(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "# fluid surface, %zu verts, %zu tris\n", mesh.vertices.size(), mesh.indices.size() / 3);
+    for (const auto& v : mesh.vertices)
+        std::fprintf(f, "v %.6f %.6f %.6f\n", v.position.x, v.position.y, v.position.z);
+    for (const auto& v : mesh.vertices)
+        std::fprintf(f, "vn %.4f %.4f %.4f\n", v.normal.x, v.normal.y, v.normal.z);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        std::fprintf(f, "f %u//%u %u//%u %u//%u\n", mesh.indices[i] + 1, mesh.indices[i] + 1,
+                     mesh.indices[i + 1] + 1, mesh.indices[i + 1] + 1, mesh.indices[i + 2] + 1,
+                     mesh.indices[i + 2] + 1);
+    return std::fclose(f) == 0;
+}
+} // namespace
+
+bool exportFluidMeshSequence(const FluidCache& cache, const QString& dir, float particleRadius,
+                             FluidSequenceMesher::Stats* stats)
+{
+    const int frames = cache.frameCount();
+    if (frames <= 0 || !QDir().mkpath(dir)) return false;
+
+    FluidSequenceMesher::Settings settings;
+    settings.particleRadius = particleRadius;
+    std::mutex readMutex;                   // FluidCache reads share one mapping + prefetcher
+    std::atomic<int> written{ 0 }, failed{ 0 };
+    auto source = [&](int index, std::vector<glm::vec3>& positions, std::vector<uint32_t>& ids) {
+        FluidCache::Frame frame;
+        {
+            std::lock_guard<std::mutex> lock(readMutex);
+            if (!cache.readFrame(index, frame)) return false;
+        }
+        positions.reserve(size_t(frame.particleCount()));
+        ids.reserve(size_t(frame.particleCount()));
+        for (int i = 0; i < frame.particleCount(); ++i) {
+            const float* src = frame.data.data() + size_t(i) * 8;
+            if (src[3] <= 0.0f) continue;
+            positions.emplace_back(src[0], src[1], src[2]);
+            ids.push_back(uint32_t(i));          // buffer slot: stable across the bake
+        }
+        return true;
+    };
+    auto sink = [&](int index, RenderableMeshComponent& mesh) {
+        const QString path = QDir(dir).filePath(QString::asprintf("frame_%05d.obj", index));
+        if (writeObj(path, mesh)) ++written;
+        else ++failed;
+    };
+    const FluidSequenceMesher::Stats st = FluidSequenceMesher::meshSequence(frames, settings, source, sink);
+    if (stats) *stats = st;
+    qInfo() << "[FluidMesher] sequence:" << written.load() << "of" << frames << "frames ->" << dir << "in"
+            << st.seconds << "s (" << st.framesPerSec() << "frames/s," << st.threads << "threads,"
+            << st.rasterized << "/" << st.leaves << "leaves rasterized)" << (failed ? "WRITE ERRORS" : "");
+    return written > 0;
+}
+
 } // namespace krs
@@ -0,0 +1,644 @@
+#include "FluidSequenceMesher.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace krs {
+
+namespace {
+
+constexpr int kLeafDim = 8;                          // samples per leaf axis (VDB leaf size)
+constexpr int kLeafSamples = kLeafDim * kLeafDim * kLeafDim;
+constexpr int kBias = 1 << 20;                       // signed lattice coords -> 21-bit fields
+
+inline uint64_t packKey(int x, int y, int z)
+{
+    return (uint64_t(uint32_t(x + kBias) & 0x1FFFFFu) << 42) |
+           (uint64_t(uint32_t(y + kBias) & 0x1FFFFFu) << 21) |
+            uint64_t(uint32_t(z + kBias) & 0x1FFFFFu);
+}
+
+inline glm::ivec3 unpackKey(uint64_t k)
+{
+    return glm::ivec3(int((k >> 42) & 0x1FFFFFu) - kBias, int((k >> 21) & 0x1FFFFFu) - kBias,
+                      int(k & 0x1FFFFFu) - kBias);
+}
+
+inline int floorDiv8(int v) { return v >= 0 ? v / kLeafDim : -((-v + kLeafDim - 1) / kLeafDim); }
+
+inline uint32_t floatBits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+
+/// One particle binned into one leaf. Sorted by (leaf, id) so a leaf's particle
+/// list, signature and accumulation order depend on ids, not buffer position.
+struct Bin {
+    uint64_t key;
+    uint32_t id, index;
+    bool operator<(const Bin& o) const { return key != o.key ? key < o.key : id < o.id; }
+};
+
+struct Leaf {
+    uint64_t sig = 0;                     // hash of the particles touching the leaf
+    std::vector<uint32_t> particles;      // indices into the frame, ascending by particle id
+    float phi[kLeafSamples];
+    bool changed = false;
+};
+
+/// Surface-nets output owned by one leaf: vertices of the cells it owns and the
+/// quads of the lattice edges it owns (corners referenced by cell key).
+struct Patch {
+    std::vector<uint64_t> vertKeys;
+    std::vector<glm::vec3> verts;
+    std::vector<uint64_t> tris;           // 3 cell keys per triangle
+};
+
+} // namespace
+
+struct FluidSequenceMesher::State {
+    std::unordered_map<uint64_t, Leaf> leaves;
+    std::unordered_map<uint64_t, Patch> patches;
+    bool trustStale = false;              // self-test neg-ctrl: reuse leaves without checking
+};
+
+FluidSequenceMesher::FluidSequenceMesher() : FluidSequenceMesher(Settings()) {}
+
+FluidSequenceMesher::FluidSequenceMesher(const Settings& settings)
+    : m_state(std::make_unique<State>()), m_settings(settings)
+{
+}
+
+FluidSequenceMesher::~FluidSequenceMesher() = default;
+
+void FluidSequenceMesher::reset()
+{
+    m_state->leaves.clear();
+    m_state->patches.clear();
+}
+
+bool FluidSequenceMesher::meshFrame(const std::vector<glm::vec3>& positions, RenderableMeshComponent& out,
+                                    const std::vector<uint32_t>* ids)
+{
+    State& st = *m_state;
+    m_last = FrameStats{};
+    const float r = m_settings.particleRadius;
+    if (positions.empty() || r <= 0.0f) { reset(); return false; }
+    if (ids && ids->size() != positions.size()) ids = nullptr;
+    krs::par::ThreadPool& pool = m_pool ? *m_pool : krs::par::ThreadPool::global();
+
+    const float h = r * m_settings.voxelScale;
+    const float invH = 1.0f / h;
+    const float R = r * m_settings.kernelScale;
+    const float R2 = R * R;
+    const float rbar = r * m_settings.surfaceScale;
+    const float far = R;                              // phi where no particle reaches
+
+    // ---- 1. bin particles into every leaf their kernel box touches ----
+    std::vector<Bin> pairs;
+    pairs.reserve(positions.size() * 8);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const glm::vec3& p = positions[i];
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+        const uint32_t id = ids ? (*ids)[i] : uint32_t(i);
+        const glm::ivec3 lo(glm::ceil((p - R) * invH)), hi(glm::floor((p + R) * invH));
+        const glm::ivec3 llo(floorDiv8(lo.x), floorDiv8(lo.y), floorDiv8(lo.z));
+        const glm::ivec3 lhi(floorDiv8(hi.x), floorDiv8(hi.y), floorDiv8(hi.z));
+        for (int x = llo.x; x <= lhi.x; ++x)
+            for (int y = llo.y; y <= lhi.y; ++y)
+                for (int z = llo.z; z <= lhi.z; ++z)
+                    pairs.push_back(Bin{ packKey(x, y, z), id, uint32_t(i) });
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    // ---- 2. diff against the previous frame: a leaf is dirty iff its particle set moved ----
+    std::vector<size_t> groupStart;
+    for (size_t k = 0; k < pairs.size(); ++k)
+        if (k == 0 || pairs[k].key != pairs[k - 1].key) groupStart.push_back(k);
+    groupStart.push_back(pairs.size());
+    const size_t groups = groupStart.size() - 1;
+    std::vector<uint64_t> sigs(groups);
+    krs::par::parallelFor(pool, groups, 64, [&](size_t lo, size_t hi) {
+        for (size_t g = lo; g < hi; ++g) {
+            uint64_t s = 1469598103934665603ull;     // FNV-1a over (id, position bits)
+            auto mix = [&](uint32_t v) { s = (s ^ v) * 1099511628211ull; };
+            for (size_t k = groupStart[g]; k < groupStart[g + 1]; ++k) {
+                const glm::vec3& p = positions[pairs[k].index];
+                mix(pairs[k].id);
+                mix(floatBits(p.x)); mix(floatBits(p.y)); mix(floatBits(p.z));
+            }
+            sigs[g] = s;
+        }
+    });
+
+    std::unordered_map<uint64_t, Leaf> next;
+    next.reserve(groups * 2);
+    std::unordered_set<uint64_t> touched;             // leaves whose samples changed or vanished
+    std::vector<std::pair<uint64_t, Leaf*>> dirty;
+    for (size_t g = 0; g < groups; ++g) {
+        const uint64_t key = pairs[groupStart[g]].key;
+        const uint32_t count = uint32_t(groupStart[g + 1] - groupStart[g]);
+        auto old = st.leaves.find(key);
+        const bool reuse = old != st.leaves.end()
+                        && (st.trustStale || (old->second.sig == sigs[g] && old->second.particles.size() == count));
+        Leaf& leaf = next[key];
+        if (reuse) {
+            leaf = std::move(old->second);
+            leaf.changed = false;
+            continue;
+        }
+        leaf.sig = sigs[g];
+        leaf.particles.resize(count);
+        for (uint32_t k = 0; k < count; ++k) leaf.particles[k] = pairs[groupStart[g] + k].index;
+        leaf.changed = true;
+        dirty.emplace_back(key, &leaf);
+        touched.insert(key);
+    }
+    for (const auto& kv : st.leaves)
+        if (!next.count(kv.first)) touched.insert(kv.first);
+    st.leaves.swap(next);
+    m_last.leaves = int(st.leaves.size());
+    m_last.rasterized = int(dirty.size());
+
+    // ---- 3. rasterize dirty leaves (Zhu-Bridson averaged SDF) ----
+    // Leaf pointers stay valid across the swap (node-based map).
+    krs::par::parallelFor(pool, dirty.size(), 4, [&](size_t lo, size_t hi) {
+        std::vector<glm::vec4> acc(kLeafSamples);
+        for (size_t w = lo; w < hi; ++w) {
+            Leaf& leaf = *dirty[w].second;
+            const glm::ivec3 o = unpackKey(dirty[w].first) * kLeafDim;
+            std::fill(acc.begin(), acc.end(), glm::vec4(0.0f));
+            for (uint32_t idx : leaf.particles) {
+                const glm::vec3& p = positions[idx];
+                const glm::ivec3 lo3 = glm::max(glm::ivec3(glm::ceil((p - R) * invH)), o);
+                const glm::ivec3 hi3 = glm::min(glm::ivec3(glm::floor((p + R) * invH)), o + (kLeafDim - 1));
+                for (int x = lo3.x; x <= hi3.x; ++x)
+                    for (int y = lo3.y; y <= hi3.y; ++y)
+                        for (int z = lo3.z; z <= hi3.z; ++z) {
+                            const glm::vec3 d = glm::vec3(float(x), float(y), float(z)) * h - p;
+                            const float d2 = glm::dot(d, d);
+                            if (d2 >= R2) continue;
+                            const float s = 1.0f - d2 / R2;
+                            const float k = s * s * s;
+                            acc[size_t(((x - o.x) * kLeafDim + (y - o.y)) * kLeafDim + (z - o.z))] += glm::vec4(p * k, k);
+                        }
+            }
+            for (int x = 0; x < kLeafDim; ++x)
+                for (int y = 0; y < kLeafDim; ++y)
+                    for (int z = 0; z < kLeafDim; ++z) {
+                        const size_t s = size_t((x * kLeafDim + y) * kLeafDim + z);
+                        if (acc[s].w <= 0.0f) { leaf.phi[s] = far; continue; }
+                        const glm::vec3 xbar = glm::vec3(acc[s]) / acc[s].w;
+                        const glm::vec3 at = glm::vec3(float(o.x + x), float(o.y + y), float(o.z + z)) * h;
+                        leaf.phi[s] = glm::length(at - xbar) - rbar;
+                    }
+        }
+    });
+
+    // ---- 4. patches: every active leaf and its backward neighbours own cells/edges that
+    // read active samples. A patch is stale iff any leaf of its forward 2x2x2 closure changed. ----
+    std::vector<uint64_t> patchKeys;
+    {
+        std::unordered_set<uint64_t> seen;
+        seen.reserve(st.leaves.size() * 4);
+        for (const auto& kv : st.leaves) {
+            const glm::ivec3 c = unpackKey(kv.first);
+            for (int i = 0; i < 8; ++i) {
+                const uint64_t k = packKey(c.x - (i & 1), c.y - ((i >> 1) & 1), c.z - ((i >> 2) & 1));
+                if (seen.insert(k).second) patchKeys.push_back(k);
+            }
+        }
+    }
+    std::sort(patchKeys.begin(), patchKeys.end());
+    std::unordered_map<uint64_t, Patch> patches;
+    patches.reserve(patchKeys.size() * 2);
+    std::vector<std::pair<uint64_t, Patch*>> remesh;
+    for (uint64_t key : patchKeys) {
+        const glm::ivec3 c = unpackKey(key);
+        auto old = st.patches.find(key);
+        bool stale = old == st.patches.end();
+        for (int i = 0; i < 8 && !stale && !st.trustStale; ++i)
+            stale = touched.count(packKey(c.x + (i & 1), c.y + ((i >> 1) & 1), c.z + ((i >> 2) & 1))) != 0;
+        Patch& p = patches[key];
+        if (!stale) { p = std::move(old->second); continue; }
+        remesh.emplace_back(key, &p);
+    }
+    st.patches.swap(patches);
+    m_last.remeshed = int(remesh.size());
+    m_last.patches = int(patchKeys.size());
+
+    // ---- 5. surface nets per stale patch ----
+    krs::par::parallelFor(pool, remesh.size(), 4, [&](size_t lo, size_t hi) {
+        for (size_t w = lo; w < hi; ++w) {
+            Patch& patch = *remesh[w].second;
+            patch = Patch{};
+            const glm::ivec3 lc = unpackKey(remesh[w].first);
+            const glm::ivec3 o = lc * kLeafDim;
+            const Leaf* nb[8];
+            bool any = false;
+            for (int i = 0; i < 8; ++i) {
+                auto it = st.leaves.find(packKey(lc.x + (i & 1), lc.y + ((i >> 1) & 1), lc.z + ((i >> 2) & 1)));
+                nb[i] = it != st.leaves.end() ? &it->second : nullptr;
+                any = any || nb[i];
+            }
+            if (!any) continue;
+            // local sample coords in [0, 2*kLeafDim) over the forward closure
+            auto phiAt = [&](int x, int y, int z) -> float {
+                const Leaf* l = nb[(x / kLeafDim) | ((y / kLeafDim) << 1) | ((z / kLeafDim) << 2)];
+                if (!l) return far;
+                return l->phi[size_t(((x % kLeafDim) * kLeafDim + (y % kLeafDim)) * kLeafDim + (z % kLeafDim))];
+            };
+            static const int kEdges[12][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },   // x
+                                               { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },   // y
+                                               { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } }; // z
+            for (int x = 0; x < kLeafDim; ++x)
+                for (int y = 0; y < kLeafDim; ++y)
+                    for (int z = 0; z < kLeafDim; ++z) {
+                        float c[8];
+                        int inside = 0;
+                        for (int i = 0; i < 8; ++i) {
+                            c[i] = phiAt(x + (i & 1), y + ((i >> 1) & 1), z + ((i >> 2) & 1));
+                            inside += c[i] < 0.0f;
+                        }
+                        if (inside == 0 || inside == 8) continue;
+                        glm::vec3 sum(0.0f);
+                        int n = 0;
+                        for (const auto& e : kEdges) {
+                            const float a = c[e[0]], b = c[e[1]];
+                            if ((a < 0.0f) == (b < 0.0f)) continue;
+                            const float t = a / (a - b);
+                            const glm::vec3 pa(float(e[0] & 1), float((e[0] >> 1) & 1), float((e[0] >> 2) & 1));
+                            const glm::vec3 pb(float(e[1] & 1), float((e[1] >> 1) & 1), float((e[1] >> 2) & 1));
+                            sum += pa + t * (pb - pa);
+                            ++n;
+                        }
+                        const glm::ivec3 g = o + glm::ivec3(x, y, z);
+                        patch.vertKeys.push_back(packKey(g.x, g.y, g.z));
+                        patch.verts.push_back((glm::vec3(g) + sum / float(n)) * h);
+                    }
+            // Quads: one per sign-changing lattice edge owned by this leaf.
+            for (int x = 0; x < kLeafDim; ++x)
+                for (int y = 0; y < kLeafDim; ++y)
+                    for (int z = 0; z < kLeafDim; ++z) {
+                        const float a = phiAt(x, y, z);
+                        const glm::ivec3 g = o + glm::ivec3(x, y, z);
+                        for (int d = 0; d < 3; ++d) {
+                            glm::ivec3 s(x, y, z);
+                            s[d] += 1;
+                            const float b = phiAt(s.x, s.y, s.z);
+                            if ((a < 0.0f) == (b < 0.0f)) continue;
+                            const int d1 = (d + 1) % 3, d2 = (d + 2) % 3;
+                            uint64_t q[4];
+                            static const int kUV[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+                            for (int k = 0; k < 4; ++k) {
+                                glm::ivec3 cell = g;
+                                cell[d1] -= 1 - kUV[k][0];
+                                cell[d2] -= 1 - kUV[k][1];
+                                q[k] = packKey(cell.x, cell.y, cell.z);
+                            }
+                            if (!(a < 0.0f)) std::swap(q[1], q[3]);   // inside on the far side: flip
+                            const uint64_t tri[6] = { q[0], q[1], q[2], q[0], q[2], q[3] };
+                            patch.tris.insert(patch.tris.end(), tri, tri + 6);
+                        }
+                    }
+        }
+    });
+
+    // ---- 6. weld patches in key order ----
+    size_t vertCount = 0, triKeys = 0;
+    for (uint64_t key : patchKeys) {
+        const Patch& p = st.patches[key];
+        vertCount += p.verts.size();
+        triKeys += p.tris.size();
+    }
+    out = RenderableMeshComponent{};
+    if (vertCount == 0 || triKeys == 0) return false;
+    std::unordered_map<uint64_t, uint32_t> index;
+    index.reserve(vertCount * 2);
+    out.vertices.resize(vertCount);
+    glm::vec3 mn(std::numeric_limits<float>::max()), mx(-std::numeric_limits<float>::max());
+    uint32_t v = 0;
+    for (uint64_t key : patchKeys) {
+        const Patch& p = st.patches[key];
+        for (size_t i = 0; i < p.verts.size(); ++i, ++v) {
+            index.emplace(p.vertKeys[i], v);
+            out.vertices[v].position = p.verts[i];
+            out.vertices[v].normal = glm::vec3(0.0f);
+            mn = glm::min(mn, p.verts[i]);
+            mx = glm::max(mx, p.verts[i]);
+        }
+    }
+    out.indices.reserve(triKeys);
+    for (uint64_t key : patchKeys) {
+        const Patch& p = st.patches[key];
+        for (size_t t = 0; t + 2 < p.tris.size(); t += 3) {
+            auto a = index.find(p.tris[t]), b = index.find(p.tris[t + 1]), c = index.find(p.tris[t + 2]);
+            if (a == index.end() || b == index.end() || c == index.end()) continue;
+            out.indices.push_back(a->second);
+            out.indices.push_back(b->second);
+            out.indices.push_back(c->second);
+        }
+    }
+
+    // Smooth vertex normals from face accumulation (same as the hero-still path).
+    for (size_t i = 0; i + 2 < out.indices.size(); i += 3) {
+        auto& v0 = out.vertices[out.indices[i]];
+        auto& v1 = out.vertices[out.indices[i + 1]];
+        auto& v2 = out.vertices[out.indices[i + 2]];
+        const glm::vec3 n = glm::cross(v1.position - v0.position, v2.position - v0.position);
+        v0.normal += n;
+        v1.normal += n;
+        v2.normal += n;
+    }
+    for (auto& vx : out.vertices) {
+        const float len = glm::length(vx.normal);
+        vx.normal = len > 1e-12f ? vx.normal / len : glm::vec3(0, 1, 0);
+    }
+    out.aabbMin = mn;
+    out.aabbMax = mx;
+    out.hasUVs = false;
+    out.hasTangents = false;
+    out.sourcePath = "fluid-sequence";
+    return !out.indices.empty();
+}
+
+FluidSequenceMesher::Stats FluidSequenceMesher::meshSequence(int frameCount, const Settings& settings,
+                                                             const Source& source, const Sink& sink,
+                                                             krs::par::ThreadPool* pool)
+{
+    krs::par::ThreadPool& tp = pool ? *pool : krs::par::ThreadPool::global();
+    Stats st;
+    st.threads = tp.size();
+    if (frameCount <= 0) return st;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // One contiguous run per participant: frames inside a run mesh incrementally.
+    const size_t runs = std::min<size_t>(size_t(frameCount), tp.size());
+    std::atomic<int> frames{ 0 };
+    std::atomic<long long> leaves{ 0 }, rasterized{ 0 }, remeshed{ 0 };
+    krs::par::parallelFor(tp, runs, 1, [&](size_t lo, size_t hi) {
+        for (size_t r = lo; r < hi; ++r) {
+            const int first = int(r * size_t(frameCount) / runs);
+            const int last = int((r + 1) * size_t(frameCount) / runs);
+            FluidSequenceMesher mesher(settings);
+            mesher.setThreadPool(&tp);
+            std::vector<glm::vec3> positions;
+            std::vector<uint32_t> ids;
+            RenderableMeshComponent mesh;
+            for (int f = first; f < last; ++f) {
+                positions.clear();
+                ids.clear();
+                if (!source(f, positions, ids)) { mesher.reset(); continue; }
+                const bool ok = mesher.meshFrame(positions, mesh, ids.empty() ? nullptr : &ids);
+                leaves += mesher.lastFrame().leaves;
+                rasterized += mesher.lastFrame().rasterized;
+                remeshed += mesher.lastFrame().remeshed;
+                if (!ok) continue;
+                sink(f, mesh);
+                ++frames;
+            }
+        }
+    });
+    st.frames = frames.load();
+    st.leaves = leaves.load();
+    st.rasterized = rasterized.load();
+    st.remeshed = remeshed.load();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return st;
+}
+
+// =====================================================================================
+// Self-tests
+// =====================================================================================
+namespace {
+
+uint64_t meshHash(const RenderableMeshComponent& m)
+{
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < n; ++i) h = (h ^ b[i]) * 1099511628211ull;
+    };
+    for (const auto& v : m.vertices) { mix(&v.position, sizeof(v.position)); mix(&v.normal, sizeof(v.normal)); }
+    mix(m.indices.data(), m.indices.size() * sizeof(unsigned));
+    return h;
+}
+
+/// Settled pool (static lattice) + a falling, drifting blob: only the blob's
+/// leaves change from frame to frame.
+void splashFrame(int frame, float r, std::vector<glm::vec3>& out)
+{
+    const float s = 2.0f * r;
+    out.clear();
+    for (int x = 0; x < 30; ++x)
+        for (int y = 0; y < 5; ++y)
+            for (int z = 0; z < 30; ++z)
+                out.emplace_back(-0.3f + x * s, 0.01f + y * s, -0.3f + z * s);
+    const float t = 0.01f * float(frame % 60);
+    const glm::vec3 c(-0.15f + 0.2f * t, 0.5f - 4.9f * t * t * 0.5f, 0.05f);
+    for (int x = 0; x < 8; ++x)
+        for (int y = 0; y < 8; ++y)
+            for (int z = 0; z < 8; ++z)
+                out.push_back(c + glm::vec3(float(x), float(y), float(z)) * s);
+}
+
+/// Pool with a blob resting on it whose particles die a slab per frame, as a
+/// bake export sees it: dead slots dropped, survivors keep their buffer slot
+/// as id. Every death shifts the index of every pool particle behind it.
+void drainFrame(int frame, float r, std::vector<glm::vec3>& out, std::vector<uint32_t>& ids)
+{
+    const float s = 2.0f * r;
+    out.clear();
+    ids.clear();
+    uint32_t slot = 0;
+    for (int x = 0; x < 8; ++x)
+        for (int y = 0; y < 8; ++y)
+            for (int z = 0; z < 8; ++z, ++slot)
+                if (x >= frame) {
+                    out.emplace_back(-0.08f + x * s, 0.11f + y * s, -0.08f + z * s);
+                    ids.push_back(slot);
+                }
+    for (int x = 0; x < 30; ++x)
+        for (int y = 0; y < 5; ++y)
+            for (int z = 0; z < 30; ++z, ++slot) {
+                out.emplace_back(-0.3f + x * s, 0.01f + y * s, -0.3f + z * s);
+                ids.push_back(slot);
+            }
+}
+
+} // namespace
+
+bool FluidSequenceMesher::runSelfTests()
+{
+    int fails = 0;
+    auto report = [&](bool ok, const char* name, const char* detail) {
+        std::fprintf(stderr, "[FLUID-MESH] %s %-38s %s\n", ok ? "PASS" : "FAIL", name, detail);
+        if (!ok) ++fails;
+    };
+    char buf[200];
+    const float r = 0.01f;
+    Settings settings;
+    settings.particleRadius = r;
+
+    // ---- 1. sphere: radius, watertight + consistently wound, outward volume ----
+    {
+        const glm::vec3 c(0.031f, 0.2f, -0.017f);
+        const float Rs = 0.15f;
+        std::vector<glm::vec3> pts;
+        for (float x = -Rs; x <= Rs; x += 2.0f * r)
+            for (float y = -Rs; y <= Rs; y += 2.0f * r)
+                for (float z = -Rs; z <= Rs; z += 2.0f * r)
+                    if (x * x + y * y + z * z <= Rs * Rs) pts.push_back(c + glm::vec3(x, y, z));
+        FluidSequenceMesher m(settings);
+        RenderableMeshComponent mesh;
+        const bool ok = m.meshFrame(pts, mesh);
+        double meanR = 0.0, vol = 0.0;
+        for (const auto& v : mesh.vertices) meanR += glm::length(v.position - c);
+        meanR /= std::max<size_t>(1, mesh.vertices.size());
+        std::map<std::pair<unsigned, unsigned>, int> directed;
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const unsigned a = mesh.indices[i], b = mesh.indices[i + 1], d = mesh.indices[i + 2];
+            ++directed[{ a, b }]; ++directed[{ b, d }]; ++directed[{ d, a }];
+            const glm::dvec3 p0(mesh.vertices[a].position - c), p1(mesh.vertices[b].position - c),
+                             p2(mesh.vertices[d].position - c);
+            vol += glm::dot(p0, glm::cross(p1, p2)) / 6.0;
+        }
+        int badEdges = 0;
+        for (const auto& kv : directed) {
+            auto rev = directed.find({ kv.first.second, kv.first.first });
+            if (kv.second != 1 || rev == directed.end() || rev->second != 1) ++badEdges;
+        }
+        const double volExpect = 4.0 / 3.0 * 3.14159265358979 * meanR * meanR * meanR;
+        std::snprintf(buf, sizeof(buf), "(%zu particles -> %zu verts, %zu tris; mean radius %.4f vs %.3f)",
+                      pts.size(), mesh.vertices.size(), mesh.indices.size() / 3, meanR, Rs);
+        report(ok && std::fabs(meanR - Rs) < 2.0 * r, "sphere radius within 2r", buf);
+        std::snprintf(buf, sizeof(buf), "(%d non-manifold / mis-wound edges of %zu)", badEdges, directed.size());
+        report(ok && badEdges == 0, "watertight, consistently wound", buf);
+        std::snprintf(buf, sizeof(buf), "(signed volume %.5f vs 4/3 pi r^3 %.5f)", vol, volExpect);
+        report(vol > 0.0 && std::fabs(vol - volExpect) < 0.05 * volExpect, "outward winding, volume", buf);
+    }
+
+    // ---- 2. incremental == from-scratch, bit for bit; dirty leaves only ----
+    {
+        FluidSequenceMesher inc(settings);
+        std::vector<glm::vec3> pts;
+        RenderableMeshComponent a, b;
+        bool identical = true;
+        long long leaves = 0, raster = 0, remesh = 0, patches = 0;
+        for (int f = 0; f < 12; ++f) {
+            splashFrame(f, r, pts);
+            inc.meshFrame(pts, a);
+            if (f > 0) {
+                leaves += inc.lastFrame().leaves; raster += inc.lastFrame().rasterized;
+                patches += inc.lastFrame().patches; remesh += inc.lastFrame().remeshed;
+            }
+            FluidSequenceMesher fresh(settings);
+            fresh.meshFrame(pts, b);
+            identical = identical && meshHash(a) == meshHash(b) && a.indices.size() == b.indices.size();
+        }
+        std::snprintf(buf, sizeof(buf), "(12 frames; rasterized %.0f%% of leaves, remeshed %.0f%% of patches)",
+                      100.0 * raster / std::max(1ll, leaves), 100.0 * remesh / std::max(1ll, patches));
+        report(identical && raster * 2 < leaves, "incremental == full rebuild", buf);
+
+        // NEG-CTRL: trusting stale leaves on a moved frame must NOT match the rebuild.
+        FluidSequenceMesher stale(settings);
+        splashFrame(0, r, pts);
+        stale.meshFrame(pts, a);
+        stale.m_state->trustStale = true;
+        splashFrame(6, r, pts);
+        stale.meshFrame(pts, a);
+        FluidSequenceMesher fresh(settings);
+        fresh.meshFrame(pts, b);
+        const bool differs = meshHash(a) != meshHash(b);
+        std::snprintf(buf, sizeof(buf), "(stale mesh %s the rebuild)", differs ? "differs from" : "MATCHES");
+        report(differs, "NEG-CTRL stale leaves detected", buf);
+    }
+
+    // ---- 3. dead particles dropped mid-sequence: reuse keyed on stable ids ----
+    {
+        FluidSequenceMesher byId(settings), byIndex(settings);
+        std::vector<glm::vec3> pts;
+        std::vector<uint32_t> ids;
+        RenderableMeshComponent a, b;
+        bool identical = true;
+        long long leaves = 0, rasterId = 0, rasterIndex = 0;
+        for (int f = 0; f < 6; ++f) {
+            drainFrame(f, r, pts, ids);
+            byId.meshFrame(pts, a, &ids);
+            byIndex.meshFrame(pts, b);
+            if (f > 0) {
+                leaves += byId.lastFrame().leaves;
+                rasterId += byId.lastFrame().rasterized;
+                rasterIndex += byIndex.lastFrame().rasterized;
+            }
+            identical = identical && meshHash(a) == meshHash(b);
+            FluidSequenceMesher fresh(settings);
+            fresh.meshFrame(pts, b, &ids);
+            identical = identical && meshHash(a) == meshHash(b) && a.indices.size() == b.indices.size();
+        }
+        std::snprintf(buf, sizeof(buf), "(6 frames, 64 deaths each; rasterized %.0f%% of leaves)",
+                      100.0 * rasterId / std::max(1ll, leaves));
+        report(identical && rasterId * 2 < leaves, "deaths keep reuse when keyed by id", buf);
+
+        // NEG-CTRL: keyed by index, every death shifts the pool and dirties its leaves.
+        std::snprintf(buf, sizeof(buf), "(by index %lld vs by id %lld leaves rasterized)", rasterIndex, rasterId);
+        report(rasterIndex > 2 * rasterId, "NEG-CTRL index keys re-rasterize", buf);
+    }
+
+    // ---- 4. 1 vs N threads: same meshes ----
+    {
+        const int frames = 16;
+        auto source = [&](int f, std::vector<glm::vec3>& p, std::vector<uint32_t>&) { splashFrame(f, r, p); return true; };
+        std::vector<uint64_t> h1(frames, 0), hN(frames, 0);
+        krs::par::ThreadPool one(1), many(4);
+        meshSequence(frames, settings, source, [&](int f, RenderableMeshComponent& m) { h1[size_t(f)] = meshHash(m); }, &one);
+        meshSequence(frames, settings, source, [&](int f, RenderableMeshComponent& m) { hN[size_t(f)] = meshHash(m); }, &many);
+        std::snprintf(buf, sizeof(buf), "(%d frames, 1 vs 4 threads)", frames);
+        report(h1 == hN && h1[0] != 0, "sequence identical across threads", buf);
+    }
+
+    // ---- 5. wall-clock sequence bench ----
+    {
+        const char* env = std::getenv("KRS_FLUID_MESH_BENCH");
+        const int frames = env ? std::max(1, std::atoi(env)) : 1000;
+        auto source = [&](int f, std::vector<glm::vec3>& p, std::vector<uint32_t>&) { splashFrame(f, r, p); return true; };
+        std::atomic<size_t> tris{ 0 };
+        auto sink = [&](int, RenderableMeshComponent& m) { tris += m.indices.size() / 3; };
+
+        // Baseline: a from-scratch rebuild of every frame (the old behaviour), on one thread.
+        krs::par::ThreadPool one(1);
+        const int fullFrames = std::min(frames, 100);
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < fullFrames; ++f) {
+            std::vector<glm::vec3> p;
+            splashFrame(f, r, p);
+            FluidSequenceMesher m(settings);
+            m.setThreadPool(&one);
+            RenderableMeshComponent mesh;
+            m.meshFrame(p, mesh);
+        }
+        const double fullFps = fullFrames / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        const Stats s1 = meshSequence(frames, settings, source, sink, &one);
+        krs::par::ThreadPool& all = krs::par::ThreadPool::global();
+        const Stats sN = all.size() > 1 ? meshSequence(frames, settings, source, sink, &all) : s1;
+        std::fprintf(stderr, "[FLUID-MESH]      bench: %d frames x %zu particles, full rebuild %.1f frames/s; "
+                             "incremental 1 thread %.2f s (%.1f frames/s), %u threads %.2f s (%.1f frames/s, %.2fx)\n",
+                     frames, size_t(4500 + 512), fullFps, s1.seconds, s1.framesPerSec(), sN.threads, sN.seconds,
+                     sN.framesPerSec(), s1.seconds / std::max(1e-9, sN.seconds));
+        std::snprintf(buf, sizeof(buf), "(%.1f vs %.1f frames/s on one thread)", s1.framesPerSec(), fullFps);
+        report(s1.frames == frames && s1.framesPerSec() > fullFps, "incremental beats full rebuild", buf);
+    }
+
+    std::fprintf(stderr, "[FLUID-MESH] %s (%d failure%s)\n", fails ? "FAIL" : "ALL PASS", fails, fails == 1 ? "" : "s");
+    return fails == 0;
+}
+
+} // namespace krs
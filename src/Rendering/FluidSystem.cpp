@@ -195,25 +195,40 @@ void FluidSystem::bakeSdfColliders(QOpenGLFunctions_4_3_Core* gl, entt::registry
     m_sdfColliders.clear();
     m_sdfsBaked = true;
 
+    // C2: bake in the body's SCALED-LOCAL frame (scale baked in; NO rotation/translation) -> a
+    // field whose distances are in world units and whose AABB carries the body's scale. The
+    // per-frame RIGID model (translation+rotation, krs::fluid::sdfRigidModel) then places it in
+    // the world, so the field RIDES the body and mat3(model) is orthonormal (correct normal
+    // rotation + penetration depth for any, incl. non-uniform, scale). Scale is captured at bake
+    // (re-baked on each play); rotation/translation track live.
+    // All colliders go through one batch: repeated fixtures bake once and static ones map
+    // straight from the SDF disk cache on later plays / sessions.
+    std::vector<entt::entity> entities;
+    std::vector<SdfBakeRequest> requests;
     for (auto e : registry.view<SDFColliderComponent, RenderableMeshComponent, TransformComponent>()) {
-        if (int(m_sdfColliders.size()) >= kMaxSdfColliders) {
+        if (int(requests.size()) >= kMaxSdfColliders) {
             qWarning() << "[Fluid] SDF collider cap reached (" << kMaxSdfColliders << ")";
             break;
         }
         const auto& sdfc = registry.get<SDFColliderComponent>(e);
         const auto& mesh = registry.get<RenderableMeshComponent>(e);
         const auto& xf = registry.get<TransformComponent>(e);
+        SdfBakeRequest r;
+        r.vertices = &mesh.vertices;
+        r.indices = &mesh.indices;
+        r.worldTransform = glm::scale(glm::mat4(1.0f), xf.scale);
+        r.voxelSize = sdfc.voxelSize;
+        entities.push_back(e);
+        requests.push_back(r);
+    }
+    std::vector<SdfBakeResult> bakes;
+    bakeMeshesToSdf(requests, bakes);
 
-        // C2: bake in the body's SCALED-LOCAL frame (scale baked in; NO rotation/translation) -> a
-        // field whose distances are in world units and whose AABB carries the body's scale. The
-        // per-frame RIGID model (translation+rotation, krs::fluid::sdfRigidModel) then places it in
-        // the world, so the field RIDES the body and mat3(model) is orthonormal (correct normal
-        // rotation + penetration depth for any, incl. non-uniform, scale). Scale is captured at bake
-        // (re-baked on each play); rotation/translation track live.
-        SdfBakeResult baked;
-        if (!bakeMeshToSdf(mesh.vertices, mesh.indices,
-                           glm::scale(glm::mat4(1.0f), xf.scale), sdfc.voxelSize, baked))
-            continue;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        SdfBakeResult& baked = bakes[i];
+        if (baked.field.empty()) continue;
+        const entt::entity e = entities[i];
+        const auto& xf = registry.get<TransformComponent>(e);
 
         SdfCollider out;
         out.aabbMin = baked.aabbMin;
@@ -508,7 +523,11 @@ void FluidSystem::setRecording(bool on)
         qInfo() << "[Fluid] recording bake to" << m_cache.directory();
     }
     else if (m_recording) {
-        qInfo() << "[Fluid] bake stopped:" << m_recordFrame << "frames";
+        const FluidCache::Stats st = m_cache.stats();
+        qInfo().nospace() << "[Fluid] bake stopped: " << m_recordFrame << " frames, "
+                          << double(st.rawBytes) / 1e6 << " MB -> " << double(st.storedBytes) / 1e6
+                          << " MB (" << st.ratio() << "x, " << (m_cache.lossless() ? "lossless" : "quantized")
+                          << ")";
     }
     m_recording = on;
 }
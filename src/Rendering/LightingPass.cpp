@@ -46,7 +46,8 @@ void LightingPass::execute(const RenderFrameContext& context) {
     lightingShd->use(gl);
     lightingShd->setVec3(gl, "viewPos", context.camera.getPosition());
     lightingShd->setVec3(gl, "lightPositions[0]", animatedLightPos);
-    lightingShd->setVec3(gl, "lightColors[0]", glm::vec3(200.0, 150.0, 150.0)); // Increased intensity for physical correctness
+    const SceneProperties* props = context.registry.ctx().find<SceneProperties>();
+    lightingShd->setVec3(gl, "lightColors[0]", props ? props->lightColor : glm::vec3(200.0, 150.0, 150.0)); // Increased intensity for physical correctness
     lightingShd->setInt(gl, "activeLightCount", 1);
     lightingShd->setInt(gl, "u_hdrEnabled", RenderingSystem::hdrEnabled() ? 1 : 0);
 
@@ -85,7 +85,7 @@ bool RenderingSystem::runLiveSdfGate()
     std::vector<glm::vec3> sub(pts.begin(), pts.begin() + baseCount);
     krs::field::GridSdf brute; brute.origin = origin; brute.extent = extent; brute.dims = glm::ivec3(N);
     const auto b0 = std::chrono::steady_clock::now();
-    brute.build(sub, radius);                                   // band default = exact brute force
+    brute.build(sub, radius, 1 << 20, nullptr);                 // exact band, serial: the old single-thread cost
     const auto b1 = std::chrono::steady_clock::now();
     const double bruteMs = std::chrono::duration<double, std::milli>(b1 - b0).count();
     const bool baselineFails = bruteMs > 15.0;
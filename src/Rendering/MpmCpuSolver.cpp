@@ -0,0 +1,1079 @@
+#include "MpmCpuSolver.hpp"
+#include "ParallelFor.hpp"
+#include "MortonSort.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define KRS_MPM_SSE 1
+#else
+#define KRS_MPM_SSE 0
+#endif
+
+// Ports of mpm_p2g_comp.glsl / mpm_grid_comp.glsl / mpm_g2p_comp.glsl. Keep the
+// float arithmetic in the same order as the shaders so the backends stay close.
+namespace {
+
+using Clock = std::chrono::steady_clock;
+double msSince(Clock::time_point t0) { return std::chrono::duration<double, std::milli>(Clock::now() - t0).count(); }
+
+constexpr int kBlock = 4;                  // nodes per block edge
+constexpr int kBlockNodes = kBlock * kBlock * kBlock;
+
+void jacobiRotateSym(glm::mat3& S, glm::mat3& V, int pp, int qq)
+{
+    const float spq = S[qq][pp];
+    if (std::abs(spq) < 1e-20f) return;
+    const float spp = S[pp][pp];
+    const float sqq = S[qq][qq];
+    const float tau = (sqq - spp) / (2.0f * spq);
+    const float t = (tau == 0.0f) ? 1.0f
+                  : (tau > 0.0f ? 1.0f : -1.0f) / (std::abs(tau) + std::sqrt(1.0f + tau * tau));
+    const float c = 1.0f / std::sqrt(1.0f + t * t);
+    const float s = t * c;
+    const int r = 3 - pp - qq;
+    const float spr = S[r][pp];
+    const float sqr = S[r][qq];
+    const float npp = c*c*spp - 2.0f*s*c*spq + s*s*sqq;
+    const float nqq = s*s*spp + 2.0f*s*c*spq + c*c*sqq;
+    const float npr = c*spr - s*sqr;
+    const float nqr = s*spr + c*sqr;
+    S[pp][pp] = npp; S[qq][qq] = nqq;
+    S[qq][pp] = 0.0f; S[pp][qq] = 0.0f;
+    S[r][pp] = npr; S[pp][r] = npr;
+    S[r][qq] = nqr; S[qq][r] = nqr;
+    const float v0p = V[pp][0], v1p = V[pp][1], v2p = V[pp][2];
+    const float v0q = V[qq][0], v1q = V[qq][1], v2q = V[qq][2];
+    V[pp][0] = c*v0p - s*v0q;  V[qq][0] = s*v0p + c*v0q;
+    V[pp][1] = c*v1p - s*v1q;  V[qq][1] = s*v1p + c*v1q;
+    V[pp][2] = c*v2p - s*v2q;  V[qq][2] = s*v2p + c*v2q;
+}
+
+// Shader svd3x3: Jacobi on F^T F -> V, U = F V Sigma^-1, sign on the smallest value.
+void svd3x3(const glm::mat3& F, glm::mat3& U, glm::vec3& Sigma, glm::mat3& V)
+{
+    glm::mat3 S = glm::transpose(F) * F;
+    V = glm::mat3(1.0f);
+    for (int sweep = 0; sweep < 4; ++sweep) {
+        jacobiRotateSym(S, V, 0, 1);
+        jacobiRotateSym(S, V, 0, 2);
+        jacobiRotateSym(S, V, 1, 2);
+    }
+    Sigma = glm::sqrt(glm::vec3(std::max(S[0][0], 0.0f), std::max(S[1][1], 0.0f), std::max(S[2][2], 0.0f)));
+    if (Sigma.x < Sigma.y) { std::swap(Sigma.x, Sigma.y); std::swap(V[0], V[1]); }
+    if (Sigma.y < Sigma.z) { std::swap(Sigma.y, Sigma.z); std::swap(V[1], V[2]); }
+    if (Sigma.x < Sigma.y) { std::swap(Sigma.x, Sigma.y); std::swap(V[0], V[1]); }
+    if (glm::determinant(V) < 0.0f) V[2] = -V[2];
+    const glm::mat3 FV = F * V;
+    const float EPS = 1e-12f;
+    U[0] = (Sigma.x > EPS) ? FV[0] / Sigma.x : glm::vec3(1, 0, 0);
+    U[1] = (Sigma.y > EPS) ? FV[1] / Sigma.y : glm::vec3(0, 1, 0);
+    U[2] = (Sigma.z > EPS) ? FV[2] / Sigma.z : glm::vec3(0, 0, 1);
+    if (Sigma.z <= EPS) {
+        if (Sigma.y > EPS) {
+            U[2] = glm::normalize(glm::cross(U[0], U[1]));
+        } else if (Sigma.x > EPS) {
+            const glm::vec3 u0 = U[0];
+            const glm::vec3 tt = (std::abs(u0.x) < 0.9f) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+            U[1] = glm::normalize(glm::cross(u0, tt));
+            U[2] = glm::normalize(glm::cross(u0, U[1]));
+        } else {
+            U = glm::mat3(1.0f);
+        }
+    }
+    if (glm::determinant(U) < 0.0f) { U[2] = -U[2]; Sigma.z = -Sigma.z; }
+}
+
+glm::mat3 diagm(const glm::vec3& d) { return glm::mat3(d.x, 0, 0, 0, d.y, 0, 0, 0, d.z); }
+
+glm::mat3 matC(const MpmCpuSolver::Particle& p) { return glm::mat3(glm::vec3(p.c0), glm::vec3(p.c1), glm::vec3(p.c2)); }
+glm::mat3 matF(const MpmCpuSolver::Particle& p) { return glm::mat3(glm::vec3(p.f0), glm::vec3(p.f1), glm::vec3(p.f2)); }
+
+// Kirchhoff stress (mpm_p2g computeTau).
+glm::mat3 computeTau(const MpmCpuSolver::Particle& pp)
+{
+    const float matType = pp.matl.w;
+    const glm::mat3 F = matF(pp);
+    if (matType < 0.5f) {                                   // FLUID: Tait EOS + Newtonian viscosity
+        const float J = std::max(pp.plastic.x, 1e-4f);
+        const float K = pp.matl.x, gamma = pp.matl.y, visc = pp.matl.z;
+        const float pres = K * (std::pow(1.0f / J, gamma) - 1.0f);
+        glm::mat3 tau(-J * pres);
+        if (visc > 0.0f) {
+            const glm::mat3 C = matC(pp);
+            const glm::mat3 D = 0.5f * (C + glm::transpose(C));
+            const float trD = (D[0][0] + D[1][1] + D[2][2]) / 3.0f;
+            tau += (2.0f * visc * J) * (D - glm::mat3(trD));
+        }
+        return tau;
+    }
+    const float mu = pp.matl.x, lambda = pp.matl.y;
+    glm::mat3 U, V; glm::vec3 sig;
+    svd3x3(F, U, sig, V);
+    if (matType > 1.5f && matType < 2.5f) {                 // SAND: Hencky, principal frame
+        const glm::vec3 lnSig = glm::log(glm::max(glm::abs(sig), glm::vec3(1e-9f)));
+        const float trEps = lnSig.x + lnSig.y + lnSig.z;
+        const glm::vec3 tauP = 2.0f * mu * lnSig + glm::vec3(lambda * trEps);
+        return U * diagm(tauP) * glm::transpose(U);
+    }
+    const glm::mat3 R = U * glm::transpose(V);              // ELASTIC / SNOW: fixed-corotated
+    const float J = sig.x * sig.y * sig.z;
+    return 2.0f * mu * (F - R) * glm::transpose(F) + glm::mat3(lambda * (J - 1.0f) * J);
+}
+
+// Quadratic B-spline stencil: base node, fractional offset and the three
+// per-axis weight rows, evaluated 3 lanes at a time on vec3.
+struct Stencil {
+    glm::ivec3 base;
+    glm::vec3 fx;
+    glm::vec3 w[3];   // w[a] = weights of offset a for (x, y, z)
+};
+inline Stencil stencil(const glm::vec3& pos, const glm::vec3& origin, float invDx)
+{
+    Stencil s;
+    const glm::vec3 Xp = (pos - origin) * invDx;
+    s.base = glm::ivec3(glm::floor(Xp - 0.5f));
+    s.fx = Xp - glm::vec3(s.base);
+    s.w[0] = 0.5f * (1.5f - s.fx) * (1.5f - s.fx);
+    s.w[1] = 0.75f - (s.fx - 1.0f) * (s.fx - 1.0f);
+    s.w[2] = 0.5f * (s.fx - 0.5f) * (s.fx - 0.5f);
+    return s;
+}
+
+// The stencil's three nodes per axis, located in the 2x2x2 storage blocks around
+// scatter block b: sel[ax][a] is the block bit ((n+1)/4 - b) << ax, or -1 when the
+// node is off the grid; loc[ax][a] is that axis' term of the in-block node index.
+struct Footprint {
+    int sel[3][3];
+    int loc[3][3];
+};
+inline Footprint footprint(const glm::ivec3& base, const glm::ivec3& b, int N)
+{
+    Footprint f;
+    for (int ax = 0; ax < 3; ++ax)
+        for (int a = 0; a < 3; ++a) {
+            const int n = base[ax] + a;
+            f.sel[ax][a] = (n >= 0 && n < N) ? (((n + 1) >> 2) - b[ax]) << ax : -1;
+            f.loc[ax][a] = ((n + 1) & 3) << (2 * ax);
+        }
+    return f;
+}
+
+// Scatter block of a particle: block of its stencil base clamped to [-1, N-1], so
+// particles outside the domain still schedule (their off-grid nodes are skipped).
+inline glm::ivec3 scatterBlock(const glm::vec3& pos, const glm::vec3& origin, float invDx, int N)
+{
+    const glm::vec3 Xp = (pos - origin) * invDx;
+    const glm::ivec3 base = glm::clamp(glm::ivec3(glm::floor(Xp - 0.5f)), glm::ivec3(-1), glm::ivec3(N - 1));
+    return (base + 1) >> 2;
+}
+
+constexpr float kSentinel = -1.0e9f;       // mpm_heat_*: empty cell temperature
+
+} // namespace
+
+// Sparse block grid + the P2G colour schedule. Node n lives in block (n+1)/4, so
+// a particle whose (clamped) base sits in scatter block b touches only storage
+// blocks b and b+1 per axis. Blocks are named by packed (x, y, z) keys; the
+// allocated ones form a sorted key list (slot = position), and each scatter block
+// caches the slots of its 8 storage blocks, so nothing is sized by N.
+struct MpmCpuSolver::Grid {
+    int N = 0, bits = 0;               // grid cells / key bits per block axis
+    std::vector<uint64_t> active;      // allocated block keys, ascending (slot order)
+    std::vector<glm::vec4> node;       // kBlockNodes per slot: xyz momentum -> velocity, w mass
+    std::vector<float> temp;           // heat grid: swept node temperature
+    // colour schedule: live particles radix-sorted by (colour, scatter block)
+    std::vector<uint64_t> key, blockKey;
+    std::vector<uint32_t> order;       // sorted position -> particle index
+    std::vector<int> live, blockStart;
+    std::vector<int> pblock;           // particle -> scatter block ordinal (-1 = dead)
+    std::vector<int> slots;            // 8 per scatter block: slot of b + (i&1, i>>1&1, i>>2)
+    int colorBlock[9] = {};
+
+    void reset(int n) {
+        N = n;
+        bits = 1;
+        while ((1 << bits) < (N >> 2) + 2) ++bits;
+        active.clear();
+    }
+    uint64_t pack(const glm::ivec3& b) const {
+        return (uint64_t(b.z) << (2 * bits)) | (uint64_t(b.y) << bits) | uint64_t(b.x);
+    }
+    glm::ivec3 unpack(uint64_t k) const {
+        const uint64_t m = (uint64_t(1) << bits) - 1;
+        return glm::ivec3(int(k & m), int((k >> bits) & m), int(k >> (2 * bits)));
+    }
+    int find(uint64_t k) const {
+        const auto it = std::lower_bound(active.begin(), active.end(), k);
+        return (it != active.end() && *it == k) ? int(it - active.begin()) : -1;
+    }
+    size_t bytes() const {
+        return node.capacity() * sizeof(glm::vec4) + temp.capacity() * sizeof(float)
+             + (active.capacity() + blockKey.capacity()) * sizeof(uint64_t) + slots.capacity() * sizeof(int);
+    }
+};
+
+MpmCpuSolver::MpmCpuSolver() : m_grid(std::make_unique<Grid>()), m_heatGrid(std::make_unique<Grid>()), m_simd(KRS_MPM_SSE != 0) {}
+MpmCpuSolver::~MpmCpuSolver() = default;
+
+void MpmCpuSolver::setSimd(bool on) { m_simd = on && KRS_MPM_SSE != 0; }
+
+void MpmCpuSolver::setParticles(const float* data, int count)
+{
+    m_particles.resize(size_t(std::max(count, 0)));
+    if (count > 0) std::memcpy(m_particles.data(), data, sizeof(Particle) * size_t(count));
+    m_sinceReorder = 0;                                  // sort on the next substep
+}
+
+// Radix-sort the particles by the Morton code of their grid cell. Dead particles sort
+// with the rest (their position still names a cell); the schedule skips them as before.
+void MpmCpuSolver::reorder(const Params& prm)
+{
+    if (m_particles.size() < 2) return;
+    krs::par::ThreadPool& pool = m_pool ? *m_pool : krs::par::ThreadPool::global();
+    const auto t0 = Clock::now();
+    krs::morton::cellKeys(&m_particles[0].posMass.x, sizeof(Particle) / sizeof(float), m_particles.size(),
+                          prm.origin, prm.dx, m_sortKeys, &pool);
+    krs::morton::radixSort(m_sortKeys, m_sortOrder, &pool);
+    m_sortScratch.resize(m_particles.size());
+    krs::par::parallelFor(pool, m_particles.size(), 4096, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; ++k) m_sortScratch[k] = m_particles[m_sortOrder[k]];
+    });
+    m_particles.swap(m_sortScratch);
+    m_stats.sortMs = msSince(t0);
+    ++m_stats.reorders;
+}
+
+double MpmCpuSolver::gridMass() const
+{
+    double m = 0.0;
+    for (size_t i = 0; i < m_grid->active.size() * kBlockNodes; ++i) m += m_grid->node[i].w;
+    return m;
+}
+
+void MpmCpuSolver::schedule(Grid& g, const Params& prm, krs::par::ThreadPool& pool)
+{
+    if (g.N != prm.N) g.reset(prm.N);
+    const int N = prm.N;
+    const float invDx = 1.0f / prm.dx;
+    const size_t np = m_particles.size();
+
+    // ---- colour schedule: key = colour | scatter block, stable, so a block keeps index order ----
+    g.live.clear();
+    for (size_t i = 0; i < np; ++i)
+        if (m_particles[i].color.w > 0.0f) g.live.push_back(int(i));
+    const size_t nl = g.live.size();
+    g.key.resize(nl);
+    krs::par::parallelFor(pool, nl, 4096, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; ++k) {
+            const glm::ivec3 b = scatterBlock(glm::vec3(m_particles[size_t(g.live[k])].posMass), prm.origin, invDx, N);
+            const int color = (b.x & 1) | ((b.y & 1) << 1) | ((b.z & 1) << 2);
+            g.key[k] = (uint64_t(color) << (3 * g.bits)) | g.pack(b);
+        }
+    });
+    krs::morton::radixSort(g.key, g.order, &pool);
+    const uint64_t blockMask = (uint64_t(1) << (3 * g.bits)) - 1;
+    g.blockStart.clear(); g.blockKey.clear();
+    g.pblock.assign(np, -1);
+    int c = 0;
+    for (size_t k = 0; k < nl; ++k) {
+        if (k == 0 || g.key[k] != g.key[k - 1]) {
+            const int color = int(g.key[k] >> (3 * g.bits));
+            while (c <= color) g.colorBlock[c++] = int(g.blockStart.size());
+            g.blockStart.push_back(int(k));
+            g.blockKey.push_back(g.key[k] & blockMask);
+        }
+        g.order[k] = uint32_t(g.live[g.order[k]]);
+        g.pblock[g.order[k]] = int(g.blockStart.size()) - 1;
+    }
+    while (c <= 8) g.colorBlock[c++] = int(g.blockStart.size());
+    g.blockStart.push_back(int(nl));
+
+    // ---- sparse allocation: storage blocks b..b+1 of every occupied scatter block ----
+    const size_t nBlocks = g.blockKey.size();
+    g.active.clear();
+    for (uint64_t bk : g.blockKey) {
+        const glm::ivec3 b = g.unpack(bk);
+        for (int i = 0; i < 8; ++i) g.active.push_back(g.pack(b + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2)));
+    }
+    std::sort(g.active.begin(), g.active.end());
+    g.active.erase(std::unique(g.active.begin(), g.active.end()), g.active.end());
+    g.slots.resize(nBlocks * 8);
+    krs::par::parallelFor(pool, nBlocks, 64, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; ++j) {
+            const glm::ivec3 b = g.unpack(g.blockKey[j]);
+            for (int i = 0; i < 8; ++i) g.slots[j * 8 + i] = g.find(g.pack(b + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2)));
+        }
+    });
+    const size_t nodes = g.active.size() * kBlockNodes;
+    if (g.node.size() < nodes) g.node.resize(nodes);
+    krs::par::parallelFor(pool, g.active.size(), 64, [&](size_t lo, size_t hi) {
+        std::fill(g.node.begin() + lo * kBlockNodes, g.node.begin() + hi * kBlockNodes, glm::vec4(0.0f));
+    });
+}
+
+void MpmCpuSolver::substep(const Params& prm)
+{
+    krs::par::ThreadPool& pool = m_pool ? *m_pool : krs::par::ThreadPool::global();
+    Grid& g = *m_grid;
+    const int N = prm.N;
+    if (m_reorderInterval > 0 && m_sinceReorder-- <= 0) {
+        reorder(prm);
+        m_sinceReorder = m_reorderInterval - 1;
+    }
+    const size_t np = m_particles.size();
+    const float dx = prm.dx, invDx = 1.0f / prm.dx, dt = prm.dt;
+    const float Dinv = 4.0f * invDx * invDx;
+    const bool simd = m_simd;
+    auto t0 = Clock::now();
+
+    schedule(g, prm, pool);
+    m_stats.activeBlocks = int(g.active.size());
+    m_stats.gridBytes = std::max(m_stats.gridBytes, g.bytes());
+
+    // ---- P2G: colours in sequence, blocks of one colour in parallel ----
+    for (int c = 0; c < 8; ++c) {
+        const int b0 = g.colorBlock[c];
+        krs::par::parallelFor(pool, size_t(g.colorBlock[c + 1] - b0), 1, [&](size_t lo, size_t hi) {
+            for (size_t b = b0 + lo; b < b0 + hi; ++b) {
+                const glm::ivec3 blk = g.unpack(g.blockKey[b]);
+                const int* sl = &g.slots[b * 8];
+                for (int k = g.blockStart[b]; k < g.blockStart[b + 1]; ++k) {
+                    const Particle& pp = m_particles[g.order[size_t(k)]];
+                    const float mass = pp.posMass.w;
+                    if (mass <= 0.0f) continue;
+                    const glm::vec3 vel(pp.velVol);
+                    const glm::mat3 affine = mass * matC(pp) - (dt * pp.velVol.w * Dinv) * computeTau(pp);
+                    const Stencil st = stencil(glm::vec3(pp.posMass), prm.origin, invDx);
+                    const Footprint fp = footprint(st.base, blk, N);
+                    const glm::vec3 mv = mass * vel;
+#if KRS_MPM_SSE
+                    if (simd) {
+                        // Lane w carries the mass: affine columns are 0 there, so w = wt * mass.
+                        const __m128 A0 = _mm_setr_ps(affine[0].x, affine[0].y, affine[0].z, 0.0f);
+                        const __m128 A1 = _mm_setr_ps(affine[1].x, affine[1].y, affine[1].z, 0.0f);
+                        const __m128 A2 = _mm_setr_ps(affine[2].x, affine[2].y, affine[2].z, 0.0f);
+                        const __m128 MV = _mm_setr_ps(mv.x, mv.y, mv.z, mass);
+                        for (int a = 0; a < 3; ++a) {
+                            if (fp.sel[0][a] < 0) continue;
+                            const __m128 ax = _mm_mul_ps(A0, _mm_set1_ps((float(a) - st.fx.x) * dx));
+                            for (int bb = 0; bb < 3; ++bb) {
+                                if (fp.sel[1][bb] < 0) continue;
+                                const __m128 axy = _mm_add_ps(ax, _mm_mul_ps(A1, _mm_set1_ps((float(bb) - st.fx.y) * dx)));
+                                for (int cc = 0; cc < 3; ++cc) {
+                                    if (fp.sel[2][cc] < 0) continue;
+                                    const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                                    const __m128 aff = _mm_add_ps(axy, _mm_mul_ps(A2, _mm_set1_ps((float(cc) - st.fx.z) * dx)));
+                                    float* nd = &g.node[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                                                        + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])].x;
+                                    _mm_storeu_ps(nd, _mm_add_ps(_mm_loadu_ps(nd), _mm_mul_ps(_mm_set1_ps(wt), _mm_add_ps(MV, aff))));
+                                }
+                            }
+                        }
+                        continue;
+                    }
+#endif
+                    for (int a = 0; a < 3; ++a)
+                    for (int bb = 0; bb < 3; ++bb)
+                    for (int cc = 0; cc < 3; ++cc) {
+                        if (fp.sel[0][a] < 0 || fp.sel[1][bb] < 0 || fp.sel[2][cc] < 0) continue;
+                        const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                        const glm::vec3 dpos = (glm::vec3(a, bb, cc) - st.fx) * dx;
+                        const glm::vec3 mom = wt * (mv + affine * dpos);
+                        g.node[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                               + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])] += glm::vec4(mom, wt * mass);
+                    }
+                }
+            }
+        });
+    }
+    m_stats.p2gMs = msSince(t0);
+    t0 = Clock::now();
+
+    // ---- grid update (mpm_grid): velocity, gravity, separating walls, floor friction ----
+    krs::par::parallelFor(pool, g.active.size(), 16, [&](size_t lo, size_t hi) {
+        for (size_t s = lo; s < hi; ++s) {
+            const glm::ivec3 b = g.unpack(g.active[s]);
+            glm::vec4* blk = &g.node[s * kBlockNodes];
+            for (int l = 0; l < kBlockNodes; ++l) {
+                const float m = blk[l].w;
+                glm::vec3 v(0.0f);
+                if (m > 1e-10f) {
+                    v = glm::vec3(blk[l]) / m;
+                    v += dt * prm.gravity;
+                    const int cx = b.x * kBlock - 1 + (l & 3);
+                    const int cy = b.y * kBlock - 1 + ((l >> 2) & 3);
+                    const int cz = b.z * kBlock - 1 + (l >> 4);
+                    if (cx < prm.bound     && v.x < 0.0f) v.x = 0.0f;
+                    if (cx >= N - prm.bound && v.x > 0.0f) v.x = 0.0f;
+                    if (cy >= N - prm.bound && v.y > 0.0f) v.y = 0.0f;
+                    if (cz < prm.bound     && v.z < 0.0f) v.z = 0.0f;
+                    if (cz >= N - prm.bound && v.z > 0.0f) v.z = 0.0f;
+                    if (cy < prm.bound && v.y < 0.0f) {             // floor: Coulomb cone
+                        const float vn = -v.y;
+                        v.y = 0.0f;
+                        const float vtl = std::sqrt(v.x * v.x + v.z * v.z);
+                        if (vtl > 1e-8f) {
+                            const float reduce = std::min(vtl, prm.floorFriction * vn);
+                            const float k = 1.0f - reduce / vtl;
+                            v.x *= k; v.z *= k;
+                        }
+                    }
+                    if (cy < prm.bound + 2 && prm.floorStick > 0.0f) {
+                        const float k = std::max(0.0f, 1.0f - prm.floorStick);
+                        v.x *= k; v.z *= k;
+                    }
+                }
+                blk[l] = glm::vec4(v, m);
+            }
+        }
+    });
+    m_stats.gridMs = msSince(t0);
+    t0 = Clock::now();
+
+    // ---- G2P (mpm_g2p): gather v and C, advect, clamp, update F + return maps ----
+    const float domain = float(N) * dx;
+    const glm::vec3 lo = prm.origin + 1.6f * dx;
+    const glm::vec3 hi = prm.origin + glm::vec3(domain) - 1.6f * dx;
+    krs::par::parallelFor(pool, np, 256, [&](size_t i0, size_t i1) {
+        for (size_t i = i0; i < i1; ++i) {
+            Particle& pp = m_particles[i];
+            if (pp.color.w <= 0.0f) continue;
+            glm::vec3 pos(pp.posMass);
+            const Stencil st = stencil(pos, prm.origin, invDx);
+            const int pb = g.pblock[i];
+            const Footprint fp = footprint(st.base, g.unpack(g.blockKey[size_t(pb)]), N);
+            const int* sl = &g.slots[size_t(pb) * 8];
+            glm::vec3 newV(0.0f);
+            glm::mat3 newC(0.0f);
+#if KRS_MPM_SSE
+            if (simd) {
+                __m128 V = _mm_setzero_ps(), C0 = _mm_setzero_ps(), C1 = _mm_setzero_ps(), C2 = _mm_setzero_ps();
+                for (int a = 0; a < 3; ++a) {
+                    if (fp.sel[0][a] < 0) continue;
+                    const __m128 dX = _mm_set1_ps((float(a) - st.fx.x) * dx);
+                    for (int bb = 0; bb < 3; ++bb) {
+                        if (fp.sel[1][bb] < 0) continue;
+                        const __m128 dY = _mm_set1_ps((float(bb) - st.fx.y) * dx);
+                        for (int cc = 0; cc < 3; ++cc) {
+                            if (fp.sel[2][cc] < 0) continue;
+                            const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                            const __m128 gv = _mm_loadu_ps(&g.node[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                                                                   + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])].x);
+                            const __m128 s = _mm_set1_ps(Dinv * wt);
+                            V = _mm_add_ps(V, _mm_mul_ps(_mm_set1_ps(wt), gv));
+                            C0 = _mm_add_ps(C0, _mm_mul_ps(_mm_mul_ps(gv, dX), s));
+                            C1 = _mm_add_ps(C1, _mm_mul_ps(_mm_mul_ps(gv, dY), s));
+                            C2 = _mm_add_ps(C2, _mm_mul_ps(_mm_mul_ps(gv, _mm_set1_ps((float(cc) - st.fx.z) * dx)), s));
+                        }
+                    }
+                }
+                float r[4][4];
+                _mm_storeu_ps(r[0], V); _mm_storeu_ps(r[1], C0); _mm_storeu_ps(r[2], C1); _mm_storeu_ps(r[3], C2);
+                newV = glm::vec3(r[0][0], r[0][1], r[0][2]);
+                for (int k = 0; k < 3; ++k) newC[k] = glm::vec3(r[k + 1][0], r[k + 1][1], r[k + 1][2]);
+            } else
+#endif
+            for (int a = 0; a < 3; ++a)
+            for (int bb = 0; bb < 3; ++bb)
+            for (int cc = 0; cc < 3; ++cc) {
+                if (fp.sel[0][a] < 0 || fp.sel[1][bb] < 0 || fp.sel[2][cc] < 0) continue;
+                const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                const glm::vec3 dpos = (glm::vec3(a, bb, cc) - st.fx) * dx;
+                const glm::vec3 gv(g.node[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                                          + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])]);
+                newV += wt * gv;
+                newC += (Dinv * wt) * glm::outerProduct(gv, dpos);
+            }
+            const float matType = pp.matl.w;
+            if (matType > 1.5f && matType < 2.5f) {             // SAND settling (off by default)
+                if (prm.picBlend > 0.0f)    newC *= (1.0f - prm.picBlend);
+                if (prm.velDampRate > 0.0f) newV *= std::max(0.0f, 1.0f - prm.velDampRate * dt);
+            }
+            pos += dt * newV;
+            pos = glm::clamp(pos, lo, hi);
+            pos.y = std::max(pos.y, prm.floorY + prm.radius);
+
+            glm::mat3 F = matF(pp);
+            if (matType < 0.5f) {                                // FLUID: track J only
+                float J = pp.plastic.x;
+                J *= (1.0f + dt * (newC[0][0] + newC[1][1] + newC[2][2]));
+                pp.plastic.x = glm::clamp(J, 0.1f, 4.0f);
+            } else {
+                const glm::mat3 Fnew = (glm::mat3(1.0f) + dt * newC) * F;
+                if (matType > 0.5f && matType < 1.5f) {
+                    F = Fnew;                                    // ELASTIC
+                } else if (matType > 1.5f && matType < 2.5f) {   // SAND: stress-space Drucker-Prager
+                    const float mu = pp.matl.x, lambda = pp.matl.y, alpha = pp.matl.z;
+                    glm::mat3 U, V; glm::vec3 sig;
+                    svd3x3(Fnew, U, sig, V);
+                    const glm::vec3 eps = glm::log(glm::max(glm::abs(sig), glm::vec3(1e-9f)));
+                    const float trEps = eps.x + eps.y + eps.z;
+                    const glm::vec3 tau = 2.0f * mu * eps + glm::vec3(lambda * trEps);
+                    const float pmean = (tau.x + tau.y + tau.z) / 3.0f;
+                    const glm::vec3 s = tau - glm::vec3(pmean);
+                    const float sNorm = glm::length(s);
+                    glm::vec3 SigProj;
+                    if (pmean >= 0.0f) {
+                        SigProj = glm::vec3(1.0f);
+                    } else {
+                        const float coneR = -3.0f * alpha * pmean;
+                        if (sNorm <= coneR || sNorm < 1e-12f) {
+                            SigProj = sig;
+                        } else {
+                            const glm::vec3 tauProj = s * (coneR / sNorm) + glm::vec3(pmean);
+                            const float trTau = tauProj.x + tauProj.y + tauProj.z;
+                            const glm::vec3 epsNew = (tauProj - glm::vec3(lambda * trTau / (2.0f * mu + 3.0f * lambda)))
+                                                   / (2.0f * mu);
+                            SigProj = glm::exp(epsNew);
+                        }
+                    }
+                    F = U * diagm(SigProj) * glm::transpose(V);
+                } else {                                         // SNOW: clamp stretches
+                    glm::mat3 U, V; glm::vec3 sig;
+                    svd3x3(Fnew, U, sig, V);
+                    const glm::vec3 SigC = glm::clamp(sig, glm::vec3(1.0f - prm.thetaC), glm::vec3(1.0f + prm.thetaS));
+                    F = U * diagm(SigC) * glm::transpose(V);
+                }
+            }
+            pp.posMass = glm::vec4(pos, pp.posMass.w);
+            pp.velVol = glm::vec4(newV, pp.velVol.w);
+            pp.c0 = glm::vec4(newC[0], pp.c0.w); pp.c1 = glm::vec4(newC[1], pp.c1.w); pp.c2 = glm::vec4(newC[2], pp.c2.w);
+            pp.f0 = glm::vec4(F[0], pp.f0.w); pp.f1 = glm::vec4(F[1], pp.f1.w); pp.f2 = glm::vec4(F[2], pp.f2.w);
+        }
+    });
+    m_stats.g2pMs = msSince(t0);
+}
+
+// mpm_heat_scatter / normalize / diffuse / gather on the sparse grid. The GPU sums in
+// 1e-3 fixed point; here the scatter is float through the same colour schedule, so the
+// step is deterministic for any thread count. Node (x, y, z) = (T, C = sum m*c_p, k).
+void MpmCpuSolver::thermalStep(const Params& prm, const ThermalParams& t)
+{
+    if (m_particles.empty()) return;
+    krs::par::ThreadPool& pool = m_pool ? *m_pool : krs::par::ThreadPool::global();
+    Grid& g = *m_heatGrid;
+    const int N = prm.N;
+    const float invDx = 1.0f / prm.dx;
+    const int nSrc = std::clamp(t.heatCount, 0, ThermalParams::kMaxSources);
+    schedule(g, prm, pool);
+    m_stats.gridBytes = std::max(m_stats.gridBytes, g.bytes());
+
+    // ---- per-source thermal mass sum(m*c_p) inside the radius ----
+    double srcMass[ThermalParams::kMaxSources] = {};
+    for (int h = 0; h < nSrc; ++h)
+        for (int i : g.live) {
+            const Particle& pp = m_particles[size_t(i)];
+            if (glm::distance(glm::vec3(pp.posMass), glm::vec3(t.heatSrc[h])) <= t.heatRadius[h])
+                srcMass[h] += double(pp.posMass.w * pp.plastic.z);
+        }
+
+    // ---- scatter: energy m*c_p*T, thermal mass m*c_p, k-weighted mass m*c_p*k ----
+    for (int c = 0; c < 8; ++c) {
+        const int b0 = g.colorBlock[c];
+        krs::par::parallelFor(pool, size_t(g.colorBlock[c + 1] - b0), 1, [&](size_t lo, size_t hi) {
+            for (size_t b = b0 + lo; b < b0 + hi; ++b) {
+                const glm::ivec3 blk = g.unpack(g.blockKey[b]);
+                const int* sl = &g.slots[b * 8];
+                for (int k = g.blockStart[b]; k < g.blockStart[b + 1]; ++k) {
+                    const Particle& pp = m_particles[g.order[size_t(k)]];
+                    const float cm = pp.posMass.w * pp.plastic.z;
+                    const float T = pp.plastic.y, kc = pp.therm2.x;
+                    const Stencil st = stencil(glm::vec3(pp.posMass), prm.origin, invDx);
+                    const Footprint fp = footprint(st.base, blk, N);
+                    for (int a = 0; a < 3; ++a)
+                    for (int bb = 0; bb < 3; ++bb)
+                    for (int cc = 0; cc < 3; ++cc) {
+                        if (fp.sel[0][a] < 0 || fp.sel[1][bb] < 0 || fp.sel[2][cc] < 0) continue;
+                        const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                        g.node[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                               + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])]
+                            += glm::vec4(wt * cm * T, wt * cm, wt * cm * kc, 0.0f);
+                    }
+                }
+            }
+        });
+    }
+
+    // ---- normalize: T = E / C, k = K / C; no thermal mass = empty (sentinel) ----
+    const size_t nodes = g.active.size() * kBlockNodes;
+    krs::par::parallelFor(pool, nodes, 4096, [&](size_t lo, size_t hi) {
+        for (size_t n = lo; n < hi; ++n) {
+            glm::vec4& nd = g.node[n];
+            if (nd.y > 1.0e-9f) nd = glm::vec4(nd.x / nd.y, nd.y, nd.z / nd.y, 0.0f);
+            else nd = glm::vec4(kSentinel, 0.0f, 0.0f, 0.0f);
+        }
+    });
+
+    // ---- diffuse: one explicit Fourier sweep over the 6 faces (harmonic-mean k, capped) ----
+    g.temp.resize(nodes);
+    krs::par::parallelFor(pool, g.active.size(), 16, [&](size_t lo, size_t hi) {
+        for (size_t s = lo; s < hi; ++s) {
+            const glm::ivec3 b = g.unpack(g.active[s]);
+            int face[6];                                   // neighbour block slot per face
+            for (int f = 0; f < 6; ++f) {
+                glm::ivec3 nb = b;
+                nb[f >> 1] += (f & 1) ? -1 : 1;
+                face[f] = (nb[f >> 1] < 0 || nb[f >> 1] >= (1 << g.bits)) ? -1 : g.find(g.pack(nb));
+            }
+            const glm::vec4* blk = &g.node[s * kBlockNodes];
+            for (int l = 0; l < kBlockNodes; ++l) {
+                const float T = blk[l].x;
+                if (T < -1.0e8f) { g.temp[s * kBlockNodes + l] = kSentinel; continue; }
+                const glm::ivec3 lc(l & 3, (l >> 2) & 3, l >> 4);
+                const glm::ivec3 cell = b * kBlock - 1 + lc;
+                const float kn = blk[l].z, Cn = blk[l].y;
+                float dE = 0.0f;
+                for (int f = 0; f < 6; ++f) {
+                    const int ax = f >> 1, dir = (f & 1) ? -1 : 1;
+                    const int ncell = cell[ax] + dir;
+                    if (ncell < 0 || ncell >= N) continue;
+                    glm::ivec3 nl = lc;
+                    nl[ax] += dir;
+                    const glm::vec4* nblk = blk;
+                    if (nl[ax] < 0 || nl[ax] >= kBlock) {
+                        if (face[f] < 0) continue;             // unallocated = empty
+                        nblk = &g.node[size_t(face[f]) * kBlockNodes];
+                        nl[ax] &= 3;
+                    }
+                    const glm::vec4& nd = nblk[(nl.z * kBlock + nl.y) * kBlock + nl.x];
+                    const float Tn = nd.x;
+                    if (Tn < -1.0e8f) continue;                // material boundary = insulated
+                    const float knb = nd.z, Cnb = nd.y;
+                    const float kf = (kn + knb > 1.0e-12f) ? (2.0f * kn * knb) / (kn + knb) : 0.0f;
+                    const float aMax = t.betaMax * std::min(Cn, Cnb) * (1.0f / 6.0f);
+                    const float aF = std::min(t.coef * kf, aMax);
+                    dE += aF * (Tn - T);
+                }
+                g.temp[s * kBlockNodes + l] = T + ((Cn > 1.0e-9f) ? dE / Cn : 0.0f);
+            }
+        }
+    });
+
+    // ---- gather: Shepard over occupied nodes, ambient exchange, sources, melt ----
+    krs::par::parallelFor(pool, m_particles.size(), 256, [&](size_t i0, size_t i1) {
+        for (size_t i = i0; i < i1; ++i) {
+            Particle& pp = m_particles[i];
+            if (pp.color.w <= 0.0f) continue;
+            const glm::vec3 pos(pp.posMass);
+            const Stencil st = stencil(pos, prm.origin, invDx);
+            const int pb = g.pblock[i];
+            const Footprint fp = footprint(st.base, g.unpack(g.blockKey[size_t(pb)]), N);
+            const int* sl = &g.slots[size_t(pb) * 8];
+            float Tsum = 0.0f, wsum = 0.0f;
+            for (int a = 0; a < 3; ++a)
+            for (int bb = 0; bb < 3; ++bb)
+            for (int cc = 0; cc < 3; ++cc) {
+                if (fp.sel[0][a] < 0 || fp.sel[1][bb] < 0 || fp.sel[2][cc] < 0) continue;
+                const float Tn = g.temp[size_t(sl[fp.sel[0][a] | fp.sel[1][bb] | fp.sel[2][cc]]) * kBlockNodes
+                                        + size_t(fp.loc[0][a] + fp.loc[1][bb] + fp.loc[2][cc])];
+                if (Tn < -1.0e8f) continue;
+                const float wt = st.w[a].x * st.w[bb].y * st.w[cc].z;
+                Tsum += wt * Tn;
+                wsum += wt;
+            }
+            float Tnew = (wsum > 1.0e-6f) ? Tsum / wsum : pp.plastic.y;
+            Tnew += t.heatExchange * t.dtFrame * (t.ambientT - Tnew);
+            for (int h = 0; h < nSrc; ++h)
+                if (glm::distance(pos, glm::vec3(t.heatSrc[h])) <= t.heatRadius[h] && srcMass[h] > 1.0e-6)
+                    Tnew += (t.heatPower[h] * t.dtFrame) / float(srcMass[h]);
+            pp.plastic.y = Tnew;
+            if (pp.matl.w > 0.5f && Tnew >= pp.plastic.w) {    // phase change: solid -> fluid
+                pp.matl = glm::vec4(t.fluidK, 7.0f, 0.0f, 0.0f);
+                pp.f0 = glm::vec4(1, 0, 0, 0); pp.f1 = glm::vec4(0, 1, 0, 0); pp.f2 = glm::vec4(0, 0, 1, 0);
+                pp.plastic.x = 1.0f;
+                pp.color = glm::vec4(glm::mix(glm::vec3(pp.color), glm::vec3(0.2f, 0.45f, 0.85f), 0.6f), pp.color.w);
+            }
+        }
+    });
+}
+
+// ===================================================================================================
+// Headless suite. Same scenes and bands as MpmSystem::runSelfTests (which also checks CPU vs GPU on a
+// GL context); these run anywhere and add the determinism + throughput checks only the CPU path has.
+// ===================================================================================================
+namespace {
+
+struct Scene { MpmCpuSolver solver; MpmCpuSolver::Params prm; float waveSpeed = 1.0f; };
+
+// Same particle record MpmSystem's seeders write (mu/lambda/alpha from E, nu, 35 deg).
+void seedBlock(Scene& s, int material, glm::vec3 center, float half, float spacing, float density,
+               float E, float nu, bool append = false, float T0 = 20.0f, float meltT = 1.0e9f, float k = 50.0f)
+{
+    std::vector<MpmCpuSolver::Particle> ps;
+    const float vol = spacing * spacing * spacing, mass = density * vol;
+    const float mu = E / (2.0f * (1.0f + nu));
+    const float lambda = E * nu / ((1.0f + nu) * (1.0f - 2.0f * nu));
+    const float sphi = std::sin(glm::radians(35.0f));
+    const float alpha = std::sqrt(2.0f / 3.0f) * (2.0f * sphi) / (3.0f - sphi);
+    const int n = std::max(1, int(std::round(2.0f * half / spacing)));
+    for (int ix = 0; ix < n; ++ix)
+        for (int iy = 0; iy < n; ++iy)
+            for (int iz = 0; iz < n; ++iz) {
+                MpmCpuSolver::Particle p{};
+                const glm::vec3 x = center - glm::vec3(half) + (glm::vec3(ix, iy, iz) + 0.5f) * spacing;
+                p.posMass = glm::vec4(x, mass);
+                p.velVol = glm::vec4(0, 0, 0, vol);
+                p.f0 = glm::vec4(1, 0, 0, 0); p.f1 = glm::vec4(0, 1, 0, 0); p.f2 = glm::vec4(0, 0, 1, 0);
+                p.plastic = glm::vec4(1.0f, T0, 900.0f, meltT);
+                p.matl = (material == 0) ? glm::vec4(E, 7.0f, 0.0f, 0.0f) : glm::vec4(mu, lambda, alpha, float(material));
+                p.color = glm::vec4(0.6f, 0.7f, 0.9f, 1.0f);
+                p.therm2 = glm::vec4(k, 0, 0, 0);
+                ps.push_back(p);
+            }
+    auto& dst = s.solver.particles();
+    if (!append) dst.clear();
+    dst.insert(dst.end(), ps.begin(), ps.end());
+    const float stiff = (material == 0) ? E * 7.0f : E;
+    s.waveSpeed = std::max(append ? s.waveSpeed : 1.0f, std::sqrt(stiff / density));
+}
+
+// MpmSystem::runSelfTests domain: 64^3 cells over [-1.5, 1.5]^3, floor at origin.y + 2dx.
+void initScene(Scene& s, int N = 64)
+{
+    s.prm.N = N;
+    s.prm.origin = glm::vec3(-1.5f);
+    s.prm.dx = 3.0f / float(N);
+    s.prm.floorY = s.prm.origin.y + 2.0f * s.prm.dx;
+}
+
+int runFor(Scene& s, float seconds)
+{
+    const float cflDt = 0.35f * s.prm.dx / std::max(s.waveSpeed, 1.0f);
+    const int sub = std::clamp(int(std::ceil(seconds / std::max(cflDt, 1.0e-5f))), 1, 6000);
+    s.prm.dt = seconds / float(sub);
+    for (int k = 0; k < sub; ++k) s.solver.substep(s.prm);
+    return sub;
+}
+
+struct Diag { double mass = 0.0; glm::dvec3 com{ 0.0 }, vel{ 0.0 }; float maxSpeed = 0.0f, minY = 1e30f; float spreadXZ = 0.0f; };
+Diag sample(const MpmCpuSolver& s)
+{
+    Diag d;
+    for (const auto& p : s.particles()) {
+        if (p.color.w <= 0.0f) continue;
+        const double m = p.posMass.w;
+        d.mass += m;
+        d.com += glm::dvec3(glm::vec3(p.posMass)) * m;
+        d.vel += glm::dvec3(glm::vec3(p.velVol)) * m;
+        d.maxSpeed = std::max(d.maxSpeed, glm::length(glm::vec3(p.velVol)));
+        d.minY = std::min(d.minY, p.posMass.y);
+    }
+    if (d.mass > 0) { d.com /= d.mass; d.vel /= d.mass; }
+    for (const auto& p : s.particles())
+        d.spreadXZ = std::max(d.spreadXZ, float(glm::length(glm::dvec2(p.posMass.x - d.com.x, p.posMass.z - d.com.z))));
+    return d;
+}
+
+// Heat: sum(m*c_p*T) / sum(m*c_p) (energy as a mean temperature), spread, melted count.
+struct Heat { double mean = 0.0; float tMin = 1e30f, tMax = -1e30f; int fluid = 0, live = 0; };
+Heat heat(const MpmCpuSolver& s)
+{
+    Heat h;
+    double cm = 0.0;
+    for (const auto& p : s.particles()) {
+        if (p.color.w <= 0.0f) continue;
+        const double c = double(p.posMass.w) * p.plastic.z;
+        h.mean += c * p.plastic.y;
+        cm += c;
+        h.tMin = std::min(h.tMin, p.plastic.y);
+        h.tMax = std::max(h.tMax, p.plastic.y);
+        h.fluid += p.matl.w < 0.5f;
+        ++h.live;
+    }
+    if (cm > 0.0) h.mean /= cm;
+    return h;
+}
+
+float maxPosDiff(const MpmCpuSolver& a, const MpmCpuSolver& b)
+{
+    float d = 0.0f;
+    for (int i = 0; i < std::min(a.count(), b.count()); ++i)
+        d = std::max(d, glm::length(glm::vec3(a.particles()[size_t(i)].posMass) - glm::vec3(b.particles()[size_t(i)].posMass)));
+    return d;
+}
+
+bool sameBits(const MpmCpuSolver& a, const MpmCpuSolver& b)
+{
+    return a.count() == b.count()
+        && std::memcmp(a.data(), b.data(), sizeof(MpmCpuSolver::Particle) * size_t(a.count())) == 0;
+}
+
+} // namespace
+
+bool MpmCpuSolver::runSelfTests()
+{
+    bool ok = true;
+    auto check = [&](const char* name, bool pass, const char* fmt, double a, double b = 0.0) {
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), fmt, a, b);
+        std::fprintf(stderr, "[MPM-CPU] %-40s %s  (%s)\n", name, pass ? "PASS" : "FAIL", detail);
+        ok = ok && pass;
+    };
+    std::fprintf(stderr, "[MPM-CPU] === CPU MLS-MPM backend ===\n");
+
+    // 1. Free fall (MpmSystem Test 1) + sparse-grid coverage: every stencil node must land in an
+    //    allocated block, so the grid holds exactly the particle mass.
+    {
+        Scene s; initScene(s);
+        seedBlock(s, 0, glm::vec3(0), 0.2f, 0.05f, 1000.0f, 5.0e4f, 0.0f);
+        const Diag d0 = sample(s.solver);
+        const float T = 0.12f;
+        runFor(s, T);
+        const Diag d1 = sample(s.solver);
+        const double vErr = std::abs(d1.vel.y + 9.81 * T) / (9.81 * T);
+        const double dropErr = std::abs((d0.com.y - d1.com.y) - 0.5 * 9.81 * T * T) / (0.5 * 9.81 * T * T);
+        const double gridErr = std::abs(s.solver.gridMass() - d1.mass) / d1.mass;
+        const double dense = double(s.prm.N) * s.prm.N * s.prm.N;
+        const double sparse = double(s.solver.stats().activeBlocks) * kBlockNodes;
+        check("free-fall velocity = g*t", vErr < 0.05, "relErr=%.4f", vErr);
+        check("free-fall drop = 0.5*g*t^2", dropErr < 0.10, "relErr=%.4f", dropErr);
+        check("grid mass == particle mass (sparse)", gridErr < 1e-5, "relErr=%.2e", gridErr);
+        check("sparse grid << dense N^3", sparse < 0.1 * dense, "nodes %.0f of %.0f", sparse, dense);
+    }
+    // 2. Elastic drop onto the floor (MpmSystem Test 9): bounded, no penetration, settles.
+    {
+        Scene s; initScene(s);
+        s.prm.radius = 0.05f;
+        seedBlock(s, 1, glm::vec3(0.0f, -0.8f, 0.0f), 0.2f, 0.05f, 2700.0f, 2.0e6f, 0.33f);
+        runFor(s, 1.0f);
+        const Diag d = sample(s.solver);
+        const float floorR = s.prm.floorY + s.prm.radius;
+        check("elastic stable (bounded)", std::isfinite(d.maxSpeed) && d.maxSpeed < 25.0f, "maxSpeed=%.3f", d.maxSpeed);
+        check("floor: minY >= floor + radius", d.minY >= floorR - 1.0e-3f, "minY=%.4f floor+r=%.4f", d.minY, floorR);
+        check("floor: block settled near floor", d.minY <= floorR + 4.0f * 0.05f, "minY=%.4f floor+r=%.4f", d.minY, floorR);
+    }
+    // 3. Sand column (MpmSystem Test 4): collapses, spreads, stays bounded.
+    {
+        Scene s; initScene(s);
+        seedBlock(s, 2, glm::vec3(0, -0.5f, 0), 0.22f, 0.045f, 1600.0f, 6.0e5f, 0.3f);
+        const Diag d0 = sample(s.solver);
+        runFor(s, 1.2f);
+        const Diag d1 = sample(s.solver);
+        check("sand stable (bounded)", std::isfinite(d1.maxSpeed) && d1.maxSpeed < 25.0f, "maxSpeed=%.3f", d1.maxSpeed);
+        check("sand settles (COM drops)", d1.com.y < d0.com.y - 0.02, "dropY=%.4f", d0.com.y - d1.com.y);
+        check("sand spreads (granular flow)", d1.spreadXZ > d0.spreadXZ, "r %.3f -> %.3f", d0.spreadXZ, d1.spreadXZ);
+    }
+    // 4. Determinism: fluid + elastic + sand + snow in contact, 1 vs 4 threads bit for bit.
+    //    NEG-CTRL: one particle nudged by 1 ulp must change the bits (the compare is not vacuous).
+    {
+        auto build = [](Scene& s) {
+            seedBlock(s, 0, glm::vec3(-0.3f, -0.9f, 0.0f), 0.15f, 0.04f, 1000.0f, 5.0e4f, 0.0f);
+            seedBlock(s, 1, glm::vec3(0.0f, -0.8f, 0.0f), 0.12f, 0.04f, 1000.0f, 1.0e5f, 0.3f, true);
+            seedBlock(s, 2, glm::vec3(0.3f, -0.9f, 0.0f), 0.15f, 0.04f, 1600.0f, 6.0e5f, 0.3f, true);
+            seedBlock(s, 3, glm::vec3(0.0f, -1.1f, 0.3f), 0.1f, 0.04f, 400.0f, 1.4e5f, 0.2f, true);
+        };
+        krs::par::ThreadPool one(1), four(4);
+        Scene a, b, c;
+        initScene(a); initScene(b); initScene(c);
+        build(a); build(b); build(c);
+        a.solver.setThreadPool(&one); b.solver.setThreadPool(&four); c.solver.setThreadPool(&four);
+        float& y = c.solver.particles()[7].posMass.y;
+        y = std::nextafter(y, 1.0f);
+        const int sub = runFor(a, 0.05f); runFor(b, 0.05f); runFor(c, 0.05f);
+        check("1 vs 4 threads (bits)", sameBits(a.solver, b.solver), "%.0f particles, %.0f substeps",
+              double(a.solver.count()), double(sub));
+        check("NEG-CTRL 1-ulp perturbation differs", !sameBits(a.solver, c.solver), "particle %.0f y + 1 ulp", 7.0);
+    }
+    // 5. Throughput / thread scaling on a large fluid block (default 64^3 = 262144 particles).
+    {
+        int n = 262144;
+        if (const char* e = std::getenv("KRS_MPM_CPU_BENCH")) n = std::max(1000, std::atoi(e));
+        const int side = std::max(1, int(std::round(std::cbrt(double(n)))));
+        const float spacing = 0.5f * (3.0f / 128.0f);            // 2 particles per cell per axis
+        const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> counts{ 1, 2, 4 };
+        if (hw > 4) counts.push_back(hw);
+        std::vector<MpmCpuSolver::Particle> ref;
+        double t1 = 0.0;
+        bool same = true;
+        for (unsigned t : counts) {
+            krs::par::ThreadPool pool(t);
+            Scene s; initScene(s, 128);
+            s.solver.setThreadPool(&pool);
+            seedBlock(s, 0, glm::vec3(0.0f, -0.6f, 0.0f), 0.5f * side * spacing, spacing, 1000.0f, 5.0e4f, 0.0f);
+            s.prm.dt = 1.0e-4f;
+            s.solver.substep(s.prm);                            // warm-up: grid + schedule allocation
+            const int steps = 3;
+            auto t0 = Clock::now();
+            for (int k = 0; k < steps; ++k) s.solver.substep(s.prm);
+            const double sec = msSince(t0) * 1e-3;
+            if (ref.empty()) { ref = s.solver.particles(); t1 = sec; }
+            else same = same && std::memcmp(ref.data(), s.solver.data(), sizeof(Particle) * ref.size()) == 0;
+            const auto& st = s.solver.stats();
+            std::fprintf(stderr, "[MPM-CPU]     threads=%u %d particles: %.2f Mparticle-substeps/s speedup=%.2fx "
+                                 "(p2g %.1f grid %.1f g2p %.1f ms; %d blocks, %.1f MiB grid)\n",
+                         t, s.solver.count(), s.solver.count() * steps / sec * 1e-6, t1 / sec,
+                         st.p2gMs, st.gridMs, st.g2pMs, st.activeBlocks, st.gridBytes / 1048576.0);
+        }
+        check("bench threads bit-identical", same, "hw=%.0f", double(hw));
+    }
+    // 6. Morton reorder: a mixed (shuffled) fluid block stepped in spawn order vs Morton order.
+    //    Same physics up to summation order; report the substep throughput of both.
+    {
+        int n = 262144;
+        if (const char* e = std::getenv("KRS_MPM_CPU_BENCH")) n = std::max(1000, std::atoi(e));
+        const int side = std::max(1, int(std::round(std::cbrt(double(n)))));
+        const float spacing = 0.5f * (3.0f / 128.0f);
+        Scene s[2];
+        double sec[2] = {};
+        for (int k = 0; k < 2; ++k) {
+            initScene(s[k], 128);
+            seedBlock(s[k], 0, glm::vec3(0.0f, -0.6f, 0.0f), 0.5f * side * spacing, spacing, 1000.0f, 5.0e4f, 0.0f);
+            std::shuffle(s[k].solver.particles().begin(), s[k].solver.particles().end(), std::mt19937(34));
+            s[k].solver.setReorderInterval(k ? 32 : 0);
+            s[k].prm.dt = 1.0e-4f;
+            s[k].solver.substep(s[k].prm);                      // warm-up (+ the reorder for k = 1)
+            const int steps = 3;
+            auto t0 = Clock::now();
+            for (int i = 0; i < steps; ++i) s[k].solver.substep(s[k].prm);
+            sec[k] = msSince(t0) * 1e-3 / steps;
+        }
+        const Diag d0 = sample(s[0].solver), d1 = sample(s[1].solver);
+        const double dCom = glm::length(d0.com - d1.com), dVel = glm::length(d0.vel - d1.vel);
+        std::fprintf(stderr, "[MPM-CPU]     %d particles, shuffled: spawn order %.2f -> Morton order %.2f "
+                             "Mparticle-substeps/s (%.2fx; sort %.1f ms per %d substeps)\n",
+                     s[0].solver.count(), s[0].solver.count() / sec[0] * 1e-6, s[1].solver.count() / sec[1] * 1e-6,
+                     sec[0] / sec[1], s[1].solver.stats().sortMs, s[1].solver.reorderInterval());
+        check("Morton reorder keeps the physics", s[1].solver.stats().reorders == 1 && dCom < 1e-6 && dVel < 1e-5,
+              "dCom=%.2e dVel=%.2e", dCom, dVel);
+    }
+    // 7. SSE2 stencils == scalar loops on the mixed scene of test 4 (same operation order, so
+    //    the bits normally match; the band allows a compiler that contracts to FMA), then the
+    //    single-thread throughput of both. NEG-CTRL: 0.99 g must leave the band.
+    {
+        auto build = [](Scene& s) {
+            seedBlock(s, 0, glm::vec3(-0.3f, -0.9f, 0.0f), 0.15f, 0.04f, 1000.0f, 5.0e4f, 0.0f);
+            seedBlock(s, 1, glm::vec3(0.0f, -0.8f, 0.0f), 0.12f, 0.04f, 1000.0f, 1.0e5f, 0.3f, true);
+            seedBlock(s, 2, glm::vec3(0.3f, -0.9f, 0.0f), 0.15f, 0.04f, 1600.0f, 6.0e5f, 0.3f, true);
+            seedBlock(s, 3, glm::vec3(0.0f, -1.1f, 0.3f), 0.1f, 0.04f, 400.0f, 1.4e5f, 0.2f, true);
+        };
+        if (!MpmCpuSolver().simd()) {
+            check("SSE2 == scalar stencils", true, "no SSE2 in this build (scalar only)%.0f", 0.0);
+        } else {
+            Scene a, b, c;
+            initScene(a); initScene(b); initScene(c);
+            build(a); build(b); build(c);
+            b.solver.setSimd(false);
+            c.prm.gravity *= 0.99f;
+            runFor(a, 0.05f); runFor(b, 0.05f); runFor(c, 0.05f);
+            const double dSimd = maxPosDiff(a.solver, b.solver), dNeg = maxPosDiff(a.solver, c.solver);
+            check("SSE2 == scalar stencils", dSimd < 1e-5, "maxDiff=%.2e bitsSame=%.0f", dSimd, double(sameBits(a.solver, b.solver)));
+            check("NEG-CTRL 0.99 g leaves the band", dNeg >= 1e-5, "maxDiff=%.2e", dNeg);
+
+            int n = 262144;
+            if (const char* e = std::getenv("KRS_MPM_CPU_BENCH")) n = std::max(1000, std::atoi(e));
+            const int side = std::max(1, int(std::round(std::cbrt(double(n)))));
+            const float spacing = 0.5f * (3.0f / 128.0f);
+            krs::par::ThreadPool one(1);
+            double rate[2] = {};
+            for (int k = 0; k < 2; ++k) {
+                Scene s; initScene(s, 128);
+                s.solver.setThreadPool(&one);
+                s.solver.setSimd(k == 1);
+                seedBlock(s, 0, glm::vec3(0.0f, -0.6f, 0.0f), 0.5f * side * spacing, spacing, 1000.0f, 5.0e4f, 0.0f);
+                s.prm.dt = 1.0e-4f;
+                s.solver.substep(s.prm);
+                const int steps = 3;
+                const auto t0 = Clock::now();
+                for (int i = 0; i < steps; ++i) s.solver.substep(s.prm);
+                rate[k] = s.solver.count() * steps / (msSince(t0) * 1e-3) * 1e-6;
+            }
+            std::fprintf(stderr, "[MPM-CPU]     1 thread: scalar %.2f -> SSE2 %.2f Mparticle-substeps/s (%.2fx)\n",
+                         rate[0], rate[1], rate[1] / std::max(rate[0], 1e-9));
+        }
+    }
+    // 8. Conduction across contact (MpmSystem Test 8): hot k=400 block against a cool k=100 block,
+    //    no ambient exchange. The spread shrinks and sum(m*c_p*T) holds. NEG-CTRL: the same run
+    //    with a 95 C ambient exchange must move the energy out of the band.
+    {
+        double meanErr[2] = {};
+        float spread[2][2] = {};
+        for (int k = 0; k < 2; ++k) {
+            Scene s; initScene(s);
+            seedBlock(s, 1, glm::vec3(-0.15f, -0.3f, 0.0f), 0.15f, 0.05f, 1000.0f, 5.0e4f, 0.0f, false, 80.0f, 1.0e9f, 400.0f);
+            seedBlock(s, 1, glm::vec3(0.15f, -0.3f, 0.0f), 0.15f, 0.05f, 1000.0f, 5.0e4f, 0.0f, true, 20.0f, 1.0e9f, 100.0f);
+            MpmCpuSolver::ThermalParams t;
+            t.coef = 18.0f * t.dtFrame * s.prm.dx;
+            if (k) { t.ambientT = 95.0f; t.heatExchange = 0.5f; }
+            const Heat h0 = heat(s.solver);
+            for (int f = 0; f < 300; ++f) s.solver.thermalStep(s.prm, t);
+            const Heat h1 = heat(s.solver);
+            meanErr[k] = std::abs(h1.mean - h0.mean);
+            spread[k][0] = h0.tMax - h0.tMin; spread[k][1] = h1.tMax - h1.tMin;
+        }
+        check("conduction: spread shrinks", spread[0][1] < 0.8f * spread[0][0], "spread %.2f -> %.2f", spread[0][0], spread[0][1]);
+        check("conduction conserves energy", meanErr[0] < 0.5, "meanErr=%.4f C", meanErr[0]);
+        check("NEG-CTRL ambient exchange drifts energy", meanErr[1] >= 0.5, "meanErr=%.2f C", meanErr[1]);
+    }
+    // 9. Phase change (MpmSystem Test 6): a 15 C elastic block melting at 30 C in a 95 C ambient
+    //    becomes fluid. NEG-CTRL: a 25 C ambient leaves it solid.
+    {
+        int melted[2] = {}, live = 0;
+        for (int k = 0; k < 2; ++k) {
+            Scene s; initScene(s);
+            seedBlock(s, 1, glm::vec3(0.0f, -0.4f, 0.0f), 0.22f, 0.05f, 1000.0f, 8.0e4f, 0.3f, false, 15.0f, 30.0f);
+            MpmCpuSolver::ThermalParams t;
+            t.coef = 0.0f; t.heatExchange = 5.0f; t.ambientT = k ? 25.0f : 95.0f;
+            s.waveSpeed = std::max(s.waveSpeed, std::sqrt(t.fluidK * 7.0f / 1000.0f));
+            for (int f = 0; f < 120; ++f) {
+                runFor(s, t.dtFrame);
+                s.solver.thermalStep(s.prm, t);
+            }
+            const Heat h = heat(s.solver);
+            melted[k] = h.fluid; live = h.live;
+        }
+        check("phase change: heated solid melts", melted[0] > live / 2, "melted %.0f of %.0f", melted[0], live);
+        check("NEG-CTRL below melt point stays solid", melted[1] == 0, "melted %.0f of %.0f", melted[1], live);
+    }
+    // 10. Fine domain: 2048^3 cells of 3 cm (61 m across) holding a 30 cm block. The old dense
+    //     (N/4+2)^3 block table alone would be over 500 MiB; the sparse grid must stay material-sized
+    //     and still carry free fall and the full particle mass. NEG-CTRL: the same particles
+    //     scattered over the domain need one block set each, so the grid grows with them.
+    {
+        const int N = 2048;
+        size_t bytes[2] = {};
+        int blocks[2] = {};
+        for (int k = 0; k < 2; ++k) {
+            Scene s; initScene(s, N);
+            s.prm.dx = 0.03f;
+            s.prm.origin = glm::vec3(-0.5f * N * s.prm.dx);
+            s.prm.floorY = s.prm.origin.y + 2.0f * s.prm.dx;
+            seedBlock(s, 0, glm::vec3(0.0f), 0.15f, 0.015f, 1000.0f, 5.0e4f, 0.0f);
+            if (k) {
+                std::mt19937 rng(2048);
+                std::uniform_real_distribution<float> u(-25.0f, 25.0f);
+                for (auto& p : s.solver.particles()) p.posMass = glm::vec4(u(rng), u(rng), u(rng), p.posMass.w);
+                s.prm.dt = 1.0e-4f;
+                s.solver.substep(s.prm);
+            } else {
+                const Diag d0 = sample(s.solver);
+                const float T = 0.12f;
+                runFor(s, T);
+                const Diag d1 = sample(s.solver);
+                const double vErr = std::abs(d1.vel.y + 9.81 * T) / (9.81 * T);
+                const double gridErr = std::abs(s.solver.gridMass() - d1.mass) / d1.mass;
+                check("2048^3: free-fall velocity = g*t", vErr < 0.05, "relErr=%.4f", vErr);
+                check("2048^3: grid mass == particle mass", gridErr < 1e-5, "relErr=%.2e drop=%.4f", gridErr, d0.com.y - d1.com.y);
+            }
+            bytes[k] = s.solver.stats().gridBytes;
+            blocks[k] = s.solver.stats().activeBlocks;
+        }
+        const double dense = std::pow(double(N / 4 + 2), 3.0) * sizeof(int);
+        check("2048^3: grid stays material-sized", bytes[0] < (size_t(16) << 20), "%.2f MiB (dense table %.0f MiB)",
+              bytes[0] / 1048576.0, dense / 1048576.0);
+        check("NEG-CTRL scattered particles grow the grid", blocks[1] > 8 * blocks[0], "blocks %.0f vs %.0f",
+              double(blocks[1]), double(blocks[0]));
+    }
+    std::fprintf(stderr, "[MPM-CPU] overall: %s\n", ok ? "ALL PASS" : "FAILURES PRESENT");
+    return ok;
+}
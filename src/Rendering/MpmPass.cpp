@@ -26,7 +26,7 @@ void MpmPass::execute(const RenderFrameContext& context)
     shader->setFloat(gl, "u_rangeMin", range.x);
     shader->setFloat(gl, "u_rangeMax", range.y);
 
-    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mpm->particleBuffer());
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mpm->particleBuffer(gl));
 
     gl->glEnable(GL_PROGRAM_POINT_SIZE);
     gl->glEnable(GL_DEPTH_TEST);
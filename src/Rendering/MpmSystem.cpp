@@ -1,4 +1,5 @@
 #include "MpmSystem.hpp"
+#include "MpmCpuSolver.hpp"
 #include "RenderingSystem.hpp"
 #include "SmokeSystem.hpp"
 #include "Shader.hpp"
@@ -10,6 +11,8 @@
 #include <QString>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
 #include <random>
 #include <string>
 
@@ -23,16 +26,23 @@
 namespace {
 constexpr int kStride = MpmSystem::kFloatsPerParticle; // 48 floats (12 vec4)
 constexpr int kLocal = 64;
+static_assert(MpmSystem::kMaxGridCpu == MpmCpuSolver::kMaxGrid, "CPU grid cap must match the solver's block keys");
 }
 
+MpmSystem::MpmSystem() : m_cpu(std::make_unique<MpmCpuSolver>()) {}
+MpmSystem::~MpmSystem() = default;
+
 void MpmSystem::initialize(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl)
 {
     Q_UNUSED(renderer);
     if (m_initialized) return;
+    // No GL context (headless) -> CPU backend, which never touches GL until something renders.
+    if (!gl || qEnvironmentVariable("KRS_MPM_BACKEND").toLower() == QLatin1String("cpu")) m_backend = Backend::Cpu;
     m_N = krs::hardwareCaps().cudaPhysics ? 96 : 64;
     bool ok = false;
     const int envN = qEnvironmentVariable("KRS_MPM_GRID").toInt(&ok);
-    if (ok && envN >= 32 && envN <= 160) m_N = (envN / 4) * 4;
+    const int maxN = (m_backend == Backend::Cpu) ? kMaxGridCpu : kMaxGridGpu; // sparse CPU grid vs dense SSBOs
+    if (ok && envN >= 32 && envN <= maxN) m_N = (envN / 4) * 4;
     // Thermodynamic field overrides (M4). Ambient temperature + Newton
     // exchange rate let a hot environment melt solids; default = inert ambient.
     if (qEnvironmentVariableIsSet("KRS_MPM_AMBIENT"))
@@ -44,18 +54,38 @@ void MpmSystem::initialize(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core*
     // Initial visualization mode (1 Thermal, 2 VonMises, 3 Strain) for headless grabs.
     const int viz = qEnvironmentVariable("KRS_MPM_VIZ").toInt();
     if (viz >= 1 && viz <= 3) { m_appearance.mode = VizMode(viz); m_calibratePending = true; }
-    allocate(gl);
+    if (m_backend == Backend::Gpu) allocate(gl);
     m_initialized = true;
-    qInfo() << "[MPM] initialized grid" << m_N << "^3, capacity" << kMaxParticles;
+    qInfo() << "[MPM] initialized grid" << m_N << "^3, capacity" << maxParticles()
+            << "backend" << (m_backend == Backend::Cpu ? "CPU" : "GPU");
 }
 
 void MpmSystem::allocate(QOpenGLFunctions_4_3_Core* gl)
 {
-    gl->glGenBuffers(1, &m_particleSSBO);
+    ensureParticleBuffer(gl, kMaxParticles);
+    ensureGpuGrid(gl);
+}
+
+// Particle SSBO holding at least `count` particles (contents are discarded on growth;
+// callers upload the full set afterwards).
+void MpmSystem::ensureParticleBuffer(QOpenGLFunctions_4_3_Core* gl, int count)
+{
+    if (m_particleSSBO != 0 && count <= m_particleCapacity) return;
+    if (m_particleSSBO == 0) gl->glGenBuffers(1, &m_particleSSBO);
+    m_particleCapacity = std::max(count, m_backend == Backend::Gpu ? kMaxParticles : 0);
     gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
     gl->glBufferData(GL_SHADER_STORAGE_BUFFER,
-                     GLsizeiptr(sizeof(float)) * kStride * kMaxParticles, nullptr, GL_DYNAMIC_DRAW);
+                     GLsizeiptr(sizeof(float)) * kStride * m_particleCapacity, nullptr, GL_DYNAMIC_DRAW);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
+// Dense m_N^3 grid + thermal SSBOs of the compute-shader backend (kept while they
+// are large enough, so the self-tests' smaller grids reuse them).
+void MpmSystem::ensureGpuGrid(QOpenGLFunctions_4_3_Core* gl)
+{
+    if (m_gridIntSSBO != 0 && m_gpuGridN >= m_N) return;
+    releaseGpuGrid(gl);
+    m_gpuGridN = m_N;
     const int cells = m_N * m_N * m_N;
     gl->glGenBuffers(1, &m_gridIntSSBO);
     gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridIntSSBO);
@@ -99,7 +129,18 @@ void MpmSystem::allocate(QOpenGLFunctions_4_3_Core* gl)
 void MpmSystem::shutdown(QOpenGLFunctions_4_3_Core* gl)
 {
     if (!m_initialized) return;
-    gl->glDeleteBuffers(1, &m_particleSSBO);
+    if (gl) {
+        if (m_particleSSBO != 0) gl->glDeleteBuffers(1, &m_particleSSBO);
+        m_particleSSBO = 0;
+        m_particleCapacity = 0;
+        releaseGpuGrid(gl);
+    }
+    m_initialized = false;
+}
+
+void MpmSystem::releaseGpuGrid(QOpenGLFunctions_4_3_Core* gl)
+{
+    if (m_gridIntSSBO == 0) return;
     gl->glDeleteBuffers(1, &m_gridIntSSBO);
     gl->glDeleteBuffers(1, &m_gridVelSSBO);
     gl->glDeleteBuffers(1, &m_gridThermSSBO);
@@ -108,7 +149,94 @@ void MpmSystem::shutdown(QOpenGLFunctions_4_3_Core* gl)
     gl->glDeleteBuffers(1, &m_gridC);
     gl->glDeleteBuffers(1, &m_gridK);
     gl->glDeleteBuffers(1, &m_heatAccumSSBO);
-    m_initialized = false;
+    m_gridIntSSBO = m_gridVelSSBO = m_gridThermSSBO = m_gridTempA = m_gridTempB = m_gridC = m_gridK = m_heatAccumSSBO = 0;
+    m_gpuGridN = 0;
+}
+
+void MpmSystem::setBackend(QOpenGLFunctions_4_3_Core* gl, Backend b)
+{
+    if (b == m_backend) return;
+    if (b == Backend::Gpu && !gl) { qWarning() << "[MPM] GPU backend needs a GL context; staying on CPU"; return; }
+    // Carry the live state across: GPU -> CPU reads the SSBO once; CPU -> GPU pushes
+    // the CPU particles (reseeding if they exceed the shader path's capacity).
+    if (m_initialized && m_particleCount > 0) {
+        if (b == Backend::Cpu) {
+            std::vector<float> buf;
+            readParticles(gl, buf);
+            m_cpu->setParticles(buf.data(), m_particleCount);
+            m_gpuStale = true;
+        } else {
+            pushCpuParticles(gl);
+            if (m_particleCount > kMaxParticles) m_seeded = false;
+        }
+    }
+    m_backend = b;
+    if (m_initialized) {
+        if (b == Backend::Gpu) {
+            // The dense shader grid caps N; keep the world floor (origin.y + 2dx) where it was.
+            if (m_N > kMaxGridGpu) {
+                const float floorY = m_origin.y + 2.0f * m_size.x / float(m_N);
+                m_N = kMaxGridGpu;
+                m_origin.y = floorY - 2.0f * m_size.x / float(m_N);
+            }
+            allocate(gl);
+        } else if (gl) {
+            releaseGpuGrid(gl);                          // the particle SSBO stays for rendering
+        }
+    }
+    qInfo() << "[MPM] backend" << (b == Backend::Cpu ? "CPU" : "GPU") << "grid" << m_N;
+}
+
+// Seeded particles (m_seedScratch, m_particleCount of them) -> the particle SSBO on
+// the GPU backend, the CPU solver on the CPU backend (uploaded when drawn).
+void MpmSystem::uploadParticles(QOpenGLFunctions_4_3_Core* gl)
+{
+    if (m_particleCount <= 0) return;
+    if (m_backend == Backend::Cpu) {
+        m_cpu->setParticles(m_seedScratch.data(), m_particleCount);
+        m_gpuStale = true;
+        return;
+    }
+    ensureParticleBuffer(gl, m_particleCount);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
+    gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+                        GLsizeiptr(sizeof(float)) * kStride * m_particleCount, m_seedScratch.data());
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_gpuStale = false;
+}
+
+// Current particle state of the active backend (CPU: no GL readback).
+void MpmSystem::readParticles(QOpenGLFunctions_4_3_Core* gl, std::vector<float>& buf)
+{
+    buf.resize(size_t(m_particleCount) * kStride);
+    if (buf.empty()) return;
+    if (m_backend == Backend::Cpu) {
+        std::memcpy(buf.data(), m_cpu->data(), sizeof(float) * buf.size());
+        return;
+    }
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
+    gl->glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(float)) * buf.size(), buf.data());
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// CPU backend: copy the stepped particles into the SSBO, creating or growing it.
+// Only particleBuffer() (a renderer drawing this frame) and the switch to the GPU
+// backend call this, so a headless CPU run never uploads.
+void MpmSystem::pushCpuParticles(QOpenGLFunctions_4_3_Core* gl)
+{
+    if (!gl || m_backend != Backend::Cpu || !m_gpuStale || m_particleCount <= 0) return;
+    ensureParticleBuffer(gl, m_particleCount);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
+    gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+                        GLsizeiptr(sizeof(float)) * kStride * m_particleCount, m_cpu->data());
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_gpuStale = false;
+}
+
+GLuint MpmSystem::particleBuffer(QOpenGLFunctions_4_3_Core* gl)
+{
+    pushCpuParticles(gl);
+    return m_particleSSBO;
 }
 
 void MpmSystem::computeDomain(entt::registry& registry)
@@ -142,7 +270,7 @@ void MpmSystem::seedBodies(QOpenGLFunctions_4_3_Core* gl, entt::registry& regist
     int count = 0;
 
     auto pushParticle = [&](const glm::vec3& p, const MpmBodyComponent& b) {
-        if (count >= kMaxParticles) return;
+        if (count >= maxParticles()) return;
         const float vol = b.particleSpacing * b.particleSpacing * b.particleSpacing;
         const float mass = b.density * vol;
         const float mu = b.youngsModulus / (2.0f * (1.0f + b.poissonRatio));
@@ -230,12 +358,7 @@ void MpmSystem::seedBodies(QOpenGLFunctions_4_3_Core* gl, entt::registry& regist
     }
 
     m_particleCount = count;
-    if (count > 0) {
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-        gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                            GLsizeiptr(sizeof(float)) * m_seedScratch.size(), m_seedScratch.data());
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    }
+    uploadParticles(gl);
     qInfo() << "[MPM] seeded" << count << "particles; domain origin" << m_origin.x << m_origin.y
             << m_origin.z << "size" << m_size.x << "waveSpeed" << m_maxWaveSpeed;
 }
@@ -265,10 +388,18 @@ void MpmSystem::update(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl,
     }
     ++m_vizFrame;
 
-    Shader* p2g = renderer.getShader("mpm_p2g");
-    Shader* grid = renderer.getShader("mpm_grid");
-    Shader* g2p = renderer.getShader("mpm_g2p");
-    if (!p2g || !grid || !g2p) return;
+    Shader* p2g = nullptr;
+    Shader* grid = nullptr;
+    Shader* g2p = nullptr;
+    if (m_backend == Backend::Gpu) {
+        p2g = renderer.getShader("mpm_p2g");
+        grid = renderer.getShader("mpm_grid");
+        g2p = renderer.getShader("mpm_g2p");
+        if (!p2g || !grid || !g2p) {
+            qWarning() << "[MPM] compute shaders unavailable -> CPU backend";
+            setBackend(gl, Backend::Cpu);
+        }
+    }
 
     const float dx = m_size.x / float(m_N);
     const float invDx = float(m_N) / m_size.x;
@@ -283,10 +414,7 @@ void MpmSystem::update(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl,
 
     for (int s = 0; s < substeps; ++s)
         runSubstep(gl, p2g, grid, g2p, sdt, m_gravity, dx, invDx);
-
-    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
-    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
-    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    endSubsteps(gl);
 
     // Heat diffusion + phase change, once per rendered frame (heat evolves far
     // slower than momentum, so a single thermal step per frame is plenty).
@@ -294,6 +422,14 @@ void MpmSystem::update(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl,
     runThermalStep(renderer, gl, frameDt);
 }
 
+void MpmSystem::endSubsteps(QOpenGLFunctions_4_3_Core* gl)
+{
+    if (m_backend != Backend::Gpu) return;
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+}
+
 void MpmSystem::collectHeatSources(entt::registry& registry)
 {
     m_heatCount = 0;
@@ -321,14 +457,32 @@ void MpmSystem::runThermalStep(RenderingSystem& renderer, QOpenGLFunctions_4_3_C
                                float dtFrame)
 {
     if (m_particleCount <= 0) return;
+    const float dx = m_size.x / float(m_N);
+    const float invDx = float(m_N) / m_size.x;
+    if (m_backend == Backend::Cpu) {                     // same four stages on the CPU (no flame-grid coupling)
+        MpmCpuSolver::Params prm;
+        prm.N = m_N; prm.origin = m_origin; prm.dx = dx;
+        MpmCpuSolver::ThermalParams t;
+        t.dtFrame = dtFrame;
+        t.ambientT = m_ambientT;
+        t.heatExchange = m_heatExchange;
+        t.coef = m_conductionScale * dtFrame * dx;
+        t.betaMax = 0.5f;
+        t.fluidK = m_fluidMeltK;
+        t.heatCount = std::min(m_heatCount, MpmCpuSolver::ThermalParams::kMaxSources);
+        for (int h = 0; h < t.heatCount; ++h) {
+            t.heatSrc[h] = m_heatSrc[h]; t.heatRadius[h] = m_heatRadius[h]; t.heatPower[h] = m_heatPower[h];
+        }
+        m_cpu->thermalStep(prm, t);
+        m_gpuStale = true;
+        return;
+    }
     Shader* scat = renderer.getShader("mpm_heat_scatter");
     Shader* norm = renderer.getShader("mpm_heat_normalize");
     Shader* diff = renderer.getShader("mpm_heat_diffuse");
     Shader* gath = renderer.getShader("mpm_heat_gather");
     if (!scat || !norm || !diff || !gath) return;
 
-    const float dx = m_size.x / float(m_N);
-    const float invDx = float(m_N) / m_size.x;
     const int cells = m_N * m_N * m_N;
     const int pGroups = (m_particleCount + kLocal - 1) / kLocal;
     const int cGroups = (cells + kLocal - 1) / kLocal;
@@ -427,6 +581,18 @@ void MpmSystem::runSubstep(QOpenGLFunctions_4_3_Core* gl, Shader* p2g, Shader* g
                            Shader* g2p, float sdt, const glm::vec3& gravity,
                            float dx, float invDx)
 {
+    if (m_backend == Backend::Cpu) {
+        MpmCpuSolver::Params prm;                        // the shader uniforms below
+        prm.N = m_N; prm.origin = m_origin; prm.dx = dx; prm.dt = sdt; prm.gravity = gravity;
+        prm.bound = 2;
+        prm.floorFriction = m_floorFriction; prm.floorStick = m_floorStick;
+        prm.thetaC = 0.025f; prm.thetaS = 0.0075f;
+        prm.floorY = m_origin.y + 2.0f * dx; prm.radius = m_renderRadius;
+        prm.picBlend = m_picBlend; prm.velDampRate = m_sandVelDampRate;
+        m_cpu->substep(prm);
+        m_gpuStale = true;
+        return;
+    }
     const int cells = m_N * m_N * m_N;
     const int pGroups = (m_particleCount + kLocal - 1) / kLocal;
     const int cGroups = (cells + kLocal - 1) / kLocal;
@@ -488,7 +654,7 @@ bool MpmSystem::runSelfTests(RenderingSystem& renderer, QOpenGLFunctions_4_3_Cor
     Shader* p2g = renderer.getShader("mpm_p2g");
     Shader* grid = renderer.getShader("mpm_grid");
     Shader* g2p = renderer.getShader("mpm_g2p");
-    if (!p2g || !grid || !g2p) { qWarning() << "[MPM selftest] shaders missing"; return false; }
+    if (m_backend == Backend::Gpu && (!p2g || !grid || !g2p)) { qWarning() << "[MPM selftest] shaders missing"; return false; }
 
     const int savedN = m_N;
     m_N = std::min(m_N, 64);
@@ -528,10 +694,7 @@ bool MpmSystem::runSelfTests(RenderingSystem& renderer, QOpenGLFunctions_4_3_Cor
                     ++count;
                 }
         m_particleCount += count;
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-        gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                            GLsizeiptr(sizeof(float)) * m_seedScratch.size(), m_seedScratch.data());
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        uploadParticles(gl);
         const float stiff = (material == 0) ? E * 7.0f : E; // fluid: K*gamma
         m_maxWaveSpeed = std::max(append ? m_maxWaveSpeed : 1.0f, std::sqrt(stiff / density));
     };
@@ -543,9 +706,7 @@ bool MpmSystem::runSelfTests(RenderingSystem& renderer, QOpenGLFunctions_4_3_Cor
         int sub = std::clamp(int(std::ceil(seconds / std::max(cflDt, 1.0e-5f))), 1, 6000);
         const float sdt = seconds / float(sub);
         for (int s = 0; s < sub; ++s) runSubstep(gl, p2g, grid, g2p, sdt, gravity, dx, invDx);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+        endSubsteps(gl);
     };
 
     bool allPass = true;
@@ -718,6 +879,9 @@ bool MpmSystem::runSelfTests(RenderingSystem& renderer, QOpenGLFunctions_4_3_Cor
               fmt("minY", d.minY) + " floor+r " + std::to_string(floorPlusR));
         m_renderRadius = savedR;
     }
+    // Test 10 — backend parity (runBackendParity): mechanics, conduction and melting on the
+    // compute shaders vs MpmCpuSolver, with neg-ctrls. Needs the GL context and shaders.
+    check("CPU backend == GPU (mechanics + heat + melt)", runBackendParity(renderer, gl), "see [mpm-parity]");
 
     qInfo() << "[MPM selftest] overall:" << (allPass ? "ALL PASS" : "FAILURES PRESENT");
     // Restore empty state so the live scene seeds fresh from the registry.
@@ -741,7 +905,9 @@ bool MpmSystem::runReposeFidelity(RenderingSystem& renderer, QOpenGLFunctions_4_
     Shader* p2g = renderer.getShader("mpm_p2g");
     Shader* grid = renderer.getShader("mpm_grid");
     Shader* g2p = renderer.getShader("mpm_g2p");
-    if (!p2g || !grid || !g2p) { printf("[fidelity] GRANULAR-REPOSE  FAIL (shaders missing)\n"); return false; }
+    if (m_backend == Backend::Gpu && (!p2g || !grid || !g2p)) {
+        printf("[fidelity] GRANULAR-REPOSE  FAIL (shaders missing)\n"); return false;
+    }
 
     m_N = std::min(m_N, 64);
     m_origin = glm::vec3(-0.6f);                     // SMALL domain -> fine dx (=1.2/64=0.019 m): a 0.24 m column
@@ -787,9 +953,7 @@ bool MpmSystem::runReposeFidelity(RenderingSystem& renderer, QOpenGLFunctions_4_
             ++count;
         }
         m_particleCount = count;
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-        gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(float)) * m_seedScratch.size(), m_seedScratch.data());
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        uploadParticles(gl);
         m_maxWaveSpeed = std::max(1.0f, std::sqrt((lambda + 2.0f * mu) / density));  // dilatational wave (proper CFL)
         return count;
     };
@@ -800,18 +964,14 @@ bool MpmSystem::runReposeFidelity(RenderingSystem& renderer, QOpenGLFunctions_4_
         int sub = std::clamp(int(std::ceil(seconds / std::max(cflDt, 1.0e-5f))), 1, 120000);
         const float sdt = seconds / float(sub);
         for (int s = 0; s < sub; ++s) runSubstep(gl, p2g, grid, g2p, sdt, glm::vec3(0, -9.81f, 0), dx, invDx);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
-        gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+        endSubsteps(gl);
     };
 
     struct Repose { int n = 0; float H0 = 0, spreadR = 0, toeR = 0, angleFlank = 0, angleApex = 0; };
     auto measure = [&](bool verbose) -> Repose {
         Repose R{};
-        std::vector<float> buf(size_t(m_particleCount) * kStride);
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-        gl->glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(float)) * buf.size(), buf.data());
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        std::vector<float> buf;
+        readParticles(gl, buf);
         std::vector<glm::vec3> pos; float yf = 1e30f, yhi = -1e30f, maxSpeed = 0.0f;
         float alpha0 = (m_particleCount > 0) ? buf[38] : -1.0f;     // alpha of particle 0 (confirm it propagated)
         std::vector<float> speeds;
@@ -914,7 +1074,8 @@ bool MpmSystem::runThermalGate1_4(RenderingSystem& renderer, QOpenGLFunctions_4_
     using std::printf;
     setvbuf(stdout, nullptr, _IONBF, 0);
     printf("[mpm-thermal] GATE 1.4 -- MPM thermal ENERGY conservation (Fourier conduction) + 2 neg-ctrls\n");
-    if (!renderer.getShader("mpm_heat_diffuse") || !renderer.getShader("mpm_heat_gather")) {
+    if (m_backend == Backend::Gpu
+        && (!renderer.getShader("mpm_heat_diffuse") || !renderer.getShader("mpm_heat_gather"))) {
         printf("[mpm-thermal] vacuous pass (heat shaders unavailable)\n");
         std::fflush(stdout); return true;
     }
@@ -945,10 +1106,7 @@ bool MpmSystem::runThermalGate1_4(RenderingSystem& renderer, QOpenGLFunctions_4_
             m_seedScratch.insert(m_seedScratch.end(), v, v + kStride); ++count;
         }
         m_particleCount += count;
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-        gl->glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                            GLsizeiptr(sizeof(float)) * m_seedScratch.size(), m_seedScratch.data());
-        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        uploadParticles(gl);
     };
     auto runHeat = [&](int frames) { for (int f = 0; f < frames; ++f) runThermalStep(renderer, gl, 1.0f / 60.0f); };
 
@@ -992,6 +1150,160 @@ bool MpmSystem::runThermalGate1_4(RenderingSystem& renderer, QOpenGLFunctions_4_
     return pass;
 }
 
+// ===================================================================================================
+// BACKEND PARITY -- the compute shaders and MpmCpuSolver step the same scenes and must land together:
+// fluid / elastic / sand drops (COM position + velocity), closed conduction between a k=400 and a k=100
+// block (energy mean + remaining spread), and a solid melting in a hot ambient (fluid fraction). The
+// only modelled difference is the GPU's fixed-point atomic scatter. NEG-CTRL A: a CPU throw at half the
+// speed must leave the COM band. NEG-CTRL B: a CPU run that skips the thermal step must leave the
+// spread band. Gated by KRS_MPM_PARITY_SELFTEST, the overnight bench and runSelfTests Test 10.
+// ===================================================================================================
+bool MpmSystem::runBackendParity(RenderingSystem& renderer, QOpenGLFunctions_4_3_Core* gl)
+{
+    using std::printf;
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    printf("[mpm-parity] CPU vs GPU MLS-MPM backend parity (mechanics + conduction + melt) + 2 neg-ctrls\n");
+    Shader* p2g = renderer.getShader("mpm_p2g");
+    Shader* grid = renderer.getShader("mpm_grid");
+    Shader* g2p = renderer.getShader("mpm_g2p");
+    if (!gl || !p2g || !grid || !g2p || !renderer.getShader("mpm_heat_scatter") || !renderer.getShader("mpm_heat_normalize")
+        || !renderer.getShader("mpm_heat_diffuse") || !renderer.getShader("mpm_heat_gather")) {
+        printf("[mpm-parity] FAIL (needs the GL context and the MPM + heat compute shaders)\n");
+        std::fflush(stdout); return false;
+    }
+
+    const Backend savedB = m_backend;
+    const int savedN = m_N, savedCount = m_particleCount;
+    const glm::vec3 savedOrigin = m_origin, savedSize = m_size;
+    const float savedAmb = m_ambientT, savedHx = m_heatExchange, savedS = m_conductionScale;
+    const float savedWave = m_maxWaveSpeed;
+    const int savedHeat = m_heatCount;
+    m_N = std::min(m_N, 64); m_origin = glm::vec3(-1.5f); m_size = glm::vec3(3.0f);
+    m_heatCount = 0;
+    ensureGpuGrid(gl);                                   // released while the CPU backend was active
+
+    auto seedBlock = [&](int material, glm::vec3 center, float half, float density, float E, float nu,
+                         glm::vec3 v0, float T0, float meltT, float k, bool append) {
+        if (!append) { m_seedScratch.clear(); m_particleCount = 0; }
+        const float spacing = 0.05f, vol = spacing * spacing * spacing, mass = density * vol;
+        const float mu = E / (2.0f * (1.0f + nu));
+        const float lambda = E * nu / ((1.0f + nu) * (1.0f - 2.0f * nu));
+        const float sphi = std::sin(glm::radians(35.0f));
+        const float alpha = std::sqrt(2.0f / 3.0f) * (2.0f * sphi) / (3.0f - sphi);
+        const int n = std::max(1, int(std::round(2.0f * half / spacing)));
+        for (int ix = 0; ix < n; ++ix) for (int iy = 0; iy < n; ++iy) for (int iz = 0; iz < n; ++iz) {
+            const glm::vec3 pp = center - glm::vec3(half) + (glm::vec3(ix, iy, iz) + 0.5f) * spacing;
+            float v[kStride] = { 0 };
+            v[0] = pp.x; v[1] = pp.y; v[2] = pp.z; v[3] = mass;
+            v[4] = v0.x; v[5] = v0.y; v[6] = v0.z; v[7] = vol;
+            v[20] = 1.0f; v[25] = 1.0f; v[30] = 1.0f; v[32] = 1.0f;
+            v[33] = T0; v[34] = 900.0f; v[35] = meltT;
+            if (material == 0) { v[36] = E; v[37] = 7.0f; v[38] = 0.0f; }
+            else { v[36] = mu; v[37] = lambda; v[38] = alpha; }
+            v[39] = float(material);
+            v[40] = 0.6f; v[41] = 0.7f; v[42] = 0.9f; v[43] = 1.0f; v[44] = k;
+            m_seedScratch.insert(m_seedScratch.end(), v, v + kStride);
+            ++m_particleCount;
+        }
+        uploadParticles(gl);
+        const float stiff = (material == 0) ? E * 7.0f : E;
+        m_maxWaveSpeed = std::max(append ? m_maxWaveSpeed : 1.0f, std::sqrt(stiff / density));
+    };
+    auto runFor = [&](float seconds) {
+        const float dx = m_size.x / float(m_N), invDx = float(m_N) / m_size.x;
+        const float cflDt = 0.35f * dx / std::max(m_maxWaveSpeed, 1.0f);
+        const int sub = std::clamp(int(std::ceil(seconds / std::max(cflDt, 1.0e-5f))), 1, 6000);
+        for (int k = 0; k < sub; ++k) runSubstep(gl, p2g, grid, g2p, seconds / float(sub), glm::vec3(0, -9.81f, 0), dx, invDx);
+        endSubsteps(gl);
+    };
+    // One scene per backend; scene(k) seeds and steps with m_backend already set.
+    auto both = [&](const std::function<void(int)>& scene, Diag (&d)[2]) {
+        for (int k = 0; k < 2; ++k) {
+            m_backend = k ? Backend::Cpu : Backend::Gpu;
+            scene(k);
+            d[k] = sample(gl);
+        }
+    };
+
+    bool pass = true;
+    auto report = [&](const char* name, bool ok, const std::string& detail) {
+        printf("[mpm-parity]   %-44s %s  (%s)\n", name, ok ? "PASS" : "FAIL", detail.c_str());
+        pass = pass && ok;
+    };
+    char buf[192];
+
+    // Mechanics: a thrown block of each material drops onto the floor and slides.
+    const char* names[3] = { "fluid COM", "elastic COM", "sand COM" };
+    for (int material : { 0, 1, 2 }) {
+        const float density = material == 2 ? 1600.0f : 1000.0f;
+        const float E = material == 2 ? 6.0e5f : (material == 1 ? 1.0e5f : 5.0e4f);
+        const float nu = material == 0 ? 0.0f : 0.3f;
+        Diag d[2];
+        both([&](int) {
+            seedBlock(material, glm::vec3(0, -0.9f, 0), 0.2f, density, E, nu, glm::vec3(0.5f, 0, 0), 20.0f, 1.0e9f, 50.0f, false);
+            runFor(0.6f);
+        }, d);
+        const double dPos = glm::length(d[0].comPosition - d[1].comPosition);
+        const double dVel = glm::length(d[0].comVelocity - d[1].comVelocity);
+        std::snprintf(buf, sizeof(buf), "dPos=%.4f (<0.01) dVel=%.4f (<0.1)", dPos, dVel);
+        report(names[material], dPos < 1.0e-2 && dVel < 0.1, buf);
+        if (material == 1) {                             // NEG-CTRL A: half the throw speed on the CPU
+            m_backend = Backend::Cpu;
+            seedBlock(1, glm::vec3(0, -0.9f, 0), 0.2f, density, E, nu, glm::vec3(0.25f, 0, 0), 20.0f, 1.0e9f, 50.0f, false);
+            runFor(0.6f);
+            const double dNeg = glm::length(d[0].comPosition - sample(gl).comPosition);
+            std::snprintf(buf, sizeof(buf), "dPos=%.4f (must be >= 0.01)", dNeg);
+            report("NEG-CTRL A half-speed throw leaves the band", dNeg >= 1.0e-2, buf);
+        }
+    }
+
+    // Conduction: closed two-block contact, no ambient sink, 120 thermal frames.
+    {
+        m_ambientT = 20.0f; m_heatExchange = 0.0f; m_conductionScale = 18.0f;
+        auto seedPair = [&]() {
+            seedBlock(1, glm::vec3(-0.15f, -0.3f, 0), 0.15f, 1000.0f, 5.0e4f, 0.0f, glm::vec3(0), 80.0f, 1.0e9f, 400.0f, false);
+            seedBlock(1, glm::vec3( 0.15f, -0.3f, 0), 0.15f, 1000.0f, 5.0e4f, 0.0f, glm::vec3(0), 20.0f, 1.0e9f, 100.0f, true);
+        };
+        Diag d[2];
+        both([&](int) { seedPair(); for (int f = 0; f < 120; ++f) runThermalStep(renderer, gl, 1.0f / 60.0f); }, d);
+        const double dMean = std::abs(d[0].tempMean - d[1].tempMean);
+        const double dSpread = std::abs(double(d[0].tempMax - d[0].tempMin) - double(d[1].tempMax - d[1].tempMin));
+        std::snprintf(buf, sizeof(buf), "dMean=%.4f C (<0.1) dSpread=%.3f C (<1) spread %.2f", dMean, dSpread,
+                      double(d[0].tempMax - d[0].tempMin));
+        report("conduction (energy mean + spread)", dMean < 0.1 && dSpread < 1.0, buf);
+        m_backend = Backend::Cpu;                        // NEG-CTRL B: CPU without the thermal step
+        seedPair();
+        const Diag dn = sample(gl);
+        const double dNeg = std::abs(double(d[0].tempMax - d[0].tempMin) - double(dn.tempMax - dn.tempMin));
+        std::snprintf(buf, sizeof(buf), "dSpread=%.2f C (must be >= 1)", dNeg);
+        report("NEG-CTRL B skipped thermal step leaves the band", dNeg >= 1.0, buf);
+    }
+
+    // Melt: 15 C elastic block (melts at 30 C) in a 95 C ambient, mechanics + heat per frame.
+    {
+        m_ambientT = 95.0f; m_heatExchange = 5.0f; m_conductionScale = savedS;
+        Diag d[2];
+        both([&](int) {
+            seedBlock(1, glm::vec3(0, -0.4f, 0), 0.22f, 1000.0f, 8.0e4f, 0.3f, glm::vec3(0), 15.0f, 30.0f, 50.0f, false);
+            m_maxWaveSpeed = std::max(m_maxWaveSpeed, std::sqrt(m_fluidMeltK * 7.0f / 1000.0f));
+            for (int f = 0; f < 60; ++f) { runFor(1.0f / 60.0f); runThermalStep(renderer, gl, 1.0f / 60.0f); }
+        }, d);
+        const double f0 = double(d[0].fluidCount) / std::max(d[0].live, 1), f1 = double(d[1].fluidCount) / std::max(d[1].live, 1);
+        std::snprintf(buf, sizeof(buf), "melted GPU %.3f CPU %.3f (|d|<0.05)", f0, f1);
+        report("melt fraction", std::abs(f0 - f1) < 0.05 && f0 > 0.5, buf);
+    }
+
+    m_backend = savedB;
+    if (m_backend == Backend::Cpu) releaseGpuGrid(gl);
+    m_N = savedN; m_origin = savedOrigin; m_size = savedSize; m_particleCount = savedCount;
+    m_ambientT = savedAmb; m_heatExchange = savedHx; m_conductionScale = savedS; m_maxWaveSpeed = savedWave;
+    m_heatCount = savedHeat;
+    m_seedScratch.clear(); m_seeded = false;
+    printf("[mpm-parity] %s\n", pass ? "ALL PASS (backends agree; both neg-ctrls caught)" : "FAILURES PRESENT");
+    std::fflush(stdout);
+    return pass;
+}
+
 glm::vec2 MpmSystem::vizRange() const
 {
     switch (m_appearance.mode) {
@@ -1008,11 +1320,8 @@ void MpmSystem::autoCalibrate(QOpenGLFunctions_4_3_Core* gl, bool smooth)
 {
     if (m_appearance.freezeRange) return;            // F2: pinned range (gates / deterministic)
     if (m_particleCount <= 0 || m_appearance.mode == VizMode::Default) return;
-    std::vector<float> buf(size_t(m_particleCount) * kStride);
-    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-    gl->glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                           GLsizeiptr(sizeof(float)) * buf.size(), buf.data());
-    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    std::vector<float> buf;
+    readParticles(gl, buf);
     float lo = 1e30f, hi = -1e30f;
     for (int i = 0; i < m_particleCount; ++i) {
         const float* p = &buf[size_t(i) * kStride];
@@ -1055,11 +1364,8 @@ MpmSystem::Diag MpmSystem::sample(QOpenGLFunctions_4_3_Core* gl)
 {
     Diag d;
     if (m_particleCount <= 0) return d;
-    std::vector<float> buf(size_t(m_particleCount) * kStride);
-    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_particleSSBO);
-    gl->glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                           GLsizeiptr(sizeof(float)) * buf.size(), buf.data());
-    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    std::vector<float> buf;
+    readParticles(gl, buf);
     double tempAccum = 0.0;
     d.tempMin = 1.0e30f;
     d.tempMax = -1.0e30f;
@@ -2,7 +2,7 @@
 //   ORB-VELOCITY  -- the VOLUME containment velocity query (krs::orb::averageVelocityInSphere)
 //                    on a controlled synthetic set (exact ground truth + global-average neg-ctrl)
 //                    AND on the REAL live fluid (off-stream -> 0 proves it is a volume query, not a
-//                    global average).
+//                    global average); the ProbeIndex spatial hash must reproduce the scan bit for bit.
 //   ORB-LIFECYCLE -- the orb<->node binding on an entt::registry: spawn N -> N orbs with N distinct
 //                    colours matching their nodes, delete-node removes the orb, delete-orb exposes the
 //                    node to remove (bidirectional), and a non-propagating removal leaves an orphan
@@ -113,19 +113,28 @@ bool RenderingSystem::runOrbVelocityGate()
         const krs::orb::OrbVelocity off = krs::orb::averageVelocityInSphere(pos, vel, c + glm::vec3(3.0f, 0.0f, 0.0f), orbR);
         const bool onOk = onStream.count > 0;
         const bool offOk = off.count == 0 && glm::length(off.avg) < 1e-9;
-
-        const bool ok = onOk && offOk && consistent;
+        // the many-orb runtime path (ProbeIndex) on the same real particles: bit-identical to the scan.
+        krs::orb::ProbeIndex index;
+        index.build(pos, vel, orbR);
+        const krs::orb::OrbVelocity idxOn = index.averageVelocityInSphere(c, orbR);
+        const krs::orb::OrbVelocity idxOff = index.averageVelocityInSphere(c + glm::vec3(3.0f, 0.0f, 0.0f), orbR);
+        const bool indexOk = idxOn.count == onStream.count && idxOn.avg == onStream.avg && idxOff.count == 0;
+
+        const bool ok = onOk && offOk && consistent && indexOk;
         printf("[orbvel]   REAL FLUID: %d live particles; orb@centroid contains %d, avg=(%.3f,%.3f,%.3f) (count>0:%d, consistent:%d); "
-               "orb off-stream contains %d (->0:%d)  %s\n",
+               "orb off-stream contains %d (->0:%d); spatial hash == scan:%d  %s\n",
                live, onStream.count, onStream.avg.x, onStream.avg.y, onStream.avg.z, int(onOk), int(consistent),
-               off.count, int(offOk), ok ? "PASS" : "FAIL");
+               off.count, int(offOk), int(indexOk), ok ? "PASS" : "FAIL");
         allOk = allOk && ok;
         f->setPlaying(false); f->reset();
     } else {
         printf("[orbvel]   REAL FLUID: skipped (no fluid system / GL)\n");
     }
 
-    printf("[orbvel] %s\n", allOk ? "ALL PASS (volume velocity query: synthetic exact, global-avg neg-ctrl, real-fluid off-stream->0)"
+    // ---- Part C: the per-step spatial hash on synthetic clouds (bit-exact vs the scan + throughput) ----
+    allOk = krs::orb::runProbeIndexSelfTest() && allOk;
+
+    printf("[orbvel] %s\n", allOk ? "ALL PASS (volume velocity query: synthetic exact, global-avg neg-ctrl, real-fluid off-stream->0, spatial hash == scan)"
                                    : "FAILURES PRESENT");
     std::fflush(stdout);
     return allOk;
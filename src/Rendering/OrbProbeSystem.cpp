@@ -4,9 +4,13 @@
 // particles once, then for each OrbBindingComponent compute the average velocity of the
 // particles inside its sphere (krs::orb::averageVelocityInSphere) and store it on the
 // component. The orb node's compute() (on the eval thread) merely relays that value.
+// With many orbs the step's particles go into a krs::orb::ProbeIndex (uniform-grid hash
+// built once) and each orb only visits the cells its sphere overlaps; the result is
+// bit-identical to the scan, so the switch is purely a cost decision.
 #include "RenderingSystem.hpp"
 #include "FluidSystem.hpp"
 #include "OrbProbe.hpp"
+#include "ParallelFor.hpp"
 #include "components.hpp"
 
 #include <QOpenGLFunctions_4_3_Core>
@@ -18,6 +22,10 @@
 
 namespace {
 struct GpuParticle { glm::vec4 posLife; glm::vec4 vel; glm::vec4 pred; };   // FluidSystem layout
+
+// Below this many orbs the per-step index build costs more than it saves (KRS_ORB_SELFTEST
+// reports the break-even: ~50 probes over 200k particles on one core, fewer with more threads).
+constexpr size_t kIndexedProbeMin = 32;
 }
 
 void RenderingSystem::updateOrbProbes(entt::registry& registry)
@@ -41,13 +49,22 @@ void RenderingSystem::updateOrbProbes(entt::registry& registry)
         }
     }
 
+    // many orbs: hash the step's particles once, cells sized to the smallest orb.
+    size_t orbs = 0;
+    float minRadius = 1e30f;
+    for (auto e : view) { ++orbs; minRadius = std::min(minRadius, std::max(view.get<TransformComponent>(e).scale.x, 1e-4f)); }
+    const bool indexed = orbs >= kIndexedProbeMin && !pos.empty();
+    krs::orb::ProbeIndex index;
+    if (indexed) index.build(std::move(pos), std::move(vel), std::max(minRadius, 1e-3f), &krs::par::ThreadPool::global());
+
     // per orb: average velocity of the particles inside its sphere (radius = transform scale).
     for (auto e : view) {
         auto& ob = view.get<OrbBindingComponent>(e);
         const auto& xf = view.get<TransformComponent>(e);
         const float radius = std::max(xf.scale.x, 1e-4f);
         ob.radius = radius;
-        const krs::orb::OrbVelocity r = krs::orb::averageVelocityInSphere(pos, vel, xf.translation, radius);
+        const krs::orb::OrbVelocity r = indexed ? index.averageVelocityInSphere(xf.translation, radius)
+                                                : krs::orb::averageVelocityInSphere(pos, vel, xf.translation, radius);
         ob.measuredVelocity = r.avg;
         ob.containedCount = r.count;
 
@@ -31,7 +31,9 @@
 #include "TonemapPass.hpp"
 #include "GlassPass.hpp"
 #include "SmokeSystem.hpp"
+#include "SmokeCpuSolver.hpp"
 #include "MpmSystem.hpp"
+#include "MpmCpuSolver.hpp"
 #include "MpmAdjoint.hpp"
 #include "HilClock.hpp"
 #include "HilBridges.hpp"
@@ -49,6 +51,16 @@
 #include "MeshMaterialSource.hpp"
 #include "DfsphBackend.hpp"
 #include "FluidSystem.hpp"
+#include "FluidSequenceMesher.hpp"
+#include "MortonSort.hpp"
+#include "CookedMeshCache.hpp"
+#include "HullSet.hpp"
+#include "VecEnv.hpp"
+#include "SimReplay.hpp"
+#include "ReplayRing.hpp"
+#include "RolloutWorkers.hpp"
+#include "DemoLog.hpp"
+#include "SdfBaker.hpp"
 #include "SdfColliderQuery.hpp" // Phase B GATE C (krs::fluid::runCollisionSyncGateC)
 #include "IntegrationHarness.hpp" // Phase 0 GATE 0a/0b (krs::integ conservation + causal harnesses)
 #include "RayPick.hpp"            // Phase 3 GATE 3.1 (krs::pick raycast)
@@ -778,6 +790,14 @@ void RenderingSystem::initializeSharedResources()
         std::_Exit(ok ? 0 : 1);
     }
 
+    // MPM backend parity: compute shaders vs the CPU solver (mechanics, conduction, melt + neg-ctrls).
+    if (m_mpm && qEnvironmentVariableIntValue("KRS_MPM_PARITY_SELFTEST") != 0) {
+        std::printf("\n================= KRS_MPM_PARITY_SELFTEST =================\n");
+        const bool ok = m_mpm->runBackendParity(*this, m_gl);
+        std::fflush(stdout);
+        std::_Exit(ok ? 0 : 1);
+    }
+
     // Phase 1 GATE 1.5: FEM static equilibrium (net reaction == applied load + unbalanced neg-ctrl).
     if (qEnvironmentVariableIntValue("KRS_FEMEQUIL_SELFTEST") != 0) {
         std::printf("\n================= KRS_FEMEQUIL_SELFTEST =================\n");
@@ -1387,16 +1407,153 @@ void RenderingSystem::initializeSharedResources()
         std::fflush(stdout); std::_Exit(ok ? 0 : 1);
     }
 
+    // CPU MLS-MPM backend: analytic checks, 1-vs-N-thread bit identity, throughput bench. Pure CPU.
+    if (qEnvironmentVariableIntValue("KRS_MPM_CPU_SELFTEST") != 0) {
+        std::printf("\n================= KRS_MPM_CPU_SELFTEST =================\n");
+        const bool ok = MpmCpuSolver::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Fluid bake cache: codec round trips + quantization bounds, container random access,
+    // prefetcher hit rate, compression-ratio report. Temp dir, no GL.
+    if (qEnvironmentVariableIntValue("KRS_FLUID_CACHE_SELFTEST") != 0) {
+        std::printf("\n================= KRS_FLUID_CACHE_SELFTEST =================\n");
+        const bool ok = FluidCache::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Fluid sequence mesher: sphere radius/watertight/volume, incremental == full rebuild,
+    // 1 vs N threads identical, KRS_FLUID_MESH_BENCH-frame wall-clock bench. No GL.
+    if (qEnvironmentVariableIntValue("KRS_FLUID_MESH_SELFTEST") != 0) {
+        std::printf("\n================= KRS_FLUID_MESH_SELFTEST =================\n");
+        const bool ok = krs::FluidSequenceMesher::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Morton particle sort: radix sort == stable_sort, neighbours == brute force,
+    // spawn-order vs Morton-order neighbour-search throughput. No GL.
+    if (qEnvironmentVariableIntValue("KRS_MORTON_SELFTEST") != 0) {
+        std::printf("\n================= KRS_MORTON_SELFTEST =================\n");
+        const bool ok = krs::morton::CellTable::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // CPU smoke reference: pressure iterations-to-tolerance (MG-PCG / V-cycle / Jacobi), MacCormack vs
+    // semi-Lagrangian, plume ms/step vs the GPU path's SL + 28 Jacobi. No GL.
+    if (qEnvironmentVariableIntValue("KRS_SMOKE_CPU_SELFTEST") != 0) {
+        std::printf("\n================= KRS_SMOKE_CPU_SELFTEST =================\n");
+        const bool ok = SmokeCpuSolver::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Cooked collision disk cache: mapped round trip, damaged entries rejected, concurrent stores,
+    // cold-vs-warm parallel launch with hit/miss counts. Temp dir, no PhysX.
+    if (qEnvironmentVariableIntValue("KRS_COOK_CACHE_SELFTEST") != 0) {
+        std::printf("\n================= KRS_COOK_CACHE_SELFTEST =================\n");
+        const bool ok = CookedMeshCache::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Hull sets (CoACD files + cached V-HACD hulls): mapped open == legacy ifstream reader, corrupt
+    // files rejected, mapped vs copying load time. Temp dir, no PhysX.
+    if (qEnvironmentVariableIntValue("KRS_HULLSET_SELFTEST") != 0) {
+        std::printf("\n================= KRS_HULLSET_SELFTEST =================\n");
+        const bool ok = krs::HullSet::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Vectorized RL environments: clones == lone env (bitwise per scene), per-env actions (neg-ctrl),
+    // reset/auto-reset, aggregate env-steps/s for KRS_VECENV_N envs in both layouts. Needs PhysX.
+    if (qEnvironmentVariableIntValue("KRS_VECENV_SELFTEST") != 0) {
+        std::printf("\n================= KRS_VECENV_SELFTEST =================\n");
+        const bool ok = krs::rl::VecEnv::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Deterministic replay: log format on a toy world (replay == recording, nudge located, damaged
+    // logs refused), then the PhysX box-pile gate (bit-exact replay, hashing overhead < 5%).
+    if (qEnvironmentVariableIntValue("KRS_REPLAY_SELFTEST") != 0) {
+        std::printf("\n================= KRS_REPLAY_SELFTEST =================\n");
+        const bool logOk = krs::replay::runSelfTests();
+        const bool simOk = SimulationController::runReplaySelfTest();
+        std::fflush(stdout); std::_Exit(logOk && simOk ? 0 : 1);
+    }
+
+    // Sim thread: step-period jitter of the fixed-rate physics thread under 60 ms UI stalls,
+    // against main-thread stepping (neg-ctrl), plus the command/frame hand-off.
+    if (qEnvironmentVariableIntValue("KRS_SIM_THREAD_SELFTEST") != 0) {
+        std::printf("\n================= KRS_SIM_THREAD_SELFTEST =================\n");
+        const bool ok = SimulationController::runSimThreadSelfTest();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Episode reset: in-place restore of a captured world (exact), seeded domain randomization,
+    // resets/s against the stop()+rebuild path.
+    if (qEnvironmentVariableIntValue("KRS_RESET_SELFTEST") != 0) {
+        std::printf("\n================= KRS_RESET_SELFTEST =================\n");
+        const bool ok = SimulationController::runResetSelfTest();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // RL replay ring: field round trip, mmap persistence + read-only attach, sum-tree sampling
+    // frequencies, insert/sample throughput vs the old deque buffer.
+    if (qEnvironmentVariableIntValue("KRS_REPLAY_RING_SELFTEST") != 0) {
+        std::printf("\n================= KRS_REPLAY_RING_SELFTEST =================\n");
+        const bool ok = krs::rl::ReplayRing::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // RL rollout workers: torn-free weight broadcast, per-worker determinism, version hand-off,
+    // learner backpressure, samples/s vs worker count.
+    if (qEnvironmentVariableIntValue("KRS_ROLLOUT_SELFTEST") != 0) {
+        std::printf("\n================= KRS_ROLLOUT_SELFTEST =================\n");
+        const bool ok = krs::rl::RolloutWorkers::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // Demonstration logs: columnar round trip, size vs zlib/JSON, crash recovery, record cost
+    // per step with background encoding, minibatch loader epochs.
+    if (qEnvironmentVariableIntValue("KRS_DEMO_LOG_SELFTEST") != 0) {
+        std::printf("\n================= KRS_DEMO_LOG_SELFTEST =================\n");
+        const bool ok = krs::demo::runSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
+    // SDF baking: tiled / narrow-band fills == dense, cache payload + key, repeated fixtures in a
+    // batch baked once then mapped from the disk cache.
+    if (qEnvironmentVariableIntValue("KRS_SDF_BAKE_SELFTEST") != 0) {
+        std::printf("\n================= KRS_SDF_BAKE_SELFTEST =================\n");
+        const bool ok = runSdfBakeSelfTests();
+        std::fflush(stdout); std::_Exit(ok ? 0 : 1);
+    }
+
     if (qEnvironmentVariableIntValue("KRS_OVERNIGHT_BENCH") != 0) {
         std::printf("\n================= KRS_OVERNIGHT_BENCH =================\n");
         struct GateRes { const char* name; bool ok; };
         GateRes g[] = {
             { "Phase A dynamics oracle (FK/M/dyn/IK/loop)", krs::dyn::runSelfTests() },
             { "Phase A articulation gate (A1/A2/A3/A5)",    krs::dyn::runArticulationGate() },
-            { "FEM oracle (axial/cantilever/conduction/Kt)", krs::fem::FemSolver::runSelfTests() },
+            { "FEM oracle (axial/cantilever/conduction/Kt/MG-PCG)", krs::fem::FemSolver::runSelfTests() },
             { "MPM fidelity suite (analytic ground truth)",  m_mpm ? m_mpm->runSelfTests(*this, m_gl) : true },
-            { "Adjoint MLS-MPM gradient check (<1e-5)",      krs::mpmad::runSelfTests() },
+            { "MPM CPU backend (analytic + threads bit-identical)", MpmCpuSolver::runSelfTests() },
+            { "MPM CPU == GPU backend parity (mechanics + heat + melt, neg-ctrls)", m_mpm ? m_mpm->runBackendParity(*this, m_gl) : true },
+            { "Fluid cache (lossless bit-exact + quantized bounds + prefetch)", FluidCache::runSelfTests() },
+            { "Fluid sequence mesher (incremental == rebuild, threads)", krs::FluidSequenceMesher::runSelfTests() },
+            { "Morton sort + cell table (== brute force, throughput)", krs::morton::CellTable::runSelfTests() },
+            { "Smoke CPU reference (MG-PCG to tolerance, MacCormack)", SmokeCpuSolver::runSelfTests() },
+            { "Cooked mesh disk cache (mapped, checksummed, warm hits)", CookedMeshCache::runSelfTests() },
+            { "Hull set mapping (== legacy COAC reader, corrupt rejected)", krs::HullSet::runSelfTests() },
+            { "Vectorized envs (clones == lone env, env-steps/s)", krs::rl::VecEnv::runSelfTests() },
+            { "Replay ring (mmap resume, sum-tree freq, vs deque)", krs::rl::ReplayRing::runSelfTests() },
+            { "Rollout workers (broadcast, determinism, samples/s)", krs::rl::RolloutWorkers::runSelfTests() },
+            { "Demo log (round trip, recovery, record cost, loader)", krs::demo::runSelfTests() },
+            { "SDF bake (tiled == dense, disk cache hits, batch dedupe)", runSdfBakeSelfTests() },
+            { "Replay log (toy replay, nudge located, damaged refused)", krs::replay::runSelfTests() },
+            { "Sim replay (box pile bit-exact, hash overhead < 5%)", SimulationController::runReplaySelfTest() },
+            { "Episode reset (in-place restore exact, seeded randomization)", SimulationController::runResetSelfTest() },
+            { "Adjoint MLS-MPM gradient check (<1e-5, ckpt)", krs::mpmad::runSelfTests() },
             { "HIL jitter (1 kHz deterministic loop)",       krs::hil::runJitterSelfTest() },
+            { "Sim thread (240 Hz through UI stalls vs main thread)", SimulationController::runSimThreadSelfTest() },
             { "HIL bridges (camera loopback + CAN)",         krs::hil::runBridgeSelfTest() },
             { "Trajectory HIL multi-fidelity verify",        krs::hil::runTrajectoryHilSelfTest() },
             { "OCCT STEP pipeline (round-trip + features)",  krs::cad::runSelfTest() },
@@ -1413,7 +1570,7 @@ void RenderingSystem::initializeSharedResources()
             { "GATE LIVE-SDF (GPU Jump-Flooding EDT on the REAL live fluid: <15ms vs brute-force baseline + distance/gradient vs analytic; shifted-grid neg-ctrl)", runLiveSdfGate() },
             { "GATE LIVE-TRACK (JFA SDF follows live falling water frame-to-frame: zero-crossing tracks vs baked-once ghost neg-ctrl; full gen+readback path <15ms)", runLiveTrackGate() },
             { "GATE VISUALIZER-DATA (revived arrow field: real arrow_field_compute vectors == analytic effector field at each arrow; stale-field neg-ctrl mismatches)", runFieldVisualizerGate() },
-            { "GATE ORB-VELOCITY (volume containment velocity query: synthetic exact + global-avg neg-ctrl + REAL fluid off-stream->0)", runOrbVelocityGate() },
+            { "GATE ORB-VELOCITY (volume containment velocity query: synthetic exact + global-avg neg-ctrl + REAL fluid off-stream->0 + spatial hash == scan)", runOrbVelocityGate() },
             { "GATE ORB-LIFECYCLE (orb<->node binding: N orbs N colours; node-delete removes orb; orb-delete exposes node; leak neg-ctrl)", runOrbLifecycleGate() },
             { "GATE 1.2 fluid<->rigid Newton 3rd (impulse==momentum + inert-box neg-ctrl)", runFluidRigidImpulseGate() },
             { "GATE 1.3 artic<->collision (collision xform tracks live FK + stale neg-ctrl)", krs::dyn::runArticCollisionGate1_3() },
@@ -1434,13 +1591,13 @@ void RenderingSystem::initializeSharedResources()
             { "GATE NODE-LIB (math/signal/time/logic nodes vs closed-form, <tol)", krs::nodes::runNodeLibraryGate() },
             { "GATE NODE-MQTT (publish-node drives live robot over the bus, FK <1e-4)", krs::nodes::runMqttNodeGate() },
             { "GATE PLAN (OMPL RRTConnect/RRTstar over SerialChain: collision-free/limits/connectivity/determinism + straight-line & boxed-in neg-ctrls)", krs::plan::runPlanningGate() },
-            { "GATE EXECUTE (planned path run through computed-torque under gravity: tracks/collision-free/limits; soft-PD lag + colliding-ref + 3x-fast neg-ctrls)", krs::plan::runExecuteGate() },
+            { "GATE EXECUTE (planned path run through computed-torque under gravity: tracks/collision-free/limits + TOPP-RA cycle time; soft-PD lag + colliding-ref + 3x-fast neg-ctrls)", krs::plan::runExecuteGate() },
             { "GATE ROBOT-CHAIN (entity owns links+joints+base+mount: owned-DOF chain/joint-from-feature/typed-mount-port/lossless-export; non-member & non-coaxial & mismatched-type & corrupt-export neg-ctrls)", krs::robot::runRobotChainGate() },
             { "GATE E2E (robot defined-via-chain -> planned -> executed; every stage asserted; severing define/plan/execute localizes the break)", krs::plan::runE2EGate() },
             { "GATE TWIN (ECS->catalog introspection + Object/Property nodes value-fidelity + stale-aware frequency; non-existent-obj & phantom-prop & disconnected & frozen-Hz neg-ctrls)", krs::twin::runTwinGate() },
             { "GATE EMITTER (avoidance-field emission magnitude/sign via FieldSolver + substance origin/rate/follow + type-switch; zero-amp & disconnected & invalid-type neg-ctrls)", krs::field::runEmitterGate() },
             { "GATE FIELD-LAW (dynamics-driven amplitude ordering accel>const>decel>static + authorable + law->emitter pipe; geometry-only-fails-ordering & unconnected-weight neg-ctrls)", krs::field::runFieldLawGate() },
-            { "GATE SDF (particle grid-SDF distance vs analytic + away-gradient + dynamics-scaling + interactive-perf; empty-SDF & flat-gradient & geometry-only neg-ctrls)", krs::field::runSdfGate() },
+            { "GATE SDF (particle grid-SDF distance vs analytic + away-gradient + dynamics-scaling + interactive-perf + slab-parallel == serial; empty-SDF & flat-gradient & geometry-only & centred-only-slab neg-ctrls)", krs::field::runSdfGate() },
             { "GATE UNCERTAINTY (variance drops with observation + reaction tempered by uncertainty + temporally-stable gradient; blind-model & no-temper & raw-jitter neg-ctrls)", krs::field::runUncertaintyGate() },
             { "GATE C-track (computed torque tracks moving setpoint; soft PD lags)", krs::ctrl::runControllerTrackGate() },
             { "GATE C-knob (goal-knob node drives live joint, FK <1e-4)", krs::ctrl::runControllerKnobGate() },
@@ -1502,6 +1659,7 @@ void RenderingSystem::initializeSharedResources()
     // Headless MLS-MPM fidelity suite (analytic ground-truth checks).
     if (m_mpm && qEnvironmentVariableIntValue("KRS_MPM_SELFTEST") != 0) {
         m_mpm->runSelfTests(*this, m_gl);
+        MpmCpuSolver::runSelfTests(); // CPU backend: analytic + determinism + scaling
         krs::mpmad::runSelfTests();   // CPU adjoint gradient checks (ADJOINT_GRADIENT_CHECK)
         krs::hil::runJitterSelfTest();// HIL_JITTER (1 kHz deterministic loop)
         krs::hil::runBridgeSelfTest();// LOOPBACK_FRAME_INTEGRITY + CAN round-trip
@@ -2,10 +2,19 @@
 // (see CMakeLists): OpenVDB 12 headers require a conformant compiler.
 #include "SdfBaker.hpp"
 #include "components.hpp"
+#include "CookedMeshCache.hpp"
+#include "ParallelFor.hpp"
 
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 
 #if defined(KR_WITH_OPENVDB)
 // Qt's keyword macros collide with OpenVDB (TypeList::foreach) and TBB
@@ -27,17 +36,163 @@
 #include <openvdb/tools/Interpolation.h>
 #endif
 
-bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
-                   const std::vector<unsigned int>& indices,
-                   const glm::mat4& worldTransform,
-                   float voxelSize,
-                   SdfBakeResult& out)
+namespace {
+
+// Bumped whenever the baked values change for the same inputs (dims clamp,
+// margin, sampling), so stale cache entries stop matching.
+constexpr uint32_t kSdfRecipe = 1;
+
+#if defined(KR_WITH_OPENVDB)
+constexpr uint32_t kSdfLibraryVersion = uint32_t(OPENVDB_LIBRARY_VERSION_NUMBER);
+#else
+constexpr uint32_t kSdfLibraryVersion = 0;
+#endif
+
+struct SdfPayloadHeader {
+    char magic[4] = { 'K', 'R', 'S', 'D' };
+    uint32_t version = 1;
+    int32_t dims[3] = { 0, 0, 0 };
+    float aabbMin[3] = { 0, 0, 0 };
+    float aabbMax[3] = { 0, 0, 0 };
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(SdfPayloadHeader) == 48, "SDF cache payload layout drift");
+
+struct Counters {
+    std::atomic<int64_t> requests{ 0 }, hits{ 0 }, shared{ 0 }, bakes{ 0 }, failures{ 0 };
+    std::atomic<int64_t> tilesSampled{ 0 }, tilesFilled{ 0 };
+    std::atomic<int64_t> bakeNs{ 0 }, loadNs{ 0 };
+};
+Counters& counters() { static Counters c; return c; }
+
+float bakeVoxel(float voxelSize) { return std::max(0.005f, voxelSize); }
+
+std::vector<unsigned char> encodeSdf(const SdfBakeResult& r)
+{
+    SdfPayloadHeader h;
+    for (int a = 0; a < 3; ++a) {
+        h.dims[a] = r.dims[a];
+        h.aabbMin[a] = r.aabbMin[a];
+        h.aabbMax[a] = r.aabbMax[a];
+    }
+    std::vector<unsigned char> bytes(sizeof(h) + r.field.size() * sizeof(float));
+    std::memcpy(bytes.data(), &h, sizeof(h));
+    std::memcpy(bytes.data() + sizeof(h), r.field.data(), r.field.size() * sizeof(float));
+    return bytes;
+}
+
+// The field is copied out of the mapping: both consumers (the GL upload and
+// the CPU mirror colliders sample) keep an owned buffer.
+bool decodeSdf(const unsigned char* data, size_t bytes, SdfBakeResult& out)
+{
+    SdfPayloadHeader h;
+    const SdfPayloadHeader expect;
+    if (bytes < sizeof(h)) return false;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, expect.magic, 4) != 0 || h.version != expect.version) return false;
+    for (int a = 0; a < 3; ++a)
+        if (h.dims[a] < 2 || h.dims[a] > 4096) return false;
+    const size_t count = size_t(h.dims[0]) * size_t(h.dims[1]) * size_t(h.dims[2]);
+    if (bytes != sizeof(h) + count * sizeof(float)) return false;
+    out.dims = glm::ivec3(h.dims[0], h.dims[1], h.dims[2]);
+    out.aabbMin = glm::vec3(h.aabbMin[0], h.aabbMin[1], h.aabbMin[2]);
+    out.aabbMax = glm::vec3(h.aabbMax[0], h.aabbMax[1], h.aabbMax[2]);
+    out.field.resize(count);
+    std::memcpy(out.field.data(), data + sizeof(h), count * sizeof(float));
+    return true;
+}
+
+glm::ivec3 tileCounts(const glm::ivec3& dims, int edge)
+{
+    return (dims + glm::ivec3(edge - 1)) / edge;
+}
+
+// Marks every tile holding a node inside the world box [lo, hi]. Callers grow
+// the box by the sampler's footprint so that a node whose interpolation
+// stencil reaches into the box is sampled too.
+void markTiles(const SdfBakeResult& out, int edge, const glm::vec3& lo, const glm::vec3& hi,
+               std::vector<uint8_t>& live)
+{
+    const glm::ivec3 tiles = tileCounts(out.dims, edge);
+    const glm::vec3 step = (out.aabbMax - out.aabbMin) / glm::vec3(out.dims - glm::ivec3(1));
+    const glm::ivec3 last = out.dims - glm::ivec3(1);
+    const glm::ivec3 n0 = glm::ivec3(glm::floor((lo - out.aabbMin) / step));
+    const glm::ivec3 n1 = glm::ivec3(glm::ceil((hi - out.aabbMin) / step));
+    if (glm::any(glm::greaterThan(n0, last)) || glm::any(glm::lessThan(n1, glm::ivec3(0)))) return;
+    const glm::ivec3 t0 = glm::clamp(n0, glm::ivec3(0), last) / edge;
+    const glm::ivec3 t1 = glm::clamp(n1, glm::ivec3(0), last) / edge;
+    for (int z = t0.z; z <= t1.z; ++z)
+        for (int y = t0.y; y <= t1.y; ++y)
+            for (int x = t0.x; x <= t1.x; ++x)
+                live[(size_t(z) * tiles.y + y) * tiles.x + x] = 1;
+}
+
+// Fills out.field tile by tile on the shared pool. makeSampler() is called
+// once per tile and returns a callable float(glm::vec3 world); OpenVDB
+// accessors are not thread-safe, so each tile gets its own. A tile that
+// `live` marks as 0 is filled with the value at one of its nodes.
+template <class MakeSampler>
+void fillTiles(SdfBakeResult& out, int edge, const std::vector<uint8_t>* live, MakeSampler&& makeSampler,
+               int64_t& sampled, int64_t& filled)
+{
+    const glm::ivec3 tiles = tileCounts(out.dims, edge);
+    const glm::vec3 mn = out.aabbMin;
+    const glm::vec3 step = (out.aabbMax - out.aabbMin) / glm::vec3(out.dims - glm::ivec3(1));
+    out.field.resize(size_t(out.dims.x) * out.dims.y * out.dims.z);
+    std::atomic<int64_t> nFilled{ 0 };
+    const size_t count = size_t(tiles.x) * tiles.y * tiles.z;
+    krs::par::parallelFor(count, 1, [&](size_t lo, size_t hi) {
+        for (size_t t = lo; t < hi; ++t) {
+            const glm::ivec3 tc(int(t % size_t(tiles.x)), int((t / size_t(tiles.x)) % size_t(tiles.y)),
+                                int(t / (size_t(tiles.x) * size_t(tiles.y))));
+            const glm::ivec3 a = tc * edge;
+            const glm::ivec3 b = glm::min(a + glm::ivec3(edge), out.dims);
+            auto sample = makeSampler();
+            if (live && !(*live)[t]) {
+                const glm::ivec3 c = (a + b - glm::ivec3(1)) / 2;
+                const float v = sample(mn + step * glm::vec3(c));
+                for (int z = a.z; z < b.z; ++z)
+                    for (int y = a.y; y < b.y; ++y) {
+                        float* row = out.field.data() + (size_t(z) * out.dims.y + y) * out.dims.x;
+                        std::fill(row + a.x, row + b.x, v);
+                    }
+                ++nFilled;
+                continue;
+            }
+            for (int z = a.z; z < b.z; ++z)
+                for (int y = a.y; y < b.y; ++y) {
+                    size_t idx = (size_t(z) * out.dims.y + y) * out.dims.x + a.x;
+                    for (int x = a.x; x < b.x; ++x, ++idx)
+                        out.field[idx] = sample(mn + step * glm::vec3(x, y, z));
+                }
+        }
+    });
+    filled = nFilled.load();
+    sampled = int64_t(count) - filled;
+}
+
+#if defined(KR_WITH_OPENVDB)
+struct VdbSampler {
+    mutable openvdb::FloatGrid::ConstAccessor acc;
+    const openvdb::math::Transform* xform;
+    float operator()(const glm::vec3& p) const {
+        return float(openvdb::tools::BoxSampler::sample(acc, xform->worldToIndex(openvdb::Vec3R(p.x, p.y, p.z))));
+    }
+};
+#endif
+
+bool bakeUncached(const std::vector<Vertex>& vertices,
+                  const std::vector<unsigned int>& indices,
+                  const glm::mat4& worldTransform,
+                  float voxelSize,
+                  const SdfBakeOptions& options,
+                  SdfBakeResult& out)
 {
 #if defined(KR_WITH_OPENVDB)
     if (vertices.empty() || indices.size() < 3) return false;
 
-    static bool s_vdbInit = false;
-    if (!s_vdbInit) { openvdb::initialize(); s_vdbInit = true; }
+    static std::once_flag s_vdbInit;
+    std::call_once(s_vdbInit, []() { openvdb::initialize(); });
 
     QElapsedTimer bakeTimer;
     bakeTimer.start();
@@ -56,8 +211,8 @@ bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
     for (size_t i = 0; i + 2 < indices.size(); i += 3)
         tris.emplace_back(indices[i], indices[i + 1], indices[i + 2]);
 
-    const float voxel = std::max(0.005f, voxelSize);
-    const float halfWidthVoxels = 4.0f;
+    const float voxel = bakeVoxel(voxelSize);
+    const float halfWidthVoxels = std::max(1.0f, options.halfWidthVoxels);
     auto vdbXform = openvdb::math::Transform::createLinearTransform(voxel);
     openvdb::FloatGrid::Ptr grid;
     try {
@@ -68,6 +223,7 @@ bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
         qWarning() << "[SdfBaker] meshToLevelSet failed:" << ex.what();
         return false;
     }
+    const qint64 levelSetMs = bakeTimer.elapsed();
 
     const float margin = halfWidthVoxels * voxel;
     mn -= glm::vec3(margin);
@@ -77,26 +233,408 @@ bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
     out.aabbMax = mx;
     const glm::vec3 ext = mx - mn;
     out.dims = glm::clamp(glm::ivec3(glm::ceil(ext / voxel)), glm::ivec3(8), glm::ivec3(160));
-    out.field.resize(size_t(out.dims.x) * out.dims.y * out.dims.z);
 
-    openvdb::tools::GridSampler<openvdb::FloatGrid, openvdb::tools::BoxSampler> sampler(*grid);
-    const glm::vec3 step = ext / glm::vec3(out.dims - glm::ivec3(1));
-    size_t idx = 0;
-    for (int z = 0; z < out.dims.z; ++z)
-        for (int y = 0; y < out.dims.y; ++y)
-            for (int x = 0; x < out.dims.x; ++x, ++idx) {
-                const glm::vec3 wp = mn + step * glm::vec3(x, y, z);
-                out.field[idx] = float(sampler.wsSample(openvdb::Vec3R(wp.x, wp.y, wp.z)));
-            }
+    // Outside the band leaves a level set holds only +-background, so a tile
+    // whose nodes' trilinear stencils (one voxel either way) miss every leaf
+    // is that constant throughout.
+    const int edge = std::max(2, options.tile);
+    std::vector<uint8_t> live;
+    if (options.narrowBand) {
+        const glm::ivec3 tiles = tileCounts(out.dims, edge);
+        live.assign(size_t(tiles.x) * tiles.y * tiles.z, 0);
+        for (auto leaf = grid->tree().cbeginLeaf(); leaf; ++leaf) {
+            const openvdb::CoordBBox box = leaf->getNodeBoundingBox();
+            const openvdb::Vec3d lo = grid->indexToWorld(box.min()), hi = grid->indexToWorld(box.max());
+            markTiles(out, edge, glm::vec3(float(lo.x()), float(lo.y()), float(lo.z())) - glm::vec3(voxel),
+                      glm::vec3(float(hi.x()), float(hi.y()), float(hi.z())) + glm::vec3(voxel), live);
+        }
+    }
+    int64_t sampled = 0, filled = 0;
+    const openvdb::math::Transform& xform = grid->transform();
+    fillTiles(out, edge, options.narrowBand ? &live : nullptr,
+              [&]() { return VdbSampler{ grid->getConstAccessor(), &xform }; }, sampled, filled);
 
+    Counters& c = counters();
+    c.tilesSampled += sampled;
+    c.tilesFilled += filled;
     qInfo() << "[SdfBaker] baked" << out.dims.x << "x" << out.dims.y << "x" << out.dims.z
             << "voxels @" << voxel << "m from" << tris.size() << "triangles in"
-            << bakeTimer.elapsed() << "ms";
+            << bakeTimer.elapsed() << "ms (level set" << levelSetMs << "ms," << sampled << "tiles sampled,"
+            << filled << "constant)";
     return true;
 #else
     Q_UNUSED(vertices); Q_UNUSED(indices); Q_UNUSED(worldTransform);
-    Q_UNUSED(voxelSize); Q_UNUSED(out);
+    Q_UNUSED(voxelSize); Q_UNUSED(options); Q_UNUSED(out);
     qWarning() << "[SdfBaker] built without OpenVDB - SDF colliders disabled";
     return false;
 #endif
 }
+
+} // namespace
+
+uint64_t sdfBakeKey(const std::vector<Vertex>& vertices,
+                    const std::vector<unsigned int>& indices,
+                    const glm::mat4& worldTransform,
+                    float voxelSize,
+                    const SdfBakeOptions& options)
+{
+    uint64_t geometry = CookedMeshCache::hash(indices.data(), indices.size() * sizeof(unsigned int));
+    for (const Vertex& v : vertices)
+        geometry = CookedMeshCache::hash(&v.position, sizeof(v.position), geometry);
+
+    // narrowBand and tile only change how the block is filled, not its values.
+    float p[19];
+    std::memcpy(p, &worldTransform[0][0], 16 * sizeof(float));
+    p[16] = bakeVoxel(voxelSize);
+    p[17] = std::max(1.0f, options.halfWidthVoxels);
+    p[18] = float(kSdfRecipe);
+    return CookedMeshCache::key(geometry, CookedMeshCache::Kind::Sdf, CookedMeshCache::hash(p, sizeof(p)),
+                                kSdfLibraryVersion);
+}
+
+CookedMeshCache& sdfBakeCache()
+{
+    struct Shared {
+        CookedMeshCache cache;
+        Shared() { cache.setDirectory(CookedMeshCache::defaultDirectory()); }
+    };
+    static Shared s;
+    return s.cache;
+}
+
+SdfBakeStats sdfBakeStats()
+{
+    const Counters& c = counters();
+    SdfBakeStats s;
+    s.requests = c.requests; s.hits = c.hits; s.shared = c.shared;
+    s.bakes = c.bakes; s.failures = c.failures;
+    s.tilesSampled = c.tilesSampled; s.tilesFilled = c.tilesFilled;
+    s.bakeMs = double(c.bakeNs.load()) * 1e-6;
+    s.loadMs = double(c.loadNs.load()) * 1e-6;
+    return s;
+}
+
+void resetSdfBakeStats()
+{
+    Counters& c = counters();
+    c.requests = 0; c.hits = 0; c.shared = 0; c.bakes = 0; c.failures = 0;
+    c.tilesSampled = 0; c.tilesFilled = 0; c.bakeNs = 0; c.loadNs = 0;
+}
+
+int bakeMeshesToSdf(const std::vector<SdfBakeRequest>& requests,
+                    std::vector<SdfBakeResult>& out,
+                    const SdfBakeOptions& options)
+{
+    const size_t n = requests.size();
+    out.assign(n, SdfBakeResult{});
+    if (n == 0) return 0;
+    Counters& c = counters();
+    c.requests += int64_t(n);
+
+    CookedMeshCache& cache = sdfBakeCache();
+    const bool cached = options.useCache && cache.enabled();
+    std::vector<uint64_t> keys(n, 0);
+    std::vector<uint8_t> hit(n, 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    krs::par::parallelFor(n, 1, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            const SdfBakeRequest& r = requests[i];
+            if (!r.vertices || !r.indices) continue;
+            keys[i] = sdfBakeKey(*r.vertices, *r.indices, r.worldTransform, r.voxelSize, options);
+            if (!cached) continue;
+            if (auto blob = cache.load(CookedMeshCache::Kind::Sdf, keys[i]))
+                hit[i] = decodeSdf(blob->data(), blob->size(), out[i]) ? 1 : 0;
+        }
+    });
+    const int64_t loadNs = timer.nsecsElapsed();
+    c.loadNs += loadNs;
+
+    timer.restart();
+    int filled = 0, hits = 0, shared = 0, baked = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (hit[i]) { ++filled; ++hits; continue; }
+        const SdfBakeRequest& r = requests[i];
+        if (!r.vertices || !r.indices) { ++c.failures; continue; }
+
+        // a fixture repeated in the scene is baked once per batch
+        size_t same = i;
+        for (size_t j = 0; j < i && same == i; ++j)
+            if (keys[j] == keys[i] && !out[j].field.empty()) same = j;
+        if (same != i) { out[i] = out[same]; ++filled; ++shared; continue; }
+
+        if (!bakeUncached(*r.vertices, *r.indices, r.worldTransform, r.voxelSize, options, out[i])) {
+            out[i] = SdfBakeResult{};
+            ++c.failures;
+            continue;
+        }
+        ++filled; ++baked;
+        if (cached) {
+            const std::vector<unsigned char> bytes = encodeSdf(out[i]);
+            cache.store(CookedMeshCache::Kind::Sdf, keys[i], bytes.data(), bytes.size());
+        }
+    }
+    const int64_t bakeNs = timer.nsecsElapsed();
+    c.bakeNs += bakeNs;
+    c.hits += hits;
+    c.shared += shared;
+    c.bakes += baked;
+
+    if (n > 1 || hits > 0)
+        qInfo() << "[SdfBaker]" << n << "SDF(s):" << hits << "cache hits," << baked << "baked,"
+                << shared << "repeated in" << double(bakeNs) * 1e-6 << "ms (hash + mapped loads"
+                << double(loadNs) * 1e-6 << "ms)";
+    return filled;
+}
+
+bool bakeMeshToSdf(const std::vector<Vertex>& vertices,
+                   const std::vector<unsigned int>& indices,
+                   const glm::mat4& worldTransform,
+                   float voxelSize,
+                   SdfBakeResult& out,
+                   const SdfBakeOptions& options)
+{
+    SdfBakeRequest r;
+    r.vertices = &vertices;
+    r.indices = &indices;
+    r.worldTransform = worldTransform;
+    r.voxelSize = voxelSize;
+    std::vector<SdfBakeResult> results;
+    if (bakeMeshesToSdf({ r }, results, options) != 1) return false;
+    out = std::move(results[0]);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+// Stand-in for a narrow-band level set: a sphere's distance stored on a voxel
+// lattice, +-background outside the band, trilinear lookup (BoxSampler's
+// stencil). "Leaves" are the 8^3 lattice blocks holding an in-band value.
+struct LatticeSphere {
+    float radius = 0.3f, voxel = 0.02f, background = 0.08f;
+    float at(int i, int j, int k) const {
+        const float d = glm::length(glm::vec3(float(i), float(j), float(k)) * voxel) - radius;
+        return std::clamp(d, -background, background);
+    }
+    float operator()(const glm::vec3& p) const {
+        const glm::vec3 q = p / voxel;
+        const glm::ivec3 i0 = glm::ivec3(glm::floor(q));
+        const glm::vec3 f = q - glm::vec3(i0);
+        auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+        const float x00 = lerp(at(i0.x, i0.y, i0.z), at(i0.x + 1, i0.y, i0.z), f.x);
+        const float x10 = lerp(at(i0.x, i0.y + 1, i0.z), at(i0.x + 1, i0.y + 1, i0.z), f.x);
+        const float x01 = lerp(at(i0.x, i0.y, i0.z + 1), at(i0.x + 1, i0.y, i0.z + 1), f.x);
+        const float x11 = lerp(at(i0.x, i0.y + 1, i0.z + 1), at(i0.x + 1, i0.y + 1, i0.z + 1), f.x);
+        return lerp(lerp(x00, x10, f.y), lerp(x01, x11, f.y), f.z);
+    }
+    // world boxes of the blocks that hold a value strictly inside the band
+    std::vector<std::pair<glm::vec3, glm::vec3>> leaves(const glm::vec3& mn, const glm::vec3& mx) const {
+        std::vector<std::pair<glm::vec3, glm::vec3>> out;
+        const glm::ivec3 b0 = glm::ivec3(glm::floor(mn / (8.0f * voxel))) - glm::ivec3(1);
+        const glm::ivec3 b1 = glm::ivec3(glm::floor(mx / (8.0f * voxel))) + glm::ivec3(1);
+        for (int bz = b0.z; bz <= b1.z; ++bz)
+            for (int by = b0.y; by <= b1.y; ++by)
+                for (int bx = b0.x; bx <= b1.x; ++bx) {
+                    bool band = false;
+                    for (int k = 0; k < 8 && !band; ++k)
+                        for (int j = 0; j < 8 && !band; ++j)
+                            for (int i = 0; i < 8 && !band; ++i)
+                                band = std::abs(at(bx * 8 + i, by * 8 + j, bz * 8 + k)) < background;
+                    if (band)
+                        out.push_back({ glm::vec3(bx * 8, by * 8, bz * 8) * voxel,
+                                        glm::vec3(bx * 8 + 7, by * 8 + 7, bz * 8 + 7) * voxel });
+                }
+        return out;
+    }
+};
+
+void boxMesh(const glm::vec3& half, std::vector<Vertex>& v, std::vector<unsigned int>& idx)
+{
+    v.clear(); idx.clear();
+    for (int i = 0; i < 8; ++i) {
+        Vertex p;
+        p.position = glm::vec3(i & 1 ? half.x : -half.x, i & 2 ? half.y : -half.y, i & 4 ? half.z : -half.z);
+        v.push_back(p);
+    }
+    const unsigned int q[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 },
+                                   { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+    for (const auto& f : q)
+        for (unsigned int t : { f[0], f[1], f[2], f[0], f[2], f[3] }) idx.push_back(t);
+}
+
+} // namespace
+
+bool runSdfBakeSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[SDF-BAKE] %s %-44s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+    CookedMeshCache& cache = sdfBakeCache();
+    const QString savedDir = cache.directory();
+    cache.setDirectory(tmp.path());
+
+    // ---- tiled fills == a serial dense fill ----
+    {
+        const LatticeSphere sphere;
+        SdfBakeResult geo;
+        geo.aabbMin = glm::vec3(-0.45f, -0.41f, -0.43f);
+        geo.aabbMax = glm::vec3(0.44f, 0.42f, 0.40f);
+        geo.dims = glm::ivec3(97, 83, 71);            // node step < voxel, no multiple of the tile edge
+        const int edge = 8;
+
+        SdfBakeResult dense = geo;
+        QElapsedTimer t; t.start();
+        dense.field.resize(size_t(geo.dims.x) * geo.dims.y * geo.dims.z);
+        const glm::vec3 step = (geo.aabbMax - geo.aabbMin) / glm::vec3(geo.dims - glm::ivec3(1));
+        size_t idx = 0;
+        for (int z = 0; z < geo.dims.z; ++z)
+            for (int y = 0; y < geo.dims.y; ++y)
+                for (int x = 0; x < geo.dims.x; ++x, ++idx)
+                    dense.field[idx] = sphere(geo.aabbMin + step * glm::vec3(x, y, z));
+        const double denseMs = double(t.nsecsElapsed()) * 1e-6;
+
+        auto bandFill = [&](float footprint, SdfBakeResult& r, int64_t& sampled, int64_t& filled) {
+            const glm::ivec3 tiles = tileCounts(geo.dims, edge);
+            std::vector<uint8_t> live(size_t(tiles.x) * tiles.y * tiles.z, 0);
+            for (const auto& leaf : sphere.leaves(geo.aabbMin, geo.aabbMax))
+                markTiles(r, edge, leaf.first - glm::vec3(footprint), leaf.second + glm::vec3(footprint), live);
+            fillTiles(r, edge, &live, [&]() { return sphere; }, sampled, filled);
+        };
+        int64_t sampled = 0, filled = 0;
+        SdfBakeResult tiled = geo;
+        t.restart();
+        fillTiles(tiled, edge, nullptr, [&]() { return sphere; }, sampled, filled);
+        const double tiledMs = double(t.nsecsElapsed()) * 1e-6;
+        SdfBakeResult band = geo;
+        t.restart();
+        bandFill(sphere.voxel, band, sampled, filled);
+        const double bandMs = double(t.nsecsElapsed()) * 1e-6;
+        const bool same = tiled.field == dense.field && band.field == dense.field;
+        report(same && filled > 0, "tiled + narrow-band fill == serial dense",
+               QStringLiteral("(%1x%2x%3; dense %4 ms, tiled %5 ms on %6 threads, narrow band %7 ms with %8 of %9 tiles constant)")
+                   .arg(geo.dims.x).arg(geo.dims.y).arg(geo.dims.z).arg(denseMs, 0, 'f', 1).arg(tiledMs, 0, 'f', 1)
+                   .arg(krs::par::ThreadPool::global().size()).arg(bandMs, 0, 'f', 1)
+                   .arg(filled).arg(filled + sampled));
+
+        // NEG-CTRL: marking only the leaf boxes skips nodes whose stencil reaches into a leaf
+        SdfBakeResult tight = geo;
+        int64_t s2 = 0, f2 = 0;
+        bandFill(0.0f, tight, s2, f2);
+        size_t differ = 0;
+        for (size_t i = 0; i < dense.field.size(); ++i) differ += tight.field[i] != dense.field[i];
+        report(differ > 0, "NEG-CTRL band without stencil margin differs",
+               QStringLiteral("(%1 nodes wrong, %2 tiles constant vs %3)").arg(differ).arg(f2).arg(filled));
+    }
+
+    // ---- payload round trip through the mapping ----
+    {
+        SdfBakeResult r;
+        r.dims = glm::ivec3(9, 7, 5);
+        r.aabbMin = glm::vec3(-1, -2, -3);
+        r.aabbMax = glm::vec3(1, 2, 3);
+        for (int i = 0; i < 9 * 7 * 5; ++i) r.field.push_back(std::sin(0.37f * float(i)));
+        const std::vector<unsigned char> bytes = encodeSdf(r);
+        const uint64_t k = 0x5DF0005DF0ull;
+        cache.store(CookedMeshCache::Kind::Sdf, k, bytes.data(), bytes.size());
+        SdfBakeResult back;
+        auto blob = cache.load(CookedMeshCache::Kind::Sdf, k);
+        const bool same = blob && decodeSdf(blob->data(), blob->size(), back) && back.field == r.field
+                       && back.dims == r.dims && back.aabbMin == r.aabbMin && back.aabbMax == r.aabbMax;
+        SdfBakeResult junk;
+        const bool shortRefused = !decodeSdf(bytes.data(), bytes.size() - sizeof(float), junk);
+        std::vector<unsigned char> lying = bytes;
+        const int32_t dimsX = 10;
+        std::memcpy(lying.data() + 8, &dimsX, sizeof(dimsX));
+        const bool dimsRefused = !decodeSdf(lying.data(), lying.size(), junk);
+        report(same && shortRefused && dimsRefused, "payload mapped back bit-exact",
+               QStringLiteral("(%1 bytes; short block refused:%2, wrong dims refused:%3)")
+                   .arg(bytes.size()).arg(shortRefused).arg(dimsRefused));
+    }
+
+    // ---- the key follows every input that changes the field ----
+    std::vector<Vertex> v; std::vector<unsigned int> idx;
+    boxMesh(glm::vec3(0.2f, 0.1f, 0.15f), v, idx);
+    {
+        const SdfBakeOptions o;
+        const glm::mat4 I(1.0f);
+        const uint64_t base = sdfBakeKey(v, idx, I, 0.02f, o);
+        std::vector<Vertex> moved = v; moved[3].position.y += 1e-4f;
+        std::vector<unsigned int> flipped = idx; std::swap(flipped[1], flipped[2]);
+        SdfBakeOptions wide = o; wide.halfWidthVoxels = 6.0f;
+        SdfBakeOptions dense = o; dense.narrowBand = false; dense.tile = 4;
+        const bool distinct = base != sdfBakeKey(moved, idx, I, 0.02f, o) && base != sdfBakeKey(v, flipped, I, 0.02f, o)
+                           && base != sdfBakeKey(v, idx, glm::scale(I, glm::vec3(1.0f, 2.0f, 1.0f)), 0.02f, o)
+                           && base != sdfBakeKey(v, idx, I, 0.021f, o) && base != sdfBakeKey(v, idx, I, 0.02f, wide);
+        const bool stable = base == sdfBakeKey(v, idx, I, 0.02f, o) && base == sdfBakeKey(v, idx, I, 0.02f, dense);
+        report(distinct && stable, "key covers mesh/transform/voxel/band width",
+               QStringLiteral("(5 single-input changes; fill mode shares the entry:%1)").arg(stable));
+    }
+
+    // ---- a batch of repeated fixtures: baked once each, then all mapped ----
+    {
+        std::vector<std::vector<Vertex>> meshes(3);
+        std::vector<std::vector<unsigned int>> tris(3);
+        for (int m = 0; m < 3; ++m) boxMesh(glm::vec3(0.1f + 0.05f * float(m), 0.1f, 0.08f), meshes[size_t(m)], tris[size_t(m)]);
+        std::vector<SdfBakeRequest> batch;
+        for (int i = 0; i < 6; ++i) {
+            SdfBakeRequest r;
+            r.vertices = &meshes[size_t(i % 3)];
+            r.indices = &tris[size_t(i % 3)];
+            r.voxelSize = 0.01f;
+            batch.push_back(r);
+        }
+#if !defined(KR_WITH_OPENVDB)
+        // no baker in this build: seed the cache with stand-in fields under the real keys
+        for (int m = 0; m < 3; ++m) {
+            SdfBakeResult r;
+            r.dims = glm::ivec3(16 + m, 12, 10);
+            r.aabbMax = glm::vec3(1.0f);
+            r.field.assign(size_t(r.dims.x) * r.dims.y * r.dims.z, float(m));
+            const std::vector<unsigned char> bytes = encodeSdf(r);
+            cache.store(CookedMeshCache::Kind::Sdf, sdfBakeKey(meshes[size_t(m)], tris[size_t(m)], batch[0].worldTransform,
+                                                               0.01f, SdfBakeOptions{}), bytes.data(), bytes.size());
+        }
+#endif
+        resetSdfBakeStats();
+        std::vector<SdfBakeResult> cold, warm;
+        const int coldFilled = bakeMeshesToSdf(batch, cold);
+        const SdfBakeStats sc = sdfBakeStats();
+        resetSdfBakeStats();
+        const int warmFilled = bakeMeshesToSdf(batch, warm);
+        const SdfBakeStats sw = sdfBakeStats();
+        bool same = coldFilled == 6 && warmFilled == 6;
+        for (size_t i = 0; i < 6 && same; ++i)
+            same = cold[i].field == warm[i].field && cold[i].dims == warm[i].dims && cold[i].field == cold[i % 3].field;
+        SdfBakeOptions off; off.useCache = false;
+        resetSdfBakeStats();
+        std::vector<SdfBakeResult> bypass;
+        bakeMeshesToSdf(batch, bypass, off);
+        const bool bypassed = sdfBakeStats().hits == 0;
+#if defined(KR_WITH_OPENVDB)
+        const bool counts = sc.bakes == 3 && sc.shared == 3 && sc.hits == 0 && sw.hits == 6 && sw.bakes == 0;
+        const QString mode = QStringLiteral("OpenVDB");
+#else
+        const bool counts = sc.hits == 6 && sw.hits == 6 && sw.bakes == 0;
+        const QString mode = QStringLiteral("no OpenVDB: seeded entries");
+#endif
+        report(same && counts && bypassed, "6 requests / 3 fixtures: bake once, then map",
+               QStringLiteral("(%1; cold %2 baked + %3 repeated + %4 hits in %5 ms; warm %6/6 hits in %7 ms; "
+                              "%8 tiles sampled, %9 constant)")
+                   .arg(mode).arg(sc.bakes).arg(sc.shared).arg(sc.hits).arg(sc.bakeMs + sc.loadMs, 0, 'f', 1)
+                   .arg(sw.hits).arg(sw.bakeMs + sw.loadMs, 0, 'f', 1).arg(sc.tilesSampled).arg(sc.tilesFilled));
+    }
+
+    cache.setDirectory(savedDir);
+    resetSdfBakeStats();
+    std::fprintf(stderr, "[SDF-BAKE] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
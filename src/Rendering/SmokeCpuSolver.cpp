@@ -0,0 +1,889 @@
+#include "SmokeCpuSolver.hpp"
+#include "ParallelFor.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+double msSince(Clock::time_point t0) { return std::chrono::duration<double, std::milli>(Clock::now() - t0).count(); }
+
+constexpr size_t kGrain = 8192;      // cells per chunk for flat loops and reductions
+constexpr int kJacobiCheck = 16;     // Jacobi sweeps between residual checks
+
+struct MaxAbs {
+    float v = 0.0f;
+    MaxAbs& operator+=(const MaxAbs& o) { v = std::max(v, o.v); return *this; }
+};
+
+size_t cellsOf(const glm::ivec3& d) { return size_t(d.x) * size_t(d.y) * size_t(d.z); }
+
+// fn(i, j, k, index) over every cell of a d-sized grid, one z-slab per chunk.
+template <class Fn>
+void forCells(krs::par::ThreadPool& pool, const glm::ivec3& d, Fn&& fn)
+{
+    krs::par::parallelFor(pool, size_t(d.z), 1, [&](size_t k0, size_t k1) {
+        for (int k = int(k0); k < int(k1); ++k)
+            for (int j = 0; j < d.y; ++j) {
+                size_t idx = (size_t(k) * d.y + j) * d.x;
+                for (int i = 0; i < d.x; ++i, ++idx) fn(i, j, k, idx);
+            }
+    });
+}
+
+float maxAbs(krs::par::ThreadPool& pool, const std::vector<float>& a)
+{
+    return krs::par::reduce<MaxAbs>(pool, a.size(), kGrain, MaxAbs{}, [&](size_t lo, size_t hi) {
+        MaxAbs m;
+        for (size_t i = lo; i < hi; ++i) m.v = std::max(m.v, std::fabs(a[i]));
+        return m;
+    }).v;
+}
+
+double dot(krs::par::ThreadPool& pool, const std::vector<float>& a, const std::vector<float>& b)
+{
+    return krs::par::reduce<double>(pool, a.size(), kGrain, 0.0, [&](size_t lo, size_t hi) {
+        double s = 0.0;
+        for (size_t i = lo; i < hi; ++i) s += double(a[i]) * double(b[i]);
+        return s;
+    });
+}
+
+void removeMean(krs::par::ThreadPool& pool, std::vector<float>& a)
+{
+    const double sum = krs::par::reduce<double>(pool, a.size(), kGrain, 0.0, [&](size_t lo, size_t hi) {
+        double s = 0.0;
+        for (size_t i = lo; i < hi; ++i) s += a[i];
+        return s;
+    });
+    const float mean = float(sum / double(a.size()));
+    krs::par::parallelFor(pool, a.size(), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) a[i] -= mean;
+    });
+}
+
+// Sum of the face neighbours of cell (i, j, k) and how many there are (walls drop out).
+inline float neighbours(const std::vector<float>& x, const glm::ivec3& d, int i, int j, int k, size_t idx, int& n)
+{
+    const size_t sy = size_t(d.x), sz = size_t(d.x) * size_t(d.y);
+    float s = 0.0f;
+    n = 0;
+    if (i > 0)       { s += x[idx - 1];  ++n; }
+    if (i < d.x - 1) { s += x[idx + 1];  ++n; }
+    if (j > 0)       { s += x[idx - sy]; ++n; }
+    if (j < d.y - 1) { s += x[idx + sy]; ++n; }
+    if (k > 0)       { s += x[idx - sz]; ++n; }
+    if (k < d.z - 1) { s += x[idx + sz]; ++n; }
+    return s;
+}
+
+// y = A x, (A x)_c = scale * (n_c x_c - sum of the neighbours): the negative Neumann Laplacian.
+void applyA(krs::par::ThreadPool& pool, const glm::ivec3& d, float scale, const std::vector<float>& x,
+            std::vector<float>& y)
+{
+    forCells(pool, d, [&](int i, int j, int k, size_t idx) {
+        int n;
+        const float s = neighbours(x, d, i, j, k, idx, n);
+        y[idx] = scale * (float(n) * x[idx] - s);
+    });
+}
+
+void residual(krs::par::ThreadPool& pool, const glm::ivec3& d, float scale, const std::vector<float>& x,
+              const std::vector<float>& b, std::vector<float>& r)
+{
+    forCells(pool, d, [&](int i, int j, int k, size_t idx) {
+        int n;
+        const float s = neighbours(x, d, i, j, k, idx, n);
+        r[idx] = b[idx] - scale * (float(n) * x[idx] - s);
+    });
+}
+
+// One Gauss-Seidel half sweep over the cells with (i + j + k) & 1 == parity. Same-parity cells
+// share no face, so the slabs run in parallel and the result is order-independent.
+void smoothColor(krs::par::ThreadPool& pool, const glm::ivec3& d, float scale, std::vector<float>& x,
+                 const std::vector<float>& b, int parity)
+{
+    const float invScale = 1.0f / scale;
+    krs::par::parallelFor(pool, size_t(d.z), 1, [&](size_t k0, size_t k1) {
+        for (int k = int(k0); k < int(k1); ++k)
+            for (int j = 0; j < d.y; ++j) {
+                const size_t row = (size_t(k) * d.y + j) * d.x;
+                for (int i = (j + k + parity) & 1; i < d.x; i += 2) {
+                    const size_t idx = row + size_t(i);
+                    int n;
+                    const float s = neighbours(x, d, i, j, k, idx, n);
+                    if (n > 0) x[idx] = (b[idx] * invScale + s) / float(n);
+                }
+            }
+    });
+}
+
+// Cell-centred, factor-2 trilinear prolongation along one axis: fine cell f takes 3/4 of its
+// parent and 1/4 of the parent's neighbour on f's side (clamped at the walls).
+struct Parents { int c[2]; };
+inline Parents parentsOf(int f, int nc)
+{
+    const int p = f >> 1;
+    return { { p, std::clamp((f & 1) ? p + 1 : p - 1, 0, nc - 1) } };
+}
+constexpr float kParentW[2] = { 0.75f, 0.25f };
+
+// Trilinear sample of a grid at index-space point g (clamped to the grid); lo/hi receive the
+// min / max of the 8 corners (MacCormack's limiter bounds).
+float sample(const std::vector<float>& f, const glm::ivec3& d, glm::vec3 g, float* lo = nullptr, float* hi = nullptr)
+{
+    g = glm::clamp(g, glm::vec3(0.0f), glm::vec3(d - 1));
+    const glm::ivec3 i0 = glm::min(glm::ivec3(g), d - 1);
+    const glm::ivec3 i1 = glm::min(i0 + 1, d - 1);
+    const glm::vec3 t = g - glm::vec3(i0);
+    const size_t sy = size_t(d.x), sz = size_t(d.x) * size_t(d.y);
+    const size_t z0 = size_t(i0.z) * sz, z1 = size_t(i1.z) * sz, y0 = size_t(i0.y) * sy, y1 = size_t(i1.y) * sy;
+    const float c000 = f[z0 + y0 + i0.x], c100 = f[z0 + y0 + i1.x];
+    const float c010 = f[z0 + y1 + i0.x], c110 = f[z0 + y1 + i1.x];
+    const float c001 = f[z1 + y0 + i0.x], c101 = f[z1 + y0 + i1.x];
+    const float c011 = f[z1 + y1 + i0.x], c111 = f[z1 + y1 + i1.x];
+    if (lo) {
+        *lo = std::min({ c000, c100, c010, c110, c001, c101, c011, c111 });
+        *hi = std::max({ c000, c100, c010, c110, c001, c101, c011, c111 });
+    }
+    const float x00 = c000 + (c100 - c000) * t.x, x10 = c010 + (c110 - c010) * t.x;
+    const float x01 = c001 + (c101 - c001) * t.x, x11 = c011 + (c111 - c011) * t.x;
+    const float y0v = x00 + (x10 - x00) * t.y, y1v = x01 + (x11 - x01) * t.y;
+    return y0v + (y1v - y0v) * t.z;
+}
+
+} // namespace
+
+SmokeCpuSolver::SmokeCpuSolver() : SmokeCpuSolver(Settings{}) {}
+
+SmokeCpuSolver::SmokeCpuSolver(const Settings& settings) : m_settings(settings)
+{
+    m_settings.dims = glm::max(m_settings.dims, glm::ivec3(1));
+    m_settings.cellSize = std::max(m_settings.cellSize, 1.0e-6f);
+    reset();
+    buildLevels();
+}
+
+krs::par::ThreadPool& SmokeCpuSolver::pool() const
+{
+    return m_pool ? *m_pool : krs::par::ThreadPool::global();
+}
+
+void SmokeCpuSolver::reset()
+{
+    const glm::ivec3 d = m_settings.dims;
+    const size_t cells = cellsOf(d);
+    m_u.assign(cellsOf(d + glm::ivec3(1, 0, 0)), 0.0f);
+    m_v.assign(cellsOf(d + glm::ivec3(0, 1, 0)), 0.0f);
+    m_w.assign(cellsOf(d + glm::ivec3(0, 0, 1)), 0.0f);
+    m_density.assign(cells, 0.0f);
+    m_temperature.assign(cells, 0.0f);
+    m_fuel.assign(cells, 0.0f);
+    m_pressure.assign(cells, 0.0f);
+    m_stats = Stats{};
+    m_stats.levels = int(m_levels.size());
+}
+
+void SmokeCpuSolver::buildLevels()
+{
+    m_levels.clear();
+    Level fine;
+    fine.dims = m_settings.dims;
+    m_levels.push_back(std::move(fine));
+    if (m_settings.pressure != Pressure::Jacobi) {
+        for (;;) {
+            const glm::ivec3 d = m_levels.back().dims;
+            if ((d.x & 1) || (d.y & 1) || (d.z & 1) || std::min({ d.x, d.y, d.z }) < 8) break;
+            Level coarse;
+            coarse.dims = d / 2;
+            coarse.scale = m_levels.back().scale * 0.25f;
+            m_levels.push_back(std::move(coarse));
+        }
+    }
+    for (Level& l : m_levels) {
+        const size_t n = cellsOf(l.dims);
+        l.x.assign(n, 0.0f);
+        l.b.assign(n, 0.0f);
+        l.r.assign(n, 0.0f);
+    }
+    m_stats.levels = int(m_levels.size());
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Step
+// ---------------------------------------------------------------------------------------------------
+void SmokeCpuSolver::step(const Params& params, const std::vector<Emitter>& emitters, float dt)
+{
+    const auto t0 = Clock::now();
+    auto t = t0;
+    emitSources(emitters, dt);
+    m_stats.emitMs = msSince(t);
+
+    t = Clock::now();
+    advectVelocity(dt);
+    m_stats.advectMs = msSince(t);
+
+    t = Clock::now();
+    applyForces(params, dt);
+    combust(params, dt);
+    m_stats.forcesMs = msSince(t);
+
+    t = Clock::now();
+    project();
+    m_stats.pressureMs = msSince(t);
+
+    t = Clock::now();
+    advectScalars(dt);
+    m_stats.advectMs += msSince(t);
+    m_stats.stepMs = msSince(t0);
+}
+
+void SmokeCpuSolver::emitSources(const std::vector<Emitter>& emitters, float dt)
+{
+    if (emitters.empty()) return;
+    const glm::ivec3 d = m_settings.dims;
+    const float h = m_settings.cellSize;
+    // smooth falloff, 1 at the centre -> 0 at the radius (the shader's smoothstep(r, 0, d))
+    auto falloff = [](const Emitter& e, const glm::vec3& p) {
+        const float dist = glm::length(p - e.center);
+        if (dist >= e.radius) return 0.0f;
+        const float s = 1.0f - dist / e.radius;
+        return s * s * (3.0f - 2.0f * s);
+    };
+    forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+        const glm::vec3 p = cellCenter(i, j, k);
+        for (const Emitter& e : emitters) {
+            const float fall = falloff(e, p);
+            if (fall <= 0.0f) continue;
+            m_density[idx] += e.densityRate * fall * dt;
+            m_temperature[idx] = std::max(m_temperature[idx], e.temperature * fall);
+            m_fuel[idx] += e.fuelRate * fall * dt;
+        }
+    });
+    // the upward jet on the interior y faces
+    const glm::ivec3 dv = d + glm::ivec3(0, 1, 0);
+    forCells(pool(), dv, [&](int i, int j, int k, size_t idx) {
+        if (j == 0 || j == d.y) return;
+        const glm::vec3 p = m_settings.origin + glm::vec3(float(i) + 0.5f, float(j), float(k) + 0.5f) * h;
+        for (const Emitter& e : emitters) m_v[idx] += e.jetSpeed * falloff(e, p) * dt;
+    });
+}
+
+glm::vec3 SmokeCpuSolver::velocityAt(const glm::vec3& g) const
+{
+    const glm::ivec3 d = m_settings.dims;
+    return glm::vec3(sample(m_u, d + glm::ivec3(1, 0, 0), g - glm::vec3(0.0f, 0.5f, 0.5f)),
+                     sample(m_v, d + glm::ivec3(0, 1, 0), g - glm::vec3(0.5f, 0.0f, 0.5f)),
+                     sample(m_w, d + glm::ivec3(0, 0, 1), g - glm::vec3(0.5f, 0.5f, 0.0f)));
+}
+
+// Advect `count` fields sharing one grid (dims, sample offset in cells) through the current
+// velocity. Semi-Lagrangian writes straight into dst; MacCormack keeps the forward estimate in
+// m_hat, traces it back the other way and corrects by half the round-trip error.
+void SmokeCpuSolver::advectGrid(const glm::ivec3& dims, const glm::vec3& offset, const Channel* channels, int count,
+                                float dt)
+{
+    const float s = dt / m_settings.cellSize;            // m/s -> cells per step
+    const bool mac = m_settings.advection == Advection::MacCormack;
+    const bool clamp = m_settings.clampMacCormack;
+    const size_t n = cellsOf(dims);
+    auto trace = [&](const glm::vec3& g, float dir) {  // RK2 (midpoint)
+        const glm::vec3 mid = g + (0.5f * dir * s) * velocityAt(g);
+        return g + (dir * s) * velocityAt(mid);
+    };
+    for (int c = 0; c < count; ++c) {
+        channels[c].dst->resize(n);
+        if (mac) { m_hat[c].resize(n); m_lo[c].resize(n); m_hi[c].resize(n); }
+    }
+
+    forCells(pool(), dims, [&](int i, int j, int k, size_t idx) {
+        const glm::vec3 p = trace(glm::vec3(i, j, k) + offset, -1.0f) - offset;
+        for (int c = 0; c < count; ++c) {
+            if (mac) m_hat[c][idx] = sample(*channels[c].src, dims, p, &m_lo[c][idx], &m_hi[c][idx]);
+            else (*channels[c].dst)[idx] = sample(*channels[c].src, dims, p);
+        }
+    });
+    if (!mac) return;
+
+    forCells(pool(), dims, [&](int i, int j, int k, size_t idx) {
+        const glm::vec3 p = trace(glm::vec3(i, j, k) + offset, 1.0f) - offset;
+        for (int c = 0; c < count; ++c) {
+            const float hat = m_hat[c][idx];
+            const float back = sample(m_hat[c], dims, p);
+            float val = hat + 0.5f * ((*channels[c].src)[idx] - back);
+            if (clamp && (val < m_lo[c][idx] || val > m_hi[c][idx])) val = hat;
+            (*channels[c].dst)[idx] = val;
+        }
+    });
+}
+
+void SmokeCpuSolver::advectVelocity(float dt)
+{
+    const glm::ivec3 d = m_settings.dims;
+    // every component traces through the OLD field, so all three land in m_out first
+    const Channel cu{ &m_u, &m_out[0] }, cv{ &m_v, &m_out[1] }, cw{ &m_w, &m_out[2] };
+    advectGrid(d + glm::ivec3(1, 0, 0), glm::vec3(0.0f, 0.5f, 0.5f), &cu, 1, dt);
+    advectGrid(d + glm::ivec3(0, 1, 0), glm::vec3(0.5f, 0.0f, 0.5f), &cv, 1, dt);
+    advectGrid(d + glm::ivec3(0, 0, 1), glm::vec3(0.5f, 0.5f, 0.0f), &cw, 1, dt);
+    m_u.swap(m_out[0]);
+    m_v.swap(m_out[1]);
+    m_w.swap(m_out[2]);
+    enforceWalls();
+}
+
+void SmokeCpuSolver::advectScalars(float dt)
+{
+    const Channel ch[3] = { { &m_density, &m_out[0] }, { &m_temperature, &m_out[1] }, { &m_fuel, &m_out[2] } };
+    advectGrid(m_settings.dims, glm::vec3(0.5f), ch, 3, dt);
+    m_density.swap(m_out[0]);
+    m_temperature.swap(m_out[1]);
+    m_fuel.swap(m_out[2]);
+}
+
+void SmokeCpuSolver::enforceWalls()
+{
+    // free slip: no flow through the six domain faces
+    const glm::ivec3 d = m_settings.dims;
+    forCells(pool(), d + glm::ivec3(1, 0, 0), [&](int i, int, int, size_t idx) { if (i == 0 || i == d.x) m_u[idx] = 0.0f; });
+    forCells(pool(), d + glm::ivec3(0, 1, 0), [&](int, int j, int, size_t idx) { if (j == 0 || j == d.y) m_v[idx] = 0.0f; });
+    forCells(pool(), d + glm::ivec3(0, 0, 1), [&](int, int, int k, size_t idx) { if (k == 0 || k == d.z) m_w[idx] = 0.0f; });
+}
+
+// Vorticity confinement + buoyancy, evaluated at the cell centres like smoke_curl / smoke_forces
+// (grid-difference curl, clamped neighbours) and averaged onto the interior faces.
+void SmokeCpuSolver::applyForces(const Params& params, float dt)
+{
+    const glm::ivec3 d = m_settings.dims;
+    const size_t cells = cellsOf(d);
+    m_cellVel.resize(cells);
+    m_curl.resize(cells);
+    const size_t uy = size_t(d.x) + 1, uz = uy * size_t(d.y);
+    const size_t vy = size_t(d.x), vz = vy * size_t(d.y + 1);
+    const size_t wz = size_t(d.x) * size_t(d.y);
+    forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+        const size_t ui = size_t(k) * uz + size_t(j) * uy + size_t(i);
+        const size_t vi = size_t(k) * vz + size_t(j) * vy + size_t(i);
+        m_cellVel[idx] = 0.5f * glm::vec3(m_u[ui] + m_u[ui + 1], m_v[vi] + m_v[vi + vy], m_w[idx] + m_w[idx + wz]);
+    });
+    auto clampIdx = [&](int i, int j, int k) {
+        return cellIndex(std::clamp(i, 0, d.x - 1), std::clamp(j, 0, d.y - 1), std::clamp(k, 0, d.z - 1));
+    };
+    forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+        const glm::vec3 xp = m_cellVel[clampIdx(i + 1, j, k)], xm = m_cellVel[clampIdx(i - 1, j, k)];
+        const glm::vec3 yp = m_cellVel[clampIdx(i, j + 1, k)], ym = m_cellVel[clampIdx(i, j - 1, k)];
+        const glm::vec3 zp = m_cellVel[clampIdx(i, j, k + 1)], zm = m_cellVel[clampIdx(i, j, k - 1)];
+        m_curl[idx] = 0.5f * glm::vec3((yp.z - ym.z) - (zp.y - zm.y),
+                                       (zp.x - zm.x) - (xp.z - xm.z),
+                                       (xp.y - xm.y) - (yp.x - ym.x));
+    });
+    // cell force (m/s^2), written over m_cellVel (no longer needed)
+    forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+        auto mag = [&](int a, int b, int c) { return glm::length(m_curl[clampIdx(a, b, c)]); };
+        const glm::vec3 gradEta = 0.5f * glm::vec3(mag(i + 1, j, k) - mag(i - 1, j, k),
+                                                   mag(i, j + 1, k) - mag(i, j - 1, k),
+                                                   mag(i, j, k + 1) - mag(i, j, k - 1));
+        const glm::vec3 N = gradEta / (glm::length(gradEta) + 1.0e-5f);
+        glm::vec3 f = params.vorticity * glm::cross(N, m_curl[idx]);
+        f.y += params.buoyancy * (m_temperature[idx] - params.ambientTemperature) - params.densityWeight * m_density[idx];
+        m_cellVel[idx] = f;
+    });
+    forCells(pool(), d + glm::ivec3(1, 0, 0), [&](int i, int j, int k, size_t idx) {
+        if (i > 0 && i < d.x) m_u[idx] += dt * 0.5f * (m_cellVel[cellIndex(i - 1, j, k)].x + m_cellVel[cellIndex(i, j, k)].x);
+    });
+    forCells(pool(), d + glm::ivec3(0, 1, 0), [&](int i, int j, int k, size_t idx) {
+        if (j > 0 && j < d.y) m_v[idx] += dt * 0.5f * (m_cellVel[cellIndex(i, j - 1, k)].y + m_cellVel[cellIndex(i, j, k)].y);
+    });
+    forCells(pool(), d + glm::ivec3(0, 0, 1), [&](int i, int j, int k, size_t idx) {
+        if (k > 0 && k < d.z) m_w[idx] += dt * 0.5f * (m_cellVel[cellIndex(i, j, k - 1)].z + m_cellVel[cellIndex(i, j, k)].z);
+    });
+}
+
+// smoke_combust: fuel -> heat + soot, cooling toward ambient, density fade.
+void SmokeCpuSolver::combust(const Params& params, float dt)
+{
+    const float cool = std::exp(-params.cooling * dt);
+    const float fade = std::exp(-params.densityDissipation * dt);
+    krs::par::parallelFor(pool(), m_density.size(), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            const float burn = std::min(m_fuel[i], params.burnRate * dt);
+            m_fuel[i] -= burn;
+            float t = m_temperature[i] + burn * 5.0f;
+            float r = m_density[i] + burn * 1.6f;
+            t = params.ambientTemperature + (t - params.ambientTemperature) * cool;
+            r *= fade;
+            m_density[i] = std::max(r, 0.0f);
+            m_temperature[i] = std::max(t, 0.0f);
+            m_fuel[i] = std::max(m_fuel[i], 0.0f);
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Pressure
+// ---------------------------------------------------------------------------------------------------
+
+// Net outflow of every cell in m/s (x h = the divergence in 1/s).
+void SmokeCpuSolver::divergence(std::vector<float>& out) const
+{
+    const glm::ivec3 d = m_settings.dims;
+    out.resize(cellsOf(d));
+    const size_t uy = size_t(d.x) + 1, uz = uy * size_t(d.y);
+    const size_t vy = size_t(d.x), vz = vy * size_t(d.y + 1);
+    const size_t wz = size_t(d.x) * size_t(d.y);
+    forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+        const size_t ui = size_t(k) * uz + size_t(j) * uy + size_t(i);
+        const size_t vi = size_t(k) * vz + size_t(j) * vy + size_t(i);
+        out[idx] = (m_u[ui + 1] - m_u[ui]) + (m_v[vi + vy] - m_v[vi]) + (m_w[idx + wz] - m_w[idx]);
+    });
+}
+
+float SmokeCpuSolver::maxDivergence() const
+{
+    std::vector<float> div;
+    divergence(div);
+    return maxAbs(pool(), div) / m_settings.cellSize;
+}
+
+void SmokeCpuSolver::project()
+{
+    const glm::ivec3 d = m_settings.dims;
+    if (m_levels.empty() || m_levels[0].dims != d) buildLevels();
+    m_stats.iterations = 0;
+    m_stats.converged = false;
+
+    // A q = -div; u -= grad q then leaves div' = -(b - A q), the solver's residual.
+    divergence(m_rhs);
+    m_stats.divergenceBefore = maxAbs(pool(), m_rhs) / m_settings.cellSize;
+    removeMean(pool(), m_rhs);          // the all-Neumann system is solvable only for zero net flux
+    krs::par::parallelFor(pool(), m_rhs.size(), kGrain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) m_rhs[i] = -m_rhs[i];
+    });
+    const float bMax = maxAbs(pool(), m_rhs);
+    if (bMax > 0.0f) {
+        switch (m_settings.pressure) {
+        case Pressure::Jacobi:       solveJacobi(bMax); break;
+        case Pressure::Multigrid:    solveMultigrid(bMax); break;
+        case Pressure::MultigridPCG: solvePcg(bMax); break;
+        }
+    } else {
+        m_stats.converged = true;
+    }
+
+    const size_t sy = size_t(d.x), sz = size_t(d.x) * size_t(d.y);
+    const std::vector<float>& q = m_pressure;
+    forCells(pool(), d + glm::ivec3(1, 0, 0), [&](int i, int j, int k, size_t idx) {
+        if (i > 0 && i < d.x) { const size_t c = cellIndex(i, j, k); m_u[idx] -= q[c] - q[c - 1]; }
+    });
+    forCells(pool(), d + glm::ivec3(0, 1, 0), [&](int i, int j, int k, size_t idx) {
+        if (j > 0 && j < d.y) { const size_t c = cellIndex(i, j, k); m_v[idx] -= q[c] - q[c - sy]; }
+    });
+    forCells(pool(), d + glm::ivec3(0, 0, 1), [&](int i, int j, int k, size_t idx) {
+        if (k > 0 && k < d.z) { const size_t c = cellIndex(i, j, k); m_w[idx] -= q[c] - q[c - sz]; }
+    });
+    m_stats.divergenceAfter = maxDivergence();
+}
+
+// The smoke_jacobi sweep, warm started; stops early once the residual meets the tolerance.
+void SmokeCpuSolver::solveJacobi(float bMax)
+{
+    const glm::ivec3 d = m_settings.dims;
+    const float target = m_settings.tolerance * bMax;
+    std::vector<float>& x = m_pressure;
+    std::vector<float>& next = m_pcgQ;
+    std::vector<float>& r = m_pcgR;
+    next.resize(x.size());
+    r.resize(x.size());
+    const int cap = std::max(0, m_settings.jacobiIterations);
+    for (int it = 0; it < cap; ++it) {
+        forCells(pool(), d, [&](int i, int j, int k, size_t idx) {
+            int n;
+            const float s = neighbours(x, d, i, j, k, idx, n);
+            next[idx] = n > 0 ? (m_rhs[idx] + s) / float(n) : 0.0f;
+        });
+        x.swap(next);
+        m_stats.iterations = it + 1;
+        if ((it + 1) % kJacobiCheck == 0 || it + 1 == cap) {
+            residual(pool(), d, 1.0f, x, m_rhs, r);
+            if (maxAbs(pool(), r) <= target) { m_stats.converged = true; return; }
+        }
+    }
+}
+
+// Stationary multigrid: x += V(b - A x) until the residual meets the tolerance.
+void SmokeCpuSolver::solveMultigrid(float bMax)
+{
+    const glm::ivec3 d = m_settings.dims;
+    const float target = m_settings.tolerance * bMax;
+    Level& top = m_levels[0];
+    for (int it = 0; it <= m_settings.maxIterations; ++it) {
+        residual(pool(), d, 1.0f, m_pressure, m_rhs, top.b);
+        if (maxAbs(pool(), top.b) <= target) { m_stats.converged = true; return; }
+        if (it == m_settings.maxIterations) return;
+        vcycle(0);
+        krs::par::parallelFor(pool(), m_pressure.size(), kGrain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) m_pressure[i] += top.x[i];
+        });
+        m_stats.iterations = it + 1;
+    }
+}
+
+// Conjugate gradients preconditioned by one V-cycle (symmetric: red-black pre, black-red post).
+void SmokeCpuSolver::solvePcg(float bMax)
+{
+    const glm::ivec3 d = m_settings.dims;
+    const float target = m_settings.tolerance * bMax;
+    const size_t n = m_pressure.size();
+    std::vector<float>& x = m_pressure;
+    std::vector<float>& r = m_pcgR;
+    std::vector<float>& z = m_pcgZ;
+    std::vector<float>& p = m_pcgP;
+    std::vector<float>& q = m_pcgQ;
+    r.resize(n); z.resize(n); p.resize(n); q.resize(n);
+    Level& top = m_levels[0];
+    auto precondition = [&]() {
+        top.b = r;
+        vcycle(0);
+        z = top.x;
+        removeMean(pool(), z);          // keep the search directions out of the constant null space
+    };
+
+    residual(pool(), d, 1.0f, x, m_rhs, r);
+    if (maxAbs(pool(), r) <= target) { m_stats.converged = true; return; }
+    precondition();
+    p = z;
+    double rz = dot(pool(), r, z);
+    for (int it = 1; it <= m_settings.maxIterations; ++it) {
+        applyA(pool(), d, 1.0f, p, q);
+        const double pq = dot(pool(), p, q);
+        if (!(pq > 0.0)) return;
+        const float alpha = float(rz / pq);
+        krs::par::parallelFor(pool(), n, kGrain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) { x[i] += alpha * p[i]; r[i] -= alpha * q[i]; }
+        });
+        m_stats.iterations = it;
+        if (maxAbs(pool(), r) <= target) { m_stats.converged = true; return; }
+        precondition();
+        const double rzNext = dot(pool(), r, z);
+        const float beta = float(rzNext / rz);
+        rz = rzNext;
+        krs::par::parallelFor(pool(), n, kGrain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) p[i] = z[i] + beta * p[i];
+        });
+    }
+}
+
+// x_l ~= A_l^-1 b_l from a zero guess. Linear and symmetric in b_l, so it is a valid CG preconditioner.
+void SmokeCpuSolver::vcycle(int level)
+{
+    Level& L = m_levels[size_t(level)];
+    std::fill(L.x.begin(), L.x.end(), 0.0f);
+    if (size_t(level) + 1 == m_levels.size()) {
+        const int half = std::max(1, m_settings.coarseSweeps / 2);
+        for (int s = 0; s < half; ++s) { smoothColor(pool(), L.dims, L.scale, L.x, L.b, 0); smoothColor(pool(), L.dims, L.scale, L.x, L.b, 1); }
+        for (int s = 0; s < half; ++s) { smoothColor(pool(), L.dims, L.scale, L.x, L.b, 1); smoothColor(pool(), L.dims, L.scale, L.x, L.b, 0); }
+        return;
+    }
+    for (int s = 0; s < m_settings.smoothSweeps; ++s) {
+        smoothColor(pool(), L.dims, L.scale, L.x, L.b, 0);
+        smoothColor(pool(), L.dims, L.scale, L.x, L.b, 1);
+    }
+    residual(pool(), L.dims, L.scale, L.x, L.b, L.r);
+
+    // restriction = prolongation^T / 8 (keeps the zero net flux of the residual)
+    Level& C = m_levels[size_t(level) + 1];
+    const glm::ivec3 fd = L.dims, cd = C.dims;
+    forCells(pool(), cd, [&](int I, int J, int K, size_t cidx) {
+        int fx[4], fy[4], fz[4];
+        float wx[4], wy[4], wz[4];
+        auto taps = [](int c, int nf, int nc, int* f, float* w) {
+            for (int t = 0; t < 4; ++t) {
+                f[t] = 2 * c - 1 + t;
+                w[t] = 0.0f;
+                if (f[t] < 0 || f[t] >= nf) continue;
+                const Parents pa = parentsOf(f[t], nc);
+                for (int s = 0; s < 2; ++s) if (pa.c[s] == c) w[t] += kParentW[s];
+            }
+        };
+        taps(I, fd.x, cd.x, fx, wx);
+        taps(J, fd.y, cd.y, fy, wy);
+        taps(K, fd.z, cd.z, fz, wz);
+        float sum = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            if (wz[c] == 0.0f) continue;
+            for (int b = 0; b < 4; ++b) {
+                if (wy[b] == 0.0f) continue;
+                const size_t row = (size_t(fz[c]) * fd.y + size_t(fy[b])) * fd.x;
+                const float wzy = wz[c] * wy[b];
+                for (int a = 0; a < 4; ++a)
+                    if (wx[a] != 0.0f) sum += wzy * wx[a] * L.r[row + size_t(fx[a])];
+            }
+        }
+        C.b[cidx] = 0.125f * sum;
+    });
+
+    vcycle(level + 1);
+
+    // trilinear prolongation of the coarse correction
+    forCells(pool(), fd, [&](int i, int j, int k, size_t idx) {
+        const Parents px = parentsOf(i, cd.x), py = parentsOf(j, cd.y), pz = parentsOf(k, cd.z);
+        float e = 0.0f;
+        for (int c = 0; c < 2; ++c)
+            for (int b = 0; b < 2; ++b) {
+                const size_t row = (size_t(pz.c[c]) * cd.y + size_t(py.c[b])) * cd.x;
+                const float wzy = kParentW[c] * kParentW[b];
+                e += wzy * (kParentW[0] * C.x[row + size_t(px.c[0])] + kParentW[1] * C.x[row + size_t(px.c[1])]);
+            }
+        L.x[idx] += e;
+    });
+
+    for (int s = 0; s < m_settings.smoothSweeps; ++s) {
+        smoothColor(pool(), L.dims, L.scale, L.x, L.b, 1);
+        smoothColor(pool(), L.dims, L.scale, L.x, L.b, 0);
+    }
+}
+
+// ===================================================================================================
+// Headless suite. The pressure and advection checks have exact answers on the MAC grid; the plume
+// compares the reference configuration against the GPU path's (semi-Lagrangian + 28 Jacobi sweeps).
+// ===================================================================================================
+namespace {
+
+// Tall axis = n cells over SmokeSystem's default 4 x 6 x 4 m box; the short axes round to multiples of 8.
+SmokeCpuSolver::Settings boxSettings(int n)
+{
+    SmokeCpuSolver::Settings s;
+    n = std::max(16, (n / 8) * 8);
+    const int side = std::max(8, int(std::lround(n * 4.0 / 6.0 / 8.0)) * 8);
+    s.dims = glm::ivec3(side, n, side);
+    s.cellSize = 6.0f / float(n);
+    s.origin = glm::vec3(-0.5f * float(side) * s.cellSize, 0.0f, -0.5f * float(side) * s.cellSize);
+    return s;
+}
+
+// A rising column (the plume's worst case for Jacobi: low-frequency divergence) plus face noise.
+void seedDivergentField(SmokeCpuSolver& s)
+{
+    const glm::ivec3 d = s.dims();
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> noise(-0.2f, 0.2f);
+    const float cx = 0.5f * float(d.x), cz = 0.5f * float(d.z), r = 0.12f * float(d.x);
+    for (int k = 0; k < d.z; ++k)
+        for (int j = 0; j <= d.y; ++j)
+            for (int i = 0; i < d.x; ++i) {
+                const float dx = float(i) + 0.5f - cx, dz = float(k) + 0.5f - cz;
+                const bool column = dx * dx + dz * dz < r * r && j < d.y / 2;
+                s.v()[(size_t(k) * (d.y + 1) + j) * d.x + i] = (j == 0 || j == d.y) ? 0.0f : (column ? 1.5f : 0.0f) + noise(rng);
+            }
+    for (int k = 0; k < d.z; ++k)
+        for (int j = 0; j < d.y; ++j)
+            for (int i = 0; i <= d.x; ++i)
+                s.u()[(size_t(k) * d.y + j) * (d.x + 1) + i] = (i == 0 || i == d.x) ? 0.0f : noise(rng);
+    for (int k = 0; k <= d.z; ++k)
+        for (int j = 0; j < d.y; ++j)
+            for (int i = 0; i < d.x; ++i)
+                s.w()[(size_t(k) * d.y + j) * d.x + i] = (k == 0 || k == d.z) ? 0.0f : noise(rng);
+}
+
+struct SolveRun { int iterations = 0; bool converged = false; float before = 0, after = 0; double ms = 0; };
+
+SolveRun solveOnce(SmokeCpuSolver::Settings st, SmokeCpuSolver::Pressure p, int jacobiCap = 28,
+                   krs::par::ThreadPool* pool = nullptr, std::vector<float>* velocityOut = nullptr)
+{
+    st.pressure = p;
+    st.jacobiIterations = jacobiCap;
+    SmokeCpuSolver s(st);
+    s.setThreadPool(pool);
+    seedDivergentField(s);
+    const auto t0 = Clock::now();
+    s.project();
+    SolveRun r;
+    r.ms = msSince(t0);
+    r.iterations = s.stats().iterations;
+    r.converged = s.stats().converged;
+    r.before = s.stats().divergenceBefore;
+    r.after = s.stats().divergenceAfter;
+    if (velocityOut) { *velocityOut = s.u(); velocityOut->insert(velocityOut->end(), s.v().begin(), s.v().end()); }
+    return r;
+}
+
+} // namespace
+
+bool SmokeCpuSolver::runSelfTests()
+{
+    bool ok = true;
+    auto check = [&](const char* name, bool pass, const char* fmt, double a, double b = 0.0, double c = 0.0) {
+        char detail[200];
+        std::snprintf(detail, sizeof(detail), fmt, a, b, c);
+        std::fprintf(stderr, "[SMOKE-CPU] %-44s %s  (%s)\n", name, pass ? "PASS" : "FAIL", detail);
+        ok = ok && pass;
+    };
+    std::fprintf(stderr, "[SMOKE-CPU] === CPU smoke reference (MacCormack + multigrid pressure) ===\n");
+
+    int gridN = 96;
+    if (const char* e = std::getenv("KRS_SMOKE_CPU_GRID")) gridN = std::clamp(std::atoi(e), 16, 256);
+    const Settings box = boxSettings(gridN);
+    const float tol = box.tolerance;
+
+    // 1. Pressure: one cold solve of a rising column + noise. The divergence left on the faces is
+    //    measured independently of the solver and must be the tolerance the solver claims.
+    {
+        const SolveRun mgpcg = solveOnce(box, Pressure::MultigridPCG);
+        const SolveRun mg = solveOnce(box, Pressure::Multigrid);
+        const SolveRun jac28 = solveOnce(box, Pressure::Jacobi, 28);
+        const int jacobiCap = 4000;
+        const SolveRun jacTol = solveOnce(box, Pressure::Jacobi, jacobiCap);
+        std::fprintf(stderr, "[SMOKE-CPU]     grid %dx%dx%d, %d MG levels, max|div| %.3f 1/s, tolerance %.0e of it\n",
+                     box.dims.x, box.dims.y, box.dims.z, SmokeCpuSolver(box).stats().levels, mgpcg.before, double(tol));
+        std::fprintf(stderr, "[SMOKE-CPU]     MG-PCG      %4d iterations %8.1f ms  -> max|div| %.2e (%.1e of start)\n",
+                     mgpcg.iterations, mgpcg.ms, mgpcg.after, mgpcg.after / mgpcg.before);
+        std::fprintf(stderr, "[SMOKE-CPU]     V-cycles    %4d iterations %8.1f ms  -> max|div| %.2e (%.1e of start)\n",
+                     mg.iterations, mg.ms, mg.after, mg.after / mg.before);
+        std::fprintf(stderr, "[SMOKE-CPU]     Jacobi x28  %4d sweeps     %8.1f ms  -> max|div| %.2e (%.1e of start)\n",
+                     jac28.iterations, jac28.ms, jac28.after, jac28.after / jac28.before);
+        std::fprintf(stderr, "[SMOKE-CPU]     Jacobi      %4d sweeps     %8.1f ms  -> max|div| %.2e (%.1e of start)%s\n",
+                     jacTol.iterations, jacTol.ms, jacTol.after, jacTol.after / jacTol.before,
+                     jacTol.converged ? "" : "  tolerance NOT reached");
+        const float slack = 1.05f;   // float rounding between the recursive and the measured residual
+        check("MG-PCG reaches tolerance", mgpcg.converged && mgpcg.after <= slack * tol * mgpcg.before,
+              "%.0f iterations, left %.2e of start", mgpcg.iterations, mgpcg.after / mgpcg.before);
+        check("V-cycles reach tolerance", mg.converged && mg.after <= slack * tol * mg.before,
+              "%.0f V-cycles, left %.2e of start", mg.iterations, mg.after / mg.before);
+        check("MG-PCG: far fewer iterations than Jacobi", mgpcg.iterations * 20 < jacTol.iterations,
+              "%.0f vs %.0f Jacobi sweeps", mgpcg.iterations, jacTol.iterations);
+        check("MG-PCG faster to tolerance than Jacobi", mgpcg.ms < jacTol.ms, "%.1f ms vs %.1f ms", mgpcg.ms, jacTol.ms);
+        // NEG-CTRL: the same measurement must see what 28 sweeps leave behind.
+        check("NEG-CTRL Jacobi x28 divergence is caught", jac28.after > 100.0f * tol * jac28.before,
+              "left %.2e of start (> 100 x tolerance)", jac28.after / jac28.before);
+    }
+
+    // 2. Thread-count independence of the whole solve (fixed-chunk reductions).
+    {
+        Settings small = boxSettings(48);
+        krs::par::ThreadPool one(1), four(4);
+        std::vector<float> a, b;
+        solveOnce(small, Pressure::MultigridPCG, 28, &one, &a);
+        solveOnce(small, Pressure::MultigridPCG, 28, &four, &b);
+        const bool same = a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+        check("MG-PCG: 1 vs 4 threads bit-identical", same, "%.0f face velocities", double(a.size()));
+    }
+
+    // 3. Advection: a sharp-edged disc carried once around by solid-body rotation (no projection).
+    //    The exact answer is the start; MacCormack must beat semi-Lagrangian and, clamped, add no
+    //    extrema. NEG-CTRL: the unclamped scheme over/undershoots at the edge.
+    {
+        struct AdvRun { double l1 = 0, peak = 0, lo = 0, hi = 0; };
+        auto rotate = [](Advection scheme, bool clampMc) {
+            Settings st;
+            st.dims = glm::ivec3(64, 4, 64);
+            st.cellSize = 1.0f;
+            st.origin = glm::vec3(0.0f);
+            st.advection = scheme;
+            st.clampMacCormack = clampMc;
+            SmokeCpuSolver s(st);
+            const glm::ivec3 d = st.dims;
+            const float omega = 2.0f * 3.14159265f / 400.0f;   // one turn in 400 unit steps
+            for (int k = 0; k < d.z; ++k)
+                for (int j = 0; j < d.y; ++j)
+                    for (int i = 0; i <= d.x; ++i)
+                        s.u()[(size_t(k) * d.y + j) * (d.x + 1) + i] = -omega * (float(k) + 0.5f - 32.0f);
+            for (int k = 0; k <= d.z; ++k)
+                for (int j = 0; j < d.y; ++j)
+                    for (int i = 0; i < d.x; ++i)
+                        s.w()[(size_t(k) * d.y + j) * d.x + i] = omega * (float(i) + 0.5f - 32.0f);
+            std::vector<float> start(s.density().size(), 0.0f);
+            for (int k = 0; k < d.z; ++k)
+                for (int j = 0; j < d.y; ++j)
+                    for (int i = 0; i < d.x; ++i) {
+                        const float dx = float(i) + 0.5f - 46.0f, dz = float(k) + 0.5f - 32.0f;
+                        start[s.cellIndex(i, j, k)] = dx * dx + dz * dz < 64.0f ? 1.0f : 0.0f;
+                    }
+            s.density() = start;
+            for (int t = 0; t < 400; ++t) s.advectScalars(1.0f);
+            AdvRun r;
+            double mass = 0.0;
+            r.lo = 1e9; r.hi = -1e9;
+            for (size_t c = 0; c < start.size(); ++c) {
+                const double v = s.density()[c];
+                r.l1 += std::fabs(v - start[c]);
+                mass += start[c];
+                r.peak = std::max(r.peak, v);
+                r.lo = std::min(r.lo, v);
+                r.hi = std::max(r.hi, v);
+            }
+            r.l1 /= mass;
+            return r;
+        };
+        const AdvRun sl = rotate(Advection::SemiLagrangian, true);
+        const AdvRun mc = rotate(Advection::MacCormack, true);
+        const AdvRun raw = rotate(Advection::MacCormack, false);
+        std::fprintf(stderr, "[SMOKE-CPU]     one rotation of a radius-8 disc: L1 error SL %.3f, MacCormack %.3f; "
+                     "peak SL %.3f, MacCormack %.3f\n", sl.l1, mc.l1, sl.peak, mc.peak);
+        check("MacCormack error < semi-Lagrangian", mc.l1 < 0.8 * sl.l1, "L1 %.3f vs %.3f", mc.l1, sl.l1);
+        check("clamped MacCormack adds no extrema", mc.lo >= -1e-6 && mc.hi <= 1.0 + 1e-6,
+              "range [%.2e, %.6f]", mc.lo, mc.hi);
+        check("NEG-CTRL unclamped MacCormack overshoots", raw.lo < -1e-3 || raw.hi > 1.0 + 1e-3,
+              "range [%.3f, %.3f]", raw.lo, raw.hi);
+    }
+
+    // 4. Plume: the full step, GPU-path configuration vs the reference, timed per step.
+    {
+        struct PlumeRun { double stepMs = 0, advectMs = 0, pressureMs = 0, iters = 0; float maxAfter = 0; double riseY = 0; bool finite = true; int converged = 0; };
+        const int steps = 36;
+        const float dt = 1.0f / 60.0f;
+        auto plume = [&](Advection adv, Pressure prs) {
+            Settings st = box;
+            st.advection = adv;
+            st.pressure = prs;
+            SmokeCpuSolver s(st);
+            Emitter e;
+            e.center = glm::vec3(0.0f, 0.6f, 0.0f);
+            e.radius = 0.35f;
+            const std::vector<Emitter> emitters{ e };
+            PlumeRun r;
+            for (int t = 0; t < steps; ++t) {
+                s.step(Params{}, emitters, dt);
+                r.stepMs += s.stats().stepMs;
+                r.advectMs += s.stats().advectMs;
+                r.pressureMs += s.stats().pressureMs;
+                r.iters += s.stats().iterations;
+                r.converged += s.stats().converged;
+                if (t >= steps / 2) r.maxAfter = std::max(r.maxAfter, s.stats().divergenceAfter);
+            }
+            r.stepMs /= steps; r.advectMs /= steps; r.pressureMs /= steps; r.iters /= steps;
+            double m = 0.0, my = 0.0;
+            const glm::ivec3 d = s.dims();
+            for (int k = 0; k < d.z; ++k)
+                for (int j = 0; j < d.y; ++j)
+                    for (int i = 0; i < d.x; ++i) {
+                        const double v = s.density()[s.cellIndex(i, j, k)];
+                        if (!std::isfinite(v)) r.finite = false;
+                        m += v;
+                        my += v * s.cellCenter(i, j, k).y;
+                    }
+            r.riseY = m > 0.0 ? my / m - e.center.y : 0.0;
+            return r;
+        };
+        const PlumeRun gpu = plume(Advection::SemiLagrangian, Pressure::Jacobi);
+        const PlumeRun ref = plume(Advection::MacCormack, Pressure::MultigridPCG);
+        std::fprintf(stderr, "[SMOKE-CPU]     plume %d steps, %dx%dx%d, 1 emitter, %u threads:\n",
+                     steps, box.dims.x, box.dims.y, box.dims.z, krs::par::ThreadPool::global().size());
+        std::fprintf(stderr, "[SMOKE-CPU]       SL + Jacobi x28   %7.1f ms/step (advect %6.1f, pressure %6.1f, %4.1f sweeps) "
+                     "max|div| %.2e 1/s, rise %.3f m\n", gpu.stepMs, gpu.advectMs, gpu.pressureMs, gpu.iters, gpu.maxAfter, gpu.riseY);
+        std::fprintf(stderr, "[SMOKE-CPU]       MacCormack+MG-PCG %7.1f ms/step (advect %6.1f, pressure %6.1f, %4.1f iters)  "
+                     "max|div| %.2e 1/s, rise %.3f m\n", ref.stepMs, ref.advectMs, ref.pressureMs, ref.iters, ref.maxAfter, ref.riseY);
+        check("plume rises, fields finite", gpu.finite && ref.finite && gpu.riseY > 0.02 && ref.riseY > 0.02,
+              "rise %.3f / %.3f m", gpu.riseY, ref.riseY);
+        check("reference converges every step", ref.converged == steps,
+              "%.0f steps; max|div| %.2e vs x28's %.2e 1/s", ref.converged, ref.maxAfter, gpu.maxAfter);
+        std::fprintf(stderr, "[SMOKE-CPU]       (x28 reached the tolerance on %d/%d steps; max|div| %.2e 1/s)\n",
+                     gpu.converged, steps, gpu.maxAfter);
+    }
+
+    std::fprintf(stderr, "[SMOKE-CPU] overall: %s\n", ok ? "ALL PASS" : "FAILURES PRESENT");
+    return ok;
+}
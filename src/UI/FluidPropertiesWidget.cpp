@@ -12,6 +12,8 @@
 #include <QComboBox>
 #include <QDebug>
 #include <QDoubleSpinBox>
+#include <QFileDialog>
+#include <QFutureWatcher>
 #include <QSpinBox>
 #include <QPushButton>
 #include <QSlider>
@@ -20,6 +22,7 @@
 #include <QColorDialog>
 #include <QScrollArea>
 #include <QTimer>
+#include <QtConcurrent>
 
 #include <algorithm>
 
@@ -314,6 +317,12 @@ FluidPropertiesWidget::FluidPropertiesWidget(RenderingSystem* renderer, QWidget*
             "(OpenVDB level set). View-independent, film-quality stills —\n"
             "blocks the UI for a few seconds on large frames."));
         g->addWidget(m_meshFrame, 4, 0, 1, 2);
+
+        m_meshSequence = new QPushButton(QStringLiteral("Export mesh sequence…"), box);
+        m_meshSequence->setToolTip(QStringLiteral(
+            "Mesh every baked frame to frame_NNNNN.obj in a folder. Frames are\n"
+            "spread over all cores; only regions that moved are re-meshed."));
+        g->addWidget(m_meshSequence, 5, 0, 1, 2);
         layout->addWidget(box);
     }
 
@@ -379,6 +388,44 @@ FluidPropertiesWidget::FluidPropertiesWidget(RenderingSystem* renderer, QWidget*
                                  .arg(vertCount)
                                  .arg(triCount));
     });
+    connect(m_meshSequence, &QPushButton::clicked, this, [this]() {
+        FluidSystem* fluid = m_renderer ? m_renderer->getFluidSystem() : nullptr;
+        if (!fluid) return;
+        if (fluid->cache().frameCount() <= 0) {
+            m_cacheInfo->setText(QStringLiteral("No baked frames to mesh — record first"));
+            return;
+        }
+        const QString dir = QFileDialog::getExistingDirectory(this, QStringLiteral("Export mesh sequence to"));
+        if (dir.isEmpty()) return;
+        m_cacheInfo->setText(QStringLiteral("Meshing %1 frames…").arg(fluid->cache().frameCount()));
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        m_meshSequence->setEnabled(false);
+        // Mesh on a worker so the UI keeps painting. It reads through its own
+        // FluidCache on the bake directory: the widget's cache is refreshed and
+        // scrubbed on this thread meanwhile.
+        using Result = std::pair<bool, krs::FluidSequenceMesher::Stats>;
+        auto* watcher = new QFutureWatcher<Result>(this);
+        connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+            const Result r = watcher->result();
+            watcher->deleteLater();
+            QApplication::restoreOverrideCursor();
+            m_meshSequence->setEnabled(true);
+            m_cacheInfo->setText(r.first ? QStringLiteral("Exported %1 meshes (%2 frames/s, %3 threads)")
+                                               .arg(r.second.frames)
+                                               .arg(r.second.framesPerSec(), 0, 'f', 1)
+                                               .arg(r.second.threads)
+                                         : QStringLiteral("Mesh sequence export failed"));
+        });
+        const QString bakeDir = fluid->cache().directory();
+        const float radius = fluid->params().particleRadius;
+        watcher->setFuture(QtConcurrent::run([bakeDir, dir, radius]() {
+            FluidCache cache;
+            cache.setDirectory(bakeDir);
+            Result r;
+            r.first = krs::exportFluidMeshSequence(cache, dir, radius, &r.second);
+            return r;
+        }));
+    });
     auto* cacheTimer = new QTimer(this);
     connect(cacheTimer, &QTimer::timeout, this, [this]() {
         FluidSystem* fluid = m_renderer ? m_renderer->getFluidSystem() : nullptr;
@@ -387,9 +434,11 @@ FluidPropertiesWidget::FluidPropertiesWidget(RenderingSystem* renderer, QWidget*
         const int n = fluid->cache().frameCount();
         if (n != m_scrubSlider->maximum() + 1) {
             m_scrubSlider->setRange(0, std::max(0, n - 1));
-            m_cacheInfo->setText(n > 0
-                ? QStringLiteral("%1 baked frames — scrub to replay").arg(n)
-                : QStringLiteral("no baked frames"));
+            const double ratio = fluid->cache().stats().ratio();
+            m_cacheInfo->setText(n <= 0 ? QStringLiteral("no baked frames")
+                : ratio > 0.0 ? QStringLiteral("%1 baked frames (%2x packed) — scrub to replay")
+                                    .arg(n).arg(ratio, 0, 'f', 1)
+                              : QStringLiteral("%1 baked frames — scrub to replay").arg(n));
         }
     });
     cacheTimer->start(500);
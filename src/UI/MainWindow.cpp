@@ -334,6 +334,11 @@ MainWindow::MainWindow(QWidget* parent)
     // speculative collision cooks, which need the PhysX core (created
     // eagerly in the SimulationController constructor).
     m_simulation = std::make_unique<SimulationController>(m_scene.get(), this);
+    // Physics on its own fixed-rate thread (HIL timing survives UI stalls). KRS_SIM_THREAD=0/1
+    // overrides; on by default when a HIL CAN bus is attached.
+    m_simulation->setThreaded(qEnvironmentVariableIsSet("KRS_SIM_THREAD")
+                                  ? qEnvironmentVariableIntValue("KRS_SIM_THREAD") != 0
+                                  : qEnvironmentVariableIsSet("KRS_HIL_CAN"));
 
     // Phase V: the visibly-articulating FANUC is the DEFAULT boot scene (ROADMAP R) --
     // built through the SAME krs::fanuc helper the V-assign / V.2 / V.6 gates validate.
@@ -1,11 +1,15 @@
 #include "CollisionCookingService.hpp"
 #include "VhacdDecomposer.hpp"
+#include "HullSet.hpp"
 #include "components.hpp"
 
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
 
 #include <algorithm>
+#include <cstring>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,10 +33,35 @@ inline uint64_t fnv1a(const void* data, size_t bytes, uint64_t seed = 1469598103
     return h;
 }
 
+// Bump when the cooking recipe changes in a way the parameter blocks below
+// do not capture (subsampling rule, V-HACD settings source, stream layout):
+// it retires every disk-cache entry written by older builds.
+constexpr uint32_t kCookRecipe = 1;
+
+// V-HACD settings the decomposition path uses (krs::decomposeMesh defaults).
+constexpr int kDecompMaxHulls = 16;
+constexpr int kDecompVoxelResolution = 100000;
+constexpr int kDecompMaxVertsPerHull = 64;
+constexpr int kHullVertexLimit = 64;
+constexpr size_t kHullSampleTarget = 2048; // dense inputs are subsampled to ~this many points
+
+int cookThreadCount()
+{
+    const int env = qEnvironmentVariableIntValue("KRS_COOK_THREADS");
+    return env > 0 ? env : std::max(1, QThread::idealThreadCount());
+}
+
 } // namespace
 
 struct CollisionCookingService::Impl
 {
+    // Cooked streams persisted across launches (PhysX-independent, so the
+    // stats accessor works in every build).
+    CookedMeshCache disk;
+    // Bounded worker pool for cooks: a scene load that requests hundreds of
+    // meshes queues them instead of spawning a thread per mesh.
+    QThreadPool pool;
+
 #if defined(KR_WITH_PHYSX)
     PxPhysics* physics = nullptr;
 
@@ -45,14 +74,82 @@ struct CollisionCookingService::Impl
     // the mesh's lifetime; shared across all instances of the geometry).
     std::unordered_map<const void*, std::shared_ptr<const std::vector<glm::vec3>>> edgeCache;
 
+    template <typename T, typename Fn>
+    std::shared_future<T> submit(Fn fn)
+    {
+        auto task = std::make_shared<std::packaged_task<T()>>(std::move(fn));
+        std::shared_future<T> fut = task->get_future().share();
+        pool.start([task]() { (*task)(); });
+        return fut;
+    }
+
+    static bool weldEnabled() { return !qEnvironmentVariableIsSet("KRS_NO_WELD"); }
+
+    /// Disk key of a cooked result: geometry + everything that shapes the
+    /// cooked bytes + the PhysX version that wrote them. Hull sets are plain
+    /// V-HACD output, so they survive an SDK update.
+    static uint64_t diskKey(uint64_t geometryHash, CookedMeshCache::Kind kind)
+    {
+        uint32_t p[8] = { kCookRecipe, uint32_t(kind), 0, 0, 0, 0, 0, 0 };
+        switch (kind) {
+        case CookedMeshCache::Kind::TriangleMesh:
+            p[2] = weldEnabled() ? 1u : 0u;
+            break;
+        case CookedMeshCache::Kind::ConvexHull:
+            p[2] = kHullVertexLimit;
+            p[3] = uint32_t(kHullSampleTarget);
+            break;
+        case CookedMeshCache::Kind::Decomposition:
+            p[2] = kHullVertexLimit;
+            p[3] = kDecompMaxHulls;
+            p[4] = kDecompVoxelResolution;
+            p[5] = kDecompMaxVertsPerHull;
+            break;
+        case CookedMeshCache::Kind::HullSet:
+            p[2] = kDecompMaxHulls;
+            p[3] = kDecompVoxelResolution;
+            p[4] = kDecompMaxVertsPerHull;
+            break;
+        case CookedMeshCache::Kind::Sdf:        // SdfBaker keys its own entries
+            break;
+        }
+        const uint32_t version = kind == CookedMeshCache::Kind::HullSet ? 0u : uint32_t(PX_PHYSICS_VERSION);
+        return CookedMeshCache::key(geometryHash, kind, CookedMeshCache::hash(p, sizeof(p)), version);
+    }
+
+    PxTriangleMesh* createTriangleMesh(const void* data, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(creationMutex);
+        if (!physics) return nullptr;
+        PxDefaultMemoryInputData in(static_cast<PxU8*>(const_cast<void*>(data)), PxU32(bytes));
+        return physics->createTriangleMesh(in);
+    }
+
+    PxConvexMesh* createConvexMesh(const void* data, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(creationMutex);
+        if (!physics) return nullptr;
+        PxDefaultMemoryInputData in(static_cast<PxU8*>(const_cast<void*>(data)), PxU32(bytes));
+        return physics->createConvexMesh(in);
+    }
+
     PxTriangleMesh* cookTriangleMesh(std::vector<PxVec3> points,
                                      std::vector<uint32_t> indices,
-                                     std::string name)
+                                     std::string name, uint64_t key)
     {
         if (points.empty() || indices.size() < 3) return nullptr;
         QElapsedTimer timer;
         timer.start();
 
+        if (auto blob = disk.load(CookedMeshCache::Kind::TriangleMesh, key)) {
+            if (PxTriangleMesh* mesh = createTriangleMesh(blob->data(), blob->size())) {
+                qInfo().nospace() << "[Cook] trimesh '" << name.c_str() << "': "
+                                  << mesh->getNbTriangles() << " tris from disk cache in "
+                                  << timer.elapsed() << " ms";
+                return mesh;
+            }
+        }
+
         PxTriangleMeshDesc desc;
         desc.points.count = static_cast<PxU32>(points.size());
         desc.points.stride = sizeof(PxVec3);
@@ -64,21 +161,19 @@ struct CollisionCookingService::Impl
         PxCookingParams params{ PxTolerancesScale{} };
         // Imported meshes often arrive as disjoint triangle soups; welding
         // removes the spurious internal edges that cause contact noise.
-        if (!qEnvironmentVariableIsSet("KRS_NO_WELD")) {
+        if (weldEnabled()) {
             params.meshWeldTolerance = 1e-4f;
             params.meshPreprocessParams = PxMeshPreprocessingFlag::eWELD_VERTICES;
         }
 
-        // Cook + insert directly (same path the convex cooking has always
-        // used); creation is serialized because PxPhysics insertion is the
-        // shared resource.
-        PxTriangleMesh* mesh = nullptr;
+        // Cook to a stream on this worker (concurrent with other cooks), keep
+        // the stream for the next launch, then insert under the creation lock.
+        PxDefaultMemoryOutputStream out;
         PxTriangleMeshCookingResult::Enum result = PxTriangleMeshCookingResult::eSUCCESS;
-        {
-            std::lock_guard<std::mutex> lock(creationMutex);
-            if (physics)
-                mesh = PxCreateTriangleMesh(params, desc,
-                                            physics->getPhysicsInsertionCallback(), &result);
+        PxTriangleMesh* mesh = nullptr;
+        if (PxCookTriangleMesh(params, desc, out, &result)) {
+            disk.store(CookedMeshCache::Kind::TriangleMesh, key, out.getData(), out.getSize());
+            mesh = createTriangleMesh(out.getData(), out.getSize());
         }
         if (!mesh) {
             qWarning() << "[Cook] trimesh cooking FAILED for" << name.c_str()
@@ -86,73 +181,150 @@ struct CollisionCookingService::Impl
                        << int(result) << ")";
             return nullptr;
         }
-        if (mesh)
-            qInfo().nospace() << "[Cook] trimesh '" << name.c_str() << "': "
-                              << points.size() << " verts -> " << mesh->getNbTriangles()
-                              << " tris in " << timer.elapsed() << " ms";
+        qInfo().nospace() << "[Cook] trimesh '" << name.c_str() << "': "
+                          << points.size() << " verts -> " << mesh->getNbTriangles()
+                          << " tris in " << timer.elapsed() << " ms";
         return mesh;
     }
 
-    /// Cook hull points without subsampling (V-HACD hulls are already ≤64).
-    PxConvexMesh* cookConvexPoints(const std::vector<glm::vec3>& pts)
+    /// Cook a point cloud to a convex stream (vertex-limited, quantized).
+    static bool cookConvexStream(const std::vector<PxVec3>& points, PxDefaultMemoryOutputStream& out)
     {
-        if (pts.size() < 4) return nullptr;
-        std::vector<PxVec3> points;
-        points.reserve(pts.size());
-        for (const auto& p : pts) points.emplace_back(p.x, p.y, p.z);
-
         PxConvexMeshDesc desc;
         desc.points.count = static_cast<PxU32>(points.size());
         desc.points.stride = sizeof(PxVec3);
         desc.points.data = points.data();
         desc.flags = PxConvexFlag::eCOMPUTE_CONVEX | PxConvexFlag::eQUANTIZE_INPUT;
-        desc.vertexLimit = 64;
+        desc.vertexLimit = kHullVertexLimit;
 
         PxCookingParams params{ PxTolerancesScale{} };
-        PxDefaultMemoryOutputStream out;
-        if (!PxCookConvexMesh(params, desc, out)) return nullptr;
-
-        std::lock_guard<std::mutex> lock(creationMutex);
-        if (!physics) return nullptr;
-        PxDefaultMemoryInputData in(out.getData(), out.getSize());
-        return physics->createConvexMesh(in);
+        return PxCookConvexMesh(params, desc, out);
     }
 
-    PxConvexMesh* cookConvexHull(std::vector<PxVec3> points, std::string name)
+    PxConvexMesh* cookConvexHull(std::vector<PxVec3> points, std::string name, uint64_t key)
     {
         if (points.size() < 4) return nullptr;
         QElapsedTimer timer;
         timer.start();
 
-        PxConvexMeshDesc desc;
-        desc.points.count = static_cast<PxU32>(points.size());
-        desc.points.stride = sizeof(PxVec3);
-        desc.points.data = points.data();
-        desc.flags = PxConvexFlag::eCOMPUTE_CONVEX | PxConvexFlag::eQUANTIZE_INPUT;
-        desc.vertexLimit = 64;
+        if (auto blob = disk.load(CookedMeshCache::Kind::ConvexHull, key)) {
+            if (PxConvexMesh* mesh = createConvexMesh(blob->data(), blob->size())) {
+                qInfo().nospace() << "[Cook] hull '" << name.c_str() << "': "
+                                  << mesh->getNbVertices() << " hull verts from disk cache in "
+                                  << timer.elapsed() << " ms";
+                return mesh;
+            }
+        }
 
-        PxCookingParams params{ PxTolerancesScale{} };
         PxDefaultMemoryOutputStream out;
-        if (!PxCookConvexMesh(params, desc, out)) {
+        if (!cookConvexStream(points, out)) {
             qWarning() << "[Cook] convex cooking FAILED for" << name.c_str()
                        << "(" << points.size() << "points )";
             return nullptr;
         }
+        disk.store(CookedMeshCache::Kind::ConvexHull, key, out.getData(), out.getSize());
 
-        PxConvexMesh* mesh = nullptr;
-        {
-            std::lock_guard<std::mutex> lock(creationMutex);
-            if (physics) {
-                PxDefaultMemoryInputData in(out.getData(), out.getSize());
-                mesh = physics->createConvexMesh(in);
-            }
-        }
+        PxConvexMesh* mesh = createConvexMesh(out.getData(), out.getSize());
         if (mesh)
             qInfo().nospace() << "[Cook] hull '" << name.c_str() << "': "
                               << points.size() << " points -> " << mesh->getNbVertices()
                               << " hull verts in " << timer.elapsed() << " ms";
         return mesh;
     }
+
+    /// Decomposition entry: [u32 hulls][u64 bytes per hull][hull streams].
+    std::vector<PxConvexMesh*> loadDecomposition(const CookedMeshCache::Blob& blob)
+    {
+        std::vector<PxConvexMesh*> hulls;
+        const unsigned char* p = blob.data();
+        const size_t size = blob.size();
+        uint32_t count = 0;
+        if (size < sizeof(count)) return hulls;
+        std::memcpy(&count, p, sizeof(count));
+        size_t offset = sizeof(count) + size_t(count) * sizeof(uint64_t);
+        if (count == 0 || offset > size) return hulls;
+        for (uint32_t h = 0; h < count; ++h) {
+            uint64_t bytes = 0;
+            std::memcpy(&bytes, p + sizeof(count) + h * sizeof(uint64_t), sizeof(bytes));
+            PxConvexMesh* mesh = bytes <= size - offset ? createConvexMesh(p + offset, size_t(bytes)) : nullptr;
+            if (!mesh) { // inconsistent entry: drop what was created and re-cook
+                for (PxConvexMesh* m : hulls) m->release();
+                hulls.clear();
+                return hulls;
+            }
+            hulls.push_back(mesh);
+            offset += size_t(bytes);
+        }
+        return hulls;
+    }
+
+    std::vector<PxConvexMesh*> cookDecomposition(const std::vector<Vertex>& verts,
+                                                 const std::vector<unsigned int>& idx,
+                                                 const std::string& name, uint64_t key, uint64_t hullKey)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        if (auto blob = disk.load(CookedMeshCache::Kind::Decomposition, key)) {
+            std::vector<PxConvexMesh*> cooked = loadDecomposition(*blob);
+            if (!cooked.empty()) {
+                qInfo().nospace() << "[Cook] decomposition '" << name.c_str() << "': "
+                                  << cooked.size() << " hulls from disk cache in "
+                                  << timer.elapsed() << " ms";
+                return cooked;
+            }
+        }
+
+        // The V-HACD pass is the expensive half; its hulls have their own
+        // entry, so a PhysX update (new cooked-stream key) re-cooks from the
+        // stored hull points instead of decomposing again.
+        krs::HullSet hullSet;
+        bool decomposed = false;
+        if (auto blob = disk.load(CookedMeshCache::Kind::HullSet, hullKey)) {
+            const unsigned char* bytes = blob->data();
+            const size_t size = blob->size();
+            hullSet.view(std::move(blob), bytes, size);
+        }
+        if (hullSet.empty()) {
+            auto bytes = std::make_shared<std::vector<unsigned char>>(krs::HullSet::encode(
+                krs::decomposeMesh(verts, idx, kDecompMaxHulls, kDecompVoxelResolution, kDecompMaxVertsPerHull)));
+            if (hullSet.view(bytes, bytes->data(), bytes->size()))
+                disk.store(CookedMeshCache::Kind::HullSet, hullKey, bytes->data(), bytes->size());
+            decomposed = true;
+        }
+
+        // Streams are heap-held: PxDefaultMemoryOutputStream owns its buffer
+        // and must not be copied by a growing vector.
+        std::vector<PxConvexMesh*> cooked;
+        std::vector<std::unique_ptr<PxDefaultMemoryOutputStream>> streams;
+        for (const krs::HullSet::Part& hull : hullSet.parts()) {
+            if (hull.count < 4) continue; // V-HACD hulls are already <= 64 points
+            std::vector<PxVec3> points;
+            points.reserve(hull.count);
+            for (uint32_t i = 0; i < hull.count; ++i) points.emplace_back(hull.points[i].x, hull.points[i].y, hull.points[i].z);
+            auto out = std::make_unique<PxDefaultMemoryOutputStream>();
+            if (!cookConvexStream(points, *out)) continue;
+            if (PxConvexMesh* m = createConvexMesh(out->getData(), out->getSize())) {
+                cooked.push_back(m);
+                streams.push_back(std::move(out));
+            }
+        }
+
+        if (!streams.empty()) {
+            const uint32_t count = uint32_t(streams.size());
+            std::vector<unsigned char> payload(sizeof(count) + count * sizeof(uint64_t));
+            std::memcpy(payload.data(), &count, sizeof(count));
+            for (uint32_t h = 0; h < count; ++h) {
+                const uint64_t bytes = streams[h]->getSize();
+                std::memcpy(payload.data() + sizeof(count) + h * sizeof(uint64_t), &bytes, sizeof(bytes));
+                payload.insert(payload.end(), streams[h]->getData(), streams[h]->getData() + bytes);
+            }
+            disk.store(CookedMeshCache::Kind::Decomposition, key, payload.data(), payload.size());
+        }
+        qInfo().nospace() << "[Cook] decomposition '" << name.c_str() << "': " << cooked.size()
+                          << " hulls cooked" << (decomposed ? "" : " from cached hull points") << " in "
+                          << timer.elapsed() << " ms";
+        return cooked;
+    }
 #endif
 };
 
@@ -193,6 +365,8 @@ CollisionCookingService::~CollisionCookingService() { delete m_impl; }
 
 void CollisionCookingService::initialize(physx::PxPhysics* physics)
 {
+    m_impl->pool.setMaxThreadCount(cookThreadCount());
+    m_impl->disk.setDirectory(CookedMeshCache::defaultDirectory());
 #if defined(KR_WITH_PHYSX)
     m_impl->physics = physics;
 #else
@@ -231,12 +405,24 @@ void CollisionCookingService::shutdown()
         if (fut.valid())
             for (PxConvexMesh* m : fut.get())
                 if (m) m->release();
+    m_impl->pool.waitForDone();
     {
         std::lock_guard<std::mutex> lock(m_impl->cacheMutex);
         m_impl->edgeCache.clear(); // keys dangle once the meshes are released
     }
     m_impl->physics = nullptr;
 #endif
+    const CookedMeshCache::Stats s = m_impl->disk.stats();
+    if (s.hits + s.misses > 0)
+        qInfo().nospace() << "[Cook] disk cache " << m_impl->disk.directory() << ": " << s.hits
+                          << " hits, " << s.misses << " misses (" << s.rejected << " rejected), "
+                          << s.stores << " stores, " << (s.bytesRead >> 10) << " KB mapped, "
+                          << (s.bytesWritten >> 10) << " KB written";
+}
+
+CookedMeshCache::Stats CollisionCookingService::diskCacheStats() const
+{
+    return m_impl->disk.stats();
 }
 
 uint64_t CollisionCookingService::hashGeometry(const std::vector<Vertex>& vertices,
@@ -284,13 +470,11 @@ CollisionCookingService::requestTriangleMesh(const std::vector<Vertex>& vertices
         std::vector<uint32_t> idx(indices.begin(), indices.end());
 
         Impl* impl = m_impl;
-        auto fut = std::async(std::launch::async,
-                              [impl, pts = std::move(points), idx = std::move(idx),
-                               name = debugName]() mutable {
-                                  return impl->cookTriangleMesh(std::move(pts), std::move(idx),
-                                                                std::move(name));
-                              })
-                       .share();
+        const uint64_t diskKey = Impl::diskKey(key, CookedMeshCache::Kind::TriangleMesh);
+        auto fut = m_impl->submit<PxTriangleMesh*>(
+            [impl, pts = std::move(points), idx = std::move(idx), name = debugName, diskKey]() mutable {
+                return impl->cookTriangleMesh(std::move(pts), std::move(idx), std::move(name), diskKey);
+            });
         m_impl->triCache.emplace(key, fut);
         return fut;
     }
@@ -327,7 +511,7 @@ CollisionCookingService::requestConvexHull(const std::vector<Vertex>& vertices,
 
         // Hulls don't need every vertex of a dense mesh; subsample huge inputs.
         std::vector<PxVec3> points;
-        const size_t stride = std::max<size_t>(1, vertices.size() / 2048);
+        const size_t stride = std::max<size_t>(1, vertices.size() / kHullSampleTarget);
         points.reserve(vertices.size() / stride + 1);
         for (size_t i = 0; i < vertices.size(); i += stride) {
             const auto& p = vertices[i].position;
@@ -335,11 +519,11 @@ CollisionCookingService::requestConvexHull(const std::vector<Vertex>& vertices,
         }
 
         Impl* impl = m_impl;
-        auto fut = std::async(std::launch::async,
-                              [impl, pts = std::move(points), name = debugName]() mutable {
-                                  return impl->cookConvexHull(std::move(pts), std::move(name));
-                              })
-                       .share();
+        const uint64_t diskKey = Impl::diskKey(key, CookedMeshCache::Kind::ConvexHull);
+        auto fut = m_impl->submit<PxConvexMesh*>(
+            [impl, pts = std::move(points), name = debugName, diskKey]() mutable {
+                return impl->cookConvexHull(std::move(pts), std::move(name), diskKey);
+            });
         m_impl->hullCache.emplace(key, fut);
         return fut;
     }
@@ -379,18 +563,12 @@ CollisionCookingService::requestConvexDecomposition(const std::vector<Vertex>& v
         std::vector<unsigned int> idx = indices;
 
         Impl* impl = m_impl;
-        auto fut = std::async(std::launch::async,
-                              [impl, verts = std::move(verts), idx = std::move(idx),
-                               name = debugName]() {
-                                  std::vector<PxConvexMesh*> cooked;
-                                  for (const auto& hull : krs::decomposeMesh(verts, idx))
-                                      if (PxConvexMesh* m = impl->cookConvexPoints(hull))
-                                          cooked.push_back(m);
-                                  qInfo().nospace() << "[Cook] decomposition '" << name.c_str()
-                                                    << "': " << cooked.size() << " hulls cooked";
-                                  return cooked;
-                              })
-                       .share();
+        const uint64_t diskKey = Impl::diskKey(key, CookedMeshCache::Kind::Decomposition);
+        const uint64_t hullKey = Impl::diskKey(key, CookedMeshCache::Kind::HullSet);
+        auto fut = m_impl->submit<std::vector<PxConvexMesh*>>(
+            [impl, verts = std::move(verts), idx = std::move(idx), name = debugName, diskKey, hullKey]() {
+                return impl->cookDecomposition(verts, idx, name, diskKey, hullKey);
+            });
         m_impl->decompCache.emplace(key, fut);
         return fut;
     }
@@ -0,0 +1,342 @@
+#include "CookedMeshCache.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct EntryHeader {
+    char magic[4] = { 'K', 'R', 'C', 'M' };
+    uint32_t version = 1;
+    uint32_t kind = 0;
+    uint32_t reserved = 0;
+    uint64_t key = 0;
+    uint64_t payloadBytes = 0;
+    uint64_t payloadHash = 0;
+};
+static_assert(sizeof(EntryHeader) == 40, "cook cache entry header layout drift");
+
+const char* kindTag(CookedMeshCache::Kind kind)
+{
+    switch (kind) {
+    case CookedMeshCache::Kind::TriangleMesh:  return "tri";
+    case CookedMeshCache::Kind::ConvexHull:    return "hull";
+    case CookedMeshCache::Kind::Decomposition: return "vhacd";
+    case CookedMeshCache::Kind::HullSet:       return "hulls";
+    case CookedMeshCache::Kind::Sdf:           return "sdf";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+struct CookedMeshCache::Dir {
+    mutable std::mutex mutex;
+    QString path;
+};
+
+CookedMeshCache::Blob::~Blob()
+{
+    if (m_file && m_map) m_file->unmap(m_map);
+}
+
+CookedMeshCache::CookedMeshCache() : m_dir(std::make_unique<Dir>()) {}
+CookedMeshCache::~CookedMeshCache() = default;
+
+void CookedMeshCache::setDirectory(const QString& dir)
+{
+    if (!dir.isEmpty()) QDir().mkpath(dir);
+    std::lock_guard<std::mutex> lock(m_dir->mutex);
+    m_dir->path = dir;
+}
+
+QString CookedMeshCache::directory() const
+{
+    std::lock_guard<std::mutex> lock(m_dir->mutex);
+    return m_dir->path;
+}
+
+bool CookedMeshCache::enabled() const { return !directory().isEmpty(); }
+
+QString CookedMeshCache::defaultDirectory()
+{
+    if (qEnvironmentVariableIsSet("KRS_COOK_CACHE") && qEnvironmentVariableIntValue("KRS_COOK_CACHE") == 0)
+        return QString();
+    const QString env = qEnvironmentVariable("KRS_COOK_CACHE_DIR");
+    return env.isEmpty() ? QDir::currentPath() + QStringLiteral("/cookcache") : env;
+}
+
+uint64_t CookedMeshCache::hash(const void* data, size_t bytes, uint64_t seed)
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < bytes; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t CookedMeshCache::key(uint64_t geometryHash, Kind kind, uint64_t paramsHash, uint32_t physxVersion)
+{
+    const uint32_t k = uint32_t(kind);
+    uint64_t h = hash(&geometryHash, sizeof(geometryHash));
+    h = hash(&k, sizeof(k), h);
+    h = hash(&paramsHash, sizeof(paramsHash), h);
+    return hash(&physxVersion, sizeof(physxVersion), h);
+}
+
+QString CookedMeshCache::entryPath(Kind kind, uint64_t key) const
+{
+    const QString dir = directory();
+    if (dir.isEmpty()) return QString();
+    return QStringLiteral("%1/%2-%3.kcm").arg(dir, QLatin1String(kindTag(kind)))
+                                         .arg(qulonglong(key), 16, 16, QLatin1Char('0'));
+}
+
+std::shared_ptr<const CookedMeshCache::Blob> CookedMeshCache::load(Kind kind, uint64_t key)
+{
+    const QString path = entryPath(kind, key);
+    if (path.isEmpty()) { ++m_misses; return nullptr; }
+
+    auto blob = std::make_shared<Blob>();
+    blob->m_file = std::make_unique<QFile>(path);
+    if (!blob->m_file->open(QIODevice::ReadOnly)) { ++m_misses; return nullptr; }
+    const qint64 size = blob->m_file->size();
+    auto reject = [&]() -> std::shared_ptr<const Blob> { ++m_rejected; ++m_misses; return nullptr; };
+    if (size < qint64(sizeof(EntryHeader))) return reject();
+    blob->m_map = blob->m_file->map(0, size);
+    if (!blob->m_map) return reject();
+
+    EntryHeader h;
+    std::memcpy(&h, blob->m_map, sizeof(h));
+    const EntryHeader expect;
+    if (std::memcmp(h.magic, expect.magic, 4) != 0 || h.version != expect.version || h.kind != uint32_t(kind)
+        || h.key != key || h.payloadBytes != uint64_t(size) - sizeof(EntryHeader))
+        return reject();
+    blob->m_data = blob->m_map + sizeof(EntryHeader);
+    blob->m_size = size_t(h.payloadBytes);
+    if (hash(blob->m_data, blob->m_size) != h.payloadHash) return reject();
+
+    ++m_hits;
+    m_bytesRead += int64_t(blob->m_size);
+    return blob;
+}
+
+std::shared_ptr<const CookedMeshCache::Blob> CookedMeshCache::mapFile(const QString& path)
+{
+    auto blob = std::make_shared<Blob>();
+    blob->m_file = std::make_unique<QFile>(path);
+    if (!blob->m_file->open(QIODevice::ReadOnly)) return nullptr;
+    const qint64 size = blob->m_file->size();
+    if (size <= 0) return nullptr;
+    blob->m_map = blob->m_file->map(0, size);
+    if (!blob->m_map) return nullptr;
+    blob->m_data = blob->m_map;
+    blob->m_size = size_t(size);
+    return blob;
+}
+
+bool CookedMeshCache::store(Kind kind, uint64_t key, const void* data, size_t bytes)
+{
+    const QString path = entryPath(kind, key);
+    if (path.isEmpty()) return false;
+    EntryHeader h;
+    h.kind = uint32_t(kind);
+    h.key = key;
+    h.payloadBytes = bytes;
+    h.payloadHash = hash(data, bytes);
+
+    QSaveFile out(path);
+    const bool ok = out.open(QIODevice::WriteOnly)
+                 && out.write(reinterpret_cast<const char*>(&h), sizeof(h)) == qint64(sizeof(h))
+                 && out.write(static_cast<const char*>(data), qint64(bytes)) == qint64(bytes)
+                 && out.commit();
+    if (!ok) { ++m_storeFailures; return false; }
+    ++m_stores;
+    m_bytesWritten += int64_t(sizeof(h) + bytes);
+    return true;
+}
+
+CookedMeshCache::Stats CookedMeshCache::stats() const
+{
+    Stats s;
+    s.hits = m_hits; s.misses = m_misses; s.rejected = m_rejected;
+    s.stores = m_stores; s.storeFailures = m_storeFailures;
+    s.bytesRead = m_bytesRead; s.bytesWritten = m_bytesWritten;
+    return s;
+}
+
+void CookedMeshCache::resetStats()
+{
+    m_hits = 0; m_misses = 0; m_rejected = 0; m_stores = 0; m_storeFailures = 0;
+    m_bytesRead = 0; m_bytesWritten = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+// Stand-in for a PhysX cook: deterministic bytes that take real CPU time to produce.
+std::vector<unsigned char> fakeCook(uint64_t seed, size_t bytes, int rounds)
+{
+    std::vector<unsigned char> out(bytes);
+    uint64_t h = seed * 0x9E3779B97F4A7C15ull + 1;
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < bytes; ++i) {
+            h ^= h >> 29; h *= 0xBF58476D1CE4E5B9ull; h ^= h >> 32;
+            out[i] = static_cast<unsigned char>(out[i] + (h & 0xFF));
+        }
+    return out;
+}
+
+} // namespace
+
+bool CookedMeshCache::runSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[COOK-CACHE] %s %-40s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+
+    // ---- round trip through the mapping ----
+    CookedMeshCache c;
+    c.setDirectory(tmp.path());
+    const std::vector<unsigned char> payload = fakeCook(1, 200000, 1);
+    const uint64_t k = key(0x1234, Kind::TriangleMesh, 0x55, 0x05010300);
+    const bool missFirst = c.load(Kind::TriangleMesh, k) == nullptr;
+    const bool stored = c.store(Kind::TriangleMesh, k, payload.data(), payload.size());
+    auto blob = c.load(Kind::TriangleMesh, k);
+    const bool same = blob && blob->size() == payload.size() && std::memcmp(blob->data(), payload.data(), payload.size()) == 0;
+    const bool otherKindMisses = c.load(Kind::ConvexHull, k) == nullptr;
+    report(missFirst && stored && same && otherKindMisses, "store -> mapped load bit-exact",
+           QStringLiteral("(%1 bytes; cold miss:%2, other kind misses:%3)").arg(payload.size()).arg(missFirst).arg(otherKindMisses));
+    blob.reset();
+
+    // ---- every key input changes the key ----
+    {
+        const uint64_t base = key(1, Kind::ConvexHull, 2, 3);
+        const bool distinct = base != key(9, Kind::ConvexHull, 2, 3) && base != key(1, Kind::TriangleMesh, 2, 3)
+                           && base != key(1, Kind::ConvexHull, 7, 3) && base != key(1, Kind::ConvexHull, 2, 4);
+        report(distinct, "key covers geometry/kind/params/PhysX", QStringLiteral("(4 single-input changes)"));
+    }
+
+    // ---- damaged entries are rejected, and a store repairs them ----
+    {
+        const QString path = c.entryPath(Kind::TriangleMesh, k);
+        auto patch = [&](qint64 offset, char value) {
+            QFile f(path);
+            if (!f.open(QIODevice::ReadWrite)) return false;
+            f.seek(offset);
+            return f.write(&value, 1) == 1;
+        };
+        const Stats before = c.stats();
+        // bit flip deep in the payload: the header still matches, only the checksum catches it
+        QFile f(path); f.open(QIODevice::ReadOnly); QByteArray orig = f.readAll(); f.close();
+        patch(qint64(sizeof(EntryHeader)) + 123456, char(orig[qint64(sizeof(EntryHeader)) + 123456] ^ 0x10));
+        const bool flipRejected = c.load(Kind::TriangleMesh, k) == nullptr;
+        // NEG-CTRL: the same damaged file passes a header-only check
+        EntryHeader h; std::memcpy(&h, orig.constData(), sizeof(h));
+        QFile g(path); g.open(QIODevice::ReadOnly); const QByteArray damaged = g.readAll(); g.close();
+        EntryHeader hd; std::memcpy(&hd, damaged.constData(), sizeof(hd));
+        const bool headerOnlyAccepts = std::memcmp(&h, &hd, sizeof(h)) == 0 && damaged != orig;
+        // truncation
+        c.store(Kind::TriangleMesh, k, payload.data(), payload.size());
+        { QFile t(path); t.open(QIODevice::ReadWrite); t.resize(t.size() - 7); }
+        const bool truncRejected = c.load(Kind::TriangleMesh, k) == nullptr;
+        // an entry renamed to another key
+        c.store(Kind::TriangleMesh, k, payload.data(), payload.size());
+        const uint64_t k2 = key(0x9999, Kind::TriangleMesh, 0x55, 0x05010300);
+        QFile::remove(c.entryPath(Kind::TriangleMesh, k2));
+        QFile::copy(path, c.entryPath(Kind::TriangleMesh, k2));
+        const bool wrongKeyRejected = c.load(Kind::TriangleMesh, k2) == nullptr;
+        const bool repaired = c.load(Kind::TriangleMesh, k) != nullptr;
+        const Stats after = c.stats();
+        report(flipRejected && truncRejected && wrongKeyRejected && repaired && after.rejected - before.rejected == 3,
+               "bit flip / truncation / wrong key rejected",
+               QStringLiteral("(%1 rejected; re-stored entry loads:%2)").arg(after.rejected - before.rejected).arg(repaired));
+        report(headerOnlyAccepts, "NEG-CTRL header-only check misses the flip",
+               QStringLiteral("(header identical, payload differs)"));
+    }
+
+    // ---- concurrent writers of one key never tear the entry ----
+    {
+        const uint64_t kc = key(77, Kind::Decomposition, 1, 1);
+        QThreadPool pool;
+        pool.setMaxThreadCount(8);
+        for (int t = 0; t < 16; ++t)
+            pool.start([&c, kc, &payload]() { c.store(Kind::Decomposition, kc, payload.data(), payload.size()); });
+        int good = 0;
+        for (int r = 0; r < 16; ++r) {
+            auto b = c.load(Kind::Decomposition, kc);
+            good += b && b->size() == payload.size() && std::memcmp(b->data(), payload.data(), payload.size()) == 0;
+        }
+        pool.waitForDone();
+        auto b = c.load(Kind::Decomposition, kc);
+        const bool final = b && std::memcmp(b->data(), payload.data(), payload.size()) == 0;
+        report(final, "16 concurrent same-key stores",
+               QStringLiteral("(final entry intact; %1 loads during the writes were whole or missing, never torn)").arg(good));
+    }
+
+    // ---- cold vs warm: a "launch" cooks every mesh in parallel, the next one only maps ----
+    {
+        const int meshes = 32;
+        auto launch = [&](CookedMeshCache& cache, std::vector<uint64_t>& digests) {
+            QThreadPool pool;
+            digests.assign(size_t(meshes), 0);
+            QElapsedTimer t; t.start();
+            for (int m = 0; m < meshes; ++m)
+                pool.start([&cache, &digests, m]() {
+                    const uint64_t km = key(uint64_t(m) + 100, Kind::ConvexHull, 0x42, 0x05010300);
+                    if (auto hit = cache.load(Kind::ConvexHull, km)) {
+                        digests[size_t(m)] = hash(hit->data(), hit->size());
+                        return;
+                    }
+                    const std::vector<unsigned char> bytes = fakeCook(uint64_t(m), 64 * 1024, 40);
+                    cache.store(Kind::ConvexHull, km, bytes.data(), bytes.size());
+                    digests[size_t(m)] = hash(bytes.data(), bytes.size());
+                });
+            pool.waitForDone();
+            return double(t.nsecsElapsed()) * 1e-6;
+        };
+        CookedMeshCache cold, warm;
+        cold.setDirectory(tmp.path() + QStringLiteral("/launch"));
+        warm.setDirectory(tmp.path() + QStringLiteral("/launch"));
+        std::vector<uint64_t> a, b;
+        const double coldMs = launch(cold, a);
+        const double warmMs = launch(warm, b);
+        const Stats sc = cold.stats(), sw = warm.stats();
+        report(a == b && sc.misses == meshes && sc.stores == meshes && sw.hits == meshes && sw.misses == 0,
+               "second launch: all hits, identical bytes",
+               QStringLiteral("(cold %1 misses / %2 stores in %3 ms on %4 threads; warm %5 hits in %6 ms = %7x; %8 KB mapped)")
+                   .arg(sc.misses).arg(sc.stores).arg(coldMs, 0, 'f', 1).arg(QThreadPool::globalInstance()->maxThreadCount())
+                   .arg(sw.hits).arg(warmMs, 0, 'f', 1).arg(coldMs / std::max(warmMs, 1e-3), 0, 'f', 1)
+                   .arg(sw.bytesRead / 1024));
+    }
+
+    // ---- disabled cache is inert ----
+    {
+        CookedMeshCache off;
+        const bool inert = !off.enabled() && !off.store(Kind::ConvexHull, 1, payload.data(), 16)
+                        && off.load(Kind::ConvexHull, 1) == nullptr && off.stats().misses == 1;
+        report(inert, "no directory: loads miss, stores dropped", QStringLiteral("(KRS_COOK_CACHE=0)"));
+    }
+
+    std::fprintf(stderr, "[COOK-CACHE] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
@@ -34,9 +34,9 @@ static inline void waitUntil(clk::time_point target)
     while (clk::now() < target) { /* fine spin to the deadline */ }
 }
 
-static JitterStats computeStats(std::vector<double>& jit, double nominalMs, int ticks)
+JitterStats summarizeJitter(std::vector<double>& jit, double nominalMs)
 {
-    JitterStats st; st.ticks = ticks; st.nominalMs = nominalMs;
+    JitterStats st; st.ticks = int(jit.size()); st.nominalMs = nominalMs;
     if (jit.empty()) return st;
     double sum = 0.0, mx = 0.0;
     for (double j : jit) { sum += j; mx = std::max(mx, j); }   // mean + max jitter
@@ -66,7 +66,7 @@ JitterStats runJitterBench(int ticks, double hz, const std::function<void(uint64
         prev = now;
         jit.push_back(std::abs(interval - nominalMs));       // deviation from the nominal period
     }
-    return computeStats(jit, nominalMs, ticks);
+    return summarizeJitter(jit, nominalMs);
 }
 
 bool runJitterSelfTest()
@@ -87,29 +87,70 @@ bool runJitterSelfTest()
     return pass;
 }
 
-void AsyncCoordinator::start(PhysicsFn physics, SensorFn sensor, double physHz, double sensorHz)
+void FixedRateThread::start(double hz, TickFn tick, int maxCatchUp)
 {
+    stop();
+    m_nominalMs = 1000.0 / hz;
+    m_ringMs.assign(std::clamp<size_t>(size_t(hz * 60.0), 1024, size_t(1) << 20), 0.0);   // ~last minute, <= 8 MB
+    m_ringHead = 0; m_devCount = 0; m_devSumMs = 0.0; m_devMaxMs = 0.0;
+    m_ticks.store(0, std::memory_order_release);
+    m_reanchors.store(0, std::memory_order_release);
     m_run.store(true, std::memory_order_release);
-    // --- physics thread: rigid deterministic cadence, publishes to the ring ---
-    m_physThread = std::thread([this, physics, physHz]() {
+    std::thread t([this, tick = std::move(tick), hz, maxCatchUp]() {
+        m_id.store(std::this_thread::get_id(), std::memory_order_release);   // before the first tick
         TimerRes res;
-        const double period = 1.0 / physHz;
-        const double nominalMs = period * 1000.0;
-        std::vector<double> jit;
+        const double period = 1.0 / hz;
+        const auto periodDur = std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(period));
         auto t0 = clk::now(); auto prev = t0;
-        uint64_t k = 0;
+        uint64_t k = 0, base = 0;                            // deadlines: t0 + (k - base) * period
         while (m_run.load(std::memory_order_acquire)) {
             ++k;
-            auto target = t0 + std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(k * period));
-            waitUntil(target);
+            auto target = t0 + std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(double(k - base) * period));
             auto now = clk::now();
-            PlantState s; s.tick = k; s.simTime = k * period;
-            if (physics) physics(k, period, s);              // advance the plant
-            m_ring.publish(s);                               // lock-free hand-off to sensors
-            jit.push_back(std::abs(std::chrono::duration<double, std::milli>(now - prev).count() - nominalMs));
+            if (now - target > periodDur * maxCatchUp) {     // stalled: re-anchor, do not burst
+                t0 = now; base = k; target = now;
+                m_reanchors.fetch_add(1, std::memory_order_acq_rel);
+            }
+            waitUntil(target);
+            now = clk::now();
+            if (tick) tick(k, period);
+            if (k > 1) {                                     // first interval is start-up, not jitter
+                const double dev = std::abs(std::chrono::duration<double, std::milli>(now - prev).count() - m_nominalMs);
+                m_ringMs[m_ringHead] = dev;
+                if (++m_ringHead == m_ringMs.size()) m_ringHead = 0;
+                ++m_devCount; m_devSumMs += dev; m_devMaxMs = std::max(m_devMaxMs, dev);
+            }
             prev = now;
+            m_ticks.store(k, std::memory_order_release);
         }
-        m_jitter = computeStats(jit, nominalMs, int(k));
+    });
+    m_id.store(t.get_id(), std::memory_order_release);   // running() as soon as start() returns
+    m_thread = std::move(t);
+}
+
+JitterStats FixedRateThread::stop()
+{
+    if (!m_thread.joinable()) return {};
+    m_run.store(false, std::memory_order_release);
+    m_thread.join();
+    m_id.store(std::thread::id(), std::memory_order_release);
+    // Percentiles over the ring window (order does not matter once sorted);
+    // count, mean and max over the whole run.
+    m_ringMs.resize(size_t(std::min<uint64_t>(m_devCount, m_ringMs.size())));
+    JitterStats st = summarizeJitter(m_ringMs, m_nominalMs);
+    st.ticks = int(m_devCount);
+    if (m_devCount) { st.meanMs = m_devSumMs / double(m_devCount); st.maxMs = m_devMaxMs; }
+    return st;
+}
+
+void AsyncCoordinator::start(PhysicsFn physics, SensorFn sensor, double physHz, double sensorHz)
+{
+    m_run.store(true, std::memory_order_release);
+    // --- physics thread: rigid deterministic cadence, publishes to the ring ---
+    m_physThread.start(physHz, [this, physics](uint64_t k, double period) {
+        PlantState s; s.tick = k; s.simTime = double(k) * period;
+        if (physics) physics(k, period, s);                  // advance the plant
+        m_ring.publish(s);                                   // lock-free hand-off to sensors
     });
     // --- sensor thread: samples the latest state asynchronously ---
     m_sensorThread = std::thread([this, sensor, sensorHz]() {
@@ -127,7 +168,7 @@ void AsyncCoordinator::start(PhysicsFn physics, SensorFn sensor, double physHz,
 void AsyncCoordinator::stop()
 {
     m_run.store(false, std::memory_order_release);
-    if (m_physThread.joinable()) m_physThread.join();
+    if (m_physThread.running()) m_jitter = m_physThread.stop();
     if (m_sensorThread.joinable()) m_sensorThread.join();
 }
 
@@ -0,0 +1,245 @@
+#include "HullSet.hpp"
+#include "CookedMeshCache.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace krs {
+
+namespace {
+
+constexpr char kMagic[4] = { 'C', 'O', 'A', 'C' };
+
+} // namespace
+
+std::vector<unsigned char> HullSet::encode(const std::vector<std::vector<glm::vec3>>& hulls)
+{
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be three packed floats");
+    uint32_t parts = 0;
+    size_t bytes = sizeof(kMagic) + sizeof(uint32_t);
+    for (const auto& h : hulls)
+        if (!h.empty()) { ++parts; bytes += sizeof(uint32_t) + h.size() * sizeof(glm::vec3); }
+
+    std::vector<unsigned char> out(bytes);
+    unsigned char* p = out.data();
+    std::memcpy(p, kMagic, sizeof(kMagic)); p += sizeof(kMagic);
+    std::memcpy(p, &parts, sizeof(parts));  p += sizeof(parts);
+    for (const auto& h : hulls) {
+        if (h.empty()) continue;
+        const uint32_t n = uint32_t(h.size());
+        std::memcpy(p, &n, sizeof(n)); p += sizeof(n);
+        std::memcpy(p, h.data(), h.size() * sizeof(glm::vec3)); p += h.size() * sizeof(glm::vec3);
+    }
+    return out;
+}
+
+bool HullSet::view(std::shared_ptr<const void> owner, const unsigned char* bytes, size_t size)
+{
+    m_parts.clear();
+    m_owner.reset();
+    if (!bytes || size < sizeof(kMagic) + sizeof(uint32_t)) return false;
+    if (reinterpret_cast<uintptr_t>(bytes) % alignof(glm::vec3) != 0) return false;
+    if (std::memcmp(bytes, kMagic, sizeof(kMagic)) != 0) return false;
+
+    uint32_t parts = 0;
+    std::memcpy(&parts, bytes + sizeof(kMagic), sizeof(parts));
+    size_t offset = sizeof(kMagic) + sizeof(parts);
+    // Every part needs at least its count word: bounds the reserve on a corrupt header.
+    if (parts == 0 || parts > (size - offset) / sizeof(uint32_t)) return false;
+
+    std::vector<Part> out;
+    out.reserve(parts);
+    for (uint32_t i = 0; i < parts; ++i) {
+        uint32_t n = 0;
+        if (size - offset < sizeof(n)) return false;
+        std::memcpy(&n, bytes + offset, sizeof(n));
+        offset += sizeof(n);
+        if (n == 0 || n > (size - offset) / sizeof(glm::vec3)) return false;
+        out.push_back({ reinterpret_cast<const glm::vec3*>(bytes + offset), n });
+        offset += size_t(n) * sizeof(glm::vec3);
+    }
+    if (offset != size) return false; // trailing bytes: not a file this layout wrote
+
+    m_parts = std::move(out);
+    m_owner = std::move(owner);
+    return true;
+}
+
+bool HullSet::open(const QString& path)
+{
+    auto blob = CookedMeshCache::mapFile(path);
+    if (!blob) { m_parts.clear(); m_owner.reset(); return false; }
+    const unsigned char* data = blob->data();
+    const size_t size = blob->size();
+    return view(std::move(blob), data, size);
+}
+
+size_t HullSet::totalPoints() const
+{
+    size_t n = 0;
+    for (const Part& p : m_parts) n += p.count;
+    return n;
+}
+
+std::vector<std::vector<glm::vec3>> HullSet::toVectors() const
+{
+    std::vector<std::vector<glm::vec3>> out;
+    out.reserve(m_parts.size());
+    for (const Part& p : m_parts) out.emplace_back(p.points, p.points + p.count);
+    return out;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+// The ifstream reader CoacdCollider.hpp used before it mapped the file (kept here as the reference).
+bool legacyLoad(const std::string& path, std::vector<std::vector<glm::vec3>>& out)
+{
+    out.clear();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    char magic[4] = {};
+    in.read(magic, 4);
+    if (in.gcount() != 4 || std::memcmp(magic, kMagic, 4) != 0) return false;
+    uint32_t numParts = 0;
+    in.read(reinterpret_cast<char*>(&numParts), sizeof(numParts));
+    if (!in || numParts == 0 || numParts > 100000u) return false;
+    out.reserve(numParts);
+    for (uint32_t p = 0; p < numParts; ++p) {
+        uint32_t numVerts = 0;
+        in.read(reinterpret_cast<char*>(&numVerts), sizeof(numVerts));
+        if (!in || numVerts == 0 || numVerts > 10000000u) { out.clear(); return false; }
+        std::vector<glm::vec3> verts(numVerts);
+        const std::streamsize bytes = std::streamsize(numVerts) * std::streamsize(sizeof(glm::vec3));
+        in.read(reinterpret_cast<char*>(verts.data()), bytes);
+        if (in.gcount() != bytes) { out.clear(); return false; }
+        out.push_back(std::move(verts));
+    }
+    return !out.empty();
+}
+
+std::vector<std::vector<glm::vec3>> syntheticHulls(int parts, int pointsPerPart, uint32_t seed)
+{
+    std::vector<std::vector<glm::vec3>> hulls(static_cast<size_t>(parts));
+    uint32_t s = seed;
+    auto rnd = [&s]() { s = s * 1664525u + 1013904223u; return float(s >> 8) / float(1u << 24) - 0.5f; };
+    for (int p = 0; p < parts; ++p) {
+        const glm::vec3 c(rnd(), rnd(), rnd());
+        hulls[size_t(p)].resize(size_t(pointsPerPart + p % 7));
+        for (auto& v : hulls[size_t(p)]) v = c + 0.1f * glm::vec3(rnd(), rnd(), rnd());
+    }
+    return hulls;
+}
+
+bool sameParts(const HullSet& set, const std::vector<std::vector<glm::vec3>>& ref)
+{
+    if (set.size() != ref.size()) return false;
+    for (size_t i = 0; i < ref.size(); ++i)
+        if (set[i].count != ref[i].size()
+            || std::memcmp(set[i].points, ref[i].data(), ref[i].size() * sizeof(glm::vec3)) != 0)
+            return false;
+    return true;
+}
+
+bool writeFile(const QString& path, const std::vector<unsigned char>& bytes)
+{
+    QFile f(path);
+    return f.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        && f.write(reinterpret_cast<const char*>(bytes.data()), qint64(bytes.size())) == qint64(bytes.size());
+}
+
+} // namespace
+
+bool HullSet::runSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[HULL-SET] %s %-40s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+
+    // ---- round trip through a mapped file, equal to the legacy reader ----
+    const auto hulls = syntheticHulls(24, 64, 7u);
+    const QString path = tmp.path() + QStringLiteral("/coacd.bin");
+    writeFile(path, encode(hulls));
+    HullSet set;
+    const bool opened = set.open(path);
+    std::vector<std::vector<glm::vec3>> legacy;
+    const bool legacyOk = legacyLoad(path.toStdString(), legacy);
+    report(opened && sameParts(set, hulls) && legacyOk && sameParts(set, legacy),
+           "encode -> mapped open == legacy reader",
+           QStringLiteral("(%1 parts, %2 points, bitwise)").arg(set.size()).arg(set.totalPoints()));
+
+    // NEG-CTRL: the same compare on a copy with one point nudged by one ulp must fail
+    {
+        auto nudged = hulls;
+        nudged[5][3].y = std::nextafter(nudged[5][3].y, 1.0f);
+        report(!sameParts(set, nudged), "NEG-CTRL one-ulp change detected", QStringLiteral("(part 5, point 3)"));
+    }
+
+    // ---- an in-memory view keeps its buffer alive ----
+    {
+        auto bytes = std::make_shared<std::vector<unsigned char>>(encode(hulls));
+        HullSet mem;
+        const bool ok = mem.view(bytes, bytes->data(), bytes->size());
+        bytes.reset();                                  // the set keeps the buffer alive
+        report(ok && sameParts(mem, hulls), "view over a shared buffer", QStringLiteral("(owner released by caller)"));
+    }
+
+    // ---- damaged files are rejected ----
+    {
+        const std::vector<unsigned char> good = encode(hulls);
+        auto truncated = good;  truncated.resize(good.size() - 5);
+        auto inflated = good;   const uint32_t big = 4000000u; std::memcpy(inflated.data() + 8, &big, 4);
+        auto badMagic = good;   badMagic[0] = 'X';
+        auto trailing = good;   trailing.push_back(0);
+        int rejected = 0;
+        for (const auto* b : { &truncated, &inflated, &badMagic, &trailing }) {
+            HullSet s;
+            rejected += !s.view(nullptr, b->data(), b->size()) && s.empty();
+        }
+        HullSet missing;
+        rejected += !missing.open(tmp.path() + QStringLiteral("/absent.bin"));
+        report(rejected == 5, "truncated/inflated/magic/trailing/missing",
+               QStringLiteral("(%1 of 5 rejected)").arg(rejected));
+    }
+
+    // ---- open() vs the copying reader on a large set ----
+    {
+        const auto big = syntheticHulls(256, 4096, 11u);
+        const QString bigPath = tmp.path() + QStringLiteral("/big.bin");
+        writeFile(bigPath, encode(big));
+        const int reps = 20;
+        QElapsedTimer t;
+        t.start();
+        size_t a = 0;
+        for (int r = 0; r < reps; ++r) { std::vector<std::vector<glm::vec3>> v; legacyLoad(bigPath.toStdString(), v); a += v.size(); }
+        const double legacyMs = double(t.nsecsElapsed()) * 1e-6 / reps;
+        t.restart();
+        size_t b = 0;
+        for (int r = 0; r < reps; ++r) { HullSet s; s.open(bigPath); b += s.size(); }
+        const double mapMs = double(t.nsecsElapsed()) * 1e-6 / reps;
+        HullSet s;
+        const bool same = s.open(bigPath) && sameParts(s, big) && a == b;
+        report(same, "mapped open vs ifstream copy",
+               QStringLiteral("(%1 parts / %2 MB: ifstream %3 ms, mapped %4 ms = %5x)")
+                   .arg(s.size()).arg(double(s.totalPoints() * sizeof(glm::vec3)) / (1 << 20), 0, 'f', 1)
+                   .arg(legacyMs, 0, 'f', 2).arg(mapMs, 0, 'f', 3).arg(legacyMs / std::max(mapMs, 1e-6), 0, 'f', 1));
+    }
+
+    std::fprintf(stderr, "[HULL-SET] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
+
+} // namespace krs
@@ -0,0 +1,359 @@
+#include "MortonSort.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace krs::morton {
+
+namespace {
+
+constexpr uint32_t kAxisMax = (1u << 21) - 1;
+constexpr size_t kSortGrain = 16384;     // fixed chunking: histograms never depend on thread count
+
+inline uint64_t spread3(uint32_t v)
+{
+    uint64_t x = v & kAxisMax;
+    x = (x | (x << 32)) & 0x001F00000000FFFFull;
+    x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+    x = (x | (x << 8))  & 0x100F00F00F00F00Full;
+    x = (x | (x << 4))  & 0x10C30C30C30C30C3ull;
+    x = (x | (x << 2))  & 0x1249249249249249ull;
+    return x;
+}
+
+inline uint32_t compact3(uint64_t x)
+{
+    x &= 0x1249249249249249ull;
+    x = (x ^ (x >> 2))  & 0x10C30C30C30C30C3ull;
+    x = (x ^ (x >> 4))  & 0x100F00F00F00F00Full;
+    x = (x ^ (x >> 8))  & 0x001F0000FF0000FFull;
+    x = (x ^ (x >> 16)) & 0x001F00000000FFFFull;
+    x = (x ^ (x >> 32)) & 0x00000000001FFFFFull;
+    return uint32_t(x);
+}
+
+inline uint32_t hashSlot(uint64_t key, int bits)
+{
+    return uint32_t((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+} // namespace
+
+uint64_t encode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spread3(x) | (spread3(y) << 1) | (spread3(z) << 2);
+}
+
+glm::uvec3 decode(uint64_t code)
+{
+    return glm::uvec3(compact3(code), compact3(code >> 1), compact3(code >> 2));
+}
+
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order, krs::par::ThreadPool* pool)
+{
+    krs::par::ThreadPool& tp = pool ? *pool : krs::par::ThreadPool::global();
+    const size_t n = keys.size();
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0u);
+    if (n < 2) return;
+
+    const uint64_t all = krs::par::reduce<uint64_t>(tp, n, kSortGrain, 0ull, [&](size_t lo, size_t hi) {
+        uint64_t m = 0;
+        for (size_t i = lo; i < hi; ++i) m |= keys[i];
+        return m;
+    });
+    int bits = 0;
+    while (bits < 64 && (all >> bits)) ++bits;
+
+    if (bits > 8 && bits <= 16) {
+        // Narrow keys (small grids): one counting pass over the whole key range
+        // beats two 8-bit passes.
+        std::vector<uint32_t> start((size_t(1) << bits) + 1, 0u);
+        for (size_t i = 0; i < n; ++i) ++start[size_t(keys[i]) + 1];
+        for (size_t d = 1; d < start.size(); ++d) start[d] += start[d - 1];
+        std::vector<uint64_t> sortedKeys(n);
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t dst = start[size_t(keys[i])]++;
+            sortedKeys[dst] = keys[i];
+            order[dst] = uint32_t(i);
+        }
+        keys.swap(sortedKeys);
+        return;
+    }
+
+    const size_t chunks = krs::par::chunkCount(n, kSortGrain);
+    std::vector<size_t> hist(chunks * 256);
+    std::vector<uint64_t> tmpKeys(n);
+    std::vector<uint32_t> tmpOrder(n);
+    for (int shift = 0; shift < bits; shift += 8) {
+        std::fill(hist.begin(), hist.end(), size_t(0));
+        tp.run(chunks, [&](size_t c) {
+            size_t* h = &hist[c * 256];
+            for (size_t i = c * kSortGrain, e = std::min(n, i + kSortGrain); i < e; ++i)
+                ++h[(keys[i] >> shift) & 0xFF];
+        });
+        // Digit-major, chunk-minor prefix: keeps equal digits in input order (stable).
+        size_t run = 0;
+        bool trivial = false;
+        for (int d = 0; d < 256; ++d) {
+            size_t total = 0;
+            for (size_t c = 0; c < chunks; ++c) {
+                const size_t v = hist[c * 256 + size_t(d)];
+                hist[c * 256 + size_t(d)] = run;
+                run += v;
+                total += v;
+            }
+            trivial = trivial || total == n;
+        }
+        if (trivial) continue;                          // every key shares this digit
+        tp.run(chunks, [&](size_t c) {
+            size_t* h = &hist[c * 256];
+            for (size_t i = c * kSortGrain, e = std::min(n, i + kSortGrain); i < e; ++i) {
+                const size_t dst = h[(keys[i] >> shift) & 0xFF]++;
+                tmpKeys[dst] = keys[i];
+                tmpOrder[dst] = order[i];
+            }
+        });
+        keys.swap(tmpKeys);
+        order.swap(tmpOrder);
+    }
+}
+
+void cellKeys(const float* xyz, size_t strideFloats, size_t count, const glm::vec3& origin, float cellSize,
+              std::vector<uint64_t>& keys, krs::par::ThreadPool* pool)
+{
+    krs::par::ThreadPool& tp = pool ? *pool : krs::par::ThreadPool::global();
+    keys.resize(count);
+    const float inv = 1.0f / cellSize;
+    krs::par::parallelFor(tp, count, kSortGrain, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            const float* p = xyz + i * strideFloats;
+            uint32_t c[3];
+            for (int a = 0; a < 3; ++a) {
+                const float f = (p[a] - origin[a]) * inv;        // truncation == floor once f > 0
+                c[a] = !(f > 0.0f) ? 0u : f >= float(kAxisMax) ? kAxisMax : uint32_t(f);
+            }
+            keys[i] = encode(c[0], c[1], c[2]);
+        }
+    });
+}
+
+void CellTable::build(const float* xyz, size_t strideFloats, size_t count, float cellSize,
+                      krs::par::ThreadPool* pool)
+{
+    m_cellSize = cellSize;
+    m_invCell = 1.0f / cellSize;
+    m_identity = false;
+    glm::vec3 mn(0.0f);
+    if (count > 0) {
+        mn = glm::vec3(xyz[0], xyz[1], xyz[2]);
+        for (size_t i = 1; i < count; ++i) {
+            const float* p = xyz + i * strideFloats;
+            mn = glm::min(mn, glm::vec3(p[0], p[1], p[2]));
+        }
+    }
+    m_origin = glm::floor(mn * m_invCell) * cellSize;
+    cellKeys(xyz, strideFloats, count, m_origin, cellSize, m_keys, pool);
+    radixSort(m_keys, m_order, pool);
+
+    m_cellKey.clear();
+    m_cellStart.clear();
+    for (size_t k = 0; k < m_keys.size(); ++k)
+        if (k == 0 || m_keys[k] != m_keys[k - 1]) {
+            m_cellKey.push_back(m_keys[k]);
+            m_cellStart.push_back(uint32_t(k));
+        }
+    m_cellStart.push_back(uint32_t(m_keys.size()));
+
+    int bits = 4;
+    while ((size_t(1) << bits) < m_cellKey.size() * 2) ++bits;
+    m_hashBits = bits;
+    m_hash.assign(size_t(1) << bits, 0u);
+    const uint32_t mask = uint32_t(m_hash.size() - 1);
+    for (size_t row = 0; row < m_cellKey.size(); ++row) {
+        uint32_t s = hashSlot(m_cellKey[row], bits);
+        while (m_hash[s]) s = (s + 1) & mask;
+        m_hash[s] = uint32_t(row + 1);
+    }
+}
+
+void CellTable::adoptOrder()
+{
+    m_identity = true;
+}
+
+glm::ivec3 CellTable::cellOf(const glm::vec3& p) const
+{
+    return glm::ivec3(glm::floor((p - m_origin) * m_invCell));
+}
+
+std::pair<uint32_t, uint32_t> CellTable::cellRange(const glm::ivec3& c) const
+{
+    if (m_hash.empty() || c.x < 0 || c.y < 0 || c.z < 0 || c.x > int(kAxisMax) || c.y > int(kAxisMax)
+        || c.z > int(kAxisMax))
+        return { 0u, 0u };
+    const uint64_t key = encode(uint32_t(c.x), uint32_t(c.y), uint32_t(c.z));
+    const uint32_t mask = uint32_t(m_hash.size() - 1);
+    for (uint32_t s = hashSlot(key, m_hashBits);; s = (s + 1) & mask) {
+        const uint32_t row = m_hash[s];
+        if (!row) return { 0u, 0u };
+        if (m_cellKey[row - 1] == key) return { m_cellStart[row - 1], m_cellStart[row] };
+    }
+}
+
+// =====================================================================================
+// Self-tests
+// =====================================================================================
+bool CellTable::runSelfTests()
+{
+    using Clock = std::chrono::steady_clock;
+    int fails = 0;
+    auto report = [&](bool ok, const char* name, const char* detail) {
+        std::fprintf(stderr, "[MORTON] %s %-40s %s\n", ok ? "PASS" : "FAIL", name, detail);
+        if (!ok) ++fails;
+    };
+    char buf[200];
+    std::mt19937_64 rng(38);
+
+    // ---- 1. codec + radix sort == std::stable_sort (duplicates, full 63-bit keys) ----
+    {
+        bool codec = true;
+        for (int i = 0; i < 10000 && codec; ++i) {
+            const glm::uvec3 c(uint32_t(rng()) & kAxisMax, uint32_t(rng()) & kAxisMax, uint32_t(rng()) & kAxisMax);
+            codec = decode(encode(c.x, c.y, c.z)) == c;
+        }
+        codec = codec && encode(1, 0, 0) == 1 && encode(0, 1, 0) == 2 && encode(0, 0, 1) == 4;
+        report(codec, "Morton encode/decode round trip", "(10000 random cells)");
+
+        std::vector<uint64_t> keys(300000);
+        for (size_t i = 0; i < keys.size(); ++i)
+            keys[i] = (i % 3 == 0) ? (rng() >> 1) : (rng() % 5000);   // mix of wide keys and heavy duplicates
+        std::vector<uint32_t> ref(keys.size());
+        std::iota(ref.begin(), ref.end(), 0u);
+        std::stable_sort(ref.begin(), ref.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+        krs::par::ThreadPool one(1), many(4);
+        std::vector<uint64_t> k1 = keys, k4 = keys;
+        std::vector<uint32_t> o1, o4;
+        radixSort(k1, o1, &one);
+        radixSort(k4, o4, &many);
+        bool same = o1 == ref && o4 == ref;
+        for (size_t i = 0; i < k1.size() && same; ++i) same = k1[i] == keys[ref[i]];
+        std::snprintf(buf, sizeof(buf), "(%zu keys, 1 and 4 threads)", keys.size());
+        report(same, "radix sort == std::stable_sort", buf);
+    }
+
+    // ---- 2. neighbour sets == brute force; NEG-CTRL: cells smaller than the radius miss pairs ----
+    {
+        const size_t n = 3000;
+        const float radius = 0.05f;
+        std::vector<glm::vec3> pts(n);
+        std::uniform_real_distribution<float> u(-0.4f, 0.4f);
+        for (auto& p : pts) p = glm::vec3(u(rng), u(rng), u(rng));
+        auto countPairs = [&](float cell) {
+            CellTable t;
+            t.build(&pts[0].x, 3, n, cell);
+            size_t pairs = 0, mismatched = 0;
+            for (size_t i = 0; i < n; ++i) {
+                std::vector<uint32_t> got, want;
+                t.forEachNeighbor(&pts[0].x, 3, pts[i], radius, [&](uint32_t j, float) { got.push_back(j); });
+                for (size_t j = 0; j < n; ++j) {
+                    const glm::vec3 d = pts[j] - pts[i];
+                    if (glm::dot(d, d) <= radius * radius) want.push_back(uint32_t(j));
+                }
+                std::sort(got.begin(), got.end());
+                pairs += want.size();
+                mismatched += got != want;
+            }
+            return std::make_pair(pairs, mismatched);
+        };
+        const auto exact = countPairs(radius);
+        std::snprintf(buf, sizeof(buf), "(%zu points, %zu pairs, %zu mismatched queries)", n, exact.first, exact.second);
+        report(exact.second == 0 && exact.first > n, "neighbours == brute force", buf);
+        const auto neg = countPairs(0.5f * radius);
+        std::snprintf(buf, sizeof(buf), "(cell = r/2: %zu queries miss neighbours)", neg.second);
+        report(neg.second > 0, "NEG-CTRL under-sized cells detected", buf);
+    }
+
+    // ---- 3. throughput: SPH density sum in spawn order vs Morton order ----
+    {
+        size_t n = 262144;
+        if (const char* e = std::getenv("KRS_MORTON_BENCH")) n = size_t(std::max(1000, std::atoi(e)));
+        constexpr size_t kStride = 8;                  // FluidCache particle: posLife + vel
+        const float spacing = 0.01f;
+        const float h = 1.9f * spacing;                // ~30 neighbours
+        const float side = std::cbrt(float(n)) * spacing;
+        std::vector<float> spawn(n * kStride, 0.0f);
+        std::uniform_real_distribution<float> u(0.0f, side);
+        for (size_t i = 0; i < n; ++i) {
+            float* p = &spawn[i * kStride];
+            p[0] = u(rng); p[1] = u(rng); p[2] = u(rng); p[3] = 1.0f;
+        }
+        krs::par::ThreadPool& pool = krs::par::ThreadPool::global();
+        const float h2 = h * h;
+        auto density = [&](const CellTable& t, const float* data, std::vector<float>& rho) {
+            rho.assign(n, 0.0f);
+            std::vector<size_t> pairs(krs::par::chunkCount(n, 4096), 0);
+            krs::par::parallelFor(pool, n, 4096, [&](size_t lo, size_t hi) {
+                size_t cnt = 0;
+                for (size_t i = lo; i < hi; ++i) {
+                    const float* p = data + i * kStride;
+                    float sum = 0.0f;
+                    t.forEachNeighbor(data, kStride, glm::vec3(p[0], p[1], p[2]), h, [&](uint32_t, float d2) {
+                        const float s = h2 - d2;
+                        sum += s * s * s;                // poly6 without the constant
+                        ++cnt;
+                    });
+                    rho[i] = sum;
+                }
+                pairs[lo / 4096] = cnt;
+            });
+            return std::accumulate(pairs.begin(), pairs.end(), size_t(0));
+        };
+
+        CellTable table;
+        auto t0 = Clock::now();
+        table.build(spawn.data(), kStride, n, h, &pool);
+        const double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::vector<float> rhoSpawn, rhoSorted;
+        density(table, spawn.data(), rhoSpawn);          // warm-up
+        t0 = Clock::now();
+        const size_t pairs = density(table, spawn.data(), rhoSpawn);
+        const double spawnSec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        // Gather the particle array into Morton order (what a solver does every few steps).
+        t0 = Clock::now();
+        std::vector<float> sorted(n * kStride);
+        for (size_t k = 0; k < n; ++k)
+            std::memcpy(&sorted[k * kStride], &spawn[size_t(table.order()[k]) * kStride], sizeof(float) * kStride);
+        table.adoptOrder();
+        const double gatherMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        density(table, sorted.data(), rhoSorted);
+        t0 = Clock::now();
+        density(table, sorted.data(), rhoSorted);
+        const double sortedSec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        bool same = true;
+        for (size_t k = 0; k < n && same; ++k) same = rhoSorted[k] == rhoSpawn[table.order()[k]];
+        std::fprintf(stderr, "[MORTON]      bench: %zu particles (32 B), %zu cells, %.1f neighbours/query, "
+                             "%u threads; build %.1f ms, gather %.1f ms\n",
+                     n, table.cells(), double(pairs) / double(n), pool.size(), buildMs, gatherMs);
+        std::fprintf(stderr, "[MORTON]      spawn order %.2f Mqueries/s (%.1f Mpairs/s) -> Morton order %.2f "
+                             "Mqueries/s (%.1f Mpairs/s): %.2fx\n",
+                     n / spawnSec * 1e-6, pairs / spawnSec * 1e-6, n / sortedSec * 1e-6, pairs / sortedSec * 1e-6,
+                     spawnSec / sortedSec);
+        std::snprintf(buf, sizeof(buf), "(%.2fx neighbour-search throughput)", spawnSec / sortedSec);
+        report(same, "Morton order: same densities, bit for bit", buf);
+    }
+
+    std::fprintf(stderr, "[MORTON] %s (%d failure%s)\n", fails ? "FAIL" : "ALL PASS", fails, fails == 1 ? "" : "s");
+    return fails == 0;
+}
+
+} // namespace krs::morton
@@ -1,10 +1,14 @@
 #include "MpmAdjoint.hpp"
+#include "ParallelFor.hpp"
+#include "SysMem.hpp"
 
 #include <glm/gtc/matrix_access.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <thread>
 
 namespace krs::mpmad {
 
@@ -135,6 +139,29 @@ static mat3 elasticTauAdjoint(const mat3& F, double mu, double lambda, const mat
     return svd3Adjoint(U, s, V, gU, gS, mat3(0.0));          // chain to dL/dF
 }
 
+// Parameter adjoints of the two stresses: tau is linear in (mu, lambda).
+static inline double ddot(const mat3& a, const mat3& b) {
+    double r = 0.0;
+    for (int c = 0; c < 3; ++c) r += glm::dot(a[c], b[c]);
+    return r;
+}
+static void elasticTauParamAdjoint(const mat3& F, const mat3& gTau, double& gmu, double& glambda)
+{
+    mat3 U, V; vec3 s; svd3(F, U, s, V);
+    double J = s.x * s.y * s.z;
+    vec3 D(s.x * s.x - s.x, s.y * s.y - s.y, s.z * s.z - s.z);
+    gmu += ddot(gTau, 2.0 * (U * diag3(D) * glm::transpose(U)));
+    glambda += trace3(gTau) * (J - 1.0) * J;
+}
+static void sandTauParamAdjoint(const mat3& F, const mat3& gTau, double& gmu, double& glambda)
+{
+    mat3 U, V; vec3 s; svd3(F, U, s, V);
+    vec3 ln(std::log(std::max(std::abs(s.x), 1e-9)), std::log(std::max(std::abs(s.y), 1e-9)),
+            std::log(std::max(std::abs(s.z), 1e-9)));
+    gmu += ddot(gTau, U * diag3(2.0 * ln) * glm::transpose(U));
+    glambda += trace3(gTau) * (ln.x + ln.y + ln.z);
+}
+
 // Weakly-compressible fluid: tau = -J*p I, p = K(J^-gamma - 1).  (mu=K, lambda=gamma)
 static mat3 fluidTau(double J, double K, double gamma)
 {
@@ -170,18 +197,90 @@ static mat3 sandTauAdjoint(const mat3& F, double mu, double lambda, const mat3&
 }
 
 // ===========================================================================
-// Differentiable MLS-MPM rollout: forward (with tape) + tape-based reverse.
+// Differentiable MLS-MPM rollout: forward + reverse (full tape or checkpointed).
 // ===========================================================================
-struct Adj { vec3 ax{ 0.0 }, av{ 0.0 }; mat3 aC{ 0.0 }, aF{ 0.0 }; };
+struct Adj {
+    vec3 ax{ 0.0 }, av{ 0.0 }; mat3 aC{ 0.0 }, aF{ 0.0 };
+    double amu = 0.0, alambda = 0.0, aalpha = 0.0;           // material parameters (constant in time)
+};
 
 class Sim {
 public:
     Config cfg;
     std::vector<Particle> p;            // live particle state
     std::vector<std::vector<Particle>> tape; // particle state at the start of each step
+    krs::par::ThreadPool* pool = nullptr;    // nullptr = krs::par::ThreadPool::global()
 
     int N3() const { return cfg.N * cfg.N * cfg.N; }
     int idx(int x, int y, int z) const { return (z * cfg.N + y) * cfg.N + x; }
+    krs::par::ThreadPool& threads() const { return pool ? *pool : krs::par::ThreadPool::global(); }
+
+    // --- deterministic parallel scatter schedule --------------------------------
+    // A particle's 3x3x3 stencil starting at `base` stays inside its kBlock^3-node
+    // block plus a 2-node skirt, so blocks of the same parity colour (2x2x2 = 8
+    // colours) never share a node. Colours run in sequence, the blocks of one colour
+    // in parallel, the particles of a block in index order: every grid node sums its
+    // contributions in one fixed order whatever the thread count.
+    static constexpr int kBlock = 4;
+    struct Schedule {
+        std::vector<int> order;         // particle indices grouped by (colour, block)
+        std::vector<int> blockStart;    // non-empty blocks: [blockStart[b], blockStart[b+1]) in order
+        int colorBlock[9] = {};         // blocks of colour c: [colorBlock[c], colorBlock[c+1])
+        std::vector<int> key, count;    // scratch
+    };
+    // Grid-sized buffers, reused across substeps (no per-step allocation).
+    struct Scratch {
+        std::vector<double> gM, agM;
+        std::vector<vec3> gMom, gV, agV, agMom;
+        std::vector<glm::ivec3> mask;
+        Schedule sched;
+    };
+    Scratch scratch;
+
+    void buildSchedule(Schedule& sc) const {
+        const int nb = (cfg.N + 1) / kBlock + 1;             // blocks per axis over base in [-1, N]
+        const int nBlocks = nb * nb * nb;
+        sc.key.resize(p.size());
+        sc.count.assign(8 * nBlocks + 1, 0);
+        for (size_t i = 0; i < p.size(); ++i) {
+            const glm::ivec3 base = glm::clamp(glm::ivec3(glm::floor((p[i].x - cfg.origin) / cfg.dx - 0.5)),
+                                               glm::ivec3(-1), glm::ivec3(cfg.N));
+            const glm::ivec3 b = (base + 1) / kBlock;
+            const int color = (b.x & 1) | ((b.y & 1) << 1) | ((b.z & 1) << 2);
+            sc.key[i] = color * nBlocks + (b.z * nb + b.y) * nb + b.x;
+            ++sc.count[sc.key[i] + 1];
+        }
+        // prefix sum -> stable counting sort (particles keep index order inside a block)
+        for (size_t k = 1; k < sc.count.size(); ++k) sc.count[k] += sc.count[k - 1];
+        sc.blockStart.clear();
+        for (int c = 0; c < 8; ++c) {
+            sc.colorBlock[c] = int(sc.blockStart.size());
+            for (int k = c * nBlocks; k < (c + 1) * nBlocks; ++k)
+                if (sc.count[k + 1] > sc.count[k]) sc.blockStart.push_back(sc.count[k]);
+        }
+        sc.colorBlock[8] = int(sc.blockStart.size());
+        sc.blockStart.push_back(int(p.size()));
+        sc.order.resize(p.size());
+        for (size_t i = 0; i < p.size(); ++i) sc.order[sc.count[sc.key[i]]++] = int(i);
+    }
+    // fn(particleIndex) for every particle, scattering race-free per the schedule.
+    template <class Fn>
+    void scatter(const Schedule& sc, Fn&& fn) const {
+        for (int c = 0; c < 8; ++c) {
+            const int b0 = sc.colorBlock[c];
+            krs::par::parallelFor(threads(), size_t(sc.colorBlock[c + 1] - b0), 1, [&](size_t lo, size_t hi) {
+                for (size_t b = b0 + lo; b < b0 + hi; ++b)
+                    for (int k = sc.blockStart[b]; k < sc.blockStart[b + 1]; ++k) fn(size_t(sc.order[k]));
+            });
+        }
+    }
+    // fn(i) for i in [0, n): independent per-item work (gathers, per-node updates).
+    template <class Fn>
+    void forEach(size_t n, size_t grain, Fn&& fn) const {
+        krs::par::parallelFor(threads(), n, grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) fn(i);
+        });
+    }
 
     // --- per-particle quadratic B-spline stencil data (weights + derivatives) ---
     struct Stencil { glm::ivec3 base; vec3 fx; vec3 w[3], dw[3]; };
@@ -205,13 +304,17 @@ public:
         return elasticTau(pp.F, pp.mu, pp.lambda);
     }
 
-    // Forward grid (mass, momentum, velocity, BC mask) from the current particles.
-    void buildGrid(std::vector<double>& gM, std::vector<vec3>& gMom,
-                   std::vector<vec3>& gV, std::vector<glm::ivec3>& mask) const {
+    // Forward grid (mass, momentum, velocity, BC mask) from the current particles,
+    // into scratch (also rebuilds the scatter schedule for this state).
+    void buildGrid() {
         const double Dinv = 4.0 / (cfg.dx * cfg.dx);
-        std::fill(gM.begin(), gM.end(), 0.0);
-        std::fill(gMom.begin(), gMom.end(), vec3(0.0));
-        for (const auto& pp : p) {                            // ---- P2G ----
+        Scratch& g = scratch;
+        std::vector<double>& gM = g.gM; std::vector<vec3>& gMom = g.gMom;
+        std::vector<vec3>& gV = g.gV; std::vector<glm::ivec3>& mask = g.mask;
+        gM.assign(N3(), 0.0); gMom.assign(N3(), vec3(0.0)); gV.resize(N3()); mask.resize(N3());
+        buildSchedule(g.sched);
+        scatter(g.sched, [&](size_t pi) {                     // ---- P2G ----
+            const Particle& pp = p[pi];
             Stencil st = stencil(pp.x);
             mat3 affine = pp.mass * pp.C - (cfg.dt * pp.vol * Dinv) * stress(pp); // APIC + internal force
             for (int a = 0; a < 3; ++a) for (int b = 0; b < 3; ++b) for (int c = 0; c < 3; ++c) {
@@ -223,8 +326,8 @@ public:
                 gM[n] += wt * pp.mass;                        // scatter mass
                 gMom[n] += wt * (pp.mass * pp.v + affine * dpos); // scatter momentum
             }
-        }
-        for (int n = 0; n < N3(); ++n) {                      // ---- grid update ----
+        });
+        forEach(size_t(N3()), 1024, [&](size_t n) {           // ---- grid update ----
             mask[n] = glm::ivec3(0);
             if (gM[n] > 1e-12) {
                 vec3 v = gMom[n] / gM[n] + cfg.dt * cfg.gravity; // momentum->velocity + gravity
@@ -237,14 +340,15 @@ public:
                 if (z >= cfg.N - cfg.bound && v.z > 0) { v.z = 0; mask[n].z = 1; }
                 gV[n] = v;
             } else gV[n] = vec3(0.0);
-        }
+        });
     }
 
     void stepForward() {
         const double Dinv = 4.0 / (cfg.dx * cfg.dx);
-        std::vector<double> gM(N3()); std::vector<vec3> gMom(N3()), gV(N3()); std::vector<glm::ivec3> mask(N3());
-        buildGrid(gM, gMom, gV, mask);
-        for (auto& pp : p) {                                  // ---- G2P ----
+        buildGrid();
+        const std::vector<vec3>& gV = scratch.gV;
+        forEach(p.size(), 64, [&](size_t pi) {                // ---- G2P ----
+            Particle& pp = p[pi];
             Stencil st = stencil(pp.x);
             vec3 vnew(0.0); mat3 Cnew(0.0);
             for (int a = 0; a < 3; ++a) for (int b = 0; b < 3; ++b) for (int c = 0; c < 3; ++c) {
@@ -266,7 +370,7 @@ public:
                 pp.F = Fnew;                                  // elastic: no plasticity
             }
             pp.v = vnew; pp.C = Cnew;
-        }
+        });
     }
 
     // --- Drucker-Prager return map: project log-singular-values onto the cone ---
@@ -292,7 +396,8 @@ public:
     }
 
     // Adjoint of the deformation-gradient plasticity (F'' = plastic(F')): aF'' -> aF'.
-    mat3 plasticAdjoint(const Particle& pp, const mat3& Fp, const mat3& aFpp) const {
+    // The cone projection also depends on (mu, lambda, alpha); those adjoints go to `ap`.
+    mat3 plasticAdjoint(const Particle& pp, const mat3& Fp, const mat3& aFpp, Adj& ap) const {
         if (pp.material != Mat::Sand) return aFpp;            // elastic/fluid: identity map
         mat3 U, V; vec3 s; svd3(Fp, U, s, V);
         bool proj; vec3 sp = dpProject(s, pp.alpha, pp.mu, pp.lambda, proj);
@@ -317,17 +422,22 @@ public:
             double k = (3.0 * pp.lambda + 2.0 * pp.mu) / (2.0 * pp.mu);
             double dg = nn + k * t * pp.alpha;
             vec3 gH = gSp * sp;                               // d sp/d H = exp(H) = sp
-            // J_H = dH/d eps = I - n n^T - k*alpha n 1^T - (dg/nn)(I - (1/3)11^T + n n^T)
+            // J_H = dH/d eps = I - n n^T - k*alpha n 1^T - (dg/nn)(I - (1/3)11^T - n n^T)
             mat3 JH(0.0);
             for (int i = 0; i < 3; ++i) for (int j = 0; j < 3; ++j) {
                 double Iij = (i == j) ? 1.0 : 0.0;
                 double v = Iij - nhat[i] * nhat[j] - k * pp.alpha * nhat[i]
-                         - (dg / nn) * (Iij - (1.0 / 3.0) + nhat[i] * nhat[j]);
+                         - (dg / nn) * (Iij - (1.0 / 3.0) - nhat[i] * nhat[j]);
                 setE(JH, i, j, v);
             }
             vec3 gEps(0.0);                                   // gEps = J_H^T gH
             for (int j = 0; j < 3; ++j) for (int i = 0; i < 3; ++i) gEps[j] += E(JH, i, j) * gH[i];
             for (int i = 0; i < 3; ++i) gS[i] = gEps[i] / s[i]; // d eps/d sig = 1/sig
+            // dH/d(param) = -(d dg/d param) nhat; dg = nn + k t alpha, k = 3 lambda/(2 mu) + 1
+            const double gDg = -glm::dot(gH, nhat);
+            ap.amu += gDg * t * pp.alpha * (-3.0 * pp.lambda / (2.0 * pp.mu * pp.mu));
+            ap.alambda += gDg * t * pp.alpha * (3.0 / (2.0 * pp.mu));
+            ap.aalpha += gDg * k * t;
         }
         return svd3Adjoint(U, s, V, gU, gS, gV);
     }
@@ -335,13 +445,15 @@ public:
     // Reverse pass over one step: output adjoints `ao` -> input adjoints `ai`.
     void stepBackward(const std::vector<Adj>& ao, std::vector<Adj>& ai) {
         const double Dinv = 4.0 / (cfg.dx * cfg.dx);
-        std::vector<double> gM(N3()); std::vector<vec3> gMom(N3()), gV(N3()); std::vector<glm::ivec3> mask(N3());
-        buildGrid(gM, gMom, gV, mask);                        // recompute forward grid from input state
-        std::vector<vec3> agV(N3(), vec3(0.0)), agMom(N3(), vec3(0.0));
-        std::vector<double> agM(N3(), 0.0);
+        buildGrid();                                          // recompute forward grid from input state
+        Scratch& gr = scratch;
+        const std::vector<double>& gM = gr.gM; const std::vector<vec3>& gMom = gr.gMom;
+        const std::vector<vec3>& gV = gr.gV; const std::vector<glm::ivec3>& mask = gr.mask;
+        std::vector<vec3>& agV = gr.agV; std::vector<vec3>& agMom = gr.agMom; std::vector<double>& agM = gr.agM;
+        agV.assign(N3(), vec3(0.0)); agMom.assign(N3(), vec3(0.0)); agM.assign(N3(), 0.0);
         ai.assign(p.size(), Adj{});
 
-        for (size_t pi = 0; pi < p.size(); ++pi) {            // ---- adjoint G2P ----
+        scatter(gr.sched, [&](size_t pi) {                    // ---- adjoint G2P ----
             const Particle& pp = p[pi];
             Stencil st = stencil(pp.x);
             vec3 vnew(0.0); mat3 Cnew(0.0);                   // recompute forward G2P outputs
@@ -355,7 +467,8 @@ public:
             }
             mat3 A = mat3(1.0) + cfg.dt * Cnew;               // F' = A F
             mat3 Fp = A * pp.F;
-            mat3 aFp = plasticAdjoint(pp, Fp, ao[pi].aF);     // adjoint of plasticity
+            ai[pi].amu = ao[pi].amu; ai[pi].alambda = ao[pi].alambda; ai[pi].aalpha = ao[pi].aalpha;
+            mat3 aFp = plasticAdjoint(pp, Fp, ao[pi].aF, ai[pi]); // adjoint of plasticity
             mat3 aA = aFp * glm::transpose(pp.F);             // dL/dA = aF' F^T
             ai[pi].aF += glm::transpose(A) * aFp;             // dL/dF_in += A^T aF'
             vec3 AVN = ao[pi].av + cfg.dt * ao[pi].ax;        // grad of vnew (from v' and x'=x+dt v)
@@ -375,15 +488,15 @@ public:
                 ai[pi].ax += Dinv * glm::dot(g, ACN * dpos) * gwt;          // Cnew via weight(x)
                 ai[pi].ax += -Dinv * wt * (glm::transpose(ACN) * g);        // Cnew via dpos(x)
             }
-        }
-        for (int n = 0; n < N3(); ++n) {                      // ---- adjoint grid update ----
-            if (gM[n] <= 1e-12) continue;
+        });
+        forEach(size_t(N3()), 1024, [&](size_t n) {           // ---- adjoint grid update ----
+            if (gM[n] <= 1e-12) return;
             vec3 a = agV[n];
             if (mask[n].x) a.x = 0; if (mask[n].y) a.y = 0; if (mask[n].z) a.z = 0; // BC kills masked grads
             agMom[n] = a / gM[n];                             // d v/d momentum = 1/m
             agM[n] = glm::dot(a, -gMom[n] / (gM[n] * gM[n])); // d v/d mass = -mom/m^2
-        }
-        for (size_t pi = 0; pi < p.size(); ++pi) {            // ---- adjoint P2G ----
+        });
+        forEach(p.size(), 64, [&](size_t pi) {                // ---- adjoint P2G (gather) ----
             const Particle& pp = p[pi];
             Stencil st = stencil(pp.x);
             mat3 affine = pp.mass * pp.C - (cfg.dt * pp.vol * Dinv) * stress(pp);
@@ -406,11 +519,99 @@ public:
             }
             ai[pi].aC += pp.mass * aAffine;                    // affine = mass*C - ...
             mat3 aTau = -(cfg.dt * pp.vol * Dinv) * aAffine;   // dL/d tau
-            if (pp.material == Mat::Elastic) ai[pi].aF += elasticTauAdjoint(pp.F, pp.mu, pp.lambda, aTau);
-            else if (pp.material == Mat::Sand) ai[pi].aF += sandTauAdjoint(pp.F, pp.mu, pp.lambda, aTau);
+            if (pp.material == Mat::Elastic) {
+                ai[pi].aF += elasticTauAdjoint(pp.F, pp.mu, pp.lambda, aTau);
+                elasticTauParamAdjoint(pp.F, aTau, ai[pi].amu, ai[pi].alambda);
+            } else if (pp.material == Mat::Sand) {
+                ai[pi].aF += sandTauAdjoint(pp.F, pp.mu, pp.lambda, aTau);
+                sandTauParamAdjoint(pp.F, aTau, ai[pi].amu, ai[pi].alambda);
+            }
             // fluid stress depends on Jp (scalar), handled via Jp chain (omitted: not a control here)
+        });
+    }
+
+    // --- reverse sweep: full tape or binomial checkpointing ---------------------
+    // Rolls out cfg.steps substeps from the current state `p` and returns the
+    // adjoints w.r.t. that initial state. seed(sim, a) is called once with sim.p at
+    // the FINAL state and fills the final adjoints `a`.
+    template <class Seed>
+    std::vector<Adj> gradient(Seed&& seed, CheckpointStats* stats = nullptr) {
+        const auto t0 = std::chrono::steady_clock::now();
+        CheckpointStats st; st.steps = cfg.steps;
+        const size_t stateBytes = p.size() * sizeof(Particle);
+        std::vector<Adj> a(p.size()), ai;
+        if (cfg.checkpoints <= 0 || cfg.checkpoints >= cfg.steps) {
+            tape.resize(cfg.steps);                           // snapshots reuse their capacity
+            for (int s = 0; s < cfg.steps; ++s) { tape[s] = p; stepForward(); ++st.forwardSteps; }
+            st.snapshots = cfg.steps;
+            seed(*this, a);
+            for (int s = cfg.steps - 1; s >= 0; --s) {
+                p = tape[s];
+                stepBackward(a, ai); a.swap(ai); ++st.backwardSteps;
+            }
+        } else {
+            Revolve rv{ *this, st, false, 0 };
+            const std::vector<Particle> s0 = p;
+            rv.held = 1;
+            rv.reverse(0, cfg.steps, cfg.checkpoints, s0, a, seed);
         }
+        st.peakStateBytes = size_t(st.snapshots) * stateBytes;
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        st.processPeakRssBytes = processPeakWorkingSetBytes();
+        if (stats) *stats = st;
+        return a;
     }
+
+    // Griewank-Walther binomial checkpointing (Revolve). With c snapshots (incl. the
+    // one at s) and t forward repetitions, at most beta(c,t) = C(c+t, c) steps can be
+    // reversed. The segment [s,e) is split at m so that the right part uses c-1
+    // snapshots at t repetitions and the left part c snapshots at t-1 (Pascal:
+    // beta(c,t) = beta(c-1,t) + beta(c,t-1)); c == 1 replays from s for every step.
+    struct Revolve {
+        Sim& sim;
+        CheckpointStats& st;
+        bool seeded;
+        int held;
+
+        static double beta(int c, int t) {
+            double b = 1.0;                                   // C(c+t, c), saturating
+            for (int i = 1; i <= c; ++i) { b = b * (t + i) / i; if (b > 1e15) return 1e15; }
+            return b;
+        }
+        void advance(int k) { for (int i = 0; i < k; ++i) { sim.stepForward(); ++st.forwardSteps; } }
+
+        // `snap` = stored state at step s; `a` = adjoints at e on entry (unset until
+        // seeded at the final state), at s on exit.
+        template <class Seed>
+        void reverse(int s, int e, int c, const std::vector<Particle>& snap, std::vector<Adj>& a, Seed& seed) {
+            st.snapshots = std::max(st.snapshots, held);
+            std::vector<Adj> ai;
+            if (c == 1 || e - s == 1) {
+                for (int i = e - 1; i >= s; --i) {
+                    sim.p = snap; advance(i - s);
+                    if (!seeded) {                            // first visit of the last step
+                        const std::vector<Particle> xi = sim.p;
+                        advance(1); seed(sim, a); seeded = true;
+                        sim.p = xi;
+                    }
+                    sim.stepBackward(a, ai); a.swap(ai); ++st.backwardSteps;
+                }
+                return;
+            }
+            const int n = e - s;
+            int t = 0;
+            while (beta(c, t) < n) ++t;
+            const int m = e - int(std::min<double>(beta(c - 1, t), n - 1));
+            sim.p = snap; advance(m - s);
+            {
+                const std::vector<Particle> snapM = sim.p;
+                ++held;
+                reverse(m, e, c - 1, snapM, a, seed);
+                --held;
+            }
+            reverse(s, m, c, snap, a, seed);
+        }
+    };
 };
 
 // ===========================================================================
@@ -450,7 +651,7 @@ GradCheck checkSvdAdjoint()
 }
 
 // Build a small deforming elastic block with a fixed shear field + control v0.
-static Sim makeElasticBlock(const vec3& v0, Mat material)
+static Sim makeElasticBlock(const vec3& v0, Mat material, int side = 4)
 {
     Sim sim; sim.cfg = Config{};
     sim.cfg.N = 20; sim.cfg.dx = 0.1; sim.cfg.origin = vec3(-1.0, -0.2, -1.0);
@@ -460,9 +661,9 @@ static Sim makeElasticBlock(const vec3& v0, Mat material)
     const double sphi = std::sin(35.0 * 3.14159265358979 / 180.0);
     const double alpha = std::sqrt(2.0 / 3.0) * (2.0 * sphi) / (3.0 - sphi);
     vec3 c0(0.0, 0.30, 0.0);
-    for (int ix = 0; ix < 4; ++ix) for (int iy = 0; iy < 4; ++iy) for (int iz = 0; iz < 4; ++iz) {
+    for (int ix = 0; ix < side; ++ix) for (int iy = 0; iy < side; ++iy) for (int iz = 0; iz < side; ++iz) {
         Particle pp;
-        pp.x = c0 + (vec3(ix, iy, iz) - 1.5) * sp;
+        pp.x = c0 + (vec3(ix, iy, iz) - 0.5 * (side - 1)) * sp;
         pp.v = v0 + vec3(0.8 * (pp.x.y - c0.y), 0.0, 0.0); // control + fixed shear -> deforms F
         pp.mass = density * sp * sp * sp; pp.vol = sp * sp * sp;
         pp.mu = mu; pp.lambda = lambda; pp.alpha = alpha; pp.material = material;
@@ -498,14 +699,7 @@ static GradCheck checkControlGradient(Mat material, double tol)
     Sim sim = makeElasticBlock(v0, material);
     std::vector<vec3> xt(sim.p.size());                      // target = initial positions
     for (size_t i = 0; i < sim.p.size(); ++i) xt[i] = sim.p[i].x;
-    sim.tape.clear();
-    for (int s = 0; s < sim.cfg.steps; ++s) { sim.tape.push_back(sim.p); sim.stepForward(); }
-    std::vector<Adj> a(sim.p.size());                        // final-state adjoints
-    dispLoss(sim, xt, &a);
-    for (int s = sim.cfg.steps - 1; s >= 0; --s) {           // reverse march
-        sim.p = sim.tape[s];
-        std::vector<Adj> ai; sim.stepBackward(a, ai); a = ai;
-    }
+    const std::vector<Adj> a = sim.gradient([&](Sim& s, std::vector<Adj>& aF) { dispLoss(s, xt, &aF); });
     vec3 dLdv0(0.0); for (auto& ad : a) dLdv0 += ad.av;      // v_p^0 = v0 for all p => sum av
     const double h = 1e-6;
     double scale = 1e-12;                                    // normalize error by gradient magnitude
@@ -523,6 +717,176 @@ static GradCheck checkControlGradient(Mat material, double tol)
 GradCheck checkElasticGradient() { return checkControlGradient(Mat::Elastic, 1e-5); }
 GradCheck checkSandGradient() { return checkControlGradient(Mat::Sand, 1e-4); }
 
+int checkpointsForBudget(size_t bytes, size_t particles)
+{
+    const size_t per = std::max<size_t>(1, particles) * sizeof(Particle);
+    return int(std::max<size_t>(1, std::min<size_t>(bytes / per, size_t(1) << 30)));
+}
+
+GradCheck checkCheckpointedGradient(int steps, int checkpoints, int side,
+                                    CheckpointStats* tapeStats, CheckpointStats* ckptStats)
+{
+    GradCheck gc;
+    const vec3 v0(0.3, -2.0, 0.15);
+    auto run = [&](int budget, CheckpointStats* st) {
+        Sim sim = makeElasticBlock(v0, Mat::Elastic, side);
+        sim.cfg.steps = steps; sim.cfg.checkpoints = budget;
+        std::vector<vec3> xt(sim.p.size());
+        for (size_t i = 0; i < sim.p.size(); ++i) xt[i] = sim.p[i].x;
+        const std::vector<Adj> a = sim.gradient([&](Sim& s, std::vector<Adj>& aF) { dispLoss(s, xt, &aF); }, st);
+        vec3 g(0.0); for (const auto& ad : a) g += ad.av;
+        return g;
+    };
+    const vec3 gc_ = run(checkpoints, ckptStats);
+    const vec3 gt = run(0, tapeStats);
+    double scale = 1e-300;
+    for (int k = 0; k < 3; ++k) scale = std::max(scale, std::abs(gt[k]));
+    for (int k = 0; k < 3; ++k) {
+        gc.analytic.push_back(gc_[k]); gc.numeric.push_back(gt[k]);  // "numeric" = full-tape reference
+        gc.maxRelErr = std::max(gc.maxRelErr, std::abs(gc_[k] - gt[k]) / scale);
+    }
+    gc.pass = gc.maxRelErr <= 1e-9 && std::isfinite(scale);
+    return gc;
+}
+
+std::vector<ScalingPoint> benchmarkThreadScaling(int side, int steps, const std::vector<unsigned>& threads)
+{
+    std::vector<ScalingPoint> out;
+    std::vector<Particle> refP; std::vector<Adj> refA;
+    auto same = [](const mat3& a, const mat3& b) { return a == b; };
+    for (unsigned t : threads) {
+        krs::par::ThreadPool pool(t);
+        Sim sim = makeElasticBlock(vec3(0.3, -2.0, 0.15), Mat::Elastic, side);
+        sim.cfg.N = 32; sim.cfg.origin = vec3(-1.6, -0.2, -1.6);  // room for large blocks
+        for (auto& pp : sim.p) pp.x.y += 0.5;
+        sim.cfg.steps = steps; sim.pool = &pool;
+        std::vector<vec3> xt(sim.p.size());
+        for (size_t i = 0; i < sim.p.size(); ++i) xt[i] = sim.p[i].x;
+        std::vector<Particle> finalP;
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::vector<Adj> a = sim.gradient([&](Sim& s, std::vector<Adj>& aF) {
+            finalP = s.p; dispLoss(s, xt, &aF);
+        });
+        ScalingPoint sp; sp.threads = pool.size();
+        sp.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (out.empty()) { refP = finalP; refA = a; sp.bitIdentical = true; }
+        else {
+            sp.speedup = out.front().seconds / std::max(sp.seconds, 1e-12);
+            sp.bitIdentical = finalP.size() == refP.size() && a.size() == refA.size();
+            for (size_t i = 0; sp.bitIdentical && i < a.size(); ++i)
+                sp.bitIdentical = finalP[i].x == refP[i].x && same(finalP[i].F, refP[i].F)
+                               && a[i].ax == refA[i].ax && a[i].av == refA[i].av
+                               && same(a[i].aC, refA[i].aC) && same(a[i].aF, refA[i].aF);
+        }
+        out.push_back(sp);
+    }
+    return out;
+}
+
+// ===========================================================================
+// Batched parameter sweeps
+// ===========================================================================
+static void applyMaterial(std::vector<Particle>& ps, const MaterialSample& m)
+{
+    const double mu = m.youngsE / (2.0 * (1.0 + m.nu));
+    const double lambda = m.youngsE * m.nu / ((1.0 + m.nu) * (1.0 - 2.0 * m.nu));
+    const double sphi = std::sin(m.frictionDeg * 3.14159265358979 / 180.0);
+    const double alpha = std::sqrt(2.0 / 3.0) * (2.0 * sphi) / (3.0 - sphi);
+    for (auto& pp : ps) {
+        if (pp.material == Mat::Fluid) continue;                // fluid: mu/lambda are K/gamma
+        pp.mu = mu; pp.lambda = lambda;
+        if (pp.material == Mat::Sand) pp.alpha = alpha;
+    }
+}
+
+// One sample on a reused simulator: reset state, roll out, reverse, chain the
+// per-particle (mu, lambda, alpha) adjoints to (E, nu, friction angle).
+static SweepResult sweepSample(Sim& sim, const SweepSetup& setup, const MaterialSample& m)
+{
+    sim.p.assign(setup.particles.begin(), setup.particles.end()); // capacity reused
+    applyMaterial(sim.p, m);
+    SweepResult r;
+    const std::vector<Adj> a = sim.gradient([&](Sim& s, std::vector<Adj>& aF) {
+        r.loss = dispLoss(s, setup.target, &aF);
+    });
+    double gmu = 0.0, glambda = 0.0, galpha = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        r.dLdv0 += a[i].av;
+        gmu += a[i].amu; glambda += a[i].alambda; galpha += a[i].aalpha;
+    }
+    const double E = m.youngsE, nu = m.nu, d = (1.0 + nu) * (1.0 - 2.0 * nu);
+    r.dLdE = gmu / (2.0 * (1.0 + nu)) + glambda * nu / d;
+    r.dLdNu = gmu * (-E / (2.0 * (1.0 + nu) * (1.0 + nu))) + glambda * E * (1.0 + 2.0 * nu * nu) / (d * d);
+    const double phi = m.frictionDeg * 3.14159265358979 / 180.0, sphi = std::sin(phi);
+    const double dAlphaDphi = std::sqrt(2.0 / 3.0) * 6.0 * std::cos(phi) / ((3.0 - sphi) * (3.0 - sphi));
+    r.dLdFriction = galpha * dAlphaDphi * (3.14159265358979 / 180.0);
+    return r;
+}
+
+std::vector<SweepResult> runParameterSweep(const SweepSetup& setup, const std::vector<MaterialSample>& samples,
+                                           SweepStats* stats)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<SweepResult> out(samples.size());
+    krs::par::ThreadPool& pool = krs::par::ThreadPool::global();
+    // One contiguous slice (and one simulator arena) per participant.
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(pool.size(), samples.size()));
+    const size_t grain = (samples.size() + workers - 1) / std::max<size_t>(1, workers);
+    krs::par::parallelFor(pool, samples.size(), grain, [&](size_t lo, size_t hi) {
+        Sim sim; sim.cfg = setup.cfg;                          // inner loops run inline on this thread
+        for (size_t i = lo; i < hi; ++i) out[i] = sweepSample(sim, setup, samples[i]);
+    });
+    if (stats) {
+        stats->samples = int(samples.size());
+        stats->threads = pool.size();
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        stats->samplesPerSec = stats->seconds > 0.0 ? samples.size() / stats->seconds : 0.0;
+    }
+    return out;
+}
+
+// Setup for the sweep checks: the makeElasticBlock layout with per-particle targets.
+static SweepSetup makeSweepSetup(Mat material, int steps)
+{
+    Sim sim = makeElasticBlock(vec3(0.3, -2.0, 0.15), material);
+    for (auto& pp : sim.p) pp.x.y -= 0.17;                  // start just above the floor: impact loads it
+    SweepSetup su; su.cfg = sim.cfg; su.cfg.steps = steps; su.particles = sim.p;
+    for (const auto& pp : sim.p) su.target.push_back(pp.x + vec3(0.02, 0.0, -0.01));
+    return su;
+}
+
+static double sweepLossOnly(const SweepSetup& su, const MaterialSample& m)
+{
+    Sim sim; sim.cfg = su.cfg; sim.p = su.particles; applyMaterial(sim.p, m);
+    for (int s = 0; s < sim.cfg.steps; ++s) sim.stepForward();
+    return dispLoss(sim, su.target, nullptr);
+}
+
+// Parameter gradients vs central FD: elastic (E, nu), sand (E, friction).
+GradCheck checkMaterialGradient()
+{
+    GradCheck gc;
+    const MaterialSample m0{ 1.0e4, 0.2, 35.0 };
+    struct Probe { Mat mat; int which; double h; };           // which: 0 = E, 1 = nu, 2 = friction
+    const Probe probes[] = { { Mat::Elastic, 0, 1.0 }, { Mat::Elastic, 1, 1e-5 },
+                             { Mat::Sand, 0, 1.0 }, { Mat::Sand, 2, 1e-4 } };
+    for (const Probe& pr : probes) {
+        const SweepSetup su = makeSweepSetup(pr.mat, 30);
+        Sim sim; sim.cfg = su.cfg;
+        const SweepResult r = sweepSample(sim, su, m0);
+        const double ana = pr.which == 0 ? r.dLdE : pr.which == 1 ? r.dLdNu : r.dLdFriction;
+        MaterialSample mp = m0, mm = m0;
+        double* fp = pr.which == 0 ? &mp.youngsE : pr.which == 1 ? &mp.nu : &mp.frictionDeg;
+        double* fm = pr.which == 0 ? &mm.youngsE : pr.which == 1 ? &mm.nu : &mm.frictionDeg;
+        *fp += pr.h; *fm -= pr.h;
+        const double num = (sweepLossOnly(su, mp) - sweepLossOnly(su, mm)) / (2.0 * pr.h);
+        gc.analytic.push_back(ana); gc.numeric.push_back(num);
+        gc.maxRelErr = std::max(gc.maxRelErr, relErr(ana, num));
+    }
+    gc.pass = gc.maxRelErr < 1e-4;
+    return gc;
+}
+
 // von Mises of the Cauchy stress sigma = tau/J for a Neo-Hookean F.
 static double vonMises(const mat3& F, double mu, double lambda)
 {
@@ -580,6 +944,67 @@ bool runSelfTests()
     ok &= log("svd3 adjoint", checkSvdAdjoint());
     ok &= log("elastic dL/dv0 (<1e-5)", checkElasticGradient());
     ok &= log("sand dL/dv0 (DP, <1e-4)", checkSandGradient());
+    ok &= log("checkpointed == tape (<1e-9)", checkCheckpointedGradient(30, 3));
+    {
+        // Long rollout: reverse-pass memory and recompute cost, tape vs checkpointed.
+        const int steps = 1000, side = 8;
+        const int budget = checkpointsForBudget(size_t(8) << 20, size_t(side) * side * side); // 8 MiB
+        CheckpointStats tp, ck;
+        const GradCheck g = checkCheckpointedGradient(steps, budget, side, &tp, &ck);
+        ok &= log("long rollout ckpt == tape", g);
+        std::fprintf(stderr, "[ADJOINT]     steps=%d particles=%d budget=%d snapshots\n", steps, side * side * side, budget);
+        std::fprintf(stderr, "[ADJOINT]     tape: state=%.1f MiB fwd=%lld t=%.2fs | ckpt: state=%.2f MiB peakSnaps=%d "
+                     "fwd=%lld recompute=+%.0f%% t=%.2fs\n",
+                     tp.peakStateBytes / 1048576.0, tp.forwardSteps, tp.seconds,
+                     ck.peakStateBytes / 1048576.0, ck.snapshots, ck.forwardSteps,
+                     100.0 * ck.recomputeOverhead(), ck.seconds);
+        std::fprintf(stderr, "[ADJOINT]     process peak RSS: after ckpt %.1f MiB, after tape %.1f MiB\n",
+                     ck.processPeakRssBytes / 1048576.0, tp.processPeakRssBytes / 1048576.0);
+        const bool bounded = ck.peakStateBytes <= (size_t(8) << 20) && ck.peakStateBytes < tp.peakStateBytes / 10;
+        std::fprintf(stderr, "[ADJOINT] %-26s %s\n", "ckpt state <= budget", bounded ? "PASS" : "FAIL");
+        ok &= bounded;
+    }
+    {
+        // Deterministic multithreaded P2G/G2P: bit-identical across thread counts.
+        const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> counts{ 1u, 2u, 4u };
+        if (hw > 4) counts.push_back(hw);
+        const auto pts = benchmarkThreadScaling(12, 20, counts);
+        bool bits = true;
+        for (const auto& sp : pts) {
+            std::fprintf(stderr, "[ADJOINT]     threads=%u fwd+rev %.3fs speedup=%.2fx bitIdentical=%d\n",
+                         sp.threads, sp.seconds, sp.speedup, int(sp.bitIdentical));
+            bits &= sp.bitIdentical;
+        }
+        std::fprintf(stderr, "[ADJOINT] %-26s %s  (1728 particles, 20 steps, hw=%u)\n",
+                     "parallel == serial (bits)", bits ? "PASS" : "FAIL", hw);
+        ok &= bits;
+    }
+    ok &= log("dL/d(E,nu,E,phi) (<1e-4)", checkMaterialGradient());
+    {
+        // Batched sweep: 8x8 (E, nu) grid on the sand block; throughput vs a naive
+        // loop that builds a fresh simulator per sample, and bit-identity between them.
+        const SweepSetup su = makeSweepSetup(Mat::Sand, 30);
+        std::vector<MaterialSample> grid;
+        for (int i = 0; i < 8; ++i) for (int j = 0; j < 8; ++j)
+            grid.push_back({ 5.0e3 + 1.0e3 * i, 0.1 + 0.03 * j, 30.0 + i });
+        SweepStats st;
+        const std::vector<SweepResult> batch = runParameterSweep(su, grid, &st);
+        const auto t0 = std::chrono::steady_clock::now();
+        bool same = true;
+        for (size_t i = 0; i < grid.size(); ++i) {
+            Sim sim; sim.cfg = su.cfg;
+            const SweepResult r = sweepSample(sim, su, grid[i]);
+            same &= r.loss == batch[i].loss && r.dLdE == batch[i].dLdE && r.dLdNu == batch[i].dLdNu
+                 && r.dLdFriction == batch[i].dLdFriction && r.dLdv0 == batch[i].dLdv0;
+        }
+        const double naive = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::fprintf(stderr, "[ADJOINT]     sweep %d samples x %d steps: batch %.1f samples/s (%u threads) | "
+                     "naive %.1f samples/s | x%.2f\n", st.samples, su.cfg.steps, st.samplesPerSec, st.threads,
+                     grid.size() / naive, naive / std::max(st.seconds, 1e-12));
+        std::fprintf(stderr, "[ADJOINT] %-26s %s\n", "sweep == isolated (bits)", same ? "PASS" : "FAIL");
+        ok &= same;
+    }
     std::fprintf(stderr, "[ADJOINT] overall: %s\n", ok ? "ALL PASS" : "FAILURES PRESENT");
     return ok;
 }
@@ -3,8 +3,26 @@
 
 #include <glm/gtc/quaternion.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
 namespace krs::orb {
 
+namespace {
+// Closest-point test of cell box [lo, lo + cs] against the sphere, on the box grown by
+// eps. Particles were binned by floor((p - origin) / cs), which can leave one a few ulps
+// outside the box rebuilt as origin + x * cs; the margin keeps the cull conservative.
+bool cellReachesSphere(const glm::vec3& lo, float cs, float eps, const glm::vec3& center, float r2)
+{
+    const glm::vec3 q = glm::clamp(center, lo - eps, lo + (cs + eps)) - center;
+    return glm::dot(q, q) <= r2;
+}
+} // namespace
+
 OrbVelocity averageVelocityInSphere(const std::vector<glm::vec3>& positions,
                                     const std::vector<glm::vec3>& velocities,
                                     const glm::vec3& center, float radius)
@@ -20,6 +38,202 @@ OrbVelocity averageVelocityInSphere(const std::vector<glm::vec3>& positions,
     return { n > 0 ? sum / float(n) : glm::vec3(0.0f), n };
 }
 
+void ProbeIndex::build(std::vector<glm::vec3> positions, std::vector<glm::vec3> velocities, float cellSize,
+                       krs::par::ThreadPool* pool)
+{
+    const size_t count = std::min(positions.size(), velocities.size());
+    positions.resize(count);
+    velocities.resize(count);
+    m_pos = std::move(positions);
+    m_vel = std::move(velocities);
+    m_table.build(count ? &m_pos[0].x : nullptr, 3, count, std::max(cellSize, 1e-4f), pool);
+    m_sortedPos.resize(count);
+    for (size_t k = 0; k < count; ++k) m_sortedPos[k] = m_pos[m_table.order()[k]];
+    glm::vec3 mx(0.0f);
+    for (size_t i = 0; i < count; ++i) mx = i ? glm::max(mx, m_pos[i]) : m_pos[i];
+    m_cellMax = count ? m_table.cellOf(mx) : glm::ivec3(-1);
+}
+
+OrbVelocity ProbeIndex::averageVelocityInSphere(const glm::vec3& center, float radius) const
+{
+    m_lastCells = m_lastTested = 0;
+    if (m_pos.empty()) return {};
+    // cells overlapping the sphere's box, clipped to the occupied extent
+    const glm::ivec3 c0 = glm::max(m_table.cellOf(center - glm::vec3(radius)), glm::ivec3(0));
+    const glm::ivec3 c1 = glm::min(m_table.cellOf(center + glm::vec3(radius)), m_cellMax);
+    if (c0.x > c1.x || c0.y > c1.y || c0.z > c1.z) return {};
+    const glm::dvec3 span = glm::dvec3(c1 - c0) + 1.0;
+    if (2.0 * span.x * span.y * span.z > double(m_table.cells())) {  // probe spans most of the cloud
+        m_lastTested = m_pos.size();
+        return krs::orb::averageVelocityInSphere(m_pos, m_vel, center, radius);
+    }
+
+    const float r2 = radius * radius;
+    const float cs = m_table.cellSize();
+    const float eps = 1e-4f * cs;
+    const std::vector<uint32_t>& order = m_table.order();
+    m_hits.clear();
+    for (int z = c0.z; z <= c1.z; ++z)
+        for (int y = c0.y; y <= c1.y; ++y)
+            for (int x = c0.x; x <= c1.x; ++x) {
+                // skip box cells the sphere does not reach (closest-point test)
+                const glm::vec3 lo = m_table.origin() + glm::vec3(float(x), float(y), float(z)) * cs;
+                if (!cellReachesSphere(lo, cs, eps, center, r2)) continue;
+                const auto range = m_table.cellRange(glm::ivec3(x, y, z));
+                if (range.first == range.second) continue;
+                ++m_lastCells;
+                for (uint32_t k = range.first; k < range.second; ++k) {
+                    const glm::vec3 d = m_sortedPos[k] - center;
+                    if (glm::dot(d, d) <= r2) m_hits.push_back(order[k]);
+                }
+                m_lastTested += range.second - range.first;
+            }
+    std::sort(m_hits.begin(), m_hits.end());     // the linear scan's summation order
+    glm::vec3 sum(0.0f);
+    for (uint32_t i : m_hits) sum += m_vel[i];
+    const int n = int(m_hits.size());
+    return { n > 0 ? sum / float(n) : glm::vec3(0.0f), n };
+}
+
+bool runProbeIndexSelfTest(int particles, int probes)
+{
+    using Clock = std::chrono::steady_clock;
+    auto secSince = [](Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); };
+    auto sameBits = [](const OrbVelocity& a, const OrbVelocity& b) {
+        return a.count == b.count && std::memcmp(&a.avg, &b.avg, sizeof(glm::vec3)) == 0;
+    };
+    bool allOk = true;
+    std::mt19937 rng(39);
+    std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+    for (int scene = 0; scene < 2; ++scene) {
+        // 0: uniform tank; 1: clustered blobs with a sparse spray (uneven cell occupancy).
+        // Particle spacing ~3 cm, probe radii 10-30 cm: the orb sizes the node spawns.
+        const float half = 0.5f * 0.03f * std::cbrt(float(particles));
+        std::vector<glm::vec3> pos, vel;
+        pos.reserve(size_t(particles)); vel.reserve(size_t(particles));
+        std::normal_distribution<float> g(0.0f, 0.15f * half);
+        for (int i = 0; i < particles; ++i) {
+            glm::vec3 p = half * glm::vec3(u(rng), u(rng), u(rng));
+            if (scene == 1 && i % 10 != 0) {
+                const int blob = i % 4;
+                p = half * glm::vec3(-0.6f + 0.4f * blob, -0.3f, 0.3f * float(blob % 2)) + glm::vec3(g(rng), g(rng), g(rng));
+            }
+            pos.push_back(p);
+            vel.push_back(glm::vec3(std::sin(7.0f * p.x), p.y - 0.5f, std::cos(5.0f * p.z)) * (1.0f + 0.01f * float(i % 97)));
+        }
+        struct Probe { glm::vec3 c; float r; };
+        std::vector<Probe> ps;
+        std::uniform_real_distribution<float> ur(0.1f, 0.3f);
+        for (int i = 0; i < probes; ++i) ps.push_back({ half * glm::vec3(u(rng), u(rng), u(rng)), ur(rng) });
+        ps.push_back({ glm::vec3(20.0f * half), 0.25f });              // off-cloud -> empty
+        ps.push_back({ glm::vec3(half), 0.2f });                       // straddles the cloud corner
+        ps.push_back({ glm::vec3(0.0f), 4.0f * half });                // bigger than the cloud
+        ps.push_back({ pos[0], 0.0f });                                // zero radius: exactly its centre particle
+        float minR = 1e30f;
+        for (const Probe& p : ps) if (p.r > 0.0f) minR = std::min(minR, p.r);
+
+        // brute force (the current runtime path)
+        std::vector<OrbVelocity> ref(ps.size());
+        auto t0 = Clock::now();
+        for (size_t k = 0; k < ps.size(); ++k) ref[k] = averageVelocityInSphere(pos, vel, ps[k].c, ps[k].r);
+        const double bruteSec = secSince(t0);
+
+        ProbeIndex index;
+        std::vector<glm::vec3> posStep = pos, velStep = vel;            // the runtime hands its arrays over
+        t0 = Clock::now();
+        index.build(std::move(posStep), std::move(velStep), minR);
+        const double buildSec = secSince(t0);
+        t0 = Clock::now();
+        std::vector<OrbVelocity> got(ps.size());
+        size_t cellsFetched = 0, tested = 0;
+        for (size_t k = 0; k < ps.size(); ++k) {
+            got[k] = index.averageVelocityInSphere(ps[k].c, ps[k].r);
+            cellsFetched += index.lastCellsFetched();
+            tested += index.lastParticlesTested();
+        }
+        const double querySec = secSince(t0);
+        int mismatched = 0, nonEmpty = 0;
+        for (size_t k = 0; k < ps.size(); ++k) { mismatched += !sameBits(ref[k], got[k]); nonEmpty += ref[k].count > 0; }
+        const bool offEmpty = got[size_t(probes)].count == 0;
+
+        // NEG-CTRL: the same hits summed in CELL order (no index sort) -- a real, tempting shortcut
+        // that drifts in the last bits; the bitwise compare must see it.
+        int cellOrderDiffers = 0;
+        for (size_t k = 0; k < size_t(probes); ++k) {
+            const float r2 = ps[k].r * ps[k].r;
+            const glm::ivec3 c0 = index.table().cellOf(ps[k].c - glm::vec3(ps[k].r));
+            const glm::ivec3 c1 = index.table().cellOf(ps[k].c + glm::vec3(ps[k].r));
+            glm::vec3 sum(0.0f); int n = 0;
+            for (int z = c0.z; z <= c1.z; ++z) for (int y = c0.y; y <= c1.y; ++y) for (int x = c0.x; x <= c1.x; ++x) {
+                const auto range = index.table().cellRange(glm::ivec3(x, y, z));
+                for (uint32_t s = range.first; s < range.second; ++s) {
+                    const uint32_t i = index.table().order()[s];
+                    const glm::vec3 d = pos[i] - ps[k].c;
+                    if (glm::dot(d, d) <= r2) { sum += vel[i]; ++n; }
+                }
+            }
+            const OrbVelocity cellOrder{ n > 0 ? sum / float(n) : glm::vec3(0.0f), n };
+            cellOrderDiffers += !sameBits(cellOrder, ref[k]);
+        }
+
+        const double perProbeGain = (bruteSec - querySec) / double(ps.size());
+        const double breakEven = perProbeGain > 0.0 ? buildSec / perProbeGain : 1e9;
+        const bool ok = mismatched == 0 && offEmpty && nonEmpty > probes / 2 && cellOrderDiffers > 0;
+        std::printf("[orbidx]   %s: %d particles x %zu probes: index == brute force bit-exact %zu/%zu (non-empty %d, "
+                    "off-cloud empty:%d); NEG-CTRL cell-order sum differs on %d probes  %s\n",
+                    scene ? "CLUSTERED" : "UNIFORM", particles, ps.size(), ps.size() - size_t(mismatched), ps.size(),
+                    nonEmpty, int(offEmpty), cellOrderDiffers, ok ? "PASS" : "FAIL");
+        std::printf("[orbidx]      brute %.2f ms (%.1f Mparticle-tests) vs index build %.2f ms + queries %.2f ms "
+                    "(%zu cells, %.1f k tests): %.1fx (%.1fx queries only; the build pays off from ~%.0f probes)\n",
+                    bruteSec * 1e3, double(particles) * double(ps.size()) * 1e-6, buildSec * 1e3, querySec * 1e3,
+                    cellsFetched, tested * 1e-3, bruteSec / (buildSec + querySec), bruteSec / std::max(querySec, 1e-9),
+                    breakEven);
+        allOk = allOk && ok;
+    }
+
+    {
+        // CELL FACES: a lattice on multiples of the cell size, +-1 ulp. Binning rounds some of
+        // these into the neighbouring cell, a few ulps outside the box the query rebuilds; each
+        // such point gets a probe whose sphere just reaches it from outside that box.
+        const float cs = 0.07f;
+        std::vector<glm::vec3> pos, vel;
+        for (int j = -10; j <= 10; ++j)
+            for (int i = -40; i <= 40; ++i) {
+                const float fx = float(i) * cs, fy = float(j) * cs;
+                for (float x : { std::nextafter(fx, -1e9f), fx, std::nextafter(fx, 1e9f) })
+                    for (float y : { std::nextafter(fy, -1e9f), fy, std::nextafter(fy, 1e9f) }) {
+                        pos.push_back(glm::vec3(x, y, 0.021f));
+                        vel.push_back(glm::vec3(x - y, 0.5f * x, 1.0f + y));
+                    }
+            }
+        ProbeIndex index;
+        index.build(pos, vel, cs);
+        const krs::morton::CellTable& t = index.table();
+        int probes = 0, mismatched = 0, uninflatedMisses = 0;
+        for (const glm::vec3& p : pos) {
+            const glm::vec3 lo = t.origin() + glm::vec3(t.cellOf(p)) * cs;
+            for (int a = 0; a < 3; ++a) {
+                const float side = p[a] < lo[a] ? -1.0f : p[a] > lo[a] + cs ? 1.0f : 0.0f;
+                if (side == 0.0f) continue;
+                glm::vec3 c = p; c[a] += side * 0.5f * cs;         // outside the box, beyond p
+                const glm::vec3 d = p - c;
+                float r = glm::length(d);
+                while (glm::dot(d, d) > r * r) r = std::nextafter(r, 1e9f);
+                ++probes;
+                mismatched += !sameBits(averageVelocityInSphere(pos, vel, c, r), index.averageVelocityInSphere(c, r));
+                uninflatedMisses += !cellReachesSphere(lo, cs, 0.0f, c, r * r);
+            }
+        }
+        const bool ok = probes > 0 && mismatched == 0 && uninflatedMisses > 0;
+        std::printf("[orbidx]   CELL FACES: %zu lattice points, %d probes reaching points binned outside their "
+                    "cell box: index == brute force %d/%d; NEG-CTRL un-inflated cull drops the cell on %d  %s\n",
+                    pos.size(), probes, probes - mismatched, probes, uninflatedMisses, ok ? "PASS" : "FAIL");
+        allOk = allOk && ok;
+    }
+    return allOk;
+}
+
 void decorateProbeOrb(entt::registry& reg, entt::entity e, std::uint64_t nodeId,
                       const glm::vec3& color, const glm::vec3& center, float radius)
 {
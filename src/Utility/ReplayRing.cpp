@@ -0,0 +1,505 @@
+#include "ReplayRing.hpp"
+#include "ParallelFor.hpp"
+
+#include <QDebug>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+namespace krs::rl {
+
+struct ReplayRing::Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t obsDim;
+    uint32_t actDim;
+    uint64_t capacity;
+    uint64_t written;       // accessed as std::atomic<uint64_t> (release after the slot's fields)
+    unsigned char pad[32];
+};
+
+namespace {
+
+constexpr char kMagic[4] = { 'K', 'R', 'R', 'B' };
+constexpr uint32_t kVersion = 1;
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+              "the write counter is shared through the mapping as a plain 64-bit word");
+
+constexpr size_t align64(size_t n) { return (n + 63) & ~size_t(63); }
+
+/// splitmix64: cheap, seedable, and the same sequence on every platform.
+struct SplitMix {
+    uint64_t s;
+    uint64_t next()
+    {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    double uniform() { return double(next() >> 11) * (1.0 / double(1ull << 53)); }   // [0, 1)
+};
+
+} // namespace
+
+ReplayRing::ReplayRing() = default;
+ReplayRing::~ReplayRing() { close(); }
+
+size_t ReplayRing::blockBytes(uint32_t obsDim, uint32_t actDim, uint64_t capacity)
+{
+    const size_t c = size_t(capacity);
+    return align64(sizeof(Header))
+         + align64(c * obsDim * sizeof(float))      // obs
+         + align64(c * actDim * sizeof(float))      // action
+         + align64(c * sizeof(float))               // reward
+         + align64(c * obsDim * sizeof(float))      // nextObs
+         + align64(c)                               // done
+         + align64(c * sizeof(float));              // priority
+}
+
+bool ReplayRing::layout(unsigned char* base, uint32_t obsDim, uint32_t actDim, uint64_t capacity)
+{
+    const size_t c = size_t(capacity);
+    unsigned char* p = base + align64(sizeof(Header));
+    m_obs = reinterpret_cast<float*>(p);      p += align64(c * obsDim * sizeof(float));
+    m_act = reinterpret_cast<float*>(p);      p += align64(c * actDim * sizeof(float));
+    m_reward = reinterpret_cast<float*>(p);   p += align64(c * sizeof(float));
+    m_next = reinterpret_cast<float*>(p);     p += align64(c * obsDim * sizeof(float));
+    m_done = p;                               p += align64(c);
+    m_priority = reinterpret_cast<float*>(p);
+    m_base = base;
+    m_obsDim = obsDim;
+    m_actDim = actDim;
+    m_capacity = capacity;
+    m_leaves = 1;
+    while (m_leaves < capacity) m_leaves <<= 1;
+    m_tree.assign(size_t(2 * m_leaves), 0.0);
+    return true;
+}
+
+std::atomic<uint64_t>& ReplayRing::writtenCounter() const
+{
+    return *reinterpret_cast<std::atomic<uint64_t>*>(&reinterpret_cast<Header*>(m_base)->written);
+}
+
+bool ReplayRing::create(uint32_t obsDim, uint32_t actDim, uint64_t capacity)
+{
+    close();
+    if (obsDim == 0 || capacity == 0) return false;
+    m_bytes = blockBytes(obsDim, actDim, capacity);
+    m_memory.reset(new uint64_t[(m_bytes + 7) / 8]());   // zeroed
+    auto* base = reinterpret_cast<unsigned char*>(m_memory.get());
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion; h.obsDim = obsDim; h.actDim = actDim; h.capacity = capacity;
+    std::memcpy(base, &h, sizeof(h));
+    m_readOnly = false;
+    m_maxPriority = 1.0f;
+    return layout(base, obsDim, actDim, capacity);
+}
+
+bool ReplayRing::create(const QString& path, uint32_t obsDim, uint32_t actDim, uint64_t capacity)
+{
+    close();
+    if (obsDim == 0 || capacity == 0) return false;
+    const size_t bytes = blockBytes(obsDim, actDim, capacity);
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate) || !file->resize(qint64(bytes))) {
+        qWarning() << "[ReplayRing] cannot create" << path << file->errorString();
+        return false;
+    }
+    unsigned char* base = file->map(0, qint64(bytes));   // a resized file reads as zeros
+    if (!base) { qWarning() << "[ReplayRing] cannot map" << path << file->errorString(); return false; }
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion; h.obsDim = obsDim; h.actDim = actDim; h.capacity = capacity;
+    std::memcpy(base, &h, sizeof(h));
+    m_file = std::move(file);
+    m_bytes = bytes;
+    m_readOnly = false;
+    m_maxPriority = 1.0f;
+    return layout(base, obsDim, actDim, capacity);
+}
+
+bool ReplayRing::open(const QString& path, bool readOnly)
+{
+    close();
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(readOnly ? QIODevice::ReadOnly : QIODevice::ReadWrite)) return false;
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(Header))) return false;
+    unsigned char* base = file->map(0, size);
+    if (!base) return false;
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion
+        || h.obsDim == 0 || h.capacity == 0 || blockBytes(h.obsDim, h.actDim, h.capacity) != size_t(size)) {
+        qWarning() << "[ReplayRing] not a ring this version wrote:" << path;
+        return false;
+    }
+    m_file = std::move(file);
+    m_bytes = size_t(size);
+    m_readOnly = readOnly;
+    layout(base, h.obsDim, h.actDim, h.capacity);
+    refresh();
+    return true;
+}
+
+void ReplayRing::close()
+{
+    if (m_file) {
+        if (m_base) m_file->unmap(m_base);
+        m_file->close();
+        m_file.reset();
+    }
+    m_memory.reset();
+    m_base = nullptr;
+    m_bytes = 0;
+    m_obs = m_act = m_reward = m_next = m_priority = nullptr;
+    m_done = nullptr;
+    m_obsDim = m_actDim = 0;
+    m_capacity = m_leaves = 0;
+    m_tree.clear();
+}
+
+uint64_t ReplayRing::written() const
+{
+    return m_base ? writtenCounter().load(std::memory_order_acquire) : 0;
+}
+
+uint64_t ReplayRing::size() const { return std::min(written(), m_capacity); }
+
+void ReplayRing::setPriority(uint64_t slot, float p)
+{
+    m_priority[slot] = p;
+    uint64_t i = m_leaves + slot;
+    m_tree[size_t(i)] = double(p);
+    for (i >>= 1; i >= 1; i >>= 1) m_tree[size_t(i)] = m_tree[size_t(2 * i)] + m_tree[size_t(2 * i + 1)];
+}
+
+void ReplayRing::refresh()
+{
+    if (!m_base) return;
+    std::fill(m_tree.begin(), m_tree.end(), 0.0);
+    const uint64_t n = size();
+    float maxP = 0.0f;
+    for (uint64_t s = 0; s < n; ++s) {
+        m_tree[size_t(m_leaves + s)] = double(m_priority[s]);
+        maxP = std::max(maxP, m_priority[s]);
+    }
+    for (uint64_t i = m_leaves - 1; i >= 1; --i) m_tree[size_t(i)] = m_tree[size_t(2 * i)] + m_tree[size_t(2 * i + 1)];
+    m_maxPriority = maxP > 0.0f ? maxP : 1.0f;
+}
+
+uint64_t ReplayRing::add(const float* obs, const float* action, float reward, const float* nextObs, bool done)
+{
+    if (!m_base || m_readOnly) return ~0ull;
+    const uint64_t w = writtenCounter().load(std::memory_order_relaxed);
+    const uint64_t slot = w % m_capacity;
+    std::memcpy(m_obs + slot * m_obsDim, obs, m_obsDim * sizeof(float));
+    if (m_actDim) std::memcpy(m_act + slot * m_actDim, action, m_actDim * sizeof(float));
+    m_reward[slot] = reward;
+    std::memcpy(m_next + slot * m_obsDim, nextObs, m_obsDim * sizeof(float));
+    m_done[slot] = done ? 1 : 0;
+    setPriority(slot, m_maxPriority);
+    writtenCounter().store(w + 1, std::memory_order_release);
+    return slot;
+}
+
+void ReplayRing::addBatch(size_t count, const float* obs, const float* actions, const float* rewards,
+                          const float* nextObs, const uint8_t* dones)
+{
+    if (!m_base || m_readOnly || count == 0) return;
+    const uint64_t w = writtenCounter().load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t slot = (w + i) % m_capacity;
+        std::memcpy(m_obs + slot * m_obsDim, obs + i * m_obsDim, m_obsDim * sizeof(float));
+        if (m_actDim) std::memcpy(m_act + slot * m_actDim, actions + i * m_actDim, m_actDim * sizeof(float));
+        m_reward[slot] = rewards[i];
+        std::memcpy(m_next + slot * m_obsDim, nextObs + i * m_obsDim, m_obsDim * sizeof(float));
+        m_done[slot] = dones[i] ? 1 : 0;
+        setPriority(slot, m_maxPriority);
+    }
+    writtenCounter().store(w + count, std::memory_order_release);   // one publish for the batch
+}
+
+void ReplayRing::resize(Batch& out, size_t batchSize) const
+{
+    out.indices.resize(batchSize);
+    out.obs.resize(batchSize * m_obsDim);
+    out.actions.resize(batchSize * m_actDim);
+    out.rewards.resize(batchSize);
+    out.nextObs.resize(batchSize * m_obsDim);
+    out.dones.resize(batchSize);
+    out.weights.resize(batchSize);
+}
+
+void ReplayRing::gather(Batch& out) const
+{
+    const size_t n = out.indices.size();
+    const size_t O = m_obsDim, A = m_actDim;
+    krs::par::parallelFor(krs::par::ThreadPool::global(), n, 128, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            const uint64_t s = out.indices[i];
+            std::memcpy(out.obs.data() + i * O, m_obs + s * O, O * sizeof(float));
+            if (A) std::memcpy(out.actions.data() + i * A, m_act + s * A, A * sizeof(float));
+            out.rewards[i] = m_reward[s];
+            std::memcpy(out.nextObs.data() + i * O, m_next + s * O, O * sizeof(float));
+            out.dones[i] = m_done[s];
+        }
+    });
+}
+
+void ReplayRing::sampleUniform(size_t batchSize, uint64_t seed, Batch& out) const
+{
+    const uint64_t n = size();
+    resize(out, n ? batchSize : 0);
+    if (!n) return;
+    SplitMix rng{ seed };
+    for (size_t i = 0; i < batchSize; ++i) out.indices[i] = rng.next() % n;
+    std::fill(out.weights.begin(), out.weights.end(), 1.0f);
+    gather(out);
+}
+
+void ReplayRing::samplePrioritized(size_t batchSize, float beta, uint64_t seed, Batch& out) const
+{
+    const uint64_t n = size();
+    const double total = m_tree.empty() ? 0.0 : m_tree[1];
+    if (!n || !(total > 0.0)) { sampleUniform(batchSize, seed, out); return; }
+    resize(out, batchSize);
+    SplitMix rng{ seed };
+    const double segment = total / double(batchSize);   // stratified: one draw per equal-mass segment
+    float maxW = 0.0f;
+    for (size_t i = 0; i < batchSize; ++i) {
+        double u = (double(i) + rng.uniform()) * segment;
+        uint64_t node = 1;
+        while (node < m_leaves) {
+            const double left = m_tree[size_t(2 * node)];
+            if (u < left) node = 2 * node;
+            else { u -= left; node = 2 * node + 1; }
+        }
+        uint64_t slot = node - m_leaves;
+        if (slot >= n || m_priority[slot] <= 0.0f) slot = std::min(slot, n - 1);   // rounding past the last leaf
+        out.indices[i] = slot;
+        const double P = double(m_priority[slot]) / total;
+        const float w = P > 0.0 ? float(std::pow(double(n) * P, -double(beta))) : 0.0f;
+        out.weights[i] = w;
+        maxW = std::max(maxW, w);
+    }
+    if (maxW > 0.0f)
+        for (float& w : out.weights) w /= maxW;
+    gather(out);
+}
+
+void ReplayRing::updatePriorities(const uint64_t* indices, const float* tdErrors, size_t count)
+{
+    if (!m_base || m_readOnly) return;
+    for (size_t i = 0; i < count; ++i) {
+        if (indices[i] >= m_capacity) continue;
+        const float p = float(std::pow(double(std::abs(tdErrors[i])) + double(m_epsilon), double(m_alpha)));
+        setPriority(indices[i], p);
+        m_maxPriority = std::max(m_maxPriority, p);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+// The deque-of-vectors layout the ReplayBuffer component used before (kept here as the reference).
+struct LegacyExperience {
+    std::vector<float> observation;
+    std::vector<float> action;
+    float reward;
+    std::vector<float> next_observation;
+    bool done;
+};
+
+/// Transition i: every field a function of i, so any slot can be checked in isolation.
+void makeTransition(uint64_t i, uint32_t obsDim, uint32_t actDim, std::vector<float>& obs,
+                    std::vector<float>& act, float& reward, std::vector<float>& next, bool& done)
+{
+    obs.resize(obsDim); act.resize(actDim); next.resize(obsDim);
+    for (uint32_t k = 0; k < obsDim; ++k) { obs[k] = float(i) + 0.001f * float(k); next[k] = -obs[k]; }
+    for (uint32_t k = 0; k < actDim; ++k) act[k] = float(i % 97) + 0.01f * float(k);
+    reward = float(i) * 0.5f;
+    done = i % 13 == 0;
+}
+
+bool slotHolds(const ReplayRing& r, uint64_t slot, uint64_t i)
+{
+    std::vector<float> obs, act, next;
+    float reward; bool done;
+    makeTransition(i, r.obsDim(), r.actDim(), obs, act, reward, next, done);
+    return std::memcmp(r.obs(slot), obs.data(), obs.size() * sizeof(float)) == 0
+        && std::memcmp(r.action(slot), act.data(), act.size() * sizeof(float)) == 0
+        && std::memcmp(r.nextObs(slot), next.data(), next.size() * sizeof(float)) == 0
+        && r.reward(slot) == reward && r.done(slot) == done;
+}
+
+void fill(ReplayRing& r, uint64_t from, uint64_t to)
+{
+    std::vector<float> obs, act, next;
+    float reward; bool done;
+    for (uint64_t i = from; i < to; ++i) {
+        makeTransition(i, r.obsDim(), r.actDim(), obs, act, reward, next, done);
+        r.add(obs.data(), act.data(), reward, next.data(), done);
+    }
+}
+
+} // namespace
+
+bool ReplayRing::runSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[REPLAY-RING] %s %-40s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+
+    // ---- round trip + wrap-around ----
+    {
+        ReplayRing r;
+        r.create(7, 3, 1000);
+        fill(r, 0, 2500);
+        bool ok = r.size() == 1000 && r.written() == 2500;
+        for (uint64_t i = 1500; i < 2500 && ok; ++i) ok = slotHolds(r, i % 1000, i);
+        const bool overwritten = !slotHolds(r, 0, 0);
+        report(ok && overwritten, "fields round trip, oldest overwritten",
+               QStringLiteral("(2500 adds into 1000 slots, slot 0 holds #2000)"));
+    }
+
+    // ---- file persistence + a concurrent read-only attach ----
+    {
+        const QString path = tmp.path() + QStringLiteral("/ring.krrb");
+        bool ok = false, attached = false;
+        {
+            ReplayRing w;
+            ok = w.create(path, 16, 4, 4096);
+            fill(w, 0, 5000);
+            const uint64_t indices[2] = { 3, 77 };
+            const float td[2] = { 4.0f, 0.25f };
+            w.updatePriorities(indices, td, 2);
+            ReplayRing reader;
+            attached = reader.open(path, true) && reader.written() == 5000;
+            fill(w, 5000, 5100);                          // writer keeps going
+            attached = attached && reader.written() == 5100 && slotHolds(reader, 5099 % 4096, 5099)
+                       && reader.add(w.obs(0), w.action(0), 0.0f, w.nextObs(0), false) == ~0ull;
+        }
+        ReplayRing r;
+        bool resumed = r.open(path) && r.written() == 5100 && r.size() == 4096;
+        for (uint64_t i = 5100 - 4096; i < 5100 && resumed; ++i) resumed = slotHolds(r, i % 4096, i);
+        resumed = resumed && std::abs(r.priority(3) - float(std::pow(4.0, 0.6))) < 1e-4f;   // (|td| + eps)^alpha kept
+        fill(r, 5100, 5101);
+        resumed = resumed && slotHolds(r, 5100 % 4096, 5100);
+        report(ok && attached && resumed, "mmap file: reopen resumes, reader sees writes",
+               QStringLiteral("(%1 KB, reader attached while writing=%2)").arg(r.bytes() / 1024).arg(int(attached)));
+
+        // a damaged file is refused
+        QFile f(path);
+        if (f.open(QIODevice::ReadWrite)) { f.resize(f.size() - 64); f.close(); }
+        ReplayRing bad;
+        report(!bad.open(path, true), "truncated ring refused", QString());
+    }
+
+    // ---- sum-tree: sampling frequencies follow the priorities ----
+    {
+        ReplayRing r;
+        r.create(1, 0, 8);
+        r.setAlpha(1.0f);
+        r.setEpsilon(0.0f);
+        fill(r, 0, 8);
+        uint64_t indices[8]; float td[8];
+        for (int i = 0; i < 8; ++i) { indices[i] = uint64_t(i); td[i] = float(i + 1); }   // P(i) = (i+1)/36
+        r.updatePriorities(indices, td, 8);
+        const int batch = 1000, rounds = 200;
+        std::vector<double> prio(8, 0.0), uni(8, 0.0);
+        Batch b;
+        bool weightsOk = true;
+        for (int k = 0; k < rounds; ++k) {
+            r.samplePrioritized(batch, 1.0f, uint64_t(k), b);
+            for (uint64_t s : b.indices) prio[size_t(s)] += 1.0;
+            float mx = 0.0f, w0 = 0.0f, w7 = 1.0f;
+            for (size_t i = 0; i < b.indices.size(); ++i) {
+                mx = std::max(mx, b.weights[i]);
+                if (b.indices[i] == 0) w0 = b.weights[i];
+                if (b.indices[i] == 7) w7 = b.weights[i];
+            }
+            weightsOk = weightsOk && mx == 1.0f && w0 > w7;
+            r.sampleUniform(batch, uint64_t(k), b);
+            for (uint64_t s : b.indices) uni[size_t(s)] += 1.0;
+        }
+        double errP = 0.0, errU = 0.0;
+        for (int i = 0; i < 8; ++i) {
+            const double expected = double(i + 1) / 36.0;
+            errP = std::max(errP, std::abs(prio[size_t(i)] / (batch * rounds) - expected));
+            errU = std::max(errU, std::abs(uni[size_t(i)] / (batch * rounds) - expected));
+        }
+        report(errP < 0.005 && weightsOk, "prioritized freq == p_i / sum",
+               QStringLiteral("(max |freq - P| %1 over %2 draws; IS weights max 1)").arg(errP, 0, 'f', 4).arg(batch * rounds));
+        report(errU > 0.05, "NEG-CTRL uniform does not follow p_i", QStringLiteral("(max |freq - P| %1)").arg(errU, 0, 'f', 4));
+    }
+
+    // ---- throughput vs the deque-of-vectors buffer ----
+    {
+        const uint32_t O = 64, A = 8;
+        const uint64_t cap = 200000, inserts = 400000;
+        const size_t batch = 256;
+        const int draws = 400;
+        std::vector<float> obs(O, 0.5f), act(A, 0.1f), next(O, 0.25f);
+        using clk = std::chrono::steady_clock;
+
+        ReplayRing r;
+        r.create(O, A, cap);
+        auto t0 = clk::now();
+        for (uint64_t i = 0; i < inserts; ++i) { obs[0] = float(i); r.add(obs.data(), act.data(), 1.0f, next.data(), false); }
+        const double ringInsert = double(inserts) / std::chrono::duration<double>(clk::now() - t0).count();
+        Batch b;
+        t0 = clk::now();
+        for (int k = 0; k < draws; ++k) r.sampleUniform(batch, uint64_t(k), b);
+        const double ringSample = double(draws * batch) / std::chrono::duration<double>(clk::now() - t0).count();
+
+        std::deque<LegacyExperience> memory;
+        t0 = clk::now();
+        for (uint64_t i = 0; i < inserts; ++i) {
+            obs[0] = float(i);
+            memory.push_back({ obs, act, 1.0f, next, false });
+            if (memory.size() > cap) memory.pop_front();
+        }
+        const double dequeInsert = double(inserts) / std::chrono::duration<double>(clk::now() - t0).count();
+        std::vector<float> bo(batch * O), ba(batch * A), bn(batch * O), br(batch);
+        SplitMix rng{ 1 };
+        t0 = clk::now();
+        for (int k = 0; k < draws; ++k)
+            for (size_t i = 0; i < batch; ++i) {
+                const LegacyExperience& e = memory[size_t(rng.next() % memory.size())];
+                std::memcpy(bo.data() + i * O, e.observation.data(), O * sizeof(float));
+                std::memcpy(ba.data() + i * A, e.action.data(), A * sizeof(float));
+                std::memcpy(bn.data() + i * O, e.next_observation.data(), O * sizeof(float));
+                br[i] = e.reward;
+            }
+        const double dequeSample = double(draws * batch) / std::chrono::duration<double>(clk::now() - t0).count();
+
+        report(ringInsert > 1.5 * dequeInsert, "insert throughput vs deque<Experience>",
+               QStringLiteral("(ring %1 M/s vs deque %2 M/s = %3x; 64+8 floats)")
+                   .arg(ringInsert * 1e-6, 0, 'f', 2).arg(dequeInsert * 1e-6, 0, 'f', 2).arg(ringInsert / dequeInsert, 0, 'f', 1));
+        std::fprintf(stderr, "[REPLAY-RING] info %-40s (ring %.2f M/s vs deque %.2f M/s = %.1fx, batch %zu)\n",
+                     "uniform sample+gather throughput", ringSample * 1e-6, dequeSample * 1e-6,
+                     ringSample / dequeSample, batch);
+    }
+
+    std::fprintf(stderr, "[REPLAY-RING] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
+
+} // namespace krs::rl
@@ -0,0 +1,683 @@
+#include "RolloutWorkers.hpp"
+#include "ParallelFor.hpp"
+#include "SimulationController.hpp"
+#include "VecEnv.hpp"
+
+#include <QDebug>
+#include <QString>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#if defined(KR_WITH_PHYSX)
+#include <PxPhysicsAPI.h>
+#endif
+
+namespace krs::rl {
+
+namespace {
+
+/// splitmix64: cheap, seedable, and the same sequence on every platform.
+uint64_t splitmix(uint64_t& s)
+{
+    uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+float uniform01(uint64_t& s) { return float(splitmix(s) >> 40) * (1.0f / 16777216.0f); }
+
+/// Standard normal (Box-Muller, one value per call: simple and reproducible).
+float gaussian(uint64_t& s)
+{
+    const float u1 = std::max(uniform01(s), 1.0e-7f);
+    const float u2 = uniform01(s);
+    return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.2831853f * u2);
+}
+
+/// Noise stream of worker `worker`.
+uint64_t workerStream(uint64_t seed, int worker)
+{
+    uint64_t s = seed ^ (0xD1B54A32D192ED03ull * uint64_t(worker + 1));
+    return splitmix(s);
+}
+
+// Environments are built and torn down one at a time: VecEnv creates scenes and
+// dispatchers on the shared PxPhysics, which is not done concurrently elsewhere either.
+std::mutex& envLifetimeMutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+class VecEnvRollout : public IRolloutEnv {
+public:
+    explicit VecEnvRollout(std::unique_ptr<VecEnv> env) : m_env(std::move(env)) {}
+    ~VecEnvRollout() override
+    {
+        std::lock_guard<std::mutex> lk(envLifetimeMutex());
+        m_env.reset();
+    }
+    int numEnvs() const override { return m_env->numEnvs(); }
+    int obsDim() const override { return m_env->obsDim(); }
+    int actDim() const override { return m_env->actDim(); }
+    const float* observations() const override { return m_env->observations(); }
+    float* actions() override { return m_env->actions(); }
+    void step() override { m_env->step(); }
+    const float* rewards() const override { return m_env->rewards(); }
+    const uint8_t* dones() const override { return m_env->dones(); }
+
+private:
+    std::unique_ptr<VecEnv> m_env;
+};
+
+} // namespace
+
+std::unique_ptr<IRolloutEnv> makeRolloutEnv(std::unique_ptr<VecEnv> env)
+{
+    if (!env || !env->initialized()) return nullptr;
+    return std::make_unique<VecEnvRollout>(std::move(env));
+}
+
+// ---------------------------------------------------------------------------------------------------
+// LinearGaussianPolicy
+// ---------------------------------------------------------------------------------------------------
+LinearGaussianPolicy::LinearGaussianPolicy(int obsDim, int actDim, float sigma)
+    : m_obsDim(obsDim), m_actDim(actDim), m_sigma(sigma),
+      m_weights(size_t(actDim) * size_t(obsDim + 1), 0.0f)
+{
+}
+
+void LinearGaussianPolicy::setWeights(const float* weights)
+{
+    std::memcpy(m_weights.data(), weights, m_weights.size() * sizeof(float));
+}
+
+void LinearGaussianPolicy::act(const float* obs, int batch, float* actions, uint64_t& rng)
+{
+    const float* W = m_weights.data();
+    const float* b = W + size_t(m_actDim) * size_t(m_obsDim);
+    for (int e = 0; e < batch; ++e) {
+        const float* o = obs + size_t(e) * size_t(m_obsDim);
+        float* a = actions + size_t(e) * size_t(m_actDim);
+        for (int j = 0; j < m_actDim; ++j) {
+            const float* w = W + size_t(j) * size_t(m_obsDim);
+            float v = b[j];
+            for (int i = 0; i < m_obsDim; ++i) v += w[i] * o[i];
+            a[j] = m_sigma > 0.0f ? v + m_sigma * gaussian(rng) : v;
+        }
+    }
+}
+
+std::unique_ptr<IPolicy> LinearGaussianPolicy::clone() const
+{
+    return std::make_unique<LinearGaussianPolicy>(*this);
+}
+
+// ---------------------------------------------------------------------------------------------------
+// PolicyBroadcast
+// ---------------------------------------------------------------------------------------------------
+PolicyBroadcast::PolicyBroadcast(size_t numWeights) : m_numWeights(numWeights)
+{
+    for (Slot& s : m_slots) {
+        s.data = std::make_unique<std::atomic<uint32_t>[]>(numWeights);
+        for (size_t i = 0; i < numWeights; ++i) s.data[i].store(0u, std::memory_order_relaxed);
+    }
+}
+
+uint64_t PolicyBroadcast::publish(const float* weights)
+{
+    const uint64_t v = m_version.load(std::memory_order_relaxed) + 1;
+    Slot& s = m_slots[v % kSlots];
+    // Seqlock write: odd while the copy is in progress, 2v once it is complete.
+    s.seq.store(2 * v - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < m_numWeights; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, weights + i, sizeof(bits));
+        s.data[i].store(bits, std::memory_order_relaxed);
+    }
+    s.seq.store(2 * v, std::memory_order_release);
+    m_version.store(v, std::memory_order_release);
+    return v;
+}
+
+uint64_t PolicyBroadcast::fetch(uint64_t have, float* out) const
+{
+    for (;;) {
+        const uint64_t v = m_version.load(std::memory_order_acquire);
+        if (v == 0 || v <= have) return have;
+        const Slot& s = m_slots[v % kSlots];
+        if (s.seq.load(std::memory_order_acquire) == 2 * v) {
+            for (size_t i = 0; i < m_numWeights; ++i) {
+                const uint32_t bits = s.data[i].load(std::memory_order_relaxed);
+                std::memcpy(out + i, &bits, sizeof(bits));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == 2 * v) return v;  // not overwritten during the copy
+        }
+        std::this_thread::yield();                                         // the writer lapped the slot
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// RolloutWorkers
+// ---------------------------------------------------------------------------------------------------
+RolloutWorkers::~RolloutWorkers() { stop(); }
+
+bool RolloutWorkers::start(const Config& config, const EnvFactory& makeEnv, const IPolicy& prototype,
+                           PolicyBroadcast& weights)
+{
+    stop();
+    if (config.workers < 1 || config.stepsPerChunk < 1 || prototype.numWeights() != weights.numWeights()) {
+        qWarning() << "[RolloutWorkers] bad config:" << config.workers << "workers," << config.stepsPerChunk
+                   << "steps per chunk, policy/broadcast weights" << prototype.numWeights() << weights.numWeights();
+        return false;
+    }
+    m_config = config;
+    if (m_config.queueCapacity <= 0) m_config.queueCapacity = 2 * m_config.workers;
+    m_weights = &weights;
+    m_samples = 0;
+    m_chunks = 0;
+    m_blockedNs = 0;
+    m_run = true;
+
+    // Each worker builds its environments and policy copy on its own thread; start() returns
+    // once all of them are built (or one failed).
+    std::mutex readyMutex;
+    std::condition_variable readyCv;
+    int ready = 0, failed = 0;
+    for (int k = 0; k < m_config.workers; ++k) {
+        m_threads.emplace_back([this, k, &makeEnv, &prototype, &readyMutex, &readyCv, &ready, &failed]() {
+            krs::par::ThreadPool::InlineScope inlineWork;
+            std::unique_ptr<IRolloutEnv> env;
+            {
+                std::lock_guard<std::mutex> lk(envLifetimeMutex());
+                env = makeEnv(k);
+            }
+            std::unique_ptr<IPolicy> policy = prototype.clone();
+            const bool ok = env != nullptr;
+            {
+                std::lock_guard<std::mutex> lk(readyMutex);     // notify under the lock: start()'s locals
+                ++ready;                                         // die as soon as it sees the last one
+                failed += ok ? 0 : 1;
+                readyCv.notify_all();
+            }
+            if (ok) workerLoop(k, env.get(), policy.get());
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lk(readyMutex);
+        readyCv.wait(lk, [&]() { return ready == m_config.workers; });
+    }
+    if (failed > 0) {
+        qWarning() << "[RolloutWorkers]" << failed << "of" << m_config.workers << "workers could not build their environments";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void RolloutWorkers::stop()
+{
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_run = false;
+    }
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+    for (std::thread& t : m_threads) t.join();
+    m_threads.clear();
+    std::lock_guard<std::mutex> lk(m_mutex);
+    for (std::unique_ptr<Trajectory>& t : m_queue) m_free.push_back(std::move(t));
+    m_queue.clear();
+}
+
+double RolloutWorkers::blockedSeconds() const
+{
+    return double(m_blockedNs.load(std::memory_order_acquire)) * 1e-9;
+}
+
+std::unique_ptr<Trajectory> RolloutWorkers::acquire()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_free.empty()) return std::make_unique<Trajectory>();
+    std::unique_ptr<Trajectory> t = std::move(m_free.back());
+    m_free.pop_back();
+    return t;
+}
+
+void RolloutWorkers::recycle(std::unique_ptr<Trajectory> chunk)
+{
+    if (!chunk) return;
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_free.push_back(std::move(chunk));
+}
+
+bool RolloutWorkers::push(std::unique_ptr<Trajectory> chunk)
+{
+    const size_t samples = chunk->samples();
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        if (m_queue.size() >= size_t(m_config.queueCapacity) && m_run) {
+            const auto t0 = std::chrono::steady_clock::now();
+            m_notFull.wait(lk, [&]() { return m_queue.size() < size_t(m_config.queueCapacity) || !m_run; });
+            m_blockedNs.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - t0).count()),
+                                  std::memory_order_relaxed);
+        }
+        if (!m_run) {
+            m_free.push_back(std::move(chunk));
+            return false;
+        }
+        m_queue.push_back(std::move(chunk));
+    }
+    m_samples.fetch_add(samples, std::memory_order_acq_rel);
+    m_chunks.fetch_add(1, std::memory_order_acq_rel);
+    m_notEmpty.notify_one();
+    return true;
+}
+
+std::unique_ptr<Trajectory> RolloutWorkers::pop(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (!m_notEmpty.wait_for(lk, std::chrono::milliseconds(std::max(0, timeoutMs)),
+                             [&]() { return !m_queue.empty() || !m_run; })
+        || m_queue.empty())
+        return nullptr;
+    std::unique_ptr<Trajectory> t = std::move(m_queue.front());
+    m_queue.pop_front();
+    lk.unlock();
+    m_notFull.notify_one();
+    return t;
+}
+
+void RolloutWorkers::workerLoop(int worker, IRolloutEnv* env, IPolicy* policy)
+{
+    const int E = env->numEnvs(), O = env->obsDim(), A = env->actDim(), T = m_config.stepsPerChunk;
+    const size_t obsRow = size_t(E) * size_t(O), actRow = size_t(E) * size_t(A);
+    std::vector<float> weights(m_weights->numWeights());
+    uint64_t version = 0, chunk = 0;
+    uint64_t rng = workerStream(m_config.seed, worker);
+
+    while (m_run.load(std::memory_order_acquire)) {
+        const uint64_t latest = m_weights->fetch(version, weights.data());
+        if (latest == 0) {                                  // nothing published yet
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (latest != version) {
+            policy->setWeights(weights.data());
+            version = latest;
+        }
+
+        std::unique_ptr<Trajectory> t = acquire();
+        t->worker = worker;
+        t->chunk = chunk++;
+        t->policyVersion = version;
+        t->numEnvs = E; t->steps = T; t->obsDim = O; t->actDim = A;
+        t->obs.resize(size_t(T) * obsRow);
+        t->actions.resize(size_t(T) * actRow);
+        t->rewards.resize(size_t(T) * size_t(E));
+        t->dones.resize(size_t(T) * size_t(E));
+        t->lastObs.resize(obsRow);
+        for (int s = 0; s < T; ++s) {
+            std::memcpy(t->obs.data() + size_t(s) * obsRow, env->observations(), obsRow * sizeof(float));
+            policy->act(env->observations(), E, env->actions(), rng);
+            std::memcpy(t->actions.data() + size_t(s) * actRow, env->actions(), actRow * sizeof(float));
+            env->step();
+            std::memcpy(t->rewards.data() + size_t(s) * size_t(E), env->rewards(), size_t(E) * sizeof(float));
+            std::memcpy(t->dones.data() + size_t(s) * size_t(E), env->dones(), size_t(E));
+        }
+        std::memcpy(t->lastObs.data(), env->observations(), obsRow * sizeof(float));
+        if (!push(std::move(t))) break;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+/// Toy batched environment: per env a 1-D chain of masses on springs, a force per mass,
+/// reward = -(tip - 1)^2. Episodes end after `episodeLen` steps and restart from a
+/// seeded random state. `substeps` sets the cost per step.
+class ChainEnv : public IRolloutEnv {
+public:
+    ChainEnv(int envs, int masses, int substeps, int episodeLen, uint64_t seed)
+        : m_envs(envs), m_masses(masses), m_substeps(substeps), m_episodeLen(episodeLen), m_seed(seed),
+          m_obs(size_t(envs) * size_t(2 * masses)), m_act(size_t(envs) * size_t(masses)),
+          m_rew(size_t(envs)), m_done(size_t(envs)), m_t(size_t(envs), 0), m_episode(size_t(envs), 0)
+    {
+        for (int e = 0; e < envs; ++e) resetEnv(e);
+    }
+    int numEnvs() const override { return m_envs; }
+    int obsDim() const override { return 2 * m_masses; }
+    int actDim() const override { return m_masses; }
+    const float* observations() const override { return m_obs.data(); }
+    float* actions() override { return m_act.data(); }
+    const float* rewards() const override { return m_rew.data(); }
+    const uint8_t* dones() const override { return m_done.data(); }
+
+    void step() override
+    {
+        const float h = 0.01f / float(m_substeps), k = 40.0f, c = 0.5f;
+        for (int e = 0; e < m_envs; ++e) {
+            float* x = m_obs.data() + size_t(e) * size_t(2 * m_masses);
+            float* v = x + m_masses;
+            const float* f = m_act.data() + size_t(e) * size_t(m_masses);
+            for (int s = 0; s < m_substeps; ++s)
+                for (int i = 0; i < m_masses; ++i) {
+                    const float left = i > 0 ? x[i - 1] : 0.0f;
+                    const float right = i + 1 < m_masses ? x[i + 1] : x[i];
+                    const float a = k * (left + right - 2.0f * x[i]) - c * v[i] + std::clamp(f[i], -10.0f, 10.0f);
+                    v[i] += h * a;
+                    x[i] += h * v[i];
+                }
+            const float d = x[m_masses - 1] - 1.0f;
+            m_rew[size_t(e)] = -d * d;
+            m_done[size_t(e)] = ++m_t[size_t(e)] >= uint32_t(m_episodeLen);
+            if (m_done[size_t(e)]) resetEnv(e);
+        }
+    }
+
+private:
+    void resetEnv(int e)
+    {
+        uint64_t s = m_seed ^ (uint64_t(e) << 32) ^ m_episode[size_t(e)]++;
+        float* x = m_obs.data() + size_t(e) * size_t(2 * m_masses);
+        for (int i = 0; i < 2 * m_masses; ++i) x[i] = 0.2f * (uniform01(s) - 0.5f);
+        m_t[size_t(e)] = 0;
+    }
+
+    int m_envs, m_masses, m_substeps, m_episodeLen;
+    uint64_t m_seed;
+    std::vector<float> m_obs, m_act, m_rew;
+    std::vector<uint8_t> m_done;
+    std::vector<uint32_t> m_t;
+    std::vector<uint64_t> m_episode;
+};
+
+bool sameChunk(const Trajectory& a, const Trajectory& b)
+{
+    auto eq = [](const auto& x, const auto& y) {
+        return x.size() == y.size() && std::memcmp(x.data(), y.data(), x.size() * sizeof(x[0])) == 0;
+    };
+    return eq(a.obs, b.obs) && eq(a.actions, b.actions) && eq(a.rewards, b.rewards) && eq(a.dones, b.dones)
+           && eq(a.lastObs, b.lastObs);
+}
+
+} // namespace
+
+bool RolloutWorkers::runSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[ROLLOUT] %s %-44s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+    using clk = std::chrono::steady_clock;
+    const int hw = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    // ---- broadcast: concurrent readers never see a torn or older set of weights ----
+    {
+        const size_t n = 4096;
+        PolicyBroadcast pb(n);
+        std::atomic<bool> done{ false };
+        std::atomic<uint64_t> torn{ 0 }, backwards{ 0 }, copies{ 0 };
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r)
+            readers.emplace_back([&]() {
+                std::vector<float> w(n);
+                uint64_t have = 0;
+                while (!done.load(std::memory_order_acquire)) {
+                    const uint64_t v = pb.fetch(have, w.data());
+                    if (v == have) continue;
+                    if (v < have) ++backwards;
+                    for (size_t i = 0; i < n; ++i)
+                        if (w[i] != float(v)) { ++torn; break; }
+                    have = v;
+                    ++copies;
+                }
+            });
+        std::vector<float> w(n);
+        const uint64_t publishes = 20000;
+        for (uint64_t v = 1; v <= publishes; ++v) {
+            std::fill(w.begin(), w.end(), float(v));
+            pb.publish(w.data());
+        }
+        done = true;
+        for (std::thread& t : readers) t.join();
+        report(torn == 0 && backwards == 0 && copies > 0 && pb.version() == publishes,
+               "broadcast: no torn or stale copies",
+               QStringLiteral("(%1 publishes of %2 floats, %3 reader copies, %4 torn)")
+                   .arg(publishes).arg(n).arg(copies.load()).arg(torn.load()));
+    }
+
+    // ---- per-worker determinism: chunks == a serial re-run of the worker's envs and seed ----
+    const int masses = 8, episodeLen = 50;
+    auto chainFactory = [&](int envs, int substeps) {
+        return [=](int worker) -> std::unique_ptr<IRolloutEnv> {
+            return std::make_unique<ChainEnv>(envs, masses, substeps, episodeLen, 1000 + uint64_t(worker));
+        };
+    };
+    {
+        Config c;
+        c.workers = 4;
+        c.stepsPerChunk = 32;
+        c.seed = 7;
+        LinearGaussianPolicy proto(2 * masses, masses, 0.3f);
+        PolicyBroadcast pb(proto.numWeights());
+        std::vector<float> w(proto.numWeights());
+        for (size_t i = 0; i < w.size(); ++i) w[i] = 0.05f * float(int(i % 7) - 3);
+        pb.publish(w.data());
+
+        RolloutWorkers rw;
+        rw.start(c, chainFactory(4, 4), proto, pb);
+        const int perWorker = 6;
+        std::map<int, std::vector<std::unique_ptr<Trajectory>>> got;
+        int total = 0;
+        while (total < c.workers * perWorker) {
+            std::unique_ptr<Trajectory> t = rw.pop(2000);
+            if (!t) break;
+            if (got[t->worker].size() < size_t(perWorker)) { got[t->worker].push_back(std::move(t)); ++total; }
+            else rw.recycle(std::move(t));
+        }
+        rw.stop();
+
+        // serial re-run of worker 2 with the same seed, and with another (neg-ctrl)
+        auto serial = [&](uint64_t seed, int worker) {
+            RolloutWorkers one;
+            one.m_config = c;
+            one.m_config.seed = seed;
+            one.m_config.queueCapacity = perWorker + 1;
+            one.m_weights = &pb;
+            one.m_run = true;
+            std::unique_ptr<IRolloutEnv> env = chainFactory(4, 4)(worker);
+            std::unique_ptr<IPolicy> policy = proto.clone();
+            // the same loop start() runs, on a thread of its own with nothing else going
+            std::thread th([&]() { one.workerLoop(worker, env.get(), policy.get()); });
+            std::vector<std::unique_ptr<Trajectory>> out;
+            while (out.size() < size_t(perWorker)) {
+                std::unique_ptr<Trajectory> t = one.pop(2000);
+                if (!t) break;
+                out.push_back(std::move(t));
+            }
+            one.stop();
+            th.join();
+            return out;
+        };
+        const int probe = 2;
+        const auto again = serial(c.seed, probe);
+        const auto other = serial(c.seed + 1, probe);
+        int match = 0, otherMatch = 0;
+        const auto& mine = got[probe];
+        for (size_t i = 0; i < mine.size() && i < again.size(); ++i) match += sameChunk(*mine[i], *again[i]);
+        for (size_t i = 0; i < mine.size() && i < other.size(); ++i) otherMatch += sameChunk(*mine[i], *other[i]);
+        report(total == c.workers * perWorker && match == perWorker, "worker chunks == serial re-run (bitwise)",
+               QStringLiteral("(%1/%2 chunks of worker %3, 4 workers running)").arg(match).arg(perWorker).arg(probe));
+        report(otherMatch == 0, "NEG-CTRL another seed gives other chunks",
+               QStringLiteral("(%1/%2 equal)").arg(otherMatch).arg(perWorker));
+    }
+
+    // ---- versions: every chunk is under one version, every worker picks up the newest ----
+    {
+        Config c;
+        c.workers = 4;
+        c.stepsPerChunk = 16;
+        LinearGaussianPolicy proto(2 * masses, masses, 0.0f);     // W = 0: action = bias = version
+        PolicyBroadcast pb(proto.numWeights());
+        std::vector<float> w(proto.numWeights(), 0.0f);
+        auto publish = [&](uint64_t v) {
+            std::fill(w.end() - masses, w.end(), float(v));
+            return pb.publish(w.data());
+        };
+        publish(1);
+        RolloutWorkers rw;
+        rw.start(c, chainFactory(2, 1), proto, pb);
+        const uint64_t finalVersion = 20;
+        int consistent = 0, chunks = 0;
+        uint64_t lagSum = 0, lagMax = 0;
+        std::vector<uint64_t> seen(size_t(c.workers), 0);
+        const auto deadline = clk::now() + std::chrono::seconds(10);
+        while (clk::now() < deadline) {
+            std::unique_ptr<Trajectory> t = rw.pop(100);
+            if (!t) continue;
+            ++chunks;
+            bool one = true;
+            for (float a : t->actions) one = one && a == float(t->policyVersion);
+            consistent += one;
+            const uint64_t lag = pb.version() - t->policyVersion;
+            lagSum += lag;
+            lagMax = std::max(lagMax, lag);
+            seen[size_t(t->worker)] = std::max(seen[size_t(t->worker)], t->policyVersion);
+            rw.recycle(std::move(t));
+            if (pb.version() < finalVersion && chunks % 4 == 0) publish(pb.version() + 1);
+            if (std::all_of(seen.begin(), seen.end(), [&](uint64_t v) { return v == finalVersion; })) break;
+        }
+        rw.stop();
+        const bool allSeen = std::all_of(seen.begin(), seen.end(), [&](uint64_t v) { return v == finalVersion; });
+        report(consistent == chunks && allSeen, "versions reach every worker, one per chunk",
+               QStringLiteral("(%1 chunks, lag mean %2 max %3 versions)")
+                   .arg(chunks).arg(chunks ? double(lagSum) / chunks : 0.0, 0, 'f', 2).arg(lagMax));
+    }
+
+    // ---- backpressure: a stalled learner blocks the workers, nothing is lost ----
+    {
+        Config c;
+        c.workers = 4;
+        c.stepsPerChunk = 8;
+        c.queueCapacity = 2;
+        LinearGaussianPolicy proto(2 * masses, masses, 0.1f);
+        PolicyBroadcast pb(proto.numWeights());
+        std::vector<float> w(proto.numWeights(), 0.0f);
+        pb.publish(w.data());
+        RolloutWorkers rw;
+        rw.start(c, chainFactory(2, 1), proto, pb);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const uint64_t queuedWhileStalled = rw.chunks();
+        std::vector<uint64_t> next(size_t(c.workers), 0);
+        bool contiguous = true;
+        for (int i = 0; i < 200; ++i) {
+            std::unique_ptr<Trajectory> t = rw.pop(2000);
+            if (!t) { contiguous = false; break; }
+            contiguous = contiguous && t->chunk == next[size_t(t->worker)]++;
+            rw.recycle(std::move(t));
+        }
+        const auto t0 = clk::now();
+        rw.stop();                                            // workers are blocked on the full queue again
+        const double stopMs = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+        report(queuedWhileStalled == uint64_t(c.queueCapacity) && contiguous && rw.blockedSeconds() > 0.0 && stopMs < 1000.0,
+               "stalled learner: workers block, no chunk lost",
+               QStringLiteral("(%1 chunks queued in 200 ms, 200 popped in order, stop %2 ms)")
+                   .arg(queuedWhileStalled).arg(stopMs, 0, 'f', 1));
+    }
+
+    // ---- throughput: samples/s vs worker count, learner popping on this thread ----
+    auto measure = [&](int workers, const EnvFactory& factory, const IPolicy& proto, double seconds) {
+        Config c;
+        c.workers = workers;
+        c.stepsPerChunk = 32;
+        PolicyBroadcast pb(proto.numWeights());
+        std::vector<float> w(proto.numWeights(), 0.0f);
+        pb.publish(w.data());
+        RolloutWorkers rw;
+        if (!rw.start(c, factory, proto, pb)) return 0.0;
+        for (int i = 0; i < workers; ++i) rw.recycle(rw.pop(2000));       // warm-up
+        uint64_t samples = 0;
+        const auto t0 = clk::now();
+        int popped = 0;
+        while (std::chrono::duration<double>(clk::now() - t0).count() < seconds) {
+            std::unique_ptr<Trajectory> t = rw.pop(100);
+            if (!t) continue;
+            samples += t->samples();
+            if (++popped % 16 == 0) pb.publish(w.data());                  // an asynchronous learner's updates
+            rw.recycle(std::move(t));
+        }
+        const double rate = double(samples) / std::chrono::duration<double>(clk::now() - t0).count();
+        rw.stop();
+        return rate;
+    };
+    {
+        LinearGaussianPolicy proto(2 * masses, masses, 0.3f);
+        const EnvFactory factory = chainFactory(16, 64);
+        std::vector<int> counts;
+        for (int n = 1; n <= std::min(hw, 16); n *= 2) counts.push_back(n);
+        std::vector<double> rates;
+        QString line;
+        for (int n : counts) {
+            rates.push_back(measure(n, factory, proto, 0.5));
+            line += QStringLiteral(" %1w %2k/s").arg(n).arg(rates.back() * 1e-3, 0, 'f', 0);
+        }
+        const auto at4 = std::find(counts.begin(), counts.end(), 4);
+        if (hw >= 4 && at4 != counts.end()) {
+            const double speedup = rates[size_t(at4 - counts.begin())] / rates[0];
+            report(speedup >= 1.5, "samples/s scale with workers (4 vs 1)",
+                   QStringLiteral("(%1x;%2)").arg(speedup, 0, 'f', 2).arg(line));
+        }
+        else {
+            std::fprintf(stderr, "[ROLLOUT] info %-44s (%s; %d hardware threads, not gated)\n",
+                         "samples/s vs workers", qPrintable(line), hw);
+        }
+    }
+
+#if defined(KR_WITH_PHYSX)
+    // ---- VecEnv-backed workers (reported) ----
+    if (SimulationController::physxCoreAlive()) {
+        using namespace physx;
+        const VecEnv::TemplateFn boxes = [](PxPhysics& physics, PxScene& scene) {
+            PxMaterial* mat = physics.createMaterial(0.6f, 0.6f, 0.0f);
+            scene.addActor(*PxCreatePlane(physics, PxPlane(0, 1, 0, 0), *mat));
+            for (int i = 0; i < 3; ++i)
+                scene.addActor(*PxCreateDynamic(physics, PxTransform(PxVec3(0.3f * float(i), 0.1f, 0.0f)),
+                                                PxBoxGeometry(0.1f, 0.1f, 0.1f), *mat, 500.0f));
+            mat->release();
+        };
+        const EnvFactory factory = [&](int) -> std::unique_ptr<IRolloutEnv> {
+            VecEnv::Config vc;
+            vc.numEnvs = 8;
+            vc.dispatcherThreads = 1;
+            vc.maxEpisodeSteps = 200;
+            auto env = std::make_unique<VecEnv>();
+            if (!env->initialize(vc, boxes)) return nullptr;
+            return makeRolloutEnv(std::move(env));
+        };
+        LinearGaussianPolicy proto(3 * VecEnv::kObsPerBody, 3 * VecEnv::kActPerBody, 1.0f);
+        const int many = std::max(1, std::min(4, hw / 2));
+        const double r1 = measure(1, factory, proto, 1.0);
+        const double rn = measure(many, factory, proto, 1.0);
+        std::fprintf(stderr, "[ROLLOUT] info %-44s (1w %.0f/s, %dw %.0f/s = %.2fx; 8 envs + 1 dispatcher thread each)\n",
+                     "VecEnv workers env-steps/s", r1, many, rn, r1 > 0.0 ? rn / r1 : 0.0);
+    }
+#endif
+
+    std::fprintf(stderr, "[ROLLOUT] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
+
+} // namespace krs::rl
@@ -0,0 +1,564 @@
+#include "SimReplay.hpp"
+#include "CookedMeshCache.hpp"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace krs::replay {
+
+namespace {
+
+constexpr char kMagic[4] = { 'K', 'R', 'R', 'P' };
+constexpr size_t kHeaderBytes = 20;
+constexpr uint32_t kVersion = 2;
+constexpr unsigned char kEventTag = 'E';
+constexpr unsigned char kStepTag = 'S';
+constexpr unsigned char kFooterTag = 'F';
+constexpr size_t kFlushBytes = size_t(1) << 16;
+
+constexpr uint64_t kMul0 = 0x9E3779B97F4A7C15ull;
+constexpr uint64_t kMul1 = 0xD6E8FEB86659FD93ull;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t mix(uint64_t x)
+{
+    x ^= x >> 32; x *= kMul1;
+    x ^= x >> 32; x *= kMul1;
+    x ^= x >> 32;
+    return x;
+}
+
+inline uint32_t floatBits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+
+/// hashWords over count 32-bit words produced by word(i), so float state
+/// can be hashed by bit pattern without punning the array.
+template <typename Word>
+uint64_t hashLanes(size_t count, uint64_t seed, Word word)
+{
+    uint64_t h = seed ^ (uint64_t(count) * kMul0);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const uint64_t lane = uint64_t(word(i)) | (uint64_t(word(i + 1)) << 32);
+        h = rotl(h ^ mix(lane ^ kMul0), 27) * kMul1 + kMul0;
+    }
+    if (i < count) h = rotl(h ^ mix(uint64_t(word(i)) ^ kMul1), 27) * kMul1 + kMul0;
+    return mix(h);
+}
+
+template <typename T>
+void put(std::vector<unsigned char>& out, const T& v)
+{
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &v, sizeof(T));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------
+// Hashing
+// ---------------------------------------------------------------------------------------------------
+uint64_t hashWords(const uint32_t* words, size_t count, uint64_t seed)
+{
+    return hashLanes(count, seed, [words](size_t i) { return words[i]; });
+}
+
+uint64_t hashBody(const BodyState& b)
+{
+    uint32_t w[14];
+    w[0] = b.id;
+    for (int k = 0; k < 3; ++k) w[1 + k] = floatBits(b.p[k]);
+    for (int k = 0; k < 4; ++k) w[4 + k] = floatBits(b.q[k]);
+    for (int k = 0; k < 3; ++k) w[8 + k] = floatBits(b.v[k]);
+    for (int k = 0; k < 3; ++k) w[11 + k] = floatBits(b.w[k]);
+    return hashWords(w, 14);
+}
+
+uint64_t hashFloats(uint32_t id, const float* values, size_t count)
+{
+    static_assert(sizeof(float) == sizeof(uint32_t), "float must be 32-bit");
+    return hashLanes(count, mix(uint64_t(id) + kMul1), [values](size_t i) { return floatBits(values[i]); });
+}
+
+uint64_t combine(const std::vector<BodyHash>& bodies)
+{
+    uint64_t h = uint64_t(bodies.size()) * kMul1;
+    for (const BodyHash& b : bodies)
+        h = rotl(h ^ mix(b.hash ^ (uint64_t(b.id) * kMul0)), 31) * kMul0 + kMul1;
+    return mix(h);
+}
+
+float Event::value(size_t i) const
+{
+    float f = 0.0f;
+    if (i < words.size()) std::memcpy(&f, &words[i], 4);
+    return f;
+}
+
+std::vector<float> Event::values() const
+{
+    std::vector<float> out(words.size());
+    if (!words.empty()) std::memcpy(out.data(), words.data(), words.size() * 4);
+    return out;
+}
+
+QString Divergence::describe() const
+{
+    if (!diverged) return QStringLiteral("no divergence");
+    QStringList ids;
+    for (size_t i = 0; i < bodies.size() && i < 8; ++i)
+        ids << (bodies[i] == kArticulationBody ? QStringLiteral("articulation") : QString::number(bodies[i]));
+    if (bodies.size() > 8) ids << QStringLiteral("... (%1 total)").arg(bodies.size());
+    return QStringLiteral("first divergence at step %1: state %2 != recorded %3, bodies [%4]")
+        .arg(step).arg(actual, 16, 16, QLatin1Char('0')).arg(expected, 16, 16, QLatin1Char('0'))
+        .arg(ids.join(QStringLiteral(", ")));
+}
+
+Divergence compare(const StepRecord& recorded, const std::vector<BodyHash>& live)
+{
+    Divergence d;
+    d.step = recorded.step;
+    d.expected = recorded.hash;
+    d.actual = combine(live);
+    if (d.actual == d.expected) return d;
+    d.diverged = true;
+    // Merge walk over the two id-sorted tables.
+    size_t a = 0, b = 0;
+    const auto& rec = recorded.bodies;
+    while (a < rec.size() || b < live.size()) {
+        if (b == live.size() || (a < rec.size() && rec[a].id < live[b].id)) { d.bodies.push_back(rec[a++].id); continue; }
+        if (a == rec.size() || live[b].id < rec[a].id) { d.bodies.push_back(live[b++].id); continue; }
+        if (rec[a].hash != live[b].hash) d.bodies.push_back(rec[a].id);
+        ++a; ++b;
+    }
+    return d;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Recorder
+// ---------------------------------------------------------------------------------------------------
+Recorder::~Recorder() { close(); }
+
+bool Recorder::open(const QString& path, const Header& header)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    m_buf.clear();
+    m_last.clear();
+    m_bytes = m_steps = m_events = 0;
+    m_buf.insert(m_buf.end(), kMagic, kMagic + 4);
+    put(m_buf, kVersion);
+    put(m_buf, header.dt);
+    put(m_buf, header.dispatcherThreads);
+    put(m_buf, uint32_t(0));
+    return true;
+}
+
+bool Recorder::close()
+{
+    if (!m_file.isOpen()) return false;
+    m_buf.push_back(kFooterTag);
+    put(m_buf, m_steps);
+    put(m_buf, m_events);
+    flush();
+    const bool ok = m_file.error() == QFileDevice::NoError;
+    m_file.close();
+    return ok;
+}
+
+void Recorder::flush()
+{
+    if (m_buf.empty() || !m_file.isOpen()) return;
+    m_file.write(reinterpret_cast<const char*>(m_buf.data()), qint64(m_buf.size()));
+    m_bytes += m_buf.size();
+    m_buf.clear();
+}
+
+void Recorder::event(EventType type, uint32_t entity, const uint32_t* words, uint32_t count)
+{
+    payload(type, entity, words, count);
+}
+
+void Recorder::event(EventType type, uint32_t entity, const float* values, uint32_t count)
+{
+    payload(type, entity, values, count);
+}
+
+void Recorder::payload(EventType type, uint32_t entity, const void* words, uint32_t count)
+{
+    if (!m_file.isOpen()) return;
+    m_buf.push_back(kEventTag);
+    m_buf.push_back(uint8_t(type));
+    put(m_buf, entity);
+    put(m_buf, count);
+    const size_t at = m_buf.size();
+    m_buf.resize(at + size_t(count) * 4);
+    if (count) std::memcpy(m_buf.data() + at, words, size_t(count) * 4);
+    ++m_events;
+    if (m_buf.size() >= kFlushBytes) flush();
+}
+
+void Recorder::step(uint64_t step, const std::vector<BodyHash>& bodies)
+{
+    if (!m_file.isOpen()) return;
+    m_buf.push_back(kStepTag);
+    put(m_buf, step);
+    put(m_buf, combine(bodies));
+    const size_t counts = m_buf.size();
+    put(m_buf, uint32_t(0));
+    put(m_buf, uint32_t(0));
+
+    uint32_t changed = 0;
+    std::vector<uint32_t> removed;
+    size_t a = 0;
+    for (const BodyHash& b : bodies) {
+        while (a < m_last.size() && m_last[a].id < b.id) removed.push_back(m_last[a++].id);
+        const bool same = a < m_last.size() && m_last[a].id == b.id && m_last[a].hash == b.hash;
+        if (a < m_last.size() && m_last[a].id == b.id) ++a;
+        if (same) continue;
+        put(m_buf, b.id);
+        put(m_buf, b.hash);
+        ++changed;
+    }
+    while (a < m_last.size()) removed.push_back(m_last[a++].id);
+    for (uint32_t id : removed) put(m_buf, id);
+    const uint32_t removedCount = uint32_t(removed.size());
+    std::memcpy(m_buf.data() + counts, &changed, 4);
+    std::memcpy(m_buf.data() + counts + 4, &removedCount, 4);
+
+    m_last = bodies;
+    ++m_steps;
+    if (m_buf.size() >= kFlushBytes) flush();
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Player
+// ---------------------------------------------------------------------------------------------------
+bool Player::fail(const QString& why)
+{
+    m_error = why;
+    m_pos = m_size;
+    return false;
+}
+
+bool Player::open(const QString& path)
+{
+    m_error.clear();
+    m_table.clear();
+    m_pos = 0;
+    m_steps = m_events = 0;
+    m_ended = false;
+    auto blob = CookedMeshCache::mapFile(path);
+    if (!blob) { m_data = nullptr; m_size = 0; return fail(QStringLiteral("cannot map %1").arg(path)); }
+    m_data = blob->data();
+    m_size = blob->size();
+    m_owner = std::move(blob);
+    if (m_size < kHeaderBytes || std::memcmp(m_data, kMagic, 4) != 0)
+        return fail(QStringLiteral("%1 is not a replay log").arg(path));
+    std::memcpy(&m_header.version, m_data + 4, 4);
+    std::memcpy(&m_header.dt, m_data + 8, 4);
+    std::memcpy(&m_header.dispatcherThreads, m_data + 12, 4);
+    if (m_header.version != kVersion) return fail(QStringLiteral("unsupported replay log version %1").arg(m_header.version));
+    m_pos = kHeaderBytes;
+    return true;
+}
+
+bool Player::next(std::vector<Event>& events, StepRecord& record)
+{
+    events.clear();
+    if (!m_error.isEmpty()) return false;
+    auto read = [this](void* dst, size_t n) {
+        if (m_size - m_pos < n) return false;
+        std::memcpy(dst, m_data + m_pos, n);
+        m_pos += n;
+        return true;
+    };
+    while (m_pos < m_size) {
+        const size_t at = m_pos;
+        const unsigned char tag = m_data[m_pos++];
+        if (tag == kEventTag) {
+            Event ev;
+            uint8_t type = 0;
+            uint32_t count = 0;
+            if (!read(&type, 1) || !read(&ev.entity, 4) || !read(&count, 4)
+                || count > kMaxEventWords || size_t(count) * 4 > m_size - m_pos)
+                return fail(QStringLiteral("truncated event record at byte %1").arg(at));
+            if (type < uint8_t(EventType::Teleport) || type > uint8_t(EventType::Spawn))
+                return fail(QStringLiteral("unknown event type %1 at byte %2").arg(type).arg(at));
+            ev.type = EventType(type);
+            ev.words.resize(count);
+            read(ev.words.data(), size_t(count) * 4);
+            events.push_back(std::move(ev));
+            ++m_events;
+        }
+        else if (tag == kStepTag) {
+            uint32_t changed = 0, removed = 0;
+            if (!read(&record.step, 8) || !read(&record.hash, 8) || !read(&changed, 4) || !read(&removed, 4)
+                || size_t(changed) * 12 + size_t(removed) * 4 > m_size - m_pos)
+                return fail(QStringLiteral("truncated step record at byte %1").arg(at));
+            // Apply the delta to the running id-sorted table.
+            std::vector<BodyHash> delta(changed);
+            for (BodyHash& b : delta) { read(&b.id, 4); read(&b.hash, 8); }
+            std::vector<uint32_t> gone(removed);
+            for (uint32_t& id : gone) read(&id, 4);
+            std::vector<BodyHash> merged;
+            merged.reserve(m_table.size() + delta.size());
+            size_t a = 0, d = 0;
+            while (a < m_table.size() || d < delta.size()) {
+                if (d == delta.size() || (a < m_table.size() && m_table[a].id < delta[d].id)) merged.push_back(m_table[a++]);
+                else if (a == m_table.size() || delta[d].id < m_table[a].id) merged.push_back(delta[d++]);
+                else { merged.push_back(delta[d++]); ++a; }
+            }
+            if (!gone.empty())
+                merged.erase(std::remove_if(merged.begin(), merged.end(), [&](const BodyHash& b) {
+                    return std::binary_search(gone.begin(), gone.end(), b.id);
+                }), merged.end());
+            m_table = std::move(merged);
+            record.bodies = m_table;
+            ++m_steps;
+            return true;
+        }
+        else if (tag == kFooterTag) {
+            uint64_t steps = 0, evs = 0;
+            if (!read(&steps, 8) || !read(&evs, 8))
+                return fail(QStringLiteral("truncated end marker at byte %1").arg(at));
+            if (steps != m_steps || evs != m_events)
+                return fail(QStringLiteral("end marker counts %1 steps / %2 events, log holds %3 / %4")
+                                .arg(steps).arg(evs).arg(m_steps).arg(m_events));
+            if (m_pos != m_size)
+                return fail(QStringLiteral("%1 bytes after the end marker").arg(m_size - m_pos));
+            m_ended = true;
+            events.clear();   // inputs after the last step never reached a step
+            return false;
+        }
+        else {
+            return fail(QStringLiteral("bad record tag 0x%1 at byte %2").arg(tag, 2, 16, QLatin1Char('0')).arg(at));
+        }
+    }
+    if (m_ended) return false;
+    return fail(QStringLiteral("log ends after %1 steps without an end marker (recording cut short)").arg(m_steps));
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Self-test: a small deterministic world standing in for the PhysX scene
+// ---------------------------------------------------------------------------------------------------
+namespace {
+
+struct ToyWorld {
+    static constexpr int kBalls = 64;
+    static constexpr float kRadius = 0.04f;
+    std::vector<BodyState> balls;
+
+    void init()
+    {
+        balls.assign(kBalls, BodyState{});
+        for (int i = 0; i < kBalls; ++i) {
+            BodyState& b = balls[size_t(i)];
+            b.id = uint32_t(i) * 3u + 5u;    // sparse ids, like entities
+            b.p[0] = 0.1f + 0.1f * float(i % 8);
+            b.p[1] = 0.2f + 0.1f * float(i / 8);
+            b.p[2] = 0.5f + 0.01f * float(i % 5);
+            b.q[3] = 1.0f;
+        }
+    }
+
+    void apply(const Event& ev)
+    {
+        if (ev.type != EventType::Impulse) return;
+        for (BodyState& b : balls)
+            if (b.id == ev.entity) for (int k = 0; k < 3; ++k) b.v[k] += ev.value(size_t(k));
+    }
+
+    void step(float dt)
+    {
+        for (BodyState& b : balls) {
+            b.v[1] -= 9.81f * dt;
+            for (int k = 0; k < 3; ++k) {
+                b.p[k] += b.v[k] * dt;
+                if (b.p[k] < kRadius)        { b.p[k] = kRadius;        b.v[k] = std::abs(b.v[k]) * 0.8f; }
+                if (b.p[k] > 1.0f - kRadius) { b.p[k] = 1.0f - kRadius; b.v[k] = -std::abs(b.v[k]) * 0.8f; }
+            }
+        }
+        for (size_t i = 0; i < balls.size(); ++i)
+            for (size_t j = i + 1; j < balls.size(); ++j) {
+                BodyState& a = balls[i];
+                BodyState& c = balls[j];
+                float n[3], d2 = 0.0f;
+                for (int k = 0; k < 3; ++k) { n[k] = c.p[k] - a.p[k]; d2 += n[k] * n[k]; }
+                if (d2 >= 4.0f * kRadius * kRadius || d2 < 1e-12f) continue;
+                const float d = std::sqrt(d2);
+                float vn = 0.0f;
+                for (int k = 0; k < 3; ++k) { n[k] /= d; vn += (c.v[k] - a.v[k]) * n[k]; }
+                const float push = 0.5f * (2.0f * kRadius - d);
+                for (int k = 0; k < 3; ++k) {
+                    a.p[k] -= n[k] * push;
+                    c.p[k] += n[k] * push;
+                    if (vn < 0.0f) { a.v[k] += vn * n[k]; c.v[k] -= vn * n[k]; }
+                }
+            }
+    }
+
+    void hashes(std::vector<BodyHash>& out) const
+    {
+        out.resize(balls.size());
+        for (size_t i = 0; i < balls.size(); ++i) out[i] = { balls[i].id, hashBody(balls[i]) };
+    }
+};
+
+constexpr float kToyDt = 1.0f / 240.0f;
+
+bool recordToy(const QString& path, int steps)
+{
+    Recorder rec;
+    Header h;
+    h.dt = kToyDt;
+    if (!rec.open(path, h)) return false;
+    ToyWorld w;
+    w.init();
+    std::vector<BodyHash> hs;
+    w.hashes(hs);
+    rec.step(0, hs);
+    uint32_t s = 17u;
+    auto rnd = [&s]() { s = s * 1664525u + 1013904223u; return float(s >> 8) / float(1u << 24) - 0.5f; };
+    for (int k = 1; k <= steps; ++k) {
+        if (k % 3 == 0) {
+            Event ev;
+            ev.type = EventType::Impulse;
+            ev.entity = w.balls[size_t(k * 7) % w.balls.size()].id;
+            const float j[3] = { rnd(), 2.0f * rnd(), rnd() };
+            rec.event(ev.type, ev.entity, j, 3);
+            ev.words = { floatBits(j[0]), floatBits(j[1]), floatBits(j[2]) };
+            w.apply(ev);
+        }
+        w.step(kToyDt);
+        w.hashes(hs);
+        rec.step(uint64_t(k), hs);
+    }
+    return rec.close();
+}
+
+/// Re-run a toy log; optionally nudge one ball's velocity by one ulp before `nudgeStep`.
+ReplayReport replayToy(const QString& path, uint64_t nudgeStep = 0, uint32_t nudgeBody = 0)
+{
+    ReplayReport report;
+    Player log;
+    if (!log.open(path)) { report.error = log.error(); return report; }
+    ToyWorld w;
+    w.init();
+    std::vector<Event> events;
+    StepRecord rec;
+    std::vector<BodyHash> live;
+    while (log.next(events, rec)) {
+        for (const Event& ev : events) w.apply(ev);
+        if (rec.step > 0) {
+            if (rec.step == nudgeStep)
+                for (BodyState& b : w.balls) if (b.id == nudgeBody) b.v[0] = std::nextafter(b.v[0], 1e9f);
+            w.step(log.header().dt);
+        }
+        w.hashes(live);
+        report.divergence = compare(rec, live);
+        if (report.divergence.diverged) break;
+        report.stepsReplayed = rec.step;
+    }
+    report.error = log.error();
+    report.ok = report.error.isEmpty() && !report.divergence.diverged;
+    return report;
+}
+
+QByteArray readAll(const QString& path)
+{
+    QFile f(path);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+bool writeAll(const QString& path, const QByteArray& bytes)
+{
+    QFile f(path);
+    return f.open(QIODevice::WriteOnly | QIODevice::Truncate) && f.write(bytes) == bytes.size();
+}
+
+} // namespace
+
+bool runSelfTests()
+{
+    bool pass = true;
+    auto report = [&](bool ok, const char* name, const QString& detail) {
+        std::fprintf(stderr, "[SIM-REPLAY] %s %-40s %s\n", ok ? "PASS" : "FAIL", name, qPrintable(detail));
+        pass = pass && ok;
+    };
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) { report(false, "temp directory", tmp.errorString()); return false; }
+    const int steps = 600;
+    const QString path = tmp.path() + QStringLiteral("/toy.krrp");
+    const bool recorded = recordToy(path, steps);
+    const qint64 logBytes = QFileInfo(path).size();
+
+    // ---- replay matches every step; a second recording is byte-identical ----
+    {
+        const ReplayReport r = replayToy(path);
+        const QString again = tmp.path() + QStringLiteral("/toy2.krrp");
+        const bool identical = recordToy(again, steps) && readAll(again) == readAll(path);
+        report(recorded && r.ok && r.stepsReplayed == uint64_t(steps) && identical, "replay == recording, every step",
+               QStringLiteral("(%1 steps, %2 B/step, re-record byte-identical %3)")
+                   .arg(r.stepsReplayed).arg(double(logBytes) / steps, 0, 'f', 1).arg(identical ? "yes" : "no"));
+    }
+
+    // ---- NEG-CTRL: a one-ulp velocity nudge is found at its step and body ----
+    {
+        const uint64_t atStep = 137;
+        const uint32_t body = 42u * 3u + 5u;
+        const ReplayReport r = replayToy(path, atStep, body);
+        const auto& d = r.divergence;
+        const bool found = d.diverged && d.step == atStep
+                           && std::find(d.bodies.begin(), d.bodies.end(), body) != d.bodies.end();
+        report(!r.ok && found, "NEG-CTRL one-ulp nudge located", d.describe());
+    }
+
+    // ---- damaged logs are refused, not replayed as a pass ----
+    {
+        const QByteArray good = readAll(path);
+        QByteArray truncated = good;  truncated.chop(7);
+        QByteArray garbled = good;    garbled[int(kHeaderBytes)] = 'X';
+        QByteArray notLog = good;     notLog[0] = 'Z';
+        QByteArray unclosed = good;   unclosed.chop(int(kFooterBytes));   // ends on a whole step record
+        int refused = 0;
+        for (const QByteArray* b : { &truncated, &garbled, &notLog, &unclosed }) {
+            const QString p = tmp.path() + QStringLiteral("/bad.krrp");
+            writeAll(p, *b);
+            const ReplayReport r = replayToy(p);
+            refused += !r.ok && !r.error.isEmpty();
+        }
+        refused += !replayToy(tmp.path() + QStringLiteral("/absent.krrp")).ok;
+        report(refused == 5, "truncated/garbled/magic/unclosed/missing refused", QStringLiteral("(%1 of 5)").arg(refused));
+    }
+
+    // ---- hashing cost per body ----
+    {
+        ToyWorld w;
+        w.init();
+        std::vector<BodyHash> hs;
+        const int reps = 20000;
+        uint64_t sink = 0;
+        QElapsedTimer t;
+        t.start();
+        for (int r = 0; r < reps; ++r) { w.balls[0].p[0] = float(r); w.hashes(hs); sink ^= combine(hs); }
+        const double nsPerBody = double(t.nsecsElapsed()) / (double(reps) * ToyWorld::kBalls);
+        report(sink != 0, "state hash cost", QStringLiteral("(%1 ns/body incl. combine; 1000 bodies = %2 us/step)")
+                                                  .arg(nsPerBody, 0, 'f', 1).arg(nsPerBody, 0, 'f', 1));
+    }
+
+    std::fprintf(stderr, "[SIM-REPLAY] overall: %s\n", pass ? "ALL PASS" : "FAILURES PRESENT");
+    return pass;
+}
+
+} // namespace krs::replay
@@ -12,7 +12,23 @@ size_t processWorkingSetBytes()
         return static_cast<size_t>(pmc.WorkingSetSize);
     return 0;
 }
+size_t processPeakWorkingSetBytes()
+{
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return static_cast<size_t>(pmc.PeakWorkingSetSize);
+    return 0;
+}
 } // namespace krs
 #else
-namespace krs { size_t processWorkingSetBytes() { return 0; } }
+#include <sys/resource.h>
+namespace krs {
+size_t processWorkingSetBytes() { return 0; }
+size_t processPeakWorkingSetBytes()
+{
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) return static_cast<size_t>(ru.ru_maxrss) * 1024u; // KiB on Linux
+    return 0;
+}
+} // namespace krs
 #endif
@@ -1,9 +1,17 @@
 #include "TrajectoryVerifier.hpp"
 #include "MpmAdjoint.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace krs::hil {
 
@@ -11,12 +19,176 @@ static double accelNorm(const std::vector<double>& qdd) {
     double s = 0.0; for (double a : qdd) s += a * a; return std::sqrt(s); // L2 over joints
 }
 
+inline std::uint64_t fnv1a(const void* data, size_t bytes, std::uint64_t h) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+std::uint64_t TrajectoryVerifier::segmentKey(const TrajPoint& a, const TrajPoint& b, const MaterialSpec& mat)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for (const TrajPoint* k : { &a, &b }) {
+        const std::uint64_t n[2] = { k->q.size(), k->qdd.size() };
+        h = fnv1a(n, sizeof(n), h);
+        h = fnv1a(k->q.data(), k->q.size() * sizeof(double), h);
+        h = fnv1a(k->qdd.data(), k->qdd.size() * sizeof(double), h);
+    }
+    const double m[5] = { mat.youngsE, mat.nu, mat.density, mat.yieldStress, mat.charLength };
+    h = fnv1a(m, sizeof(m), h);
+    const std::uint64_t tag = kExactModelTag;
+    return fnv1a(&tag, sizeof(tag), h);
+}
+
+// ---------------------------------------------------------------------------
+// Worker pool + result cache
+// ---------------------------------------------------------------------------
+// Cache file: "KRTV" u32 version, then fixed 24-byte records appended as solves
+// finish (a torn trailing record from a crash is ignored on load).
+struct CacheRecord { std::uint64_t key; std::int32_t verdict; std::int32_t pad; double maxVonMises; };
+static_assert(sizeof(CacheRecord) == 24, "cache record layout");
+
+struct TrajectoryVerifier::Impl {
+    struct Waiter { std::uint64_t plan; std::promise<ExactResult> promise; };
+    struct Job {                                   // one pending solve, shared by identical segments
+        double accel = 0.0;
+        MaterialSpec mat;
+        double priority = 0.0;
+        bool running = false;
+        std::vector<Waiter> waiters;
+    };
+    struct Entry { double priority; std::uint64_t seq, key; };   // heap entry (stale ones are skipped)
+    static bool lower(const Entry& a, const Entry& b) {
+        return a.priority != b.priority ? a.priority < b.priority : a.seq > b.seq; // max priority, then FIFO
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Entry> heap;
+    std::unordered_map<std::uint64_t, Job> jobs;   // queued or running, by content key
+    std::unordered_map<std::uint64_t, ExactResult> cache;
+    std::ofstream cacheOut;
+    VerifierStats st;
+    int running = 0;
+    std::uint64_t seq = 0;
+    bool stop = false;
+    std::vector<std::thread> threads;
+
+    void loadCache(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        bool valid = false;
+        if (in) {
+            char magic[4] = {}; std::uint32_t version = 0;
+            in.read(magic, 4); in.read(reinterpret_cast<char*>(&version), sizeof(version));
+            valid = in && std::memcmp(magic, "KRTV", 4) == 0 && version == 1;
+            CacheRecord r;
+            while (valid && in.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+                ExactResult e; e.verdict = Verdict(r.verdict); e.maxVonMises = r.maxVonMises; e.cached = true;
+                cache[r.key] = e;
+            }
+        }
+        in.close();
+        if (valid) { cacheOut.open(path, std::ios::binary | std::ios::app); return; }
+        if (in.is_open() || std::filesystem::exists(path))
+            std::fprintf(stderr, "[HIL] verifier cache '%s' unreadable; starting fresh\n", path.c_str());
+        cacheOut.open(path, std::ios::binary | std::ios::trunc);
+        const std::uint32_t version = 1;
+        cacheOut.write("KRTV", 4); cacheOut.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        cacheOut.flush();
+    }
+    void persist(std::uint64_t key, const ExactResult& r) {
+        if (!cacheOut) return;
+        const CacheRecord rec{ key, std::int32_t(r.verdict), 0, r.maxVonMises };
+        cacheOut.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+        cacheOut.flush();
+    }
+
+    // Resolve `plan`'s waiters as Cancelled (plan 0 = unmanaged, never superseded).
+    void cancelLocked(std::uint64_t plan, bool all) {
+        for (auto it = jobs.begin(); it != jobs.end();) {
+            Job& j = it->second;
+            if (all && j.running) { ++it; continue; }   // shutdown: running solves finish normally
+            for (auto w = j.waiters.begin(); w != j.waiters.end();) {
+                if (all || w->plan == plan) {
+                    w->promise.set_value(ExactResult{ Verdict::Cancelled, 0.0, false });
+                    ++st.cancelled;
+                    w = j.waiters.erase(w);
+                } else ++w;
+            }
+            if (j.waiters.empty() && !j.running) it = jobs.erase(it);
+            else ++it;
+        }
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        for (;;) {
+            wake.wait(lk, [&]() { return stop || !heap.empty(); });
+            if (stop) return;
+            std::pop_heap(heap.begin(), heap.end(), lower);
+            const Entry e = heap.back(); heap.pop_back();
+            auto it = jobs.find(e.key);
+            if (it == jobs.end() || it->second.running) continue;   // cancelled / duplicate entry
+            Job& j = it->second;
+            j.running = true;
+            st.peakRunning = std::max(st.peakRunning, ++running);
+            const double a = j.accel; const MaterialSpec m = j.mat;
+            lk.unlock();
+            const auto ev = krs::mpmad::evaluatePeakStress(a, m.youngsE, m.nu, m.density, m.yieldStress);
+            ExactResult r; r.maxVonMises = ev.maxVonMises;
+            r.verdict = ev.exceeded ? Verdict::Rejected : Verdict::Safe;   // exact yield decision
+            lk.lock();
+            --running; ++st.exactRuns;
+            cache[e.key] = ExactResult{ r.verdict, r.maxVonMises, true };
+            persist(e.key, r);
+            std::vector<Waiter> waiters = std::move(jobs[e.key].waiters);
+            jobs.erase(e.key);
+            lk.unlock();
+            for (Waiter& w : waiters) w.promise.set_value(r);
+            lk.lock();
+        }
+    }
+};
+
+TrajectoryVerifier::TrajectoryVerifier(const VerifierOptions& opt) : m_impl(std::make_unique<Impl>())
+{
+    unsigned n = opt.workers;
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency() / 2);
+    m_impl->st.workers = n;
+    if (!opt.cacheFile.empty()) m_impl->loadCache(opt.cacheFile);
+    for (unsigned i = 0; i < n; ++i) m_impl->threads.emplace_back([this]() { m_impl->workerLoop(); });
+}
+
+TrajectoryVerifier::~TrajectoryVerifier()
+{
+    {
+        std::lock_guard<std::mutex> lk(m_impl->mutex);
+        m_impl->cancelLocked(0, true);
+        m_impl->stop = true;
+    }
+    m_impl->wake.notify_all();
+    for (std::thread& t : m_impl->threads) t.join();
+}
+
+void TrajectoryVerifier::cancel(std::uint64_t plan)
+{
+    std::lock_guard<std::mutex> lk(m_impl->mutex);
+    m_impl->cancelLocked(plan, false);
+}
+
+VerifierStats TrajectoryVerifier::stats() const
+{
+    std::lock_guard<std::mutex> lk(m_impl->mutex);
+    return m_impl->st;
+}
+
 std::vector<SegmentToken> TrajectoryVerifier::submit(const std::vector<TrajPoint>& traj,
-                                                     const MaterialSpec& mat)
+                                                     const MaterialSpec& mat, std::uint64_t plan)
 {
     std::vector<SegmentToken> out;
     if (traj.size() < 2) return out;
     const double flagThreshold = 0.75 * mat.yieldStress;          // 75% of yield
+    std::vector<std::uint64_t> keys(traj.size() - 1, 0);
     for (size_t i = 0; i + 1 < traj.size(); ++i) {
         SegmentToken t;
         t.index = int(i); t.tStart = traj[i].t; t.tEnd = traj[i + 1].t;
@@ -24,22 +196,40 @@ std::vector<SegmentToken> TrajectoryVerifier::submit(const std::vector<TrajPoint
         // Fast surrogate: conservative inertial stress estimate sigma ~ rho*L*a.
         t.surrogateStress = mat.density * mat.charLength * t.peakAccel * kSurrogateSafety;
         t.flagged = t.surrogateStress > flagThreshold;
-        if (t.flagged) {
-            // Fork the exact double-precision MpmAdjoint pass to a background
-            // thread; the planner thread returns without waiting on it.
-            const double a = t.peakAccel; const MaterialSpec m = mat;
-            t.result = std::async(std::launch::async, [a, m]() {
-                auto e = krs::mpmad::evaluatePeakStress(a, m.youngsE, m.nu, m.density, m.yieldStress);
-                ExactResult r; r.maxVonMises = e.maxVonMises;
-                r.verdict = e.exceeded ? Verdict::Rejected : Verdict::Safe; // exact yield decision
-                return r;
-            });
-        } else {
+        if (t.flagged) keys[i] = segmentKey(traj[i], traj[i + 1], mat);
+        else {
             std::promise<ExactResult> p; p.set_value(ExactResult{ Verdict::Safe, 0.0 }); // immediate SAFE
             t.result = p.get_future();
         }
         out.push_back(std::move(t));
     }
+    // Queue the exact passes in one critical section so the workers see the whole
+    // batch and start with the most suspicious segment; the planner thread returns
+    // without waiting on any solve.
+    Impl& im = *m_impl;
+    {
+        std::lock_guard<std::mutex> lk(im.mutex);
+        if (plan != 0) im.cancelLocked(plan, false);                 // supersede this plan's older jobs
+        for (SegmentToken& t : out) {
+            if (!t.flagged) continue;
+            const std::uint64_t key = keys[size_t(t.index)];
+            std::promise<ExactResult> p;
+            t.result = p.get_future();
+            if (auto c = im.cache.find(key); c != im.cache.end()) {
+                ++im.st.cacheHits; p.set_value(c->second); continue;
+            }
+            const double priority = t.surrogateStress / mat.yieldStress;
+            Impl::Job& j = im.jobs[key];                            // new, or shared with an identical segment
+            if (j.waiters.empty() && !j.running) { j.accel = t.peakAccel; j.mat = mat; j.priority = -1.0; }
+            j.waiters.push_back(Impl::Waiter{ plan, std::move(p) });
+            if (!j.running && priority > j.priority) {
+                j.priority = priority;
+                im.heap.push_back(Impl::Entry{ priority, im.seq++, key });
+                std::push_heap(im.heap.begin(), im.heap.end(), Impl::lower);
+            }
+        }
+    }
+    im.wake.notify_all();
     return out;
 }
 
@@ -105,13 +295,81 @@ bool runTrajectoryHilSelfTest()
                      r.verdict == Verdict::Rejected ? "REJECTED" : "SAFE", r.maxVonMises);
     }
 
-    bool pass = flaggedTransient && baselineClean && nonBlocking && rejectedHigh && safeModerate;
+    // (4) bounded pool + priority: one worker runs the exact passes strictly one at a
+    //     time, identical segments share a solve, the most suspicious resolves first.
+    // (5) supersede: re-submitting plan 7 cancels everything the first submit had pending.
+    // (6) persistent cache: a fresh verifier on the same file resolves every flagged
+    //     segment without a solve. NEG-CTRL: a changed material misses the cache.
+    const std::string cachePath =
+        (std::filesystem::temp_directory_path() / "krs_trajverify_selftest.cache").string();
+    std::error_code ec; std::filesystem::remove(cachePath, ec);
+    bool bounded = false, priorityFirst = false, superseded = false;
+    int distinct = 0;
+    std::vector<Verdict> verdicts(tokens.size(), Verdict::Safe);
+    {
+        std::vector<std::uint64_t> keys;
+        for (const auto& tk : tokens)
+            if (tk.flagged) keys.push_back(TrajectoryVerifier::segmentKey(traj[tk.index], traj[tk.index + 1], mat));
+        std::sort(keys.begin(), keys.end());
+        distinct = int(std::unique(keys.begin(), keys.end()) - keys.begin());
+
+        VerifierOptions o; o.workers = 1; o.cacheFile = cachePath;
+        TrajectoryVerifier v(o);
+        auto first = v.submit(traj, mat, 7);
+        auto second = v.submit(traj, mat, 7);
+        int cancelled = 0;
+        for (auto& tk : first) if (tk.flagged && tk.result.get().verdict == Verdict::Cancelled) ++cancelled;
+        superseded = cancelled == flagged;
+        // first flagged future of `second` to become ready must be in the high window
+        int firstReady = -1;
+        while (firstReady < 0) {
+            for (auto& tk : second)
+                if (tk.flagged && tk.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    firstReady = tk.index; break;
+                }
+            if (firstReady < 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        priorityFirst = firstReady >= 19 && firstReady <= 24;
+        for (auto& tk : second) if (tk.flagged) verdicts[size_t(tk.index)] = tk.result.get().verdict;
+        const VerifierStats vs = v.stats();
+        bounded = vs.peakRunning == 1 && vs.exactRuns <= distinct;
+        std::fprintf(stderr, "[HIL]   pool: workers=%u peakRunning=%d exactRuns=%lld (distinct=%d) cancelled=%lld "
+                     "firstResolved=seg %d\n", vs.workers, vs.peakRunning, vs.exactRuns, distinct, vs.cancelled, firstReady);
+    }
+    bool cacheInstant = true, cacheMiss = false;
+    {
+        VerifierOptions o; o.workers = 1; o.cacheFile = cachePath;
+        TrajectoryVerifier v(o);
+        auto c0 = clk::now();
+        auto again = v.submit(traj, mat, 1);
+        for (auto& tk : again) {
+            if (!tk.flagged) continue;
+            if (tk.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { cacheInstant = false; continue; }
+            const ExactResult r = tk.result.get();
+            cacheInstant &= r.cached && r.verdict == verdicts[size_t(tk.index)];
+        }
+        const double reMs = ms(clk::now() - c0);
+        cacheInstant &= v.stats().exactRuns == 0;
+        MaterialSpec mat2 = mat; mat2.yieldStress *= 1.01;          // NEG-CTRL: different content
+        auto changed = v.submit(traj, mat2, 2);
+        for (auto& tk : changed)
+            if (tk.flagged && tk.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) cacheMiss = true;
+        v.cancel(2);
+        std::fprintf(stderr, "[HIL]   cache: re-verify %.3fms (one exact %.1fms) allCached=%d  NEG-CTRL changed material missed=%d\n",
+                     reMs, tOne, int(cacheInstant), int(cacheMiss));
+    }
+    std::filesystem::remove(cachePath, ec);
+
+    bool pass = flaggedTransient && baselineClean && nonBlocking && rejectedHigh && safeModerate
+             && bounded && priorityFirst && superseded && cacheInstant && cacheMiss;
     std::fprintf(stderr,
         "[HIL] TRAJECTORY_HIL_LOOP %s  flagged=%d pendingAtStart=%d submit=%.3fms oneExact=%.1fms\n",
         pass ? "PASS" : "FAIL", flagged, pendingAtStart, submitMs, tOne);
     std::fprintf(stderr,
         "[HIL]   flagTransient=%d baselineClean=%d nonBlocking=%d rejectedHigh=%d safeModerate=%d probeVM=%.3e\n",
         flaggedTransient, baselineClean, nonBlocking, rejectedHigh, safeModerate, probe.maxVonMises);
+    std::fprintf(stderr, "[HIL]   bounded=%d priorityFirst=%d superseded=%d cacheInstant=%d cacheMiss=%d\n",
+                 bounded, priorityFirst, superseded, cacheInstant, cacheMiss);
     return pass;
 }
 